@@ -0,0 +1,45 @@
+/*
+ * GPU back-end selection.
+ * The back-end is chosen once at startup, before the first GPUContext is created.
+ */
+
+#pragma once
+
+#include "LIB_utildefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum eGPUBackendType {
+  GPU_BACKEND_NONE = 0,
+  GPU_BACKEND_OPENGL = (1 << 0),
+  /** No device calls at all. Only does bookkeeping. Used for profiling on GPU-less machines. */
+  GPU_BACKEND_NULL = (1 << 4),
+  /** Software rasterizer running on the CPU. Used for off-screen rendering without a GPU. */
+  GPU_BACKEND_CPU = (1 << 5),
+  GPU_BACKEND_ANY = 0xFFFFFFFFu,
+} eGPUBackendType;
+
+/**
+ * Set the back-end to create when the first GPUContext is allocated.
+ * Has no effect once a back-end exists.
+ */
+void GPU_backend_type_selection_set(eGPUBackendType backend);
+eGPUBackendType GPU_backend_type_selection_get(void);
+
+/**
+ * Parse a back-end name as given on the command line ("opengl", "null", "cpu").
+ * Returns #GPU_BACKEND_NONE if the name is unknown.
+ */
+eGPUBackendType GPU_backend_type_from_name(const char *name);
+
+/**
+ * Override the selection using the `DUST_GPU_BACKEND` environment variable if set.
+ * Returns false if the variable contains an unknown back-end name.
+ */
+bool GPU_backend_type_selection_from_env(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -185,6 +185,20 @@ void GPU_batch_draw_instanced(GPUBatch *batch, int i_count);
  */
 void GPU_batch_draw_advanced(GPUBatch *batch, int v_first, int v_count, int i_first, int i_count);
 
+/**
+ * Arguments of one indirect draw, as read from the indirect buffer. Same layout as the indexed
+ * indirect commands of the graphic APIs. For non-indexed batches `base_index` is the first
+ * instance and `i_first` is ignored, like the non-indexed commands which are one word shorter.
+ * Compute shaders writing draw arguments (e.g. for culling) must use this layout.
+ */
+typedef struct GPUDrawCommand {
+  uint v_count;
+  uint i_count;
+  uint v_first;
+  int base_index;
+  uint i_first;
+} GPUDrawCommand;
+
 /**
  * Issue a draw call using GPU computed arguments. The argument are expected to be valid for the
  * type of geometry drawn (index or non-indexed).
@@ -0,0 +1,57 @@
+/* Automatic instancing of repeated batch draws.
+ *
+ * Gizmos and overlays draw the same batch many times, only changing the model matrix and the
+ * color. Draws recorded into an instancer are grouped by batch, shader and pipeline state, and
+ * each group is submitted as a single instanced draw:
+ * - the model matrix and color of each draw are written into an instance vertex buffer using the
+ *   attributes #GPU_BATCH_INSTANCER_ATTR_MATRIX (mat4) and #GPU_BATCH_INSTANCER_ATTR_COLOR (vec4),
+ *   the shader must read them as instance attributes,
+ * - the pipeline state is the one of the context when the draw is recorded (#GPU_blend,
+ *   #GPU_depth_test, ...), it is restored after submission,
+ * - groups are drawn in the order of their first draw. Draws relying on their order (blending
+ *   without depth test, ...) must be submitted in between,
+ * - other uniforms, textures and matrices are the ones of the context at submission,
+ * - the active frame-buffer must not change between the first draw and submission.
+ *
+ * The batches must not have instance buffers of their own and must stay valid until submission.
+ */
+
+#pragma once
+
+#include "GPU_batch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GPU_BATCH_INSTANCER_ATTR_MATRIX "InstanceModelMatrix"
+#define GPU_BATCH_INSTANCER_ATTR_COLOR "InstanceColor"
+
+typedef struct GPUBatchInstancer GPUBatchInstancer;
+
+typedef struct GPUBatchInstancerStats {
+  /** Draws recorded during the last frame. */
+  unsigned int draw_len;
+  /** Instanced draw calls they were submitted with. */
+  unsigned int call_len;
+} GPUBatchInstancerStats;
+
+GPUBatchInstancer *GPU_batch_instancer_create(void);
+void GPU_batch_instancer_free(GPUBatchInstancer *instancer);
+
+/** Record one instance of \a batch drawn with \a shader. */
+void GPU_batch_instancer_draw(GPUBatchInstancer *instancer,
+                              GPUBatch *batch,
+                              GPUShader *shader,
+                              const float model_matrix[4][4],
+                              const float color[4]);
+/** Draw the recorded instances, then empty the instancer. */
+void GPU_batch_instancer_submit(GPUBatchInstancer *instancer);
+/** Empty the instancer without drawing. */
+void GPU_batch_instancer_clear(GPUBatchInstancer *instancer);
+
+void GPU_batch_instancer_stats_get(GPUBatchInstancerStats *r_stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+/* Deferred command lists.
+ *
+ * A command list records binds, state changes, uniforms and draws without needing a context, so
+ * it can be filled from any thread. The thread owning the context then replays the lists, in the
+ * order it chooses, which lets draw generation run in parallel:
+ *
+ * \code{.c}
+ * // Worker thread, one list per thread.
+ * GPU_command_list_shader_bind(list, shader);
+ * GPU_command_list_uniform_4fv(list, "color", color);
+ * GPU_command_list_draw(list, batch);
+ *
+ * // Context thread, once the workers are done.
+ * GPU_command_list_replay(list);
+ * GPU_command_list_reset(list);
+ * \endcode
+ *
+ * A list must only be recorded by one thread at a time. Everything it references must stay valid
+ * until it is replayed. Replay starts from the state of the context, and restores the state and
+ * the bound shader afterwards. The textures and uniform buffers bound by the list are unbound
+ * after the replay, the caller must bind again the ones it uses at the same units or slots.
+ * Uniforms apply to the shader bound last in the list. Matrices are not recorded, the matrix
+ * uniforms must be set explicitly.
+ */
+
+#pragma once
+
+#include "GPU_batch.h"
+#include "GPU_state.h"
+#include "GPU_texture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct GPUCommandList GPUCommandList;
+
+GPUCommandList *GPU_command_list_create(void);
+void GPU_command_list_free(GPUCommandList *list);
+
+/** Remove all commands, keeping the memory for the next recording. */
+void GPU_command_list_reset(GPUCommandList *list);
+bool GPU_command_list_is_empty(const GPUCommandList *list);
+/** Execute the commands on the active context. Must be called from the context thread. */
+void GPU_command_list_replay(GPUCommandList *list);
+
+/* Recording. Same behavior as the immediate functions of the same name. */
+
+void GPU_command_list_shader_bind(GPUCommandList *list, GPUShader *shader);
+
+void GPU_command_list_blend(GPUCommandList *list, eGPUBlend blend);
+void GPU_command_list_depth_test(GPUCommandList *list, eGPUDepthTest test);
+void GPU_command_list_face_culling(GPUCommandList *list, eGPUFaceCullTest culling);
+void GPU_command_list_write_mask(GPUCommandList *list, eGPUWriteMask mask);
+void GPU_command_list_line_width(GPUCommandList *list, float width);
+void GPU_command_list_point_size(GPUCommandList *list, float size);
+
+void GPU_command_list_texture_bind(GPUCommandList *list, GPUTexture *tex, int unit);
+void GPU_command_list_uniformbuf_bind(GPUCommandList *list, GPUUniformBuf *ubo, int slot);
+
+void GPU_command_list_uniform_vector(
+    GPUCommandList *list, int location, int length, int arraysize, const float *value);
+void GPU_command_list_uniform_vector_int(
+    GPUCommandList *list, int location, int length, int arraysize, const int *value);
+/* Lookup \a name in the shader bound last in the list. */
+void GPU_command_list_uniform_1i(GPUCommandList *list, const char *name, int value);
+void GPU_command_list_uniform_1f(GPUCommandList *list, const char *name, float value);
+void GPU_command_list_uniform_4fv(GPUCommandList *list, const char *name, const float data[4]);
+void GPU_command_list_uniform_mat4(GPUCommandList *list, const char *name, const float data[4][4]);
+
+/** Same parameters as #GPU_batch_draw_advanced. */
+void GPU_command_list_draw_ex(
+    GPUCommandList *list, GPUBatch *batch, int v_first, int v_count, int i_first, int i_count);
+#define GPU_command_list_draw(list, batch) GPU_command_list_draw_ex(list, batch, 0, 0, 0, 0)
+
+#ifdef __cplusplus
+}
+#endif
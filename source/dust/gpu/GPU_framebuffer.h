@@ -247,6 +247,18 @@ void GPU_framebuffer_read_color(GPUFrameBuffer *fb,
                                 int slot,
                                 eGPUDataFormat format,
                                 void *data);
+/**
+ * Non blocking version of #GPU_framebuffer_read_color. The result must be freed with
+ * #GPU_readback_free or handed over with #GPU_readback_callback_set.
+ */
+struct GPUReadback *GPU_framebuffer_read_color_async(GPUFrameBuffer *fb,
+                                                     int x,
+                                                     int y,
+                                                     int w,
+                                                     int h,
+                                                     int channels,
+                                                     int slot,
+                                                     eGPUDataFormat format);
 
 /**
  * Read_slot and write_slot are only used for color buffers.
@@ -257,6 +269,14 @@ void GPU_framebuffer_blit(GPUFrameBuffer *fb_read,
                           int write_slot,
                           eGPUFrameBufferBits blit_buffers);
 
+/**
+ * Render each mip level of the attachments from the previous one, calling \a callback for each
+ * level with the frame-buffer bound to it.
+ * If \a callback is NULL, levels are filtered with a 2x2 box filter using
+ * #GPU_texture_downsample, which writes all levels in a single compute dispatch when supported.
+ * Callers whose callback only draws a 2x2 box filter must pass NULL instead, the callback path
+ * renders and synchronizes once per level.
+ */
 void GPU_framebuffer_recursive_downsample(GPUFrameBuffer *fb,
                                           int max_lvl,
                                           void (*callback)(void *userData, int level),
@@ -281,6 +301,8 @@ void GPU_offscreen_free(GPUOffScreen *ofs);
 void GPU_offscreen_bind(GPUOffScreen *ofs, bool save);
 void GPU_offscreen_unbind(GPUOffScreen *ofs, bool restore);
 void GPU_offscreen_read_pixels(GPUOffScreen *ofs, eGPUDataFormat format, void *pixels);
+/** Non blocking version of #GPU_offscreen_read_pixels. See #GPU_framebuffer_read_color_async. */
+struct GPUReadback *GPU_offscreen_read_pixels_async(GPUOffScreen *ofs, eGPUDataFormat format);
 void GPU_offscreen_draw_to_screen(GPUOffScreen *ofs, int x, int y);
 int GPU_offscreen_width(const GPUOffScreen *ofs);
 int GPU_offscreen_height(const GPUOffScreen *ofs);
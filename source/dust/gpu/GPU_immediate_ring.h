@@ -0,0 +1,45 @@
+/* Streaming buffer of the immediate mode.
+ *
+ * Each context writes its immediate vertices into one large buffer mapped for the lifetime of the
+ * context. #immBegin only takes the next range of the buffer, ranges are reused once the device
+ * is done reading them. The counters below help sizing #GPU_IMMEDIATE_RING_SIZE.
+ *
+ * Consecutive draws using the same shader, vertex format, primitive type, state and uniforms are
+ * merged: their vertices are written one after the other and drawn with a single call once
+ * something changes. Only points, lines, triangles and triangle strips (joined with degenerate
+ * triangles) are merged.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "LIB_utildefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size in bytes of the buffer of each context. Grows if a single draw needs more. */
+#define GPU_IMMEDIATE_RING_SIZE (4 * 1024 * 1024)
+
+typedef struct GPUImmediateRingStats {
+  /** All contexts during the last frame. */
+  uint64_t bytes_streamed;
+  unsigned int draw_len;
+  /** Number of times a ring went back to its start. */
+  unsigned int wrap_len;
+  /** Draws that had to wait for the device to release a range. */
+  unsigned int stall_len;
+  /** Draws appended to the previous one. The number of draw calls is `draw_len - merged_len`. */
+  unsigned int merged_len;
+} GPUImmediateRingStats;
+
+void GPU_immediate_ring_stats_get(GPUImmediateRingStats *r_stats);
+
+/** Enable merging of immediate draws (the default). Disabling helps debugging draw order. */
+void GPU_immediate_merge_set(bool enable);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,8 +2,20 @@
 
 #pragma once
 
+#include "LIB_utildefines.h"
+
 #include "GPU_primitive.h"
 
+typedef enum eGPUIndexBufOptimize {
+  GPU_INDEXBUF_OPTIMIZE_NONE = 0,
+  /** Reorder the triangles so that their vertices are found in the post-transform cache. */
+  GPU_INDEXBUF_OPTIMIZE_VERTEX_CACHE = (1 << 0),
+  /** Also draw the clusters of triangles facing away from the mesh center first. */
+  GPU_INDEXBUF_OPTIMIZE_OVERDRAW = (1 << 1),
+} eGPUIndexBufOptimize;
+
+ENUM_OPERATORS(eGPUIndexBufOptimize, GPU_INDEXBUF_OPTIMIZE_OVERDRAW)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -42,6 +54,33 @@ void GPU_indexbuf_init_build_on_device(GPUIndexBuf *elem, uint index_len);
  */
 void GPU_indexbuf_join(GPUIndexBufBuilder *builder, const GPUIndexBufBuilder *builder_from);
 
+/**
+ * Build disjoint ranges of primitives from several threads.
+ * Each thread fills its own sub-builder, sharing the index data of \a builder, using the
+ * `GPU_indexbuf_set_*` functions with the primitive indices of its range. The sub-builders are
+ * then joined into \a builder without any locking.
+ */
+void GPU_indexbuf_subbuilder_init(const GPUIndexBufBuilder *builder,
+                                  GPUIndexBufBuilder *r_subbuilder);
+void GPU_indexbuf_subbuilder_finish(GPUIndexBufBuilder *builder,
+                                    const GPUIndexBufBuilder *subbuilder);
+
+/** Fill the primitives [\a prim_start..\a prim_end) with the `GPU_indexbuf_set_*` functions. */
+typedef void (*GPUIndexBufFillFn)(void *user_data,
+                                  GPUIndexBufBuilder *subbuilder,
+                                  uint prim_start,
+                                  uint prim_end);
+
+/**
+ * Call \a fill_fn from many threads for ranges of up to \a grain_size of the \a prim_len
+ * primitives of \a builder, then join the sub-builders in range order.
+ */
+void GPU_indexbuf_fill_parallel(GPUIndexBufBuilder *builder,
+                                uint prim_len,
+                                uint grain_size,
+                                GPUIndexBufFillFn fill_fn,
+                                void *user_data);
+
 void GPU_indexbuf_add_generic_vert(GPUIndexBufBuilder *, uint v);
 void GPU_indexbuf_add_primitive_restart(GPUIndexBufBuilder *);
 
@@ -59,6 +98,16 @@ void GPU_indexbuf_set_point_restart(GPUIndexBufBuilder *builder, uint elem);
 void GPU_indexbuf_set_line_restart(GPUIndexBufBuilder *builder, uint elem);
 void GPU_indexbuf_set_tri_restart(GPUIndexBufBuilder *builder, uint elem);
 
+/**
+ * Reorder the triangles of a #GPU_PRIM_TRIS builder, to call before building it. The drawn
+ * triangles and their winding are unchanged, restart triangles are removed.
+ * \a positions has one element per vertex and is only read by #GPU_INDEXBUF_OPTIMIZE_OVERDRAW.
+ * \note Indices are stored as 16bit when their range allows it, optimized or not.
+ */
+void GPU_indexbuf_optimize(GPUIndexBufBuilder *,
+                           eGPUIndexBufOptimize flags,
+                           const float (*positions)[3]);
+
 GPUIndexBuf *GPU_indexbuf_build(GPUIndexBufBuilder *);
 void GPU_indexbuf_build_in_place(GPUIndexBufBuilder *, GPUIndexBuf *);
 
@@ -0,0 +1,77 @@
+/* Per category accounting of device memory.
+ *
+ * Textures and vertex buffers are tagged with the category of their owner. Each category can be
+ * given a budget: when it is exceeded, #GPU_memory_budget_step first frees the unused textures of
+ * the texture pool, then evicts the least recently bound textures that were registered as
+ * evictable by cache owners (image textures, batch caches, ...). Evicted textures are simply
+ * recreated by their owner on next use.
+ *
+ * Everything is untagged (#GPU_MEMORY_CATEGORY_OTHER) by default.
+ */
+
+#pragma once
+
+#include "GPU_texture.h"
+#include "GPU_vertex_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum eGPUMemoryCategory {
+  GPU_MEMORY_CATEGORY_OTHER = 0,
+  /** Textures of image data-blocks. */
+  GPU_MEMORY_CATEGORY_IMAGE,
+  /** Viewport render targets. */
+  GPU_MEMORY_CATEGORY_VIEWPORT,
+  /** #GPUOffScreen and other scratch targets. */
+  GPU_MEMORY_CATEGORY_OFFSCREEN,
+  /** Geometry caches of the draw manager. */
+  GPU_MEMORY_CATEGORY_BATCH_CACHE,
+} eGPUMemoryCategory;
+
+#define GPU_MEMORY_CATEGORY_LEN (GPU_MEMORY_CATEGORY_BATCH_CACHE + 1)
+
+typedef struct GPUMemoryUsage {
+  /** Bytes currently allocated. */
+  size_t used;
+  /** Highest value of #used since start-up. */
+  size_t peak;
+  /** Zero if unlimited. */
+  size_t budget;
+  /** Number of textures and buffers holding memory. */
+  unsigned int resource_len;
+  /** Number of textures evicted since start-up. */
+  unsigned int evicted_len;
+} GPUMemoryUsage;
+
+/**
+ * Called when \a tex is evicted. The owner must drop its reference (using #GPU_texture_free)
+ * and forget the texture, so that it gets recreated on next use.
+ */
+typedef void (*GPUTextureEvictFn)(GPUTexture *tex, void *user_data);
+
+/** Account the memory of \a tex to \a category. Views are never accounted. */
+void GPU_texture_memory_category_set(GPUTexture *tex, eGPUMemoryCategory category);
+/** Account the data of \a verts to \a category, including future allocations. */
+void GPU_vertbuf_memory_category_set(GPUVertBuf *verts, eGPUMemoryCategory category);
+
+/**
+ * Allow \a tex to be evicted when its category is over budget. Pass NULL to remove.
+ * \a evict_fn is always called from #GPU_memory_budget_step, with a context bound.
+ */
+void GPU_texture_evict_callback_set(GPUTexture *tex, GPUTextureEvictFn evict_fn, void *user_data);
+
+/** Set the budget of \a category in bytes. Zero disables the limit. */
+void GPU_memory_budget_set(eGPUMemoryCategory category, size_t budget);
+/**
+ * Evict textures of the categories that are over budget and advance one frame. Call it at the end
+ * of a frame: textures bound during the frame are not evicted.
+ */
+void GPU_memory_budget_step(void);
+
+void GPU_memory_usage_get(eGPUMemoryCategory category, GPUMemoryUsage *r_usage);
+
+#ifdef __cplusplus
+}
+#endif
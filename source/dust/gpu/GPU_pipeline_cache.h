@@ -0,0 +1,60 @@
+/* Pipeline state object cache.
+ *
+ * Back-ends with immutable pipeline objects build one for every combination of shader, vertex
+ * layout, primitive type, #GPUState and frame-buffer attachment formats a draw uses. Creating a
+ * pipeline compiles the shader for that combination, which takes long enough to make the first
+ * draw using it stall. Pipelines are cached and shared by all contexts.
+ *
+ * The key of every pipeline created is recorded. Saving the records at exit and loading them at
+ * the next startup lets #GPU_pipeline_cache_warm create the pipelines of a shader right after it
+ * is compiled, before anything draws with it. Records only refer to shaders by name.
+ */
+
+#pragma once
+
+#include "GPU_shader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct GPUPipelineCacheStats {
+  /** Draws of the last frame that found their pipeline in the cache. */
+  unsigned int hit_len;
+  /** Draws of the last frame that had to create their pipeline. Each one is a stall. */
+  unsigned int miss_len;
+  /** Pipelines created by #GPU_pipeline_cache_warm since startup. */
+  unsigned int warm_len;
+  /** Live pipelines and recorded keys. */
+  unsigned int pipeline_len;
+  unsigned int record_len;
+  /** Time spent creating pipelines since startup, in seconds. */
+  double create_time;
+} GPUPipelineCacheStats;
+
+/**
+ * Add the records of \a filepath, written by #GPU_pipeline_cache_keys_save, to the ones of this
+ * session. Return false if the file is missing or was written by another version.
+ */
+bool GPU_pipeline_cache_keys_load(const char *filepath);
+/** Write the records of this session and the loaded ones. */
+bool GPU_pipeline_cache_keys_save(const char *filepath);
+/**
+ * Load the keys of \a filepath when the back-end is created and save them there when it is
+ * freed. Must be called before the first GPUContext is created, NULL disables it (the default).
+ * Overridden by the `DUST_GPU_PIPELINE_KEYS` environment variable if set.
+ */
+void GPU_pipeline_cache_keys_path_set(const char *filepath);
+
+/**
+ * Create the recorded pipelines of \a shader that don't exist yet. Call it once the shader is
+ * compiled, with a context active. #GPU_shader_compile_finalize calls it for the shaders it
+ * returns. Return the number of pipelines created.
+ */
+int GPU_pipeline_cache_warm(GPUShader *shader);
+
+void GPU_pipeline_cache_stats_get(GPUPipelineCacheStats *r_stats);
+
+#ifdef __cplusplus
+}
+#endif
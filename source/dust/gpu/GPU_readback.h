@@ -0,0 +1,54 @@
+/* Asynchronous readback of frame-buffer and texture data.
+ *
+ * A read request copies the data into a staging buffer and returns immediately with a handle.
+ * The copy completes once the device reached that point of the command stream. The data can be
+ * polled with #GPU_readback_is_ready, waited on with #GPU_readback_data_get, or delivered to a
+ * callback by #GPU_readback_poll. This allows reading back frame N while rendering frame N+1.
+ *
+ * Staging buffers come from a small ring shared by all contexts and are recycled once the
+ * handle is freed.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "LIB_utildefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Opaque type hiding dust::gpu::Readback. */
+typedef struct GPUReadback GPUReadback;
+
+/**
+ * Called by #GPU_readback_poll once the data is available. \a data is only valid during the call.
+ * The handle is freed after the callback returns.
+ */
+typedef void (*GPUReadbackCallback)(const void *data, size_t size, void *user_data);
+
+/** Number of staging buffers kept alive for reuse. */
+#define GPU_READBACK_RING_LEN 3
+
+/** Non blocking. True once the data of \a readback can be accessed without waiting. */
+bool GPU_readback_is_ready(GPUReadback *readback);
+/** Wait for the copy if needed and return the data. Valid until the handle is freed. */
+const void *GPU_readback_data_get(GPUReadback *readback);
+size_t GPU_readback_size_get(const GPUReadback *readback);
+/** Give the staging buffer back to the ring. Waits if the copy is still in flight. */
+void GPU_readback_free(GPUReadback *readback);
+
+/**
+ * Hand over \a readback to #GPU_readback_poll which will call \a callback once the data is ready
+ * and free the handle. The caller must not use the handle anymore.
+ */
+void GPU_readback_callback_set(GPUReadback *readback,
+                               GPUReadbackCallback callback,
+                               void *user_data);
+/** Call the callbacks of the completed readbacks. Never blocks. */
+void GPU_readback_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
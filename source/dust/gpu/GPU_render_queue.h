@@ -0,0 +1,79 @@
+/* Sorted draw submission.
+ *
+ * Draws are recorded into a queue together with the pipeline state, shader and resources they
+ * need, then sorted with a 64bit key and submitted at once, so that consecutive draws share as
+ * much state as possible:
+ * - the pipeline state is the one of the context when the draw is recorded (#GPU_blend,
+ *   #GPU_depth_test, ...), it is restored after submission,
+ * - textures and uniform buffers bound with the queue functions stay bound for the following
+ *   draws, like with the immediate API,
+ * - uniforms and matrices are NOT recorded. Per draw data must live in uniform buffers, the
+ *   matrices are the ones of the context at submission.
+ */
+
+#pragma once
+
+#include "GPU_batch.h"
+#include "GPU_texture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Texture units and uniform buffer slots that can be bound with the queue functions. */
+#define GPU_RENDER_QUEUE_TEXTURE_MAX 8
+#define GPU_RENDER_QUEUE_UBO_MAX 4
+
+typedef struct GPURenderQueue GPURenderQueue;
+
+typedef enum eGPURenderQueueOrder {
+  /** Group by shader, state and resources, then front to back. */
+  GPU_RENDER_QUEUE_OPAQUE = 0,
+  /** Back to front. Draws at the same depth are grouped by shader, state and resources. */
+  GPU_RENDER_QUEUE_TRANSPARENT,
+} eGPURenderQueueOrder;
+
+typedef struct GPURenderQueueStats {
+  /** Draws submitted during the last frame. */
+  unsigned int draw_len;
+  /**
+   * Shader, pipeline state and resource changes of the last frame, if the draws had been
+   * submitted in recorded order, and after sorting.
+   */
+  unsigned int transitions_recorded;
+  unsigned int transitions_submitted;
+} GPURenderQueueStats;
+
+GPURenderQueue *GPU_render_queue_create(eGPURenderQueueOrder order);
+void GPU_render_queue_free(GPURenderQueue *queue);
+
+/** Bind \a tex to texture \a unit for the next recorded draws. NULL to unbind. */
+void GPU_render_queue_texture_bind(GPURenderQueue *queue, GPUTexture *tex, int unit);
+/** Bind \a ubo to \a slot for the next recorded draws. NULL to unbind. */
+void GPU_render_queue_uniformbuf_bind(GPURenderQueue *queue, GPUUniformBuf *ubo, int slot);
+
+/**
+ * Record a draw. Same parameters as #GPU_batch_draw_advanced.
+ * \a depth is the view space distance used for ordering, smaller being closer to the camera.
+ */
+void GPU_render_queue_draw_ex(GPURenderQueue *queue,
+                              GPUBatch *batch,
+                              GPUShader *shader,
+                              float depth,
+                              int v_first,
+                              int v_count,
+                              int i_first,
+                              int i_count);
+#define GPU_render_queue_draw(queue, batch, shader, depth) \
+  GPU_render_queue_draw_ex(queue, batch, shader, depth, 0, 0, 0, 0)
+
+/** Sort and draw the recorded draws, then empty the queue and its bindings. */
+void GPU_render_queue_submit(GPURenderQueue *queue);
+/** Empty the queue without drawing. */
+void GPU_render_queue_clear(GPURenderQueue *queue);
+
+void GPU_render_queue_stats_get(GPURenderQueueStats *r_stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -186,6 +186,27 @@ void GPU_shader_uniform_mat3_as_mat4(GPUShader *sh, const char *name, const floa
 void GPU_shader_uniform_2fv_array(GPUShader *sh, const char *name, int len, const float (*val)[2]);
 void GPU_shader_uniform_4fv_array(GPUShader *sh, const char *name, int len, const float (*val)[4]);
 
+/**
+ * Interned \a name of a shader input, the same for all shaders. Get it once, the `_by_id`
+ * functions then look inputs up without hashing nor comparing strings, for use in hot loops.
+ * Only the inputs of shaders created from a #GPUShaderCreateInfo are found by id.
+ */
+int GPU_shader_name_id_get(const char *name);
+int GPU_shader_get_uniform_by_id(GPUShader *shader, int name_id);
+int GPU_shader_get_uniform_block_binding_by_id(GPUShader *shader, int name_id);
+int GPU_shader_get_ssbo_by_id(GPUShader *shader, int name_id);
+int GPU_shader_get_texture_binding_by_id(GPUShader *shader, int name_id);
+int GPU_shader_get_attribute_by_id(GPUShader *shader, int name_id);
+
+void GPU_shader_uniform_vector_by_id(
+    GPUShader *shader, int name_id, int length, int arraysize, const float *value);
+void GPU_shader_uniform_vector_int_by_id(
+    GPUShader *shader, int name_id, int length, int arraysize, const int *value);
+void GPU_shader_uniform_1i_by_id(GPUShader *sh, int name_id, int value);
+void GPU_shader_uniform_1f_by_id(GPUShader *sh, int name_id, float value);
+void GPU_shader_uniform_4fv_by_id(GPUShader *sh, int name_id, const float data[4]);
+void GPU_shader_uniform_mat4_by_id(GPUShader *sh, int name_id, const float data[4][4]);
+
 unsigned int GPU_shader_get_attribute_len(const GPUShader *shader);
 int GPU_shader_get_attribute(GPUShader *shader, const char *name);
 bool GPU_shader_get_attribute_info(const GPUShader *shader,
@@ -0,0 +1,48 @@
+/* Shader binary cache.
+ *
+ * Keeps the program binaries of compiled shaders on disk so that the next sessions load them
+ * instead of compiling the sources again. Entries are keyed by a hash of the fully resolved
+ * create info and sources of the shader, and by the driver that produced the binary: updating
+ * the driver or any source invalidates the entries. Only back-ends supporting program binaries
+ * use the cache.
+ */
+
+#pragma once
+
+#include "GPU_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct GPUShaderCacheStats {
+  /** Shaders loaded from the cache. */
+  uint hit_len;
+  /** Shaders compiled because they were not in the cache. */
+  uint miss_len;
+  /** Entries discarded because they were corrupted or refused by the driver. */
+  uint reject_len;
+  /** Time spent loading binaries and compiling shaders, in seconds. */
+  double load_time;
+  double compile_time;
+  /** Size of all the entries on disk. */
+  size_t disk_size;
+} GPUShaderCacheStats;
+
+/**
+ * Use \a directory to store the binaries, creating it if needed. When the entries exceed
+ * \a size_max bytes, the least recently used ones are deleted. A NULL \a directory disables the
+ * cache, which is the default.
+ */
+void GPU_shader_cache_init(const char *directory, size_t size_max);
+void GPU_shader_cache_exit(void);
+/** Delete all the entries. */
+void GPU_shader_cache_clear(void);
+
+/** Print every hit, miss and compile time to stdout. */
+void GPU_shader_cache_debug_set(bool enable);
+void GPU_shader_cache_stats_get(GPUShaderCacheStats *r_stats);
+
+#ifdef __cplusplus
+}
+#endif
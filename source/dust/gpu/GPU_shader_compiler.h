@@ -0,0 +1,67 @@
+/* Asynchronous shader compilation.
+ *
+ * Shaders are compiled from their create info on a pool of worker threads, so that creating
+ * shader variants on demand doesn't stall the frame. Draw code polls the handle and keeps drawing
+ * with a placeholder shader until the compiled one is ready. The placeholder is chosen by the
+ * caller, only it knows which shader has a compatible interface (a builtin uniform color shader,
+ * a less specialized variant, ...), or it skips the draw.
+ * The create infos are finalized on the calling thread before being queued.
+ * On-demand compilations are done before the batches, so that compiling all the static shaders
+ * at startup doesn't delay them.
+ */
+
+#pragma once
+
+#include "GPU_shader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Opaque type of a compilation in progress. */
+typedef struct GPUShaderCompileHandle GPUShaderCompileHandle;
+
+/**
+ * Create a GPU context sharing its objects with the main one and make it active on the calling
+ * thread. Called once by each worker thread, return NULL if the back-end needs no context.
+ */
+typedef void *(*GPUShaderCompilerContextCreateFn)(void *user_data);
+/** Deactivate and free a context returned by #GPUShaderCompilerContextCreateFn. */
+typedef void (*GPUShaderCompilerContextFreeFn)(void *context, void *user_data);
+
+/**
+ * Start \a thread_len worker threads, zero to use one per core but one. The context functions
+ * can be NULL when the back-end compiles without a context.
+ * Without workers, the compilations are done synchronously by #GPU_shader_compile_async.
+ */
+void GPU_shader_compiler_init(int thread_len,
+                              GPUShaderCompilerContextCreateFn context_create_fn,
+                              GPUShaderCompilerContextFreeFn context_free_fn,
+                              void *user_data);
+/** Stop the workers. Compilations not yet started give NULL shaders. */
+void GPU_shader_compiler_exit(void);
+
+/** Compile one shader with a high priority. Return immediately. */
+GPUShaderCompileHandle *GPU_shader_compile_async(const GPUShaderCreateInfo *info);
+/**
+ * Compile \a infos_len shaders on all the workers, for example all the statically compiled
+ * create infos at startup. Return immediately.
+ */
+GPUShaderCompileHandle *GPU_shader_batch_compile_async(const GPUShaderCreateInfo **infos,
+                                                       int infos_len);
+
+/** True when all the shaders of \a handle are compiled. Never blocks. */
+bool GPU_shader_compile_is_ready(const GPUShaderCompileHandle *handle);
+/**
+ * Wait for the compilation and write its shaders to \a r_shaders, in the order of the create
+ * infos, NULL for the ones that failed. The handle is freed and set to NULL.
+ * Needs an active context: the recorded pipelines of the shaders are created, see
+ * #GPU_pipeline_cache_warm.
+ */
+void GPU_shader_compile_finalize(GPUShaderCompileHandle **handle, GPUShader **r_shaders);
+/** Stop the compilation and free its shaders. The handle is freed and set to NULL. */
+void GPU_shader_compile_cancel(GPUShaderCompileHandle **handle);
+
+#ifdef __cplusplus
+}
+#endif
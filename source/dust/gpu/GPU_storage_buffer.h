@@ -48,6 +48,11 @@ void GPU_storagebuf_clear_to_zero(GPUStorageBuf *ssbo);
  * NOTE: Not synchronized. Use appropriate barrier before reading.
  */
 void GPU_storagebuf_read(GPUStorageBuf *ssbo, void *data);
+/**
+ * Non blocking version of #GPU_storagebuf_read. See GPU_readback.h.
+ * Only the first \a size bytes are returned, at most the size of the buffer.
+ */
+struct GPUReadback *GPU_storagebuf_read_async(GPUStorageBuf *ssbo, size_t size);
 
 /**
  * \brief Copy a part of a vertex buffer to a storage buffer.
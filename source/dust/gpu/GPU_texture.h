@@ -56,8 +56,24 @@ extern "C" {
 
 /**
  * Update user defined sampler states.
+ * The sampler table is only rebuilt if the anisotropic filter level changed.
  */
 void GPU_samplers_update(void);
+/** User preference, applied by the next #GPU_samplers_update. Clamped to the device limit. */
+void GPU_samplers_anisotropic_filter_set(float level);
+
+typedef struct GPUSamplerStats {
+  /** Texture binds during the last frame. */
+  unsigned int binds;
+  /** Binds of the last frame which changed the sampler state of a unit. */
+  unsigned int rebinds;
+  /** Number of times the sampler table was built. */
+  unsigned int rebuild_count;
+  /** Anisotropic filter level in use. */
+  float anisotropy;
+} GPUSamplerStats;
+
+void GPU_samplers_stats_get(GPUSamplerStats *r_stats);
 
 /* GPU Texture
  * - always returns unsigned char RGBA textures
@@ -277,13 +293,66 @@ void GPU_texture_update_sub(GPUTexture *tex,
                             int width,
                             int height,
                             int depth);
+
 /**
  * Makes data interpretation aware of the source layout.
  * Skipping pixels correctly when changing rows when doing partial update.
  */
 void GPU_unpack_row_length_set(uint len);
 
+/* Upload Queue
+ * - Batches sub-rect uploads of many textures and spreads them over frames.
+ * - Pixels are copied into a staging ring in host memory, so the caller can free them right away.
+ *   Uploads still go through #GPU_texture_update_sub, the queue only defers and paces them.
+ * - #GPU_texture_upload_queue_flush uploads the oldest updates first, up to a per-frame budget.
+ * When the ring is full, the oldest updates are uploaded immediately (a stall). All these
+ * functions need an active GPUContext. */
+
+/** Size of the staging ring in bytes. Bigger updates bypass the queue. */
+#define GPU_TEXTURE_UPLOAD_RING_SIZE (32 * 1024 * 1024)
+
+/**
+ * Same as #GPU_texture_update_sub but deferred to the next #GPU_texture_upload_queue_flush.
+ * \a pixels must be tightly packed, #GPU_unpack_row_length_set has no effect.
+ * Queued updates of a texture are applied in order.
+ */
+void GPU_texture_update_sub_queued(GPUTexture *tex,
+                                   eGPUDataFormat data_format,
+                                   const void *pixels,
+                                   int offset_x,
+                                   int offset_y,
+                                   int offset_z,
+                                   int width,
+                                   int height,
+                                   int depth);
+/** Upload queued updates until the per-frame budget is reached. Call once per frame. */
+void GPU_texture_upload_queue_flush(void);
+/** Upload all queued updates, ignoring the budget. */
+void GPU_texture_upload_queue_finish(void);
+/** Upload everything then free the staging ring. */
+void GPU_texture_upload_queue_free(void);
+/** Maximum number of bytes uploaded by #GPU_texture_upload_queue_flush. 0 means no limit. */
+void GPU_texture_upload_budget_set(size_t bytes_per_frame);
+
+typedef struct GPUTextureUploadStats {
+  /** Cumulative since start-up. */
+  uint64_t bytes_uploaded;
+  uint64_t updates_uploaded;
+  /** Updates uploaded outside of a flush because the ring was full. */
+  uint64_t stall_count;
+  double stall_time;
+  /** Current content of the queue. */
+  uint64_t bytes_pending;
+  uint updates_pending;
+} GPUTextureUploadStats;
+
+void GPU_texture_upload_stats_get(GPUTextureUploadStats *r_stats);
+
 void *GPU_texture_read(GPUTexture *tex, eGPUDataFormat data_format, int miplvl);
+/** Non blocking version of #GPU_texture_read. See GPU_readback.h. */
+struct GPUReadback *GPU_texture_read_async(GPUTexture *tex,
+                                           eGPUDataFormat data_format,
+                                           int miplvl);
 /**
  * Fills the whole texture with the same data for all pixels.
  * \warning Only work for 2D texture for now.
@@ -311,7 +380,16 @@ void GPU_texture_image_unbind_all(void);
  */
 void GPU_texture_copy(GPUTexture *dst, GPUTexture *src);
 
+/** Generate all the mip levels from level 0 using #GPU_texture_downsample. */
 void GPU_texture_generate_mipmap(GPUTexture *tex);
+/**
+ * Generate mip levels 1 to \a max_lvl of a 2D texture from level 0 using a 2x2 box filter.
+ * When compute shaders and image load-store are supported, up to 8 levels are written by a single
+ * dispatch. Otherwise falls back to the mip generation of the back-end.
+ */
+void GPU_texture_downsample(GPUTexture *tex, int max_lvl);
+/** Free the shaders and buffers used by #GPU_texture_downsample. Needs an active context. */
+void GPU_texture_downsample_free(void);
 void GPU_texture_anisotropic_filter(GPUTexture *tex, bool use_aniso);
 void GPU_texture_compare_mode(GPUTexture *tex, bool use_compare);
 void GPU_texture_filter_mode(GPUTexture *tex, bool use_filter);
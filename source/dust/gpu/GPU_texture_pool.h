@@ -0,0 +1,46 @@
+/* Pool of transient textures.
+ *
+ * Scratch textures (off-screen color and depth targets, per-eye XR targets, ...) are often
+ * recreated every time a region changes size. The pool keeps released textures around so that
+ * the next request with the same format, size and mip count reuses one instead of going through
+ * a new device allocation. Textures that stay unused for #GPU_TEXTURE_POOL_MAX_AGE frames are
+ * freed by #GPU_texture_pool_step.
+ *
+ * The content of an acquired texture is undefined.
+ */
+
+#pragma once
+
+#include "GPU_texture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of #GPU_texture_pool_step calls an unused texture is kept for. */
+#define GPU_TEXTURE_POOL_MAX_AGE 8
+
+/**
+ * Return a 2D texture matching the parameters, reusing a released one if possible.
+ * \a name is only used if a new texture needs to be created.
+ * Returns NULL if the allocation failed.
+ */
+GPUTexture *GPU_texture_pool_acquire(
+    const char *name, int w, int h, int mip_len, eGPUTextureFormat format);
+/**
+ * Give back a texture obtained with #GPU_texture_pool_acquire. Equivalent to #GPU_texture_free
+ * for the caller. If other references to the texture still exist it is not recycled.
+ */
+void GPU_texture_pool_release(GPUTexture *tex);
+
+/** Advance the pool by one frame and free the textures that were unused for too long. */
+void GPU_texture_pool_step(void);
+/** Free all the released textures. Acquired textures are left untouched. */
+void GPU_texture_pool_free_unused(void);
+
+/** Statistics: number of textures waiting for reuse and the memory they hold in bytes. */
+void GPU_texture_pool_stats_get(int *r_unused_len, size_t *r_unused_memory);
+
+#ifdef __cplusplus
+}
+#endif
@@ -145,6 +145,21 @@ GPU_INLINE uint GPU_vertbuf_raw_used(GPUVertBufRaw *a)
 
 void GPU_vertbuf_attr_get_raw_data(GPUVertBuf *, uint a_idx, GPUVertBufRaw *access);
 
+/**
+ * Convert \a len normals with #GPU_normal_convert_v3_array at the current position of \a access,
+ * and step past them.
+ */
+void GPU_vertbuf_raw_normals_fill(GPUVertBufRaw *access,
+                                  const float (*normals)[3],
+                                  uint len,
+                                  bool do_hq_normals);
+
+/**
+ * Fill a normal attribute from tightly packed float normals, converting them to the type of the
+ * attribute: #GPU_COMP_I10, #GPU_COMP_I16 or #GPU_COMP_F32.
+ */
+void GPU_vertbuf_attr_fill_normals(GPUVertBuf *, uint a_idx, const float (*normals)[3]);
+
 /**
  * Returns the data buffer and set it to null internally to avoid freeing.
  * \note Be careful when using this. The data needs to match the expected format.
@@ -0,0 +1,69 @@
+/* Vertex format compression.
+ *
+ * Picks compact encodings for the float attributes of a vertex format, given what each attribute
+ * holds and the error it tolerates, and repacks existing buffers to the compact format:
+ * - normals: 10_10_10_2 signed normalized integers, or 16bit ones for tighter tolerances,
+ * - texture coordinates and colors: 8bit or 16bit unsigned normalized integers.
+ * The shaders read the attributes as floats in both cases, no change is needed on their side.
+ */
+
+#pragma once
+
+#include "GPU_vertex_buffer.h"
+#include "GPU_vertex_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum eGPUVertAttrUsage {
+  /** Kept as is. */
+  GPU_VERT_ATTR_USAGE_GENERIC = 0,
+  /** Unit vectors with 3 components. */
+  GPU_VERT_ATTR_USAGE_NORMAL,
+  /** Texture coordinates inside [0..1]. */
+  GPU_VERT_ATTR_USAGE_UV,
+  /** Colors inside [0..1]. */
+  GPU_VERT_ATTR_USAGE_COLOR,
+} eGPUVertAttrUsage;
+
+typedef struct GPUVertAttrHint {
+  eGPUVertAttrUsage usage;
+  /**
+   * Largest error allowed on each component. The smallest encoding within the tolerance is
+   * used, the attribute stays a float if none is. Zero picks the usual encoding of the usage:
+   * 10_10_10_2 normals, 16bit texture coordinates and 8bit colors.
+   */
+  float tolerance;
+} GPUVertAttrHint;
+
+typedef struct GPUVertBufCompressInfo {
+  /** Size of the vertex data in bytes, before and after compression. */
+  size_t size_before;
+  size_t size_after;
+  /** Number of attributes that were given a compact encoding. */
+  int attr_compressed_len;
+} GPUVertBufCompressInfo;
+
+/**
+ * Fill \a r_format with \a format using compact encodings. \a hints has one element per attribute
+ * of \a format. Only float attributes can be compressed. Return the number of compressed
+ * attributes.
+ */
+int GPU_vertformat_compress(const GPUVertFormat *format,
+                            const GPUVertAttrHint *hints,
+                            GPUVertFormat *r_format);
+
+/**
+ * Create a copy of \a verts using the format given by #GPU_vertformat_compress. Attributes with
+ * values outside of the range of their usage are kept as floats.
+ * Return NULL if no attribute can be compressed, or if \a verts is de-interleaved.
+ * \a r_info is optional.
+ */
+GPUVertBuf *GPU_vertbuf_compress(GPUVertBuf *verts,
+                                 const GPUVertAttrHint *hints,
+                                 GPUVertBufCompressInfo *r_info);
+
+#ifdef __cplusplus
+}
+#endif
@@ -223,6 +223,16 @@ LIB_INLINE void GPU_normal_convert_v3(GPUNormal *gpu_normal,
   }
 }
 
+/**
+ * Array versions of the conversions above, vectorized where the target supports it.
+ * The \a len converted normals are written every \a dst_stride bytes from \a dst, so they can go
+ * straight into an interleaved vertex buffer. The results match the single normal conversions.
+ */
+void GPU_normal_convert_i10_v3_array(const float (*src)[3], void *dst, uint dst_stride, uint len);
+void GPU_normal_convert_i10_s3_array(const short (*src)[3], void *dst, uint dst_stride, uint len);
+void GPU_normal_convert_v3_array(
+    const float (*src)[3], void *dst, uint dst_stride, uint len, bool do_hq_normals);
+
 #ifdef __cplusplus
 }
 #endif
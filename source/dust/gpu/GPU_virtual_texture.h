@@ -0,0 +1,94 @@
+/* Virtual texturing of tile sets (UDIM).
+ *
+ * Instead of one full texture per tile, only the pages (squares of #GPU_VIRTUAL_PAGE_SIZE
+ * texels of one mip level of one tile) that are actually sampled are kept on the device:
+ * - a physical cache texture holds a fixed number of pages, recycled in least recently used order,
+ * - a page table (storage buffer) maps each virtual page to its slot in the cache,
+ * - shaders using #GPU_virtual_texture_shader_lib write the pages they miss into a feedback
+ *   buffer, read back asynchronously by #GPU_virtual_texture_update,
+ * - missing pages are produced by the owner's load callback on a background thread, then
+ *   uploaded by #GPU_virtual_texture_update.
+ *
+ * Until a page is loaded, shaders fall back to the closest coarser resident mip level. The
+ * coarsest page of every tile is loaded at creation and never evicted.
+ */
+
+#pragma once
+
+#include "GPU_shader.h"
+#include "GPU_texture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Texels per page side, excluding the border. */
+#define GPU_VIRTUAL_PAGE_SIZE 128
+/** Texels around each page copied from its neighbors, so that bilinear filtering is seamless. */
+#define GPU_VIRTUAL_PAGE_BORDER 2
+/** Feedback buffers in flight, and the most frames a page request waits for its processing. */
+#define GPU_VIRTUAL_FEEDBACK_RING_LEN 3
+/** Maximum number of page requests recorded per frame. */
+#define GPU_VIRTUAL_FEEDBACK_LEN 32768
+/** Maximum number of pages uploaded by one #GPU_virtual_texture_update call. */
+#define GPU_VIRTUAL_UPLOAD_MAX 16
+
+typedef struct GPUVirtualTexture GPUVirtualTexture;
+
+/**
+ * Write the RGBA float texels of the area of \a mip of \a tile starting at (\a x, \a y) into
+ * \a r_rgba (\a width * \a height texels, rows bottom to top). The area goes outside of the tile
+ * around its borders, in which case coordinates must be clamped.
+ * Called from a worker thread. Return false if the data is not available, the page is then
+ * filled with zeros.
+ */
+typedef bool (*GPUVirtualPageLoadFn)(
+    void *user_data, int tile, int mip, int x, int y, int width, int height, float *r_rgba);
+
+typedef struct GPUVirtualTextureStats {
+  /** Pages in the cache. */
+  int resident_len;
+  /** Pages requested and not yet uploaded. */
+  int pending_len;
+  /** Pages uploaded and evicted since creation. */
+  int loaded_len;
+  int evicted_len;
+} GPUVirtualTextureStats;
+
+/**
+ * Create a virtual texture of \a tile_len tiles of \a tile_width by \a tile_height texels with a
+ * full mip chain. \a cache_page_len is the number of pages the cache can hold, and must be larger
+ * than \a tile_len. \a load_fn and \a user_data must stay valid until the texture is freed.
+ */
+GPUVirtualTexture *GPU_virtual_texture_create(const char *name,
+                                              int tile_len,
+                                              int tile_width,
+                                              int tile_height,
+                                              eGPUTextureFormat cache_format,
+                                              int cache_page_len,
+                                              GPUVirtualPageLoadFn load_fn,
+                                              void *user_data);
+/** Waits for the page being loaded, if any. */
+void GPU_virtual_texture_free(GPUVirtualTexture *vt);
+
+/**
+ * Process the feedback of previous frames, request the missing pages and upload the loaded ones.
+ * To be called once per frame before drawing with the texture.
+ */
+void GPU_virtual_texture_update(GPUVirtualTexture *vt);
+
+/** Bind the resources and uniforms used by #GPU_virtual_texture_shader_lib to bound \a shader. */
+void GPU_virtual_texture_bind(GPUVirtualTexture *vt, GPUShader *shader);
+
+/**
+ * GLSL library to include in fragment shaders sampling a virtual texture.
+ * Provides `vec4 virtual_texture_sample(int tile, vec2 uv)`, \a uv being inside [0..1] of the
+ * tile.
+ */
+const char *GPU_virtual_texture_shader_lib(void);
+
+void GPU_virtual_texture_stats_get(GPUVirtualTexture *vt, GPUVirtualTextureStats *r_stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,96 @@
+#include "null_query.hh"
+
+#include "cpu_backend.hh"
+#include "cpu_batch.hh"
+#include "cpu_context.hh"
+#include "cpu_framebuffer.hh"
+#include "cpu_index_buffer.hh"
+#include "cpu_shader.hh"
+#include "cpu_storage_buffer.hh"
+#include "cpu_texture.hh"
+#include "cpu_uniform_buffer.hh"
+#include "cpu_vertex_buffer.hh"
+
+#include "gpu_batch_instancer_private.hh"
+#include "gpu_drawlist_indirect.hh"
+#include "gpu_render_queue_private.hh"
+
+namespace dust::gpu {
+
+void CPUBackend::compute_dispatch(int /*groups_x_len*/,
+                                  int /*groups_y_len*/,
+                                  int /*groups_z_len*/)
+{
+  /* Compute shaders are not executed. */
+}
+
+void CPUBackend::compute_dispatch_indirect(StorageBuf * /*indirect_buf*/)
+{
+}
+
+void CPUBackend::render_step()
+{
+  SamplerTable::get().frame_step();
+  RenderQueue::stats.frame_step();
+  ImmediateRing::stats.frame_step();
+  BatchInstancer::stats.frame_step();
+}
+
+Context *CPUBackend::context_alloc(void *ghost_window, void * /*ghost_context*/)
+{
+  return new CPUContext(ghost_window);
+}
+
+Batch *CPUBackend::batch_alloc()
+{
+  return new CPUBatch();
+}
+
+DrawList *CPUBackend::drawlist_alloc(int list_length)
+{
+  /* Indirect draws read their arguments back from the host copy of the storage buffer, uploading
+   * them first would only add a copy: draw the commands one by one. */
+  return new IndirectDrawList(list_length, false);
+}
+
+FrameBuffer *CPUBackend::framebuffer_alloc(const char *name)
+{
+  return new CPUFrameBuffer(name);
+}
+
+IndexBuf *CPUBackend::indexbuf_alloc()
+{
+  return new CPUIndexBuf();
+}
+
+QueryPool *CPUBackend::querypool_alloc()
+{
+  return new NullQueryPool();
+}
+
+Shader *CPUBackend::shader_alloc(const char *name)
+{
+  return new CPUShader(name);
+}
+
+Texture *CPUBackend::texture_alloc(const char *name)
+{
+  return new CPUTexture(name);
+}
+
+UniformBuf *CPUBackend::uniformbuf_alloc(int size, const char *name)
+{
+  return new CPUUniformBuf(size, name);
+}
+
+StorageBuf *CPUBackend::storagebuf_alloc(int size, GPUUsageType /*usage*/, const char *name)
+{
+  return new CPUStorageBuf(size, name);
+}
+
+VertBuf *CPUBackend::vertbuf_alloc()
+{
+  return new CPUVertBuf();
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,101 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+
+#include "GPU_batch_instancer.h"
+
+#include "gpu_context_private.hh"
+#include "gpu_storage_buffer_private.hh"
+
+#include "cpu_batch.hh"
+#include "cpu_index_buffer.hh"
+#include "cpu_rasterizer.hh"
+#include "cpu_shader.hh"
+#include "cpu_storage_buffer.hh"
+#include "cpu_vertex_buffer.hh"
+
+namespace dust::gpu {
+
+/** Look for \a name in the vertex buffers of \a batch. The first buffer using it wins. */
+static CPUVertAttrStream batch_attr_find(const Batch *batch, const char *name, bool is_instanced)
+{
+  const int vbo_len = is_instanced ? GPU_BATCH_INST_VBO_MAX_LEN : GPU_BATCH_VBO_MAX_LEN;
+  for (int v = 0; v < vbo_len; v++) {
+    CPUVertBuf *vbo = static_cast<CPUVertBuf *>(is_instanced ? batch->inst_(v) :
+                                                               batch->verts_(v));
+    if (vbo == nullptr) {
+      continue;
+    }
+    CPUVertAttrStream stream = cpu_vert_attr_stream_find(
+        &vbo->format, vbo->data_get(), vbo->vertex_len, name);
+    if (stream.is_valid()) {
+      return stream;
+    }
+  }
+  return {};
+}
+
+void CPUBatch::draw(int v_first, int v_count, int i_first, int i_count)
+{
+  imm_flush_merged();
+  Context::get()->state_manager->apply_state();
+  const CPUIndexBuf *elem = static_cast<const CPUIndexBuf *>(this->elem_());
+  this->draw_command(v_first, v_count, elem ? elem->index_base_get() : 0, i_first, i_count);
+}
+
+void CPUBatch::draw_command(int v_first, int v_count, int base_index, int i_first, int i_count)
+{
+  CPUDrawCall draw;
+  draw.prim_type = prim_type;
+  draw.pos = batch_attr_find(this, "pos", false);
+  draw.color = batch_attr_find(this, "color", false);
+  draw.uv = batch_attr_find(this, "texCoord", false);
+  draw.inst_model_matrix = batch_attr_find(this, GPU_BATCH_INSTANCER_ATTR_MATRIX, true);
+  draw.inst_color = batch_attr_find(this, GPU_BATCH_INSTANCER_ATTR_COLOR, true);
+  draw.elem = static_cast<const CPUIndexBuf *>(this->elem_());
+  draw.base_index = base_index;
+  draw.v_first = v_first;
+  draw.v_count = v_count;
+  draw.i_first = i_first;
+  draw.i_count = i_count;
+  draw.shader = static_cast<CPUShader *>(Context::get()->shader);
+  cpu_draw(draw);
+}
+
+void CPUBatch::draw_indirect(GPUStorageBuf *indirect_buf, intptr_t offset)
+{
+  this->multi_draw_indirect(indirect_buf, 1, offset, sizeof(GPUDrawCommand));
+}
+
+void CPUBatch::multi_draw_indirect(GPUStorageBuf *indirect_buf,
+                                   int count,
+                                   intptr_t offset,
+                                   intptr_t stride)
+{
+  imm_flush_merged();
+  Context::get()->state_manager->apply_state();
+
+  /* Only the arguments uploaded from the host are there, compute shaders are not executed. */
+  CPUStorageBuf *buf = static_cast<CPUStorageBuf *>(unwrap(indirect_buf));
+  const uchar *data = buf->data_get();
+  for (int i = 0; i < count; i++) {
+    const intptr_t command_offset = offset + stride * i;
+    LIB_assert(command_offset + intptr_t(sizeof(GPUDrawCommand)) <= intptr_t(buf->size_get()));
+    GPUDrawCommand command;
+    memcpy(&command, data + command_offset, sizeof(command));
+    if (this->elem_()) {
+      this->draw_command(int(command.v_first),
+                         int(command.v_count),
+                         command.base_index,
+                         int(command.i_first),
+                         int(command.i_count));
+    }
+    else {
+      /* Non-indexed commands have the first instance in place of the base index. */
+      this->draw_command(
+          int(command.v_first), int(command.v_count), 0, command.base_index, int(command.i_count));
+    }
+  }
+}
+
+}  // namespace dust::gpu
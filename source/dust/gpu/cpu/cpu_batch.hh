@@ -0,0 +1,25 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_batch_private.hh"
+
+namespace dust::gpu {
+
+/** Batch drawn by the software rasterizer. See #cpu_draw for what is supported. */
+class CPUBatch : public Batch {
+ public:
+  void draw(int v_first, int v_count, int i_first, int i_count) override;
+  void draw_indirect(GPUStorageBuf *indirect_buf, intptr_t offset) override;
+  void multi_draw_indirect(GPUStorageBuf *indirect_buf,
+                           int count,
+                           intptr_t offset,
+                           intptr_t stride) override;
+
+ private:
+  void draw_command(int v_first, int v_count, int base_index, int i_first, int i_count);
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUBatch");
+};
+
+}  // namespace dust::gpu
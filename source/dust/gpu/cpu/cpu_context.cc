@@ -0,0 +1,81 @@
+#include "LIB_assert.h"
+
+#include "null_state.hh"
+
+#include "cpu_context.hh"
+#include "cpu_framebuffer.hh"
+#include "cpu_immediate.hh"
+
+namespace dust::gpu {
+
+/* Size of the default frame-buffers. They have no attachment so what is drawn to them is
+ * discarded, but region drawing code still needs a sensible size. */
+#define CPU_WINDOW_DEFAULT_WIDTH 1920
+#define CPU_WINDOW_DEFAULT_HEIGHT 1080
+
+/* -------------------------------------------------------------------- */
+/* Constructor / Destructor */
+
+CPUContext::CPUContext(void *ghost_window)
+{
+  ghost_window_ = ghost_window;
+
+  /* Sampling is always isotropic. */
+  SamplerTable::get().init(1.0f);
+  state_manager = new NullStateManager();
+  imm = new CPUImmediate();
+
+  CPUFrameBuffer *back = new CPUFrameBuffer("back_left");
+  back->size_set(CPU_WINDOW_DEFAULT_WIDTH, CPU_WINDOW_DEFAULT_HEIGHT);
+  back->viewport_reset();
+  back->scissor_reset();
+  CPUFrameBuffer *front = new CPUFrameBuffer("front_left");
+  front->size_set(CPU_WINDOW_DEFAULT_WIDTH, CPU_WINDOW_DEFAULT_HEIGHT);
+  front->viewport_reset();
+  front->scissor_reset();
+
+  back_left = back;
+  front_left = front;
+  active_fb = back_left;
+}
+
+CPUContext::~CPUContext()
+{
+  /* Frame-buffers, state manager and immediate are freed by the base class. */
+}
+
+/* -------------------------------------------------------------------- */
+/* Activate / Deactivate context */
+
+void CPUContext::activate()
+{
+  /* Make sure no other context is already bound to this thread. */
+  LIB_assert(is_active_ == false);
+
+  is_active_ = true;
+  thread_ = pthread_self();
+
+  back_left->viewport_reset();
+  back_left->scissor_reset();
+
+  immActivate();
+}
+
+void CPUContext::deactivate()
+{
+  imm_flush_merged();
+  immDeactivate();
+  is_active_ = false;
+}
+
+/* -------------------------------------------------------------------- */
+/* Memory Management */
+
+void CPUContext::memory_statistics_get(int *total_mem, int *free_mem)
+{
+  /* Resources live in system memory, there is no dedicated pool to report. */
+  *total_mem = 0;
+  *free_mem = 0;
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_context_private.hh"
+
+namespace dust::gpu {
+
+class CPUContext : public Context {
+ public:
+  CPUContext(void *ghost_window);
+  ~CPUContext();
+
+  void activate() override;
+  void deactivate() override;
+  void begin_frame() override{};
+  void end_frame() override
+  {
+    imm_flush_merged();
+  }
+
+  /* Every operation is executed synchronously. */
+  void flush() override
+  {
+    imm_flush_merged();
+  }
+  void finish() override
+  {
+    imm_flush_merged();
+  }
+
+  void memory_statistics_get(int *total_mem, int *free_mem) override;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUContext");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,310 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+#include "LIB_string.h"
+
+#include "gpu_context_private.hh"
+
+#include "cpu_framebuffer.hh"
+#include "cpu_texture.hh"
+
+namespace dust::gpu {
+
+/* -------------------------------------------------------------------- */
+/* Creation & Deletion */
+
+CPUFrameBuffer::CPUFrameBuffer(const char *name) : FrameBuffer(name)
+{
+}
+
+CPUFrameBuffer::~CPUFrameBuffer()
+{
+  Context *ctx = Context::get();
+  if (ctx && ctx->active_fb == this) {
+    ctx->active_fb = nullptr;
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Config */
+
+CPUTexture *CPUFrameBuffer::attachment_get(GPUAttachmentType type, int *r_mip, int *r_layer) const
+{
+  const GPUAttachment &attach = attachments_[type];
+  if (attach.tex == nullptr) {
+    return nullptr;
+  }
+  *r_mip = attach.mip;
+  *r_layer = max_ii(0, attach.layer);
+  return static_cast<CPUTexture *>(unwrap(attach.tex));
+}
+
+CPUTexture *CPUFrameBuffer::depth_attachment_get(int *r_mip, int *r_layer) const
+{
+  CPUTexture *tex = this->attachment_get(GPU_FB_DEPTH_ATTACHMENT, r_mip, r_layer);
+  if (tex == nullptr) {
+    tex = this->attachment_get(GPU_FB_DEPTH_STENCIL_ATTACHMENT, r_mip, r_layer);
+  }
+  return tex;
+}
+
+void CPUFrameBuffer::update_attachments()
+{
+  for (GPUAttachmentType type = GPU_FB_MAX_ATTACHMENT - 1; type >= 0; --type) {
+    const GPUAttachment &attach = attachments_[type];
+    if (attach.tex == nullptr) {
+      continue;
+    }
+    int size[3];
+    unwrap(attach.tex)->mip_size_get(attach.mip, size);
+    this->size_set(size[0], size[1]);
+  }
+  dirty_attachments_ = false;
+}
+
+bool CPUFrameBuffer::check(char err_out[256])
+{
+  this->bind(true);
+
+  int size[2] = {-1, -1};
+  const char *err = nullptr;
+
+  for (const GPUAttachment &attach : attachments_) {
+    if (attach.tex == nullptr) {
+      continue;
+    }
+    int mip_size[3];
+    unwrap(attach.tex)->mip_size_get(attach.mip, mip_size);
+    if (size[0] == -1) {
+      size[0] = mip_size[0];
+      size[1] = mip_size[1];
+    }
+    else if (size[0] != mip_size[0] || size[1] != mip_size[1]) {
+      err = "Attachments have different sizes";
+      break;
+    }
+  }
+
+  if (err) {
+    const char *format = "GPUFrameBuffer: %s framebuffer incomplete: %s\n";
+    if (err_out) {
+      LIB_snprintf(err_out, 256, format, name_, err);
+    }
+    else {
+      fprintf(stderr, format, name_, err);
+    }
+    return false;
+  }
+  return true;
+}
+
+void CPUFrameBuffer::bind(bool /*enabled_srgb*/)
+{
+  imm_flush_merged();
+  if (dirty_attachments_) {
+    this->update_attachments();
+    this->viewport_reset();
+    this->scissor_reset();
+  }
+  Context::get()->active_fb = this;
+  dirty_state_ = false;
+}
+
+/* -------------------------------------------------------------------- */
+/* Operations */
+
+void CPUFrameBuffer::clear_area_get(int r_area[4]) const
+{
+  if (scissor_test_) {
+    r_area[0] = clamp_i(scissor_[0], 0, width_);
+    r_area[1] = clamp_i(scissor_[1], 0, height_);
+    r_area[2] = clamp_i(scissor_[0] + scissor_[2], 0, width_) - r_area[0];
+    r_area[3] = clamp_i(scissor_[1] + scissor_[3], 0, height_) - r_area[1];
+  }
+  else {
+    r_area[0] = r_area[1] = 0;
+    r_area[2] = width_;
+    r_area[3] = height_;
+  }
+}
+
+void CPUFrameBuffer::clear(eGPUFrameBufferBits buffers,
+                           const float clear_col[4],
+                           float clear_depth,
+                           uint /*clear_stencil*/)
+{
+  imm_flush_merged();
+  LIB_assert(Context::get()->active_fb == this);
+  int area[4];
+  this->clear_area_get(area);
+  if (area[2] <= 0 || area[3] <= 0) {
+    return;
+  }
+
+  int mip, layer;
+  if (buffers & GPU_COLOR_BIT) {
+    for (int slot = 0; slot < GPU_FB_MAX_COLOR_ATTACHMENT; slot++) {
+      CPUTexture *tex = this->attachment_get(GPU_FB_COLOR_ATTACHMENT0 + slot, &mip, &layer);
+      if (tex) {
+        tex->clear_area(mip, layer, area, GPU_DATA_FLOAT, clear_col);
+      }
+    }
+  }
+  if (buffers & GPU_DEPTH_BIT) {
+    CPUTexture *tex = this->depth_attachment_get(&mip, &layer);
+    if (tex) {
+      tex->clear_area(mip, layer, area, GPU_DATA_FLOAT, &clear_depth);
+    }
+  }
+  /* Stencil is not supported. */
+}
+
+void CPUFrameBuffer::clear_multi(const float (*clear_col)[4])
+{
+  imm_flush_merged();
+  int area[4];
+  this->clear_area_get(area);
+  if (area[2] <= 0 || area[3] <= 0) {
+    return;
+  }
+  int mip, layer;
+  for (int slot = 0; slot < GPU_FB_MAX_COLOR_ATTACHMENT; slot++) {
+    CPUTexture *tex = this->attachment_get(GPU_FB_COLOR_ATTACHMENT0 + slot, &mip, &layer);
+    if (tex) {
+      tex->clear_area(mip, layer, area, GPU_DATA_FLOAT, clear_col[slot]);
+    }
+  }
+}
+
+void CPUFrameBuffer::clear_attachment(GPUAttachmentType type,
+                                      eGPUDataFormat data_format,
+                                      const void *clear_value)
+{
+  imm_flush_merged();
+  int area[4];
+  this->clear_area_get(area);
+  int mip, layer;
+  CPUTexture *tex = this->attachment_get(type, &mip, &layer);
+  if (tex == nullptr || area[2] <= 0 || area[3] <= 0) {
+    return;
+  }
+  if (type == GPU_FB_DEPTH_STENCIL_ATTACHMENT && data_format == GPU_DATA_UINT_24_8) {
+    tex->clear_area(mip, layer, area, data_format, clear_value);
+  }
+  else if (type == GPU_FB_DEPTH_STENCIL_ATTACHMENT || type == GPU_FB_DEPTH_ATTACHMENT) {
+    /* Same as the other back-ends: the clear value is a float depth. */
+    tex->clear_area(mip, layer, area, GPU_DATA_FLOAT, clear_value);
+  }
+  else {
+    tex->clear_area(mip, layer, area, data_format, clear_value);
+  }
+}
+
+void CPUFrameBuffer::attachment_set_loadstore_op(GPUAttachmentType /*type*/,
+                                                 eGPULoadOp /*load_action*/,
+                                                 eGPUStoreOp /*store_action*/)
+{
+  /* Nothing to do, attachments are always loaded and stored. */
+}
+
+void CPUFrameBuffer::read(eGPUFrameBufferBits planes,
+                          eGPUDataFormat format,
+                          const int area[4],
+                          int channel_len,
+                          int slot,
+                          void *r_data)
+{
+  imm_flush_merged();
+  LIB_assert((planes & GPU_STENCIL_BIT) == 0);
+  LIB_assert(area[2] > 0 && area[3] > 0);
+
+  int mip, layer;
+  CPUTexture *tex = nullptr;
+  if (planes & GPU_COLOR_BIT) {
+    tex = this->attachment_get(GPU_FB_COLOR_ATTACHMENT0 + slot, &mip, &layer);
+  }
+  else if (planes & GPU_DEPTH_BIT) {
+    tex = this->depth_attachment_get(&mip, &layer);
+  }
+
+  if (tex == nullptr) {
+    /* Window frame-buffers have no storage. */
+    memset(r_data, 0, size_t(area[2]) * area[3] * channel_len * to_bytesize(format));
+    return;
+  }
+  LIB_assert(area[0] >= 0 && area[1] >= 0);
+  LIB_assert(area[0] + area[2] <= width_ && area[1] + area[3] <= height_);
+  tex->read_area(mip, layer, area, channel_len, format, r_data);
+}
+
+/** Copy the whole mip of \a src to \a dst at the given offset, clipped to the size of \a dst. */
+static void blit_texture(CPUTexture *src,
+                         int src_mip,
+                         int src_layer,
+                         CPUTexture *dst,
+                         int dst_mip,
+                         int dst_layer,
+                         int dst_offset_x,
+                         int dst_offset_y)
+{
+  const int src_w = src->mip_width_get(src_mip), src_h = src->mip_height_get(src_mip);
+  const int dst_w = dst->mip_width_get(dst_mip), dst_h = dst->mip_height_get(dst_mip);
+  const int x_min = max_ii(0, -dst_offset_x);
+  const int y_min = max_ii(0, -dst_offset_y);
+  const int x_max = min_ii(src_w, dst_w - dst_offset_x);
+  const int y_max = min_ii(src_h, dst_h - dst_offset_y);
+  if (x_min >= x_max || y_min >= y_max) {
+    return;
+  }
+
+  const int src_channel_len = src->channel_len();
+  const int dst_channel_len = dst->channel_len();
+  const int channel_len = min_ii(src_channel_len, dst_channel_len);
+  for (int y = y_min; y < y_max; y++) {
+    const float *src_texel = src->texel_get(src_mip, x_min, y, src_layer);
+    float *dst_texel = dst->texel_get(dst_mip, x_min + dst_offset_x, y + dst_offset_y, dst_layer);
+    if (src_channel_len == dst_channel_len) {
+      memcpy(dst_texel, src_texel, sizeof(float) * (x_max - x_min) * channel_len);
+      continue;
+    }
+    for (int x = x_min; x < x_max; x++) {
+      memcpy(dst_texel, src_texel, sizeof(float) * channel_len);
+      src_texel += src_channel_len;
+      dst_texel += dst_channel_len;
+    }
+  }
+}
+
+void CPUFrameBuffer::blit_to(eGPUFrameBufferBits planes,
+                             int src_slot,
+                             FrameBuffer *dst_,
+                             int dst_slot,
+                             int dst_offset_x,
+                             int dst_offset_y)
+{
+  imm_flush_merged();
+  CPUFrameBuffer *dst = static_cast<CPUFrameBuffer *>(dst_);
+  int src_mip, src_layer, dst_mip, dst_layer;
+
+  if (planes & GPU_COLOR_BIT) {
+    CPUTexture *src_tex = this->attachment_get(
+        GPU_FB_COLOR_ATTACHMENT0 + src_slot, &src_mip, &src_layer);
+    CPUTexture *dst_tex = dst->attachment_get(
+        GPU_FB_COLOR_ATTACHMENT0 + dst_slot, &dst_mip, &dst_layer);
+    if (src_tex && dst_tex) {
+      blit_texture(
+          src_tex, src_mip, src_layer, dst_tex, dst_mip, dst_layer, dst_offset_x, dst_offset_y);
+    }
+  }
+  if (planes & GPU_DEPTH_BIT) {
+    CPUTexture *src_tex = this->depth_attachment_get(&src_mip, &src_layer);
+    CPUTexture *dst_tex = dst->depth_attachment_get(&dst_mip, &dst_layer);
+    if (src_tex && dst_tex) {
+      blit_texture(
+          src_tex, src_mip, src_layer, dst_tex, dst_mip, dst_layer, dst_offset_x, dst_offset_y);
+    }
+  }
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_framebuffer_private.hh"
+
+namespace dust::gpu {
+
+class CPUTexture;
+
+/**
+ * Frame-buffer of the CPU back-end. All operations work on the attached #CPUTexture.
+ * Frame-buffers without attachments (like the window ones) silently discard what is drawn.
+ */
+class CPUFrameBuffer : public FrameBuffer {
+ public:
+  CPUFrameBuffer(const char *name);
+  ~CPUFrameBuffer();
+
+  void bind(bool enabled_srgb) override;
+  bool check(char err_out[256]) override;
+  void clear(eGPUFrameBufferBits buffers,
+             const float clear_col[4],
+             float clear_depth,
+             uint clear_stencil) override;
+  void clear_multi(const float (*clear_col)[4]) override;
+  void clear_attachment(GPUAttachmentType type,
+                        eGPUDataFormat data_format,
+                        const void *clear_value) override;
+
+  void attachment_set_loadstore_op(GPUAttachmentType type,
+                                   eGPULoadOp load_action,
+                                   eGPUStoreOp store_action) override;
+
+  void read(eGPUFrameBufferBits planes,
+            eGPUDataFormat format,
+            const int area[4],
+            int channel_len,
+            int slot,
+            void *r_data) override;
+
+  void blit_to(eGPUFrameBufferBits planes,
+               int src_slot,
+               FrameBuffer *dst,
+               int dst_slot,
+               int dst_offset_x,
+               int dst_offset_y) override;
+
+  /** Return the texture attached to \a type and the mip and layer to render to. */
+  CPUTexture *attachment_get(GPUAttachmentType type, int *r_mip, int *r_layer) const;
+  /** Same as #attachment_get for the depth or depth-stencil attachment. */
+  CPUTexture *depth_attachment_get(int *r_mip, int *r_layer) const;
+
+  int width_get() const
+  {
+    return width_;
+  }
+  int height_get() const
+  {
+    return height_;
+  }
+
+ private:
+  /** Update the size from the attachments. */
+  void update_attachments();
+  /** Region affected by clears: the whole frame-buffer or the scissor if enabled. */
+  void clear_area_get(int r_area[4]) const;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUFrameBuffer");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,30 @@
+#include "gpu_context_private.hh"
+#include "gpu_shader_private.hh"
+#include "gpu_vertex_format_private.hh"
+
+#include "cpu_immediate.hh"
+#include "cpu_rasterizer.hh"
+#include "cpu_shader.hh"
+
+namespace dust::gpu {
+
+void CPUImmediate::draw(GPUPrimType prim_type,
+                        GPUShader *shader,
+                        const GPUVertFormat *format,
+                        const uchar *data,
+                        uint vertex_len)
+{
+  Context::get()->state_manager->apply_state();
+
+  CPUDrawCall draw;
+  draw.prim_type = prim_type;
+  draw.pos = cpu_vert_attr_stream_find(format, data, vertex_len, "pos");
+  draw.color = cpu_vert_attr_stream_find(format, data, vertex_len, "color");
+  draw.uv = cpu_vert_attr_stream_find(format, data, vertex_len, "texCoord");
+  draw.v_first = 0;
+  draw.v_count = int(vertex_len);
+  draw.shader = static_cast<CPUShader *>(unwrap(shader));
+  cpu_draw(draw);
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_immediate_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Immediate mode writing vertices into a host ring, rasterized as soon as a draw is flushed.
+ * The vertices are consumed synchronously so the ring never waits.
+ */
+class CPUImmediate : public Immediate {
+ public:
+  CPUImmediate()
+  {
+    ring = new ImmediateRing();
+  };
+
+ protected:
+  void draw(GPUPrimType prim_type,
+            GPUShader *shader,
+            const GPUVertFormat *format,
+            const uchar *data,
+            uint vertex_len) override;
+
+ public:
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUImmediate");
+};
+
+}  // namespace dust::gpu
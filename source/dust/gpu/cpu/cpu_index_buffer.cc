@@ -0,0 +1,41 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+
+#include "cpu_index_buffer.hh"
+
+namespace dust::gpu {
+
+void CPUIndexBuf::upload_data()
+{
+  /* The host data is used directly. */
+}
+
+void CPUIndexBuf::bind_as_ssbo(uint /*binding*/)
+{
+}
+
+const uint32_t *CPUIndexBuf::read() const
+{
+  LIB_assert(!is_subrange_);
+  return data_;
+}
+
+void CPUIndexBuf::update_sub(uint start, uint len, const void *data)
+{
+  LIB_assert(!is_subrange_ && data_ != nullptr);
+  LIB_assert(start + len <= this->size_get());
+  memcpy((uchar *)data_ + start, data, len);
+}
+
+const void *CPUIndexBuf::index_data_get() const
+{
+  if (is_subrange_) {
+    const CPUIndexBuf *src = static_cast<const CPUIndexBuf *>(src_);
+    const size_t index_size = this->is_u16() ? sizeof(uint16_t) : sizeof(uint32_t);
+    return static_cast<const uchar *>(src->index_data_get()) + index_start_ * index_size;
+  }
+  return data_;
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_index_buffer_private.hh"
+
+namespace dust::gpu {
+
+/** Index buffer living in system memory. Sub-ranges read the data of their source. */
+class CPUIndexBuf : public IndexBuf {
+ public:
+  void upload_data() override;
+  void bind_as_ssbo(uint binding) override;
+
+  const uint32_t *read() const override;
+
+  void update_sub(uint start, uint len, const void *data) override;
+
+  /** First index of this buffer inside #index_data_get(). */
+  const void *index_data_get() const;
+  bool is_u16() const
+  {
+    return index_type_ == GPU_INDEX_U16;
+  }
+  /** Index value marking a primitive restart. */
+  uint32_t restart_index_get() const
+  {
+    return this->is_u16() ? 0xFFFFu : 0xFFFFFFFFu;
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUIndexBuf");
+};
+
+}  // namespace dust::gpu
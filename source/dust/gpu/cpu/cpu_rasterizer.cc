@@ -0,0 +1,1080 @@
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#include "LIB_assert.h"
+#include "LIB_index_range.hh"
+#include "LIB_math_base.h"
+#include "LIB_math_matrix.h"
+#include "LIB_math_vector.h"
+#include "LIB_task.hh"
+#include "LIB_utildefines.h"
+#include "LIB_vector.hh"
+
+#include "gpu_context_private.hh"
+#include "gpu_shader_interface.hh"
+
+#include "null_state.hh"
+
+#include "cpu_framebuffer.hh"
+#include "cpu_index_buffer.hh"
+#include "cpu_rasterizer.hh"
+#include "cpu_shader.hh"
+#include "cpu_texture.hh"
+
+namespace dust::gpu {
+
+/* Tile size in pixels. Big enough to amortize the binning, small enough to balance the threads
+ * on small previews. */
+#define CPU_TILE_SIZE 64
+
+/* Number of vertices transformed by each task. */
+#define CPU_VERTEX_GRAIN_SIZE 4096
+
+/* -------------------------------------------------------------------- */
+/* Vertex Fetch */
+
+template<typename T>
+static void fetch_components(const uchar *src, int comp_len, float normalize, float r_value[4])
+{
+  for (int c = 0; c < comp_len; c++) {
+    T value;
+    memcpy(&value, src + c * sizeof(T), sizeof(T));
+    r_value[c] = (normalize != 0.0f) ? max_ff(float(value) / normalize, -1.0f) : float(value);
+  }
+}
+
+void CPUVertAttrStream::fetch(uint index, float r_value[4]) const
+{
+  r_value[0] = r_value[1] = r_value[2] = 0.0f;
+  r_value[3] = 1.0f;
+  if (index >= len) {
+    return;
+  }
+  const uchar *src = data + size_t(index) * stride;
+  const int comp_len = min_ii(attr.comp_len, 4);
+  const bool normalize = (attr.fetch_mode == GPU_FETCH_INT_TO_FLOAT_UNIT);
+
+  switch (attr.comp_type) {
+    case GPU_COMP_F32:
+      memcpy(r_value, src, sizeof(float) * comp_len);
+      break;
+    case GPU_COMP_U8:
+      fetch_components<uint8_t>(src, comp_len, normalize ? 255.0f : 0.0f, r_value);
+      break;
+    case GPU_COMP_I8:
+      fetch_components<int8_t>(src, comp_len, normalize ? 127.0f : 0.0f, r_value);
+      break;
+    case GPU_COMP_U16:
+      fetch_components<uint16_t>(src, comp_len, normalize ? 65535.0f : 0.0f, r_value);
+      break;
+    case GPU_COMP_I16:
+      fetch_components<int16_t>(src, comp_len, normalize ? 32767.0f : 0.0f, r_value);
+      break;
+    case GPU_COMP_U32:
+      fetch_components<uint32_t>(src, comp_len, normalize ? 4294967295.0f : 0.0f, r_value);
+      break;
+    case GPU_COMP_I32:
+      fetch_components<int32_t>(src, comp_len, normalize ? 2147483647.0f : 0.0f, r_value);
+      break;
+    case GPU_COMP_I10: {
+      GPUPackedNormal packed;
+      memcpy(&packed, src, sizeof(packed));
+      const float scale = normalize ? 1.0f / 511.0f : 1.0f;
+      r_value[0] = max_ff(packed.x * scale, -1.0f);
+      r_value[1] = max_ff(packed.y * scale, -1.0f);
+      r_value[2] = max_ff(packed.z * scale, -1.0f);
+      r_value[3] = float(packed.w);
+      break;
+    }
+  }
+}
+
+void CPUVertAttrStream::fetch_matrix(uint index, float r_value[4][4]) const
+{
+  if (index >= len || attr.comp_type != GPU_COMP_F32 || attr.comp_len != 16) {
+    unit_m4(r_value);
+    return;
+  }
+  memcpy(r_value, data + size_t(index) * stride, sizeof(float[4][4]));
+}
+
+CPUVertAttrStream cpu_vert_attr_stream_find(const GPUVertFormat *format,
+                                            const uchar *data,
+                                            uint vertex_len,
+                                            const char *name)
+{
+  CPUVertAttrStream stream;
+  if (data == nullptr) {
+    return stream;
+  }
+  uint offset = 0;
+  for (uint a_idx = 0; a_idx < format->attr_len; a_idx++) {
+    const GPUVertAttr *attr = &format->attrs[a_idx];
+    if (format->deinterleaved) {
+      offset += ((a_idx == 0) ? 0 : format->attrs[a_idx - 1].size) * vertex_len;
+    }
+    else {
+      offset = attr->offset;
+    }
+    for (uint n_idx = 0; n_idx < attr->name_len; n_idx++) {
+      if (STREQ(GPU_vertformat_attr_name_get(format, attr, n_idx), name)) {
+        stream.data = data + offset;
+        stream.stride = format->deinterleaved ? attr->size : format->stride;
+        stream.len = vertex_len;
+        stream.attr = *attr;
+        return stream;
+      }
+    }
+  }
+  return stream;
+}
+
+/* -------------------------------------------------------------------- */
+/* Pipeline Data */
+
+/** Vertex after the vertex stage. */
+struct RasterVert {
+  /** Clip space position. */
+  float clip[4];
+  /** Window space position and depth. Only valid if the vertex is inside the clip volume. */
+  float x, y, z;
+  float inv_w;
+  float color[4];
+  float uv[2];
+};
+
+enum RasterPrimType : uint8_t {
+  RASTER_POINT = 0,
+  RASTER_LINE,
+  RASTER_TRIANGLE,
+};
+
+/** Primitive ready to be rasterized. */
+struct RasterPrim {
+  uint32_t v[3];
+  RasterPrimType type;
+  /** Bit per edge, set if the edge is a top or left edge. */
+  uint8_t top_left;
+  /** Pixel bounds: `{xmin, ymin, xmax, ymax}`, max excluded. */
+  int bounds[4];
+  /** Edge functions `A * x + B * y + C` of the edge opposite to each vertex. */
+  float edge[3][3];
+  float inv_area;
+};
+
+/** Shared, read-only data used by all the tiles. */
+struct RasterContext {
+  const RasterVert *verts;
+
+  CPUTexture *color_tex = nullptr;
+  int color_mip = 0, color_layer = 0;
+  CPUTexture *depth_tex = nullptr;
+  int depth_mip = 0, depth_layer = 0;
+
+  eGPUWriteMask write_mask;
+  eGPUBlend blend;
+  eGPUDepthTest depth_test;
+  eGPUFaceCullTest culling_test;
+  bool invert_facing;
+  float point_size;
+
+  bool has_color_attr;
+  bool has_uv_attr;
+  float uniform_color[4];
+  CPUTexture *image = nullptr;
+  const SamplerState *sampler = nullptr;
+
+  /** Pixels that can be written: viewport, scissor and target size. `{xmin, ymin, xmax, ymax}`. */
+  int clip_rect[4];
+  /** Viewport transform. */
+  float viewport[4];
+};
+
+/* -------------------------------------------------------------------- */
+/* Vertex Stage */
+
+static void draw_matrix_get(const CPUShader *shader, float r_mvp[4][4])
+{
+  unit_m4(r_mvp);
+  const ShaderInterface *interface = shader->interface;
+  if (interface == nullptr) {
+    return;
+  }
+  if (shader->uniform_get(interface->uniform_builtin(GPU_UNIFORM_MVP), 16, &r_mvp[0][0])) {
+    return;
+  }
+  /* Shaders using the separate matrices. */
+  float model[4][4], view_projection[4][4];
+  unit_m4(model);
+  unit_m4(view_projection);
+  bool found = shader->uniform_get(
+      interface->uniform_builtin(GPU_UNIFORM_VIEWPROJECTION), 16, &view_projection[0][0]);
+  found |= shader->uniform_get(interface->uniform_builtin(GPU_UNIFORM_MODEL), 16, &model[0][0]);
+  if (found) {
+    mul_m4_m4m4(r_mvp, view_projection, model);
+  }
+}
+
+static void vertex_window_coords(const RasterContext &ctx, RasterVert &v)
+{
+  const float inv_w = 1.0f / v.clip[3];
+  v.inv_w = inv_w;
+  v.x = (v.clip[0] * inv_w * 0.5f + 0.5f) * ctx.viewport[2] + ctx.viewport[0];
+  v.y = (v.clip[1] * inv_w * 0.5f + 0.5f) * ctx.viewport[3] + ctx.viewport[1];
+  v.z = v.clip[2] * inv_w * 0.5f + 0.5f;
+}
+
+/** Signed distance to the near and far clip planes. Positive inside. */
+static inline float clip_distance(const RasterVert &v, int plane)
+{
+  return (plane == 0) ? (v.clip[3] + v.clip[2]) : (v.clip[3] - v.clip[2]);
+}
+
+static inline bool vertex_is_inside(const RasterVert &v)
+{
+  return clip_distance(v, 0) >= 0.0f && clip_distance(v, 1) >= 0.0f && v.clip[3] > 0.0f;
+}
+
+static RasterVert vertex_interpolate(const RasterContext &ctx,
+                                     const RasterVert &a,
+                                     const RasterVert &b,
+                                     float t)
+{
+  RasterVert v;
+  for (int i = 0; i < 4; i++) {
+    v.clip[i] = a.clip[i] + (b.clip[i] - a.clip[i]) * t;
+    v.color[i] = a.color[i] + (b.color[i] - a.color[i]) * t;
+  }
+  for (int i = 0; i < 2; i++) {
+    v.uv[i] = a.uv[i] + (b.uv[i] - a.uv[i]) * t;
+  }
+  vertex_window_coords(ctx, v);
+  return v;
+}
+
+/* -------------------------------------------------------------------- */
+/* Primitive Setup */
+
+/**
+ * Edge function of the edge going from \a p to \a q, positive on its left.
+ * Computed from the vertices sorted in a fixed order so that two triangles sharing an edge get
+ * exactly opposite values, which guarantees no gaps or double hits between them.
+ */
+static void edge_setup(const RasterVert &p, const RasterVert &q, float r_edge[3])
+{
+  const bool swap = (p.x > q.x) || (p.x == q.x && p.y > q.y);
+  const RasterVert &a = swap ? q : p;
+  const RasterVert &b = swap ? p : q;
+  float A = a.y - b.y;
+  float B = b.x - a.x;
+  float C = -(A * a.x + B * a.y);
+  if (swap) {
+    A = -A;
+    B = -B;
+    C = -C;
+  }
+  r_edge[0] = A;
+  r_edge[1] = B;
+  r_edge[2] = C;
+}
+
+static void bounds_clip(const RasterContext &ctx, const float min[2], const float max[2], int r[4])
+{
+  r[0] = max_ii(ctx.clip_rect[0], int(floorf(min[0])));
+  r[1] = max_ii(ctx.clip_rect[1], int(floorf(min[1])));
+  r[2] = min_ii(ctx.clip_rect[2], int(ceilf(max[0])));
+  r[3] = min_ii(ctx.clip_rect[3], int(ceilf(max[1])));
+}
+
+static bool bounds_is_empty(const int bounds[4])
+{
+  return bounds[0] >= bounds[2] || bounds[1] >= bounds[3];
+}
+
+static void triangle_setup(const RasterContext &ctx,
+                           Vector<RasterVert> &verts,
+                           uint32_t i0,
+                           uint32_t i1,
+                           uint32_t i2,
+                           Vector<RasterPrim> &r_prims)
+{
+  const RasterVert *a = &verts[i0], *b = &verts[i1], *c = &verts[i2];
+  const float area = (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
+  if (!(area != 0.0f) || !isfinite(area)) {
+    return;
+  }
+  /* Counter-clockwise is front facing, like the default of the other back-ends. */
+  const bool is_front = (area > 0.0f) != ctx.invert_facing;
+  if ((ctx.culling_test == GPU_CULL_BACK && !is_front) ||
+      (ctx.culling_test == GPU_CULL_FRONT && is_front))
+  {
+    return;
+  }
+  if (area < 0.0f) {
+    SWAP(uint32_t, i1, i2);
+    SWAP(const RasterVert *, b, c);
+  }
+
+  RasterPrim prim;
+  prim.type = RASTER_TRIANGLE;
+  prim.v[0] = i0;
+  prim.v[1] = i1;
+  prim.v[2] = i2;
+  prim.inv_area = 1.0f / fabsf(area);
+
+  const float min[2] = {min_fff(a->x, b->x, c->x), min_fff(a->y, b->y, c->y)};
+  const float max[2] = {max_fff(a->x, b->x, c->x), max_fff(a->y, b->y, c->y)};
+  bounds_clip(ctx, min, max, prim.bounds);
+  if (bounds_is_empty(prim.bounds)) {
+    return;
+  }
+
+  edge_setup(*b, *c, prim.edge[0]);
+  edge_setup(*c, *a, prim.edge[1]);
+  edge_setup(*a, *b, prim.edge[2]);
+  prim.top_left = 0;
+  for (int e = 0; e < 3; e++) {
+    /* With Y up and counter-clockwise winding, left edges go down and top edges go left. */
+    const float A = prim.edge[e][0], B = prim.edge[e][1];
+    if (A > 0.0f || (A == 0.0f && B < 0.0f)) {
+      prim.top_left |= 1 << e;
+    }
+  }
+  r_prims.append(prim);
+}
+
+/** Clip a polygon against the near and far planes. Return the new vertex count. */
+static int polygon_clip(const RasterContext &ctx, RasterVert *poly, int poly_len)
+{
+  RasterVert tmp[8];
+  for (int plane = 0; plane < 2; plane++) {
+    int out_len = 0;
+    for (int i = 0; i < poly_len; i++) {
+      const RasterVert &cur = poly[i];
+      const RasterVert &next = poly[(i + 1) % poly_len];
+      const float d_cur = clip_distance(cur, plane);
+      const float d_next = clip_distance(next, plane);
+      if (d_cur >= 0.0f) {
+        tmp[out_len++] = cur;
+      }
+      if ((d_cur >= 0.0f) != (d_next >= 0.0f)) {
+        tmp[out_len++] = vertex_interpolate(ctx, cur, next, d_cur / (d_cur - d_next));
+      }
+    }
+    poly_len = out_len;
+    memcpy(poly, tmp, sizeof(RasterVert) * out_len);
+    if (poly_len < 3) {
+      return 0;
+    }
+  }
+  return poly_len;
+}
+
+static void triangle_assemble(const RasterContext &ctx,
+                              Vector<RasterVert> &verts,
+                              uint32_t i0,
+                              uint32_t i1,
+                              uint32_t i2,
+                              Vector<RasterPrim> &r_prims)
+{
+  if (vertex_is_inside(verts[i0]) && vertex_is_inside(verts[i1]) && vertex_is_inside(verts[i2])) {
+    triangle_setup(ctx, verts, i0, i1, i2, r_prims);
+    return;
+  }
+  /* Slow path, the triangle crosses the near or far plane. */
+  RasterVert poly[8] = {verts[i0], verts[i1], verts[i2]};
+  const int poly_len = polygon_clip(ctx, poly, 3);
+  if (poly_len == 0) {
+    return;
+  }
+  const uint32_t first = uint32_t(verts.size());
+  for (int i = 0; i < poly_len; i++) {
+    verts.append(poly[i]);
+  }
+  for (int i = 1; i + 1 < poly_len; i++) {
+    triangle_setup(ctx, verts, first, first + i, first + i + 1, r_prims);
+  }
+}
+
+static void line_assemble(const RasterContext &ctx,
+                          Vector<RasterVert> &verts,
+                          uint32_t i0,
+                          uint32_t i1,
+                          Vector<RasterPrim> &r_prims)
+{
+  if (!vertex_is_inside(verts[i0]) || !vertex_is_inside(verts[i1])) {
+    RasterVert a = verts[i0], b = verts[i1];
+    for (int plane = 0; plane < 2; plane++) {
+      const float d_a = clip_distance(a, plane), d_b = clip_distance(b, plane);
+      if (d_a < 0.0f && d_b < 0.0f) {
+        return;
+      }
+      if (d_a < 0.0f) {
+        a = vertex_interpolate(ctx, a, b, d_a / (d_a - d_b));
+      }
+      else if (d_b < 0.0f) {
+        b = vertex_interpolate(ctx, b, a, d_b / (d_b - d_a));
+      }
+    }
+    i0 = uint32_t(verts.size());
+    i1 = i0 + 1;
+    verts.append(a);
+    verts.append(b);
+  }
+  const RasterVert &a = verts[i0], &b = verts[i1];
+
+  RasterPrim prim;
+  prim.type = RASTER_LINE;
+  prim.v[0] = i0;
+  prim.v[1] = i1;
+  prim.v[2] = i1;
+  const float min[2] = {min_ff(a.x, b.x), min_ff(a.y, b.y)};
+  const float max[2] = {max_ff(a.x, b.x) + 1.0f, max_ff(a.y, b.y) + 1.0f};
+  bounds_clip(ctx, min, max, prim.bounds);
+  if (!bounds_is_empty(prim.bounds)) {
+    r_prims.append(prim);
+  }
+}
+
+static void point_assemble(const RasterContext &ctx,
+                           const Vector<RasterVert> &verts,
+                           uint32_t i0,
+                           Vector<RasterPrim> &r_prims)
+{
+  const RasterVert &v = verts[i0];
+  if (!vertex_is_inside(v)) {
+    return;
+  }
+  RasterPrim prim;
+  prim.type = RASTER_POINT;
+  prim.v[0] = prim.v[1] = prim.v[2] = i0;
+  const float radius = ctx.point_size * 0.5f;
+  const float min[2] = {v.x - radius + 0.5f, v.y - radius + 0.5f};
+  const float max[2] = {v.x + radius + 0.5f, v.y + radius + 0.5f};
+  bounds_clip(ctx, min, max, prim.bounds);
+  if (!bounds_is_empty(prim.bounds)) {
+    r_prims.append(prim);
+  }
+}
+
+/** Build the primitives from the vertex indices. #RESTART_INDEX starts a new strip or fan. */
+#define RESTART_INDEX 0xFFFFFFFFu
+
+static void primitives_assemble(const RasterContext &ctx,
+                                GPUPrimType prim_type,
+                                Span<uint32_t> indices,
+                                Vector<RasterVert> &verts,
+                                Vector<RasterPrim> &r_prims)
+{
+  /* Vertices of the current strip, fan or list since the last restart. */
+  uint32_t v[3];
+  int v_len = 0;
+  uint32_t loop_first = RESTART_INDEX, loop_last = RESTART_INDEX;
+  bool strip_odd = false;
+
+  auto close_loop = [&]() {
+    if (prim_type == GPU_PRIM_LINE_LOOP && loop_first != loop_last) {
+      line_assemble(ctx, verts, loop_last, loop_first, r_prims);
+    }
+    loop_first = loop_last = RESTART_INDEX;
+  };
+
+  for (const uint32_t index : indices) {
+    if (index == RESTART_INDEX) {
+      close_loop();
+      v_len = 0;
+      strip_odd = false;
+      continue;
+    }
+    switch (prim_type) {
+      case GPU_PRIM_POINTS:
+        point_assemble(ctx, verts, index, r_prims);
+        break;
+      case GPU_PRIM_LINES:
+        v[v_len++] = index;
+        if (v_len == 2) {
+          line_assemble(ctx, verts, v[0], v[1], r_prims);
+          v_len = 0;
+        }
+        break;
+      case GPU_PRIM_LINE_STRIP:
+      case GPU_PRIM_LINE_LOOP:
+        if (loop_first == RESTART_INDEX) {
+          loop_first = index;
+        }
+        else {
+          line_assemble(ctx, verts, loop_last, index, r_prims);
+        }
+        loop_last = index;
+        break;
+      case GPU_PRIM_TRIS:
+        v[v_len++] = index;
+        if (v_len == 3) {
+          triangle_assemble(ctx, verts, v[0], v[1], v[2], r_prims);
+          v_len = 0;
+        }
+        break;
+      case GPU_PRIM_TRI_STRIP:
+        if (v_len < 2) {
+          v[v_len++] = index;
+          break;
+        }
+        /* Keep the winding of the strip consistent. */
+        if (strip_odd) {
+          triangle_assemble(ctx, verts, v[1], v[0], index, r_prims);
+        }
+        else {
+          triangle_assemble(ctx, verts, v[0], v[1], index, r_prims);
+        }
+        strip_odd = !strip_odd;
+        v[0] = v[1];
+        v[1] = index;
+        break;
+      case GPU_PRIM_TRI_FAN:
+        if (v_len < 2) {
+          v[v_len++] = index;
+          break;
+        }
+        triangle_assemble(ctx, verts, v[0], v[1], index, r_prims);
+        v[1] = index;
+        break;
+      default:
+        /* Adjacency primitives are only used with geometry shaders, which are not supported. */
+        return;
+    }
+  }
+  close_loop();
+}
+
+/* -------------------------------------------------------------------- */
+/* Fragment Stage */
+
+static inline bool depth_test_pass(eGPUDepthTest test, float z, float depth)
+{
+  switch (test) {
+    case GPU_DEPTH_LESS:
+      return z < depth;
+    case GPU_DEPTH_LESS_EQUAL:
+      return z <= depth;
+    case GPU_DEPTH_EQUAL:
+      return z == depth;
+    case GPU_DEPTH_GREATER:
+      return z > depth;
+    case GPU_DEPTH_GREATER_EQUAL:
+      return z >= depth;
+    case GPU_DEPTH_ALWAYS:
+    case GPU_DEPTH_NONE:
+    default:
+      return true;
+  }
+}
+
+/** Same equations as the blend functions set by the OpenGL back-end. */
+static void blend_apply(eGPUBlend blend, const float src[4], const float dst[4], float r[4])
+{
+  const float sa = src[3], da = dst[3];
+  switch (blend) {
+    case GPU_BLEND_ALPHA:
+      for (int c = 0; c < 3; c++) {
+        r[c] = src[c] * sa + dst[c] * (1.0f - sa);
+      }
+      r[3] = sa + da * (1.0f - sa);
+      break;
+    case GPU_BLEND_ALPHA_PREMULT:
+      for (int c = 0; c < 4; c++) {
+        r[c] = src[c] + dst[c] * (1.0f - sa);
+      }
+      break;
+    case GPU_BLEND_ADDITIVE:
+      for (int c = 0; c < 3; c++) {
+        r[c] = src[c] * sa + dst[c];
+      }
+      r[3] = sa + da;
+      break;
+    case GPU_BLEND_ADDITIVE_PREMULT:
+      for (int c = 0; c < 4; c++) {
+        r[c] = src[c] + dst[c];
+      }
+      break;
+    case GPU_BLEND_MULTIPLY:
+      for (int c = 0; c < 4; c++) {
+        r[c] = src[c] * dst[c];
+      }
+      break;
+    case GPU_BLEND_SUBTRACT:
+      for (int c = 0; c < 4; c++) {
+        r[c] = dst[c] - src[c];
+      }
+      break;
+    case GPU_BLEND_INVERT:
+      for (int c = 0; c < 4; c++) {
+        r[c] = src[c] * (1.0f - dst[c]);
+      }
+      break;
+    case GPU_BLEND_OIT:
+      for (int c = 0; c < 3; c++) {
+        r[c] = src[c] + dst[c];
+      }
+      r[3] = da * (1.0f - sa);
+      break;
+    case GPU_BLEND_BACKGROUND:
+      for (int c = 0; c < 4; c++) {
+        r[c] = src[c] * (1.0f - da) + dst[c] * sa;
+      }
+      break;
+    case GPU_BLEND_ALPHA_UNDER_PREMUL:
+      for (int c = 0; c < 4; c++) {
+        r[c] = src[c] * (1.0f - da) + dst[c];
+      }
+      break;
+    case GPU_BLEND_NONE:
+    case GPU_BLEND_CUSTOM:
+    default:
+      /* Dual source blending needs a second shader output. */
+      memcpy(r, src, sizeof(float[4]));
+      break;
+  }
+}
+
+/**
+ * Shade and write one fragment. \a l are the barycentric weights of the primitive vertices
+ * in window space, \a z is the fragment depth.
+ */
+static void fragment_write(const RasterContext &ctx,
+                           const RasterPrim &prim,
+                           const float l[3],
+                           float z,
+                           int x,
+                           int y)
+{
+  float *depth_texel = nullptr;
+  if (ctx.depth_tex && ctx.depth_test != GPU_DEPTH_NONE) {
+    z = clamp_f(z, 0.0f, 1.0f);
+    depth_texel = ctx.depth_tex->texel_get(ctx.depth_mip, x, y, ctx.depth_layer);
+    if (!depth_test_pass(ctx.depth_test, z, *depth_texel)) {
+      return;
+    }
+    if (ctx.write_mask & GPU_WRITE_DEPTH) {
+      *depth_texel = z;
+    }
+  }
+
+  if (ctx.color_tex == nullptr || (ctx.write_mask & GPU_WRITE_COLOR) == 0) {
+    return;
+  }
+
+  const RasterVert *v[3] = {&ctx.verts[prim.v[0]], &ctx.verts[prim.v[1]], &ctx.verts[prim.v[2]]};
+  /* Perspective correct weights. */
+  float w[3];
+  const float inv_w = l[0] * v[0]->inv_w + l[1] * v[1]->inv_w + l[2] * v[2]->inv_w;
+  for (int i = 0; i < 3; i++) {
+    w[i] = l[i] * v[i]->inv_w / inv_w;
+  }
+
+  float color[4];
+  if (ctx.has_color_attr) {
+    for (int c = 0; c < 4; c++) {
+      color[c] = w[0] * v[0]->color[c] + w[1] * v[1]->color[c] + w[2] * v[2]->color[c];
+    }
+  }
+  else {
+    memcpy(color, ctx.uniform_color, sizeof(color));
+  }
+  if (ctx.image) {
+    float texel[4];
+    const float u = w[0] * v[0]->uv[0] + w[1] * v[1]->uv[0] + w[2] * v[2]->uv[0];
+    const float t = w[0] * v[0]->uv[1] + w[1] * v[1]->uv[1] + w[2] * v[2]->uv[1];
+    ctx.image->sample(u, t, *ctx.sampler, texel);
+    for (int c = 0; c < 4; c++) {
+      color[c] *= texel[c];
+    }
+  }
+
+  float *dst = ctx.color_tex->texel_get(ctx.color_mip, x, y, ctx.color_layer);
+  const int channel_len = ctx.color_tex->channel_len();
+  float dst_color[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+  memcpy(dst_color, dst, sizeof(float) * channel_len);
+
+  float result[4];
+  blend_apply(ctx.blend, color, dst_color, result);
+  for (int c = 0; c < 4; c++) {
+    if ((ctx.write_mask & (GPU_WRITE_RED << c)) == 0) {
+      result[c] = dst_color[c];
+    }
+  }
+  ctx.color_tex->texel_store(dst, result);
+}
+
+/* -------------------------------------------------------------------- */
+/* Rasterization */
+
+static void rasterize_triangle(const RasterContext &ctx, const RasterPrim &prim, const int rect[4])
+{
+  const int x_min = max_ii(rect[0], prim.bounds[0]);
+  const int y_min = max_ii(rect[1], prim.bounds[1]);
+  const int x_max = min_ii(rect[2], prim.bounds[2]);
+  const int y_max = min_ii(rect[3], prim.bounds[3]);
+  if (x_min >= x_max || y_min >= y_max) {
+    return;
+  }
+  const float z0 = ctx.verts[prim.v[0]].z;
+  const float z1 = ctx.verts[prim.v[1]].z;
+  const float z2 = ctx.verts[prim.v[2]].z;
+
+#ifdef __SSE2__
+  const __m128 lane_offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 inv_area = _mm_set1_ps(prim.inv_area);
+  const __m128 x_end = _mm_set1_ps(float(x_max));
+  __m128 edge_a[3], top_left[3];
+  for (int e = 0; e < 3; e++) {
+    edge_a[e] = _mm_set1_ps(prim.edge[e][0]);
+    top_left[e] = _mm_castsi128_ps(_mm_set1_epi32((prim.top_left & (1 << e)) ? -1 : 0));
+  }
+  const __m128 z[3] = {_mm_set1_ps(z0), _mm_set1_ps(z1), _mm_set1_ps(z2)};
+
+  for (int y = y_min; y < y_max; y++) {
+    const float py = float(y) + 0.5f;
+    __m128 row[3];
+    for (int e = 0; e < 3; e++) {
+      row[e] = _mm_set1_ps(prim.edge[e][1] * py + prim.edge[e][2]);
+    }
+    for (int x = x_min; x < x_max; x += 4) {
+      const __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), lane_offset);
+      __m128 mask = _mm_cmplt_ps(px, x_end);
+      __m128 w[3];
+      for (int e = 0; e < 3; e++) {
+        w[e] = _mm_add_ps(_mm_mul_ps(edge_a[e], px), row[e]);
+        const __m128 inside = _mm_or_ps(_mm_cmpgt_ps(w[e], zero),
+                                        _mm_and_ps(_mm_cmpeq_ps(w[e], zero), top_left[e]));
+        mask = _mm_and_ps(mask, inside);
+      }
+      const int lanes = _mm_movemask_ps(mask);
+      if (lanes == 0) {
+        continue;
+      }
+      float l[3][4], depth[4];
+      for (int e = 0; e < 3; e++) {
+        w[e] = _mm_mul_ps(w[e], inv_area);
+        _mm_storeu_ps(l[e], w[e]);
+      }
+      const __m128 z_interp = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w[0], z[0]), _mm_mul_ps(w[1], z[1])),
+                                         _mm_mul_ps(w[2], z[2]));
+      _mm_storeu_ps(depth, z_interp);
+      for (int i = 0; i < 4; i++) {
+        if (lanes & (1 << i)) {
+          const float weights[3] = {l[0][i], l[1][i], l[2][i]};
+          fragment_write(ctx, prim, weights, depth[i], x + i, y);
+        }
+      }
+    }
+  }
+#else
+  for (int y = y_min; y < y_max; y++) {
+    const float py = float(y) + 0.5f;
+    for (int x = x_min; x < x_max; x++) {
+      const float px = float(x) + 0.5f;
+      float weights[3];
+      bool inside = true;
+      for (int e = 0; e < 3; e++) {
+        const float w = prim.edge[e][0] * px + (prim.edge[e][1] * py + prim.edge[e][2]);
+        inside &= (w > 0.0f) || (w == 0.0f && (prim.top_left & (1 << e)));
+        weights[e] = w * prim.inv_area;
+      }
+      if (inside) {
+        const float depth = weights[0] * z0 + weights[1] * z1 + weights[2] * z2;
+        fragment_write(ctx, prim, weights, depth, x, y);
+      }
+    }
+  }
+#endif
+}
+
+/**
+ * DDA line, one pixel wide. The last pixel is not drawn so that connected segments do not
+ * overlap. Steps are computed from the whole line so that every tile gets the same pixels.
+ */
+static void rasterize_line(const RasterContext &ctx, const RasterPrim &prim, const int rect[4])
+{
+  int clip[4] = {max_ii(rect[0], prim.bounds[0]),
+                 max_ii(rect[1], prim.bounds[1]),
+                 min_ii(rect[2], prim.bounds[2]),
+                 min_ii(rect[3], prim.bounds[3])};
+  if (bounds_is_empty(clip)) {
+    return;
+  }
+  const RasterVert &a = ctx.verts[prim.v[0]];
+  const RasterVert &b = ctx.verts[prim.v[1]];
+  const float d[2] = {b.x - a.x, b.y - a.y};
+  const int steps = max_ii(1, int(ceilf(max_ff(fabsf(d[0]), fabsf(d[1])))));
+
+  /* Parametric range of the line inside the rectangle. */
+  float t_min = 0.0f, t_max = 1.0f;
+  const float origin[2] = {a.x, a.y};
+  for (int axis = 0; axis < 2; axis++) {
+    const float lo = float(clip[axis]), hi = float(clip[axis + 2]);
+    if (d[axis] == 0.0f) {
+      if (origin[axis] < lo - 1.0f || origin[axis] > hi + 1.0f) {
+        return;
+      }
+      continue;
+    }
+    float t0 = (lo - 1.0f - origin[axis]) / d[axis];
+    float t1 = (hi + 1.0f - origin[axis]) / d[axis];
+    if (t0 > t1) {
+      SWAP(float, t0, t1);
+    }
+    t_min = max_ff(t_min, t0);
+    t_max = min_ff(t_max, t1);
+  }
+  if (t_min > t_max) {
+    return;
+  }
+
+  const int k_min = max_ii(0, int(floorf(t_min * steps)));
+  const int k_max = min_ii(steps - 1, int(ceilf(t_max * steps)));
+  for (int k = k_min; k <= k_max; k++) {
+    const float t = float(k) / float(steps);
+    const int x = int(floorf(a.x + d[0] * t));
+    const int y = int(floorf(a.y + d[1] * t));
+    if (x < clip[0] || x >= clip[2] || y < clip[1] || y >= clip[3]) {
+      continue;
+    }
+    const float weights[3] = {1.0f - t, t, 0.0f};
+    fragment_write(ctx, prim, weights, a.z + (b.z - a.z) * t, x, y);
+  }
+}
+
+static void rasterize_point(const RasterContext &ctx, const RasterPrim &prim, const int rect[4])
+{
+  const RasterVert &v = ctx.verts[prim.v[0]];
+  const float weights[3] = {1.0f, 0.0f, 0.0f};
+  for (int y = max_ii(rect[1], prim.bounds[1]); y < min_ii(rect[3], prim.bounds[3]); y++) {
+    for (int x = max_ii(rect[0], prim.bounds[0]); x < min_ii(rect[2], prim.bounds[2]); x++) {
+      fragment_write(ctx, prim, weights, v.z, x, y);
+    }
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Draw */
+
+void cpu_draw(const CPUDrawCall &draw)
+{
+  Context *ctx = Context::get();
+  CPUFrameBuffer *fb = static_cast<CPUFrameBuffer *>(ctx->active_fb);
+  if (fb == nullptr || !draw.pos.is_valid() || draw.v_count <= 0 || draw.i_count <= 0) {
+    return;
+  }
+
+  RasterContext raster;
+  raster.color_tex = fb->attachment_get(
+      GPU_FB_COLOR_ATTACHMENT0, &raster.color_mip, &raster.color_layer);
+  raster.depth_tex = fb->depth_attachment_get(&raster.depth_mip, &raster.depth_layer);
+  if (raster.color_tex && (raster.color_tex->format_flag_get() & GPU_FORMAT_INTEGER)) {
+    /* Integer outputs need the real fragment shader. */
+    raster.color_tex = nullptr;
+  }
+  if (raster.color_tex == nullptr && raster.depth_tex == nullptr) {
+    return;
+  }
+
+  const StateManager *state_manager = ctx->state_manager;
+  const GPUState &state = state_manager->state;
+  raster.write_mask = eGPUWriteMask(state.write_mask);
+  raster.blend = eGPUBlend(state.blend);
+  raster.depth_test = eGPUDepthTest(state.depth_test);
+  raster.culling_test = eGPUFaceCullTest(state.culling_test);
+  raster.invert_facing = state.invert_facing;
+  raster.point_size = max_ff(1.0f, fabsf(state_manager->mutable_state.point_size));
+
+  /* Clip rectangle. */
+  int viewport[4];
+  fb->viewport_get(viewport);
+  for (int i = 0; i < 4; i++) {
+    raster.viewport[i] = float(viewport[i]);
+  }
+  raster.clip_rect[0] = max_ii(0, viewport[0]);
+  raster.clip_rect[1] = max_ii(0, viewport[1]);
+  raster.clip_rect[2] = min_ii(fb->width_get(), viewport[0] + viewport[2]);
+  raster.clip_rect[3] = min_ii(fb->height_get(), viewport[1] + viewport[3]);
+  if (fb->scissor_test_get()) {
+    int scissor[4];
+    fb->scissor_get(scissor);
+    raster.clip_rect[0] = max_ii(raster.clip_rect[0], scissor[0]);
+    raster.clip_rect[1] = max_ii(raster.clip_rect[1], scissor[1]);
+    raster.clip_rect[2] = min_ii(raster.clip_rect[2], scissor[0] + scissor[2]);
+    raster.clip_rect[3] = min_ii(raster.clip_rect[3], scissor[1] + scissor[3]);
+  }
+  if (bounds_is_empty(raster.clip_rect)) {
+    return;
+  }
+
+  /* Fixed function shading inputs. */
+  float mvp[4][4];
+  draw_matrix_get(draw.shader, mvp);
+  raster.has_color_attr = draw.color.is_valid() || draw.inst_color.is_valid();
+  raster.has_uv_attr = draw.uv.is_valid();
+  copy_v4_fl(raster.uniform_color, 1.0f);
+  const ShaderInterface *interface = draw.shader->interface;
+  if (interface) {
+    draw.shader->uniform_get(
+        interface->uniform_builtin(GPU_UNIFORM_COLOR), 4, raster.uniform_color);
+    static const int image_name_id = ShaderNameTable::get().id_get("image");
+    const ShaderInput *image = draw.shader->input_table.get(ShaderInputType::UNIFORM,
+                                                            image_name_id);
+    if (image && raster.has_uv_attr) {
+      const NullStateManager *null_state = static_cast<const NullStateManager *>(state_manager);
+      raster.image = static_cast<CPUTexture *>(null_state->texture_get(image->binding));
+      raster.sampler = &null_state->sampler_get(image->binding);
+    }
+  }
+
+  /* Vertex indices, with the base index applied. */
+  Vector<uint32_t> indices(draw.v_count);
+  uint32_t vert_min = UINT32_MAX, vert_max = 0;
+  if (draw.elem) {
+    const void *elem_data = draw.elem->index_data_get();
+    const uint32_t restart = draw.elem->restart_index_get();
+    const uint32_t base = uint32_t(draw.base_index);
+    for (int i = 0; i < draw.v_count; i++) {
+      const uint32_t index = draw.elem->is_u16() ?
+                                 static_cast<const uint16_t *>(elem_data)[draw.v_first + i] :
+                                 static_cast<const uint32_t *>(elem_data)[draw.v_first + i];
+      if (index == restart) {
+        indices[i] = RESTART_INDEX;
+        continue;
+      }
+      indices[i] = index + base;
+      vert_min = min_uu(vert_min, indices[i]);
+      vert_max = max_uu(vert_max, indices[i]);
+    }
+    if (vert_min > vert_max) {
+      return;
+    }
+  }
+  else {
+    vert_min = uint32_t(draw.v_first);
+    vert_max = uint32_t(draw.v_first + draw.v_count - 1);
+  }
+
+  /* Per instance inputs. */
+  struct InstanceInputs {
+    float mvp[4][4];
+    float color[4];
+  };
+  Vector<InstanceInputs> instances(draw.i_count);
+  for (const int instance : IndexRange(draw.i_count)) {
+    const uint32_t inst_index = uint32_t(draw.i_first + instance);
+    float model[4][4];
+    draw.inst_model_matrix.fetch_matrix(inst_index, model);
+    mul_m4_m4m4(instances[instance].mvp, mvp, model);
+    draw.inst_color.fetch(inst_index, instances[instance].color);
+  }
+
+  /* Vertex stage, once per instance. Indices are made relative to the first transformed vertex
+   * of the instance. */
+  const uint32_t vert_len = vert_max - vert_min + 1;
+  Vector<RasterVert> verts(int64_t(vert_len) * draw.i_count);
+  threading::parallel_for(verts.index_range(), CPU_VERTEX_GRAIN_SIZE, [&](IndexRange range) {
+    for (const int64_t i : range) {
+      RasterVert &v = verts[i];
+      const int instance = int(i / vert_len);
+      const uint32_t vert_index = vert_min + uint32_t(i % vert_len);
+      float pos[4];
+      draw.pos.fetch(vert_index, pos);
+      mul_v4_m4v4(v.clip, instances[instance].mvp, pos);
+      if (draw.color.is_valid()) {
+        draw.color.fetch(vert_index, v.color);
+      }
+      else if (raster.has_color_attr) {
+        copy_v4_v4(v.color, instances[instance].color);
+      }
+      if (raster.has_uv_attr) {
+        float uv[4];
+        draw.uv.fetch(vert_index, uv);
+        copy_v2_v2(v.uv, uv);
+      }
+      vertex_window_coords(raster, v);
+    }
+  });
+  for (int i = 0; i < draw.v_count; i++) {
+    if (draw.elem == nullptr) {
+      indices[i] = uint32_t(i);
+    }
+    else if (indices[i] != RESTART_INDEX) {
+      indices[i] -= vert_min;
+    }
+  }
+
+  /* Primitive assembly, clipping and setup. Instances are assembled in order so that the tiles
+   * rasterize them in submission order. */
+  Vector<RasterPrim> prims;
+  Vector<uint32_t> instance_indices(indices.size());
+  for (const int instance : IndexRange(draw.i_count)) {
+    const uint32_t offset = uint32_t(instance) * vert_len;
+    for (const int64_t i : indices.index_range()) {
+      instance_indices[i] = (indices[i] == RESTART_INDEX) ? RESTART_INDEX : indices[i] + offset;
+    }
+    primitives_assemble(raster, draw.prim_type, instance_indices, verts, prims);
+  }
+  if (prims.is_empty()) {
+    return;
+  }
+  raster.verts = verts.data();
+
+  /* Binning. */
+  const int tile_x_min = raster.clip_rect[0] / CPU_TILE_SIZE;
+  const int tile_y_min = raster.clip_rect[1] / CPU_TILE_SIZE;
+  const int tile_x_len = divide_ceil_u(raster.clip_rect[2], CPU_TILE_SIZE) - tile_x_min;
+  const int tile_y_len = divide_ceil_u(raster.clip_rect[3], CPU_TILE_SIZE) - tile_y_min;
+  Vector<Vector<uint32_t>> tiles(tile_x_len * tile_y_len);
+  for (const int64_t prim_index : prims.index_range()) {
+    const RasterPrim &prim = prims[prim_index];
+    const int tx_min = prim.bounds[0] / CPU_TILE_SIZE - tile_x_min;
+    const int ty_min = prim.bounds[1] / CPU_TILE_SIZE - tile_y_min;
+    const int tx_max = (prim.bounds[2] - 1) / CPU_TILE_SIZE - tile_x_min;
+    const int ty_max = (prim.bounds[3] - 1) / CPU_TILE_SIZE - tile_y_min;
+    for (int ty = ty_min; ty <= ty_max; ty++) {
+      for (int tx = tx_min; tx <= tx_max; tx++) {
+        tiles[ty * tile_x_len + tx].append(uint32_t(prim_index));
+      }
+    }
+  }
+
+  /* Rasterization. Each tile is owned by one thread. */
+  threading::parallel_for(tiles.index_range(), 1, [&](IndexRange range) {
+    for (const int64_t tile_index : range) {
+      const Vector<uint32_t> &tile = tiles[tile_index];
+      if (tile.is_empty()) {
+        continue;
+      }
+      const int tx = int(tile_index % tile_x_len) + tile_x_min;
+      const int ty = int(tile_index / tile_x_len) + tile_y_min;
+      const int rect[4] = {max_ii(tx * CPU_TILE_SIZE, raster.clip_rect[0]),
+                           max_ii(ty * CPU_TILE_SIZE, raster.clip_rect[1]),
+                           min_ii((tx + 1) * CPU_TILE_SIZE, raster.clip_rect[2]),
+                           min_ii((ty + 1) * CPU_TILE_SIZE, raster.clip_rect[3])};
+      for (const uint32_t prim_index : tile) {
+        const RasterPrim &prim = prims[prim_index];
+        switch (prim.type) {
+          case RASTER_TRIANGLE:
+            rasterize_triangle(raster, prim, rect);
+            break;
+          case RASTER_LINE:
+            rasterize_line(raster, prim, rect);
+            break;
+          case RASTER_POINT:
+            rasterize_point(raster, prim, rect);
+            break;
+        }
+      }
+    }
+  });
+}
+
+}  // namespace dust::gpu
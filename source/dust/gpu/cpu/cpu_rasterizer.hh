@@ -0,0 +1,76 @@
+/*
+ * Software rasterizer of the CPU back-end.
+ *
+ * Shaders are not executed. Draws are rendered with a fixed function pipeline that covers the
+ * builtin shaders used for previews and UI drawing:
+ * - `pos` is transformed by `ModelViewProjectionMatrix` (or `ViewProjectionMatrix * ModelMatrix`),
+ *   after the `InstanceModelMatrix` instance attribute if any,
+ * - the output color is the `color` vertex attribute, or the `color` instance attribute, or the
+ *   `color` uniform, or white,
+ * - if the shader has an `image` sampler, it is sampled at `texCoord` and multiplied with it.
+ *
+ * The frame-buffer is split into tiles. Primitives are set up and binned once, then tiles are
+ * rasterized in parallel, each tile processing its primitives in submission order so blending
+ * stays deterministic. Triangle coverage and depth are evaluated 4 pixels at a time using SSE2
+ * when available.
+ */
+
+#pragma once
+
+#include "GPU_primitive.h"
+#include "GPU_vertex_format.h"
+
+namespace dust::gpu {
+
+class CPUIndexBuf;
+class CPUShader;
+
+/** Access to one vertex attribute inside a vertex buffer. */
+struct CPUVertAttrStream {
+  const uchar *data = nullptr;
+  uint stride = 0;
+  /** Number of elements that can be fetched. */
+  uint len = 0;
+  GPUVertAttr attr = {};
+
+  bool is_valid() const
+  {
+    return data != nullptr;
+  }
+
+  /** Fetch element \a index converted to float. Missing components default to (0, 0, 0, 1). */
+  void fetch(uint index, float r_value[4]) const;
+  /** Fetch element \a index of a 4x4 float matrix attribute, identity for other attributes. */
+  void fetch_matrix(uint index, float r_value[4][4]) const;
+};
+
+/**
+ * Find the attribute named \a name (or any of its aliases) inside \a format.
+ * \a data is the buffer using this format and \a vertex_len its number of vertices.
+ */
+CPUVertAttrStream cpu_vert_attr_stream_find(const GPUVertFormat *format,
+                                            const uchar *data,
+                                            uint vertex_len,
+                                            const char *name);
+
+struct CPUDrawCall {
+  GPUPrimType prim_type = GPU_PRIM_NONE;
+  /** Vertex attributes. Only #pos is required. */
+  CPUVertAttrStream pos, color, uv;
+  /** Instance attributes, see #GPU_BATCH_INSTANCER_ATTR_MATRIX. */
+  CPUVertAttrStream inst_model_matrix, inst_color;
+  /**
+   * Optional index buffer. #v_first and #v_count are then ranges of indices, and #base_index is
+   * added to the indices.
+   */
+  const CPUIndexBuf *elem = nullptr;
+  int base_index = 0;
+  int v_first = 0, v_count = 0;
+  int i_first = 0, i_count = 1;
+  CPUShader *shader = nullptr;
+};
+
+/** Rasterize \a draw into the active frame-buffer using the current state. */
+void cpu_draw(const CPUDrawCall &draw);
+
+}  // namespace dust::gpu
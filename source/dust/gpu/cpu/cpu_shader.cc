@@ -0,0 +1,84 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+
+#include "cpu_shader.hh"
+
+namespace dust::gpu {
+
+float *CPUShader::uniform_ensure(int location, int array_size)
+{
+  const int location_end = location + array_size;
+  if (uniforms_set_.size() < location_end) {
+    uniforms_.resize(location_end * CPU_UNIFORM_LOCATION_LEN, 0.0f);
+    uniforms_set_.resize(location_end, false);
+  }
+  for (int i = location; i < location_end; i++) {
+    uniforms_set_[i] = true;
+  }
+  return uniforms_.data() + location * CPU_UNIFORM_LOCATION_LEN;
+}
+
+void CPUShader::uniform_float(int location, int comp_len, int array_size, const float *data)
+{
+  if (location < 0) {
+    return;
+  }
+  LIB_assert(comp_len <= CPU_UNIFORM_LOCATION_LEN);
+  /* Setting the same value again (e.g. the color of each immediate draw) keeps them merged. */
+  if (!this->uniform_equals(location, comp_len, array_size, data)) {
+    imm_flush_merged();
+  }
+  float *dst = this->uniform_ensure(location, array_size);
+  /* Like GL, each array element uses its own location. */
+  for (int i = 0; i < array_size; i++) {
+    memcpy(dst + i * CPU_UNIFORM_LOCATION_LEN, data + i * comp_len, sizeof(float) * comp_len);
+  }
+}
+
+void CPUShader::uniform_int(int location, int comp_len, int array_size, const int *data)
+{
+  if (location < 0) {
+    return;
+  }
+  LIB_assert(comp_len <= CPU_UNIFORM_LOCATION_LEN);
+  imm_flush_merged();
+  float *dst = this->uniform_ensure(location, array_size);
+  for (int i = 0; i < array_size; i++) {
+    for (int c = 0; c < comp_len; c++) {
+      dst[i * CPU_UNIFORM_LOCATION_LEN + c] = float(data[i * comp_len + c]);
+    }
+  }
+}
+
+bool CPUShader::uniform_equals(int location,
+                               int comp_len,
+                               int array_size,
+                               const float *data) const
+{
+  if (location + array_size > uniforms_set_.size()) {
+    return false;
+  }
+  for (int i = 0; i < array_size; i++) {
+    if (!uniforms_set_[location + i] ||
+        memcmp(uniforms_.data() + (location + i) * CPU_UNIFORM_LOCATION_LEN,
+               data + i * comp_len,
+               sizeof(float) * comp_len) != 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CPUShader::uniform_get(int location, int len, float *r_data) const
+{
+  if (location < 0 || location >= uniforms_set_.size() || !uniforms_set_[location]) {
+    return false;
+  }
+  LIB_assert(len <= CPU_UNIFORM_LOCATION_LEN);
+  memcpy(r_data, uniforms_.data() + location * CPU_UNIFORM_LOCATION_LEN, sizeof(float) * len);
+  return true;
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_vector.hh"
+
+#include "gpu_immediate_private.hh"
+
+#include "null_shader.hh"
+
+namespace dust::gpu {
+
+/* Floats stored per uniform location. Large enough for a 4x4 matrix. */
+#define CPU_UNIFORM_LOCATION_LEN 16
+
+/**
+ * Shader of the CPU back-end. GLSL is never compiled: the rasterizer emulates the fixed function
+ * behavior of the builtin shaders (see #cpu_draw), so this only needs to store uniform values.
+ * The interface is built from the create info like for the null back-end.
+ */
+class CPUShader : public NullShader {
+ private:
+  /** #CPU_UNIFORM_LOCATION_LEN floats per location. Integers are converted to floats. */
+  Vector<float> uniforms_;
+  /** One flag per location, true if the uniform was set at least once. */
+  Vector<bool> uniforms_set_;
+
+ public:
+  CPUShader(const char *name) : NullShader(name){};
+  ~CPUShader()
+  {
+    /* Merged immediate draws read the uniforms. */
+    imm_flush_merged();
+  }
+
+  void bind() override{};
+
+  void uniform_float(int location, int comp_len, int array_size, const float *data) override;
+  void uniform_int(int location, int comp_len, int array_size, const int *data) override;
+
+  /**
+   * Copy \a len floats of the uniform at \a location into \a r_data.
+   * Return false if the location is invalid or the uniform was never set.
+   */
+  bool uniform_get(int location, int len, float *r_data) const;
+
+ private:
+  float *uniform_ensure(int location, int array_size);
+  /** True if the uniform at \a location is already set to \a data. */
+  bool uniform_equals(int location, int comp_len, int array_size, const float *data) const;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUShader");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,70 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+
+#include "gpu_immediate_private.hh"
+
+#include "cpu_storage_buffer.hh"
+#include "cpu_vertex_buffer.hh"
+
+namespace dust::gpu {
+
+CPUStorageBuf::CPUStorageBuf(size_t size, const char *name) : NullStorageBuf(size, name)
+{
+  host_data_ = (uchar *)MEM_callocN(size, __func__);
+}
+
+CPUStorageBuf::~CPUStorageBuf()
+{
+  MEM_SAFE_FREE(host_data_);
+}
+
+void CPUStorageBuf::update(const void *data)
+{
+  imm_flush_merged();
+  NullStorageBuf::update(data);
+  memcpy(host_data_, data, size_in_bytes_);
+}
+
+void CPUStorageBuf::bind(int slot)
+{
+  /* The merged immediate draws read the buffers bound when they were recorded. */
+  imm_flush_merged();
+  NullStorageBuf::bind(slot);
+}
+
+void CPUStorageBuf::unbind()
+{
+  imm_flush_merged();
+  NullStorageBuf::unbind();
+}
+
+void CPUStorageBuf::clear(eGPUTextureFormat internal_format,
+                          eGPUDataFormat data_format,
+                          void *data)
+{
+  imm_flush_merged();
+  NullStorageBuf::clear(internal_format, data_format, data);
+  /* Only the 32 bit formats are used to clear buffers. */
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  uint32_t *dst = reinterpret_cast<uint32_t *>(host_data_);
+  for (size_t i = 0; i < size_in_bytes_ / sizeof(uint32_t); i++) {
+    dst[i] = value;
+  }
+}
+
+void CPUStorageBuf::copy_sub(VertBuf *src, uint dst_offset, uint src_offset, uint copy_size)
+{
+  imm_flush_merged();
+  NullStorageBuf::copy_sub(src, dst_offset, src_offset, copy_size);
+  const uchar *src_data = static_cast<CPUVertBuf *>(src)->data_get();
+  memcpy(host_data_ + dst_offset, src_data + src_offset, copy_size);
+}
+
+void CPUStorageBuf::read(void *data)
+{
+  memcpy(data, this->data_get(), size_in_bytes_);
+}
+
+}  // namespace dust::gpu
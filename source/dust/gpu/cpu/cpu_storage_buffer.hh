@@ -0,0 +1,46 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "null_storage_buffer.hh"
+
+namespace dust::gpu {
+
+/**
+ * Storage buffer living in system memory, so that draws can read their indirect arguments from
+ * it. Compute shaders are not executed: only the data uploaded from the host is there.
+ */
+class CPUStorageBuf : public NullStorageBuf {
+ private:
+  uchar *host_data_ = nullptr;
+
+ public:
+  CPUStorageBuf(size_t size, const char *name);
+  ~CPUStorageBuf();
+
+  void update(const void *data) override;
+  void bind(int slot) override;
+  void unbind() override;
+  void clear(eGPUTextureFormat internal_format, eGPUDataFormat data_format, void *data) override;
+  void copy_sub(VertBuf *src, uint dst_offset, uint src_offset, uint copy_size) override;
+  void read(void *data) override;
+
+  size_t size_get() const
+  {
+    return size_in_bytes_;
+  }
+
+  const uchar *data_get()
+  {
+    /* Flush the data given at creation. */
+    if (data_ != nullptr) {
+      this->update(data_);
+      MEM_SAFE_FREE(data_);
+    }
+    return host_data_;
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUStorageBuf");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,481 @@
+#include <cmath>
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+
+#include "gpu_context_private.hh"
+#include "gpu_texture_convert.hh"
+#include "gpu_texture_downsample.hh"
+
+#include "null_state.hh"
+
+#include "cpu_texture.hh"
+
+namespace dust::gpu {
+
+/* -------------------------------------------------------------------- */
+/* Data Conversion
+ * Conversions between the data formats of the API and the float storage. */
+
+static inline float uint_as_float(uint32_t i)
+{
+  float f;
+  memcpy(&f, &i, sizeof(f));
+  return f;
+}
+
+/** Formats whose values are clamped to [0..1] when written. */
+static bool format_is_normalized(eGPUTextureFormat format)
+{
+  switch (format) {
+    case GPU_RGBA8:
+    case GPU_RG8:
+    case GPU_R8:
+    case GPU_SRGB8_A8:
+    case GPU_RGBA16:
+    case GPU_RG16:
+    case GPU_R16:
+    case GPU_RGB10_A2:
+    case GPU_DEPTH_COMPONENT32F:
+    case GPU_DEPTH_COMPONENT24:
+    case GPU_DEPTH_COMPONENT16:
+    case GPU_DEPTH24_STENCIL8:
+    case GPU_DEPTH32F_STENCIL8:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** Number of texels expanded at once by #convert_from_storage. */
+#define CONVERT_EXPAND_TEXEL_LEN 256
+
+/**
+ * Convert \a texel_len texels from \a data_format to the float storage.
+ * Integer textures store the bit pattern of the integer values.
+ */
+static void convert_to_storage(const void *src,
+                               eGPUDataFormat data_format,
+                               eGPUTextureFormat tex_format,
+                               int channel_len,
+                               size_t texel_len,
+                               float *dst)
+{
+  const bool is_integer = (to_format_flag(tex_format) & GPU_FORMAT_INTEGER) != 0;
+  convert_texels(src,
+                 data_format,
+                 dst,
+                 is_integer ? GPU_DATA_UINT : GPU_DATA_FLOAT,
+                 tex_format,
+                 channel_len,
+                 texel_len);
+}
+
+/**
+ * Convert \a texel_len texels of \a src_channel_len floats from the storage to \a data_format,
+ * writing \a dst_channel_len components per texel. Missing components are filled with zero,
+ * and one for alpha.
+ */
+static void convert_from_storage(const float *src,
+                                 int src_channel_len,
+                                 eGPUTextureFormat tex_format,
+                                 eGPUDataFormat data_format,
+                                 int dst_channel_len,
+                                 size_t texel_len,
+                                 void *dst)
+{
+  const bool is_integer = (to_format_flag(tex_format) & GPU_FORMAT_INTEGER) != 0;
+  const eGPUDataFormat storage_format = is_integer ? GPU_DATA_UINT : GPU_DATA_FLOAT;
+
+  if (src_channel_len == dst_channel_len) {
+    convert_texels(
+        src, storage_format, dst, data_format, tex_format, dst_channel_len, texel_len);
+    return;
+  }
+
+  const float alpha = is_integer ? uint_as_float(1) : 1.0f;
+  const size_t dst_chunk_size = convert_buffer_size(
+      data_format, dst_channel_len, CONVERT_EXPAND_TEXEL_LEN);
+  uchar *dst_chunk = static_cast<uchar *>(dst);
+  for (size_t texel = 0; texel < texel_len; texel += CONVERT_EXPAND_TEXEL_LEN) {
+    const size_t chunk_len = min_zz(CONVERT_EXPAND_TEXEL_LEN, texel_len - texel);
+    float expanded[CONVERT_EXPAND_TEXEL_LEN * 4];
+    for (size_t i = 0; i < chunk_len; i++) {
+      const float *src_texel = src + (texel + i) * src_channel_len;
+      for (int c = 0; c < dst_channel_len; c++) {
+        expanded[i * dst_channel_len + c] = (c < src_channel_len) ? src_texel[c] :
+                                            (c == 3)              ? alpha :
+                                                                    0.0f;
+      }
+    }
+    convert_texels(
+        expanded, storage_format, dst_chunk, data_format, tex_format, dst_channel_len, chunk_len);
+    dst_chunk += dst_chunk_size;
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Creation & Deletion */
+
+CPUTexture::CPUTexture(const char *name) : Texture(name)
+{
+}
+
+CPUTexture::~CPUTexture()
+{
+  MEM_SAFE_FREE(data_);
+}
+
+void CPUTexture::mip_extent_get(int mip, int r_extent[3]) const
+{
+  r_extent[0] = r_extent[1] = r_extent[2] = 1;
+  this->mip_size_get(mip, r_extent);
+  r_extent[1] = max_ii(1, r_extent[1]);
+  r_extent[2] = max_ii(1, r_extent[2]);
+}
+
+size_t CPUTexture::mip_texel_len(int mip) const
+{
+  int extent[3];
+  this->mip_extent_get(mip, extent);
+  return size_t(extent[0]) * extent[1] * extent[2];
+}
+
+bool CPUTexture::init_internal()
+{
+  if ((format_flag_ & GPU_FORMAT_DEPTH) && (type_ & GPU_TEXTURE_3D)) {
+    /* 3D depth textures are not supported by any back-end. */
+    return false;
+  }
+  /* Compressed formats are never decoded: their storage stays zeroed and uploads are ignored. */
+  mipmaps_ = min_ii(max_ii(1, mipmaps_), int(ARRAY_SIZE(mip_offsets_)));
+
+  size_t total_len = 0;
+  for (int mip = 0; mip < mipmaps_; mip++) {
+    mip_offsets_[mip] = total_len;
+    total_len += this->mip_texel_len(mip) * this->channel_len();
+  }
+  data_ = (float *)MEM_callocN(sizeof(float) * total_len, __func__);
+  return data_ != nullptr;
+}
+
+bool CPUTexture::init_internal(GPUVertBuf * /*vbo*/)
+{
+  /* Buffer textures get their own storage. It is not kept in sync with the vertex buffer. */
+  mipmaps_ = 1;
+  data_ = (float *)MEM_callocN(sizeof(float) * this->mip_texel_len(0) * this->channel_len(),
+                               __func__);
+  return data_ != nullptr;
+}
+
+bool CPUTexture::init_internal(const GPUTexture *src, int mip_offset, int layer_offset)
+{
+  CPUTexture *src_tex = static_cast<CPUTexture *>(unwrap(const_cast<GPUTexture *>(src)));
+  LIB_assert(src_tex->channel_len() == this->channel_len());
+  /* Always point to the texture owning the storage. */
+  src_ = (src_tex->src_) ? src_tex->src_ : src_tex;
+  src_mip_offset_ = src_tex->src_mip_offset_ + mip_offset;
+  src_layer_offset_ = src_tex->src_layer_offset_ + layer_offset;
+  return true;
+}
+
+/* -------------------------------------------------------------------- */
+/* Texel Access */
+
+float *CPUTexture::texel_get(int mip, int x, int y, int layer)
+{
+  if (src_) {
+    if (type_ == GPU_TEXTURE_1D_ARRAY) {
+      return src_->texel_get(mip + src_mip_offset_, x, y + src_layer_offset_, layer);
+    }
+    return src_->texel_get(mip + src_mip_offset_, x, y, layer + src_layer_offset_);
+  }
+  int extent[3];
+  this->mip_extent_get(mip, extent);
+  const size_t texel = (size_t(layer) * extent[1] + y) * extent[0] + x;
+  return data_ + mip_offsets_[mip] + texel * this->channel_len();
+}
+
+void CPUTexture::texel_store(float *texel, const float value[4]) const
+{
+  const int channel_len = to_component_len(format_);
+  if (format_flag_ & GPU_FORMAT_INTEGER) {
+    for (int c = 0; c < channel_len; c++) {
+      texel[c] = uint_as_float(uint32_t(int32_t(value[c])));
+    }
+  }
+  else if (format_is_normalized(format_)) {
+    for (int c = 0; c < channel_len; c++) {
+      texel[c] = clamp_f(value[c], 0.0f, 1.0f);
+    }
+  }
+  else {
+    for (int c = 0; c < channel_len; c++) {
+      texel[c] = value[c];
+    }
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Operations */
+
+void CPUTexture::update_sub(
+    int mip, int offset[3], int extent[3], eGPUDataFormat type, const void *data)
+{
+  LIB_assert(validate_data_format(format_, type));
+  LIB_assert(data != nullptr);
+
+  if (format_flag_ & GPU_FORMAT_COMPRESSED) {
+    /* Not decoded, see #init_internal. */
+    return;
+  }
+
+  const int dimensions = this->dimensions_count();
+  int region[3] = {1, 1, 1};
+  int origin[3] = {0, 0, 0};
+  for (int i = 0; i < dimensions; i++) {
+    region[i] = extent[i];
+    origin[i] = offset[i];
+  }
+
+  int mip_extent[3];
+  this->mip_extent_get(mip, mip_extent);
+  for (int i = 0; i < 3; i++) {
+    LIB_assert_msg(origin[i] >= 0 && origin[i] + region[i] <= mip_extent[i],
+                   "GPUTexture: update is out of the texture bounds");
+  }
+  UNUSED_VARS_NDEBUG(mip_extent);
+
+  const int channel_len = this->channel_len();
+  const size_t texel_size = convert_buffer_size(type, channel_len, 1);
+  /* Respect the row length set by #GPU_unpack_row_length_set. */
+  const NullStateManager *state = static_cast<const NullStateManager *>(
+      Context::get()->state_manager);
+  const uint row_length = state->texture_unpack_row_length_get();
+  const size_t row_stride = size_t(row_length > 0 ? row_length : region[0]) * texel_size;
+
+  const uchar *src = static_cast<const uchar *>(data);
+  for (int z = 0; z < region[2]; z++) {
+    for (int y = 0; y < region[1]; y++) {
+      float *dst = this->texel_get(mip, origin[0], origin[1] + y, origin[2] + z);
+      convert_to_storage(src, type, format_, channel_len, region[0], dst);
+      src += row_stride;
+    }
+  }
+}
+
+void CPUTexture::generate_mipmap()
+{
+  if (src_ || (type_ & GPU_TEXTURE_3D) || (format_flag_ & GPU_FORMAT_INTEGER)) {
+    return;
+  }
+  const int channel_len = this->channel_len();
+  for (int mip = 1; mip < mipmaps_; mip++) {
+    int src_extent[3], dst_extent[3];
+    this->mip_extent_get(mip - 1, src_extent);
+    this->mip_extent_get(mip, dst_extent);
+    if (type_ == GPU_TEXTURE_1D_ARRAY) {
+      /* Layers are stored as rows and are not filtered together. */
+      const int row_extent[2] = {src_extent[0], 1};
+      for (int y = 0; y < dst_extent[1]; y++) {
+        texture_downsample_reference(this->texel_get(mip - 1, 0, y, 0),
+                                     row_extent,
+                                     channel_len,
+                                     this->texel_get(mip, 0, y, 0));
+      }
+      continue;
+    }
+    for (int layer = 0; layer < dst_extent[2]; layer++) {
+      /* Same filter as the GPU back-ends use for #GPU_texture_downsample. */
+      texture_downsample_reference(this->texel_get(mip - 1, 0, 0, layer),
+                                   src_extent,
+                                   channel_len,
+                                   this->texel_get(mip, 0, 0, layer));
+    }
+  }
+}
+
+void CPUTexture::copy_to(Texture *dst_)
+{
+  CPUTexture *dst = static_cast<CPUTexture *>(dst_);
+  /* Same restrictions as the other back-ends. */
+  LIB_assert((dst->w_ == w_) && (dst->h_ == h_) && (dst->d_ == d_));
+  LIB_assert(dst->format_ == format_);
+  LIB_assert(dst->type_ == type_);
+
+  const int channel_len = this->channel_len();
+  for (int mip = 0; mip < min_ii(mipmaps_, dst->mipmaps_); mip++) {
+    int extent[3];
+    this->mip_extent_get(mip, extent);
+    for (int layer = 0; layer < extent[2]; layer++) {
+      for (int y = 0; y < extent[1]; y++) {
+        memcpy(dst->texel_get(mip, 0, y, layer),
+               this->texel_get(mip, 0, y, layer),
+               sizeof(float) * extent[0] * channel_len);
+      }
+    }
+  }
+}
+
+void CPUTexture::clear_area(
+    int mip, int layer, const int area[4], eGPUDataFormat format, const void *data)
+{
+  const int channel_len = this->channel_len();
+  float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  convert_to_storage(data, format, format_, channel_len, 1, value);
+
+  for (int y = area[1]; y < area[1] + area[3]; y++) {
+    float *dst = this->texel_get(mip, area[0], y, layer);
+    for (int x = 0; x < area[2]; x++, dst += channel_len) {
+      memcpy(dst, value, sizeof(float) * channel_len);
+    }
+  }
+}
+
+void CPUTexture::clear(eGPUDataFormat format, const void *data)
+{
+  LIB_assert(validate_data_format(format_, format));
+  int extent[3];
+  this->mip_extent_get(0, extent);
+  const int area[4] = {0, 0, extent[0], extent[1]};
+  for (int layer = 0; layer < extent[2]; layer++) {
+    this->clear_area(0, layer, area, format, data);
+  }
+}
+
+void CPUTexture::swizzle_set(const char swizzle_mask[4])
+{
+  memcpy(swizzle_, swizzle_mask, sizeof(swizzle_));
+}
+
+void CPUTexture::stencil_texture_mode_set(bool use_stencil)
+{
+  LIB_assert(GPU_texture_stencil(wrap(this)) || !use_stencil);
+  stencil_texture_mode_ = use_stencil;
+}
+
+void CPUTexture::mip_range_set(int min, int max)
+{
+  LIB_assert(min <= max && min >= 0 && max <= mipmaps_);
+  mip_min_ = min;
+  mip_max_ = max;
+}
+
+void CPUTexture::read_area(int mip,
+                           int layer,
+                           const int area[4],
+                           int channel_len,
+                           eGPUDataFormat format,
+                           void *r_data)
+{
+  const size_t row_size = convert_buffer_size(format, channel_len, area[2]);
+  uchar *dst = static_cast<uchar *>(r_data);
+  for (int y = area[1]; y < area[1] + area[3]; y++) {
+    convert_from_storage(this->texel_get(mip, area[0], y, layer),
+                         this->channel_len(),
+                         format_,
+                         format,
+                         channel_len,
+                         area[2],
+                         dst);
+    dst += row_size;
+  }
+}
+
+void *CPUTexture::read(int mip, eGPUDataFormat type)
+{
+  LIB_assert(!(format_flag_ & GPU_FORMAT_COMPRESSED));
+  LIB_assert(mip >= 0 && mip < mipmaps_);
+
+  int extent[3];
+  this->mip_extent_get(mip, extent);
+
+  const size_t sample_len = size_t(extent[0]) * extent[1] * extent[2];
+  const size_t texture_size = sample_len * to_bytesize(format_, type);
+  uchar *data = (uchar *)MEM_mallocN(texture_size, "CPUTexture::read");
+
+  const int area[4] = {0, 0, extent[0], extent[1]};
+  const size_t layer_size = texture_size / extent[2];
+  for (int layer = 0; layer < extent[2]; layer++) {
+    this->read_area(mip, layer, area, this->channel_len(), type, data + layer * layer_size);
+  }
+  return data;
+}
+
+/* -------------------------------------------------------------------- */
+/* Sampling */
+
+static inline int wrap_coord(int coord, int size, bool repeat)
+{
+  if (repeat) {
+    coord %= size;
+    return (coord < 0) ? coord + size : coord;
+  }
+  return clamp_i(coord, 0, size - 1);
+}
+
+static float swizzle_component(const float color[4], char swizzle)
+{
+  switch (swizzle) {
+    case 'r':
+      return color[0];
+    case 'g':
+      return color[1];
+    case 'b':
+      return color[2];
+    case 'a':
+      return color[3];
+    case '1':
+      return 1.0f;
+    default:
+      return 0.0f;
+  }
+}
+
+void CPUTexture::sample(float u, float v, const SamplerState &sampler, float r_color[4])
+{
+  const int mip = clamp_i(mip_min_, 0, mipmaps_ - 1);
+  int extent[3];
+  this->mip_extent_get(mip, extent);
+  const int channel_len = this->channel_len();
+  const bool repeat_s = sampler.wrap[0] == SamplerWrap::REPEAT;
+  const bool repeat_t = sampler.wrap[1] == SamplerWrap::REPEAT;
+
+  float color[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+  if ((sampler.wrap[0] == SamplerWrap::CLAMP_TO_BORDER && (u < 0.0f || u > 1.0f)) ||
+      (sampler.wrap[1] == SamplerWrap::CLAMP_TO_BORDER && (v < 0.0f || v > 1.0f)))
+  {
+    color[3] = 0.0f;
+  }
+  else if (sampler.mag_filter == SamplerFilter::LINEAR) {
+    const float x = u * extent[0] - 0.5f;
+    const float y = v * extent[1] - 0.5f;
+    const float fx = floorf(x), fy = floorf(y);
+    const float tx = x - fx, ty = y - fy;
+    const int x0 = wrap_coord(int(fx), extent[0], repeat_s);
+    const int x1 = wrap_coord(int(fx) + 1, extent[0], repeat_s);
+    const int y0 = wrap_coord(int(fy), extent[1], repeat_t);
+    const int y1 = wrap_coord(int(fy) + 1, extent[1], repeat_t);
+    const float *s00 = this->texel_get(mip, x0, y0, 0);
+    const float *s10 = this->texel_get(mip, x1, y0, 0);
+    const float *s01 = this->texel_get(mip, x0, y1, 0);
+    const float *s11 = this->texel_get(mip, x1, y1, 0);
+    for (int c = 0; c < channel_len; c++) {
+      const float bottom = s00[c] + (s10[c] - s00[c]) * tx;
+      const float top = s01[c] + (s11[c] - s01[c]) * tx;
+      color[c] = bottom + (top - bottom) * ty;
+    }
+  }
+  else {
+    const int x = wrap_coord(int(floorf(u * extent[0])), extent[0], repeat_s);
+    const int y = wrap_coord(int(floorf(v * extent[1])), extent[1], repeat_t);
+    memcpy(color, this->texel_get(mip, x, y, 0), sizeof(float) * channel_len);
+  }
+
+  for (int c = 0; c < 4; c++) {
+    r_color[c] = swizzle_component(color, swizzle_[c]);
+  }
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_sampler_private.hh"
+#include "gpu_texture_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Texture stored in system memory.
+ *
+ * Every texel is stored as one float per component, whatever the texture format, so that the
+ * rasterizer and the conversion code only have a single layout to deal with. Integer formats
+ * store the 32bit integer bit pattern in the float slots.
+ * Storage layout is mip after mip, each mip being `[layer or depth][height][width][component]`.
+ */
+class CPUTexture : public Texture {
+ private:
+  /** Storage of all mips. Null for views, which use #src_. */
+  float *data_ = nullptr;
+  /** Offset (in floats) of each mip inside #data_. */
+  size_t mip_offsets_[16] = {0};
+  /** Texture views alias the storage of their source. */
+  CPUTexture *src_ = nullptr;
+  int src_mip_offset_ = 0;
+  int src_layer_offset_ = 0;
+
+  char swizzle_[4] = {'r', 'g', 'b', 'a'};
+  bool stencil_texture_mode_ = false;
+
+ public:
+  CPUTexture(const char *name);
+  ~CPUTexture();
+
+  void update_sub(
+      int mip, int offset[3], int extent[3], eGPUDataFormat type, const void *data) override;
+
+  void generate_mipmap() override;
+  void copy_to(Texture *dst) override;
+  void clear(eGPUDataFormat format, const void *data) override;
+  void swizzle_set(const char swizzle_mask[4]) override;
+  void stencil_texture_mode_set(bool use_stencil) override;
+  void mip_range_set(int min, int max) override;
+  void *read(int mip, eGPUDataFormat type) override;
+  /** The storage is float, #update_sub and #read convert from and to every data format. */
+  bool data_format_is_native(eGPUDataFormat /*format*/) const override
+  {
+    return true;
+  }
+
+  uint gl_bindcode_get() const override
+  {
+    return 0;
+  }
+
+  /** Number of floats per texel. */
+  int channel_len() const
+  {
+    return to_component_len(format_);
+  }
+
+  /** Return the first component of texel (x, y, layer) of the given mip. No bound check. */
+  float *texel_get(int mip, int x, int y, int layer);
+
+  /** Write (or blend by the caller) a texel, clamping the values like the format would. */
+  void texel_store(float *texel, const float value[4]) const;
+
+  /**
+   * Read a region of a mip into \a r_data using the given data format.
+   * \a area is `{x, y, width, height}`. Only the first \a channel_len channels are written.
+   */
+  void read_area(int mip,
+                 int layer,
+                 const int area[4],
+                 int channel_len,
+                 eGPUDataFormat format,
+                 void *r_data);
+
+  /** Fill a region of a mip with a single value given in \a format. */
+  void clear_area(int mip, int layer, const int area[4], eGPUDataFormat format, const void *data);
+
+  /** Sample level #mip_min_ at normalized coordinates (u, v). */
+  void sample(float u, float v, const SamplerState &sampler, float r_color[4]);
+
+ protected:
+  bool init_internal() override;
+  bool init_internal(GPUVertBuf *vbo) override;
+  bool init_internal(const GPUTexture *src, int mip_offset, int layer_offset) override;
+
+ private:
+  /** Number of texels of one mip, all layers included. */
+  size_t mip_texel_len(int mip) const;
+  /** Width, height, depth or layers of the mip in texels, never zero. */
+  void mip_extent_get(int mip, int r_extent[3]) const;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUTexture");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,26 @@
+#include "gpu_immediate_private.hh"
+
+#include "cpu_uniform_buffer.hh"
+
+namespace dust::gpu {
+
+void CPUUniformBuf::update(const void *data)
+{
+  imm_flush_merged();
+  NullUniformBuf::update(data);
+}
+
+void CPUUniformBuf::bind(int slot)
+{
+  /* The merged immediate draws read the buffers bound when they were recorded. */
+  imm_flush_merged();
+  NullUniformBuf::bind(slot);
+}
+
+void CPUUniformBuf::unbind()
+{
+  imm_flush_merged();
+  NullUniformBuf::unbind();
+}
+
+}  // namespace dust::gpu
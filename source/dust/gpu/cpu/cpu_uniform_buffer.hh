@@ -0,0 +1,21 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "null_uniform_buffer.hh"
+
+namespace dust::gpu {
+
+/** Uniform buffer flushing the merged immediate draws before anything they read changes. */
+class CPUUniformBuf : public NullUniformBuf {
+ public:
+  CPUUniformBuf(size_t size, const char *name) : NullUniformBuf(size, name){};
+
+  void update(const void *data) override;
+  void bind(int slot) override;
+  void unbind() override;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUUniformBuf");
+};
+
+}  // namespace dust::gpu
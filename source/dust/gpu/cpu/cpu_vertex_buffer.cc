@@ -0,0 +1,98 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+
+#include "gpu_memory_budget_private.hh"
+
+#include "cpu_vertex_buffer.hh"
+
+namespace dust::gpu {
+
+CPUVertBuf::~CPUVertBuf()
+{
+  MemoryBudget::get().buffer_remove(this);
+}
+
+void CPUVertBuf::allocated_size_set(size_t size)
+{
+  memory_usage -= allocated_size_;
+  memory_usage += size;
+  allocated_size_ = size;
+  MemoryBudget::get().buffer_size_set(this, size);
+}
+
+void CPUVertBuf::acquire_data()
+{
+  /* Device only buffers still need a storage since the device is the host. */
+  MEM_SAFE_FREE(data);
+  data = (uchar *)MEM_callocN(sizeof(uchar) * this->size_alloc_get(), __func__);
+  this->allocated_size_set(this->size_alloc_get());
+}
+
+void CPUVertBuf::resize_data()
+{
+  data = (uchar *)MEM_reallocN(data, sizeof(uchar) * this->size_alloc_get());
+  this->allocated_size_set(this->size_alloc_get());
+}
+
+void CPUVertBuf::release_data()
+{
+  MEM_SAFE_FREE(data);
+  this->allocated_size_set(0);
+}
+
+void CPUVertBuf::duplicate_data(VertBuf *dst_)
+{
+  CPUVertBuf *dst = static_cast<CPUVertBuf *>(dst_);
+  /* The full copy done by #VertBuf::duplicate shares the data pointer. */
+  dst->allocated_size_ = 0;
+  if (data != nullptr) {
+    dst->data = (uchar *)MEM_dupallocN(data);
+    dst->allocated_size_set(allocated_size_);
+  }
+}
+
+void CPUVertBuf::upload_data()
+{
+  if (flag & GPU_VERTBUF_DATA_DIRTY) {
+    flag &= ~GPU_VERTBUF_DATA_DIRTY;
+    flag |= GPU_VERTBUF_DATA_UPLOADED;
+  }
+}
+
+void CPUVertBuf::bind_as_ssbo(uint /*binding*/)
+{
+  this->upload_data();
+}
+
+void CPUVertBuf::bind_as_texture(uint /*binding*/)
+{
+  this->upload_data();
+}
+
+void CPUVertBuf::update_sub(uint start, uint len, const void *data_)
+{
+  LIB_assert(data != nullptr);
+  LIB_assert(start + len <= this->size_alloc_get());
+  memcpy(data + start, data_, len);
+}
+
+const void *CPUVertBuf::read() const
+{
+  return data;
+}
+
+void *CPUVertBuf::unmap(const void *mapped_data) const
+{
+  const size_t size = this->size_used_get();
+  void *result = MEM_mallocN(size, __func__);
+  memcpy(result, mapped_data, size);
+  return result;
+}
+
+void CPUVertBuf::wrap_handle(uint64_t /*handle*/)
+{
+  LIB_assert_msg(0, "CPUVertBuf: wrapping a device handle is not supported");
+}
+
+}  // namespace dust::gpu
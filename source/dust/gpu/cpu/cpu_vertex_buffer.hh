@@ -0,0 +1,51 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_vertex_buffer_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Vertex buffer living in system memory. The host data is the device data, so it is never
+ * freed after upload, whatever the usage.
+ */
+class CPUVertBuf : public VertBuf {
+ private:
+  /** Size of #data accounted in #VertBuf::memory_usage. */
+  size_t allocated_size_ = 0;
+
+ public:
+  ~CPUVertBuf() override;
+
+  void bind_as_ssbo(uint binding) override;
+  void bind_as_texture(uint binding) override;
+
+  void update_sub(uint start, uint len, const void *data) override;
+
+  const void *read() const override;
+  void *unmap(const void *mapped_data) const override;
+
+  void wrap_handle(uint64_t handle) override;
+
+  /** Make sure the data can be read by the rasterizer. */
+  const uchar *data_get()
+  {
+    this->upload();
+    return data;
+  }
+
+ protected:
+  void acquire_data() override;
+  void resize_data() override;
+  void release_data() override;
+  void upload_data() override;
+  void duplicate_data(VertBuf *dst) override;
+
+ private:
+  void allocated_size_set(size_t size);
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CPUVertBuf");
+};
+
+}  // namespace dust::gpu
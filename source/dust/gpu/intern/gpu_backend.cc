@@ -0,0 +1,148 @@
+/* Back-end selection and creation. */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "LIB_utildefines.h"
+
+#include "GPU_backend.h"
+#include "GPU_texture.h"
+#include "GPU_texture_pool.h"
+
+#include "gpu_backend.hh"
+#include "gpu_pipeline_cache_private.hh"
+#include "gpu_readback_private.hh"
+
+#include "cpu_backend.hh"
+#include "null_backend.hh"
+#ifdef WITH_OPENGL_BACKEND
+#  include "gl_backend.hh"
+#endif
+
+namespace dust::gpu {
+
+GPUBackend *gpu_backend_create(eGPUBackendType type)
+{
+  switch (type) {
+#ifdef WITH_OPENGL_BACKEND
+    case GPU_BACKEND_OPENGL:
+      return new GLBackend;
+#endif
+    case GPU_BACKEND_NULL:
+      return new NullBackend;
+    case GPU_BACKEND_CPU:
+      return new CPUBackend;
+    default:
+      break;
+  }
+  return nullptr;
+}
+
+static GPUBackend *g_backend = nullptr;
+static bool g_backend_init_failed = false;
+
+GPUBackend *GPUBackend::get()
+{
+  if (g_backend == nullptr && !g_backend_init_failed) {
+    gpu_backend_init();
+  }
+  return g_backend;
+}
+
+GPUBackend *GPUBackend::get_if_created()
+{
+  return g_backend;
+}
+
+bool gpu_backend_init()
+{
+  if (g_backend != nullptr) {
+    return true;
+  }
+  if (g_backend_init_failed) {
+    return false;
+  }
+  if (!GPU_backend_type_selection_from_env()) {
+    g_backend_init_failed = true;
+    return false;
+  }
+  g_backend = gpu_backend_create(GPU_backend_type_selection_get());
+  if (g_backend == nullptr) {
+    fprintf(stderr, "GPUBackend: Error: selected back-end is not compiled in.\n");
+    g_backend_init_failed = true;
+    return false;
+  }
+  PipelineCache::get().init();
+  return true;
+}
+
+void gpu_backend_exit()
+{
+  if (g_backend != nullptr) {
+    /* Free what still holds objects of the back-end before it is gone. */
+    /* The queued uploads hold references to textures, which can then be pooled. */
+    GPU_texture_upload_queue_free();
+    GPU_texture_pool_free_unused();
+    ReadbackRing::get().free();
+    PipelineCache::get().exit();
+  }
+  delete g_backend;
+  g_backend = nullptr;
+  g_backend_init_failed = false;
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+static eGPUBackendType g_backend_type_selection = GPU_BACKEND_OPENGL;
+
+void GPU_backend_type_selection_set(eGPUBackendType backend)
+{
+  if (GPUBackend::get_if_created() != nullptr) {
+    fprintf(stderr, "GPUBackend: Warning: back-end already created, selection ignored.\n");
+    return;
+  }
+  g_backend_type_selection = backend;
+}
+
+eGPUBackendType GPU_backend_type_selection_get()
+{
+  return g_backend_type_selection;
+}
+
+eGPUBackendType GPU_backend_type_from_name(const char *name)
+{
+  if (name == nullptr) {
+    return GPU_BACKEND_NONE;
+  }
+  if (STREQ(name, "opengl")) {
+    return GPU_BACKEND_OPENGL;
+  }
+  if (STREQ(name, "null")) {
+    return GPU_BACKEND_NULL;
+  }
+  if (STREQ(name, "cpu")) {
+    return GPU_BACKEND_CPU;
+  }
+  return GPU_BACKEND_NONE;
+}
+
+bool GPU_backend_type_selection_from_env()
+{
+  const char *name = getenv("DUST_GPU_BACKEND");
+  if (name == nullptr || name[0] == '\0') {
+    return true;
+  }
+  eGPUBackendType type = GPU_backend_type_from_name(name);
+  if (type == GPU_BACKEND_NONE) {
+    fprintf(stderr, "GPUBackend: Error: unknown back-end \"%s\" in DUST_GPU_BACKEND.\n", name);
+    return false;
+  }
+  GPU_backend_type_selection_set(type);
+  return true;
+}
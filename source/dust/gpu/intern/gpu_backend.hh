@@ -3,10 +3,10 @@
 
 #pragma once
 
+#include "GPU_backend.h"
 #include "GPU_vertex_buffer.h"
 
-namespace blender {
-namespace gpu {
+namespace dust::gpu {
 
 class Context;
 
@@ -16,6 +16,7 @@ class FrameBuffer;
 class IndexBuf;
 class QueryPool;
 class Shader;
+class StagingBuffer;
 class Texture;
 class UniformBuf;
 class StorageBuf;
@@ -26,7 +27,10 @@ class GPUBackend {
   virtual ~GPUBackend() = default;
   virtual void delete_resources() = 0;
 
+  /** Create the back-end on the first call, see #gpu_backend_init. */
   static GPUBackend *get();
+  /** Null until something needed the back-end. */
+  static GPUBackend *get_if_created();
 
   virtual void samplers_update() = 0;
   virtual void compute_dispatch(int groups_x_len, int groups_y_len, int groups_z_len) = 0;
@@ -44,6 +48,8 @@ class GPUBackend {
   virtual UniformBuf *uniformbuf_alloc(int size, const char *name) = 0;
   virtual StorageBuf *storagebuf_alloc(int size, GPUUsageType usage, const char *name) = 0;
   virtual VertBuf *vertbuf_alloc() = 0;
+  /** Back-ends with asynchronous transfers return their own staging buffers. */
+  virtual StagingBuffer *stagingbuf_alloc();
 
   /* Render Frame Coordination --
    * Used for performing per-frame actions globally */
@@ -52,5 +58,22 @@ class GPUBackend {
   virtual void render_step() = 0;
 };
 
-}  // namespace gpu
-}  // namespace blender
+/**
+ * Create the back-end matching \a type. Returns nullptr if the type is not compiled in.
+ */
+GPUBackend *gpu_backend_create(eGPUBackendType type);
+
+/**
+ * Create the back-end returned by #GPUBackend::get, once. The `DUST_GPU_BACKEND` environment
+ * variable overrides #GPU_backend_type_selection_set. Called by the first #GPUBackend::get, which
+ * #GPU_context_create uses to allocate the first context. Returns false if no back-end could be
+ * created, the error is only reported once.
+ */
+bool gpu_backend_init();
+/**
+ * Free the back-end and the shared objects created with it (pooled textures, upload and readback
+ * rings). Called by #GPU_context_discard with the last context still active.
+ */
+void gpu_backend_exit();
+
+}  // namespace dust::gpu
@@ -0,0 +1,253 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+
+#include "GPU_batch_instancer.h"
+#include "GPU_shader.h"
+
+#include "gpu_batch_instancer_private.hh"
+#include "gpu_context_private.hh"
+
+namespace dust::gpu {
+
+BatchInstancerStats BatchInstancer::stats;
+
+static const GPUVertFormat &instance_format()
+{
+  static const GPUVertFormat format = []() {
+    GPUVertFormat format = {0};
+    GPU_vertformat_attr_add(
+        &format, GPU_BATCH_INSTANCER_ATTR_MATRIX, GPU_COMP_F32, 16, GPU_FETCH_FLOAT);
+    GPU_vertformat_attr_add(
+        &format, GPU_BATCH_INSTANCER_ATTR_COLOR, GPU_COMP_F32, 4, GPU_FETCH_FLOAT);
+    return format;
+  }();
+  return format;
+}
+
+uint64_t BatchInstanceKey::hash() const
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  hash = (hash ^ uint64_t(uintptr_t(batch))) * 0x100000001b3ull;
+  hash = (hash ^ uint64_t(uintptr_t(shader))) * 0x100000001b3ull;
+  hash = (hash ^ state.data) * 0x100000001b3ull;
+  for (int i = 0; i < ARRAY_SIZE(mutable_state.data); i++) {
+    hash = (hash ^ mutable_state.data[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+BatchInstancer::~BatchInstancer()
+{
+  for (BatchInstanceProxy &proxy : proxies_.values()) {
+    GPU_batch_discard(proxy.batch);
+  }
+  if (instance_buf_) {
+    GPU_vertbuf_discard(instance_buf_);
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Recording */
+
+void BatchInstancer::draw(GPUBatch *batch,
+                          GPUShader *shader,
+                          const float model_matrix[4][4],
+                          const float color[4])
+{
+  LIB_assert_msg(batch->inst[0] == nullptr, "Batch already uses instance buffers");
+  if (instances_.is_empty()) {
+    framebuffer_ = GPU_framebuffer_active_get();
+  }
+
+  const StateManager *state_manager = Context::get()->state_manager;
+  BatchInstanceKey key;
+  key.batch = batch;
+  key.shader = shader;
+  key.state = state_manager->state;
+  key.mutable_state = state_manager->mutable_state;
+
+  int group_id;
+  const int *id = group_ids_.lookup_ptr(key);
+  if (id) {
+    group_id = *id;
+  }
+  else {
+    group_id = int(groups_.size());
+    groups_.append({key, 0, 0});
+    group_ids_.add_new(key, group_id);
+  }
+  groups_[group_id].len++;
+
+  BatchInstance instance;
+  memcpy(instance.model_matrix, model_matrix, sizeof(instance.model_matrix));
+  memcpy(instance.color, color, sizeof(instance.color));
+  instances_.append(instance);
+  instance_groups_.append(group_id);
+}
+
+/* -------------------------------------------------------------------- */
+/* Submission */
+
+GPUBatch *BatchInstancer::proxy_get(GPUBatch *batch)
+{
+  BatchInstanceProxy *proxy = proxies_.lookup_ptr(batch);
+  if (proxy == nullptr) {
+    proxies_.add_new(batch, {GPU_batch_calloc(), false});
+    proxy = proxies_.lookup_ptr(batch);
+  }
+  proxy->is_used = true;
+
+  /* The recorded batch might have been rebuilt since the last submission. */
+  GPUBatch *dst = proxy->batch;
+  if (dst->prim_type != batch->prim_type || dst->elem != batch->elem ||
+      memcmp(dst->verts, batch->verts, sizeof(batch->verts)) != 0)
+  {
+    GPU_batch_copy(dst, batch);
+    GPU_batch_instbuf_add_ex(dst, instance_buf_, false);
+  }
+  return dst;
+}
+
+void BatchInstancer::proxies_prune()
+{
+  Vector<GPUBatch *> unused;
+  for (auto item : proxies_.items()) {
+    if (item.value.is_used) {
+      item.value.is_used = false;
+    }
+    else {
+      GPU_batch_discard(item.value.batch);
+      unused.append(item.key);
+    }
+  }
+  for (GPUBatch *batch : unused) {
+    proxies_.remove(batch);
+  }
+}
+
+void BatchInstancer::submit()
+{
+  if (instances_.is_empty()) {
+    this->clear();
+    return;
+  }
+
+  LIB_assert_msg(GPU_framebuffer_active_get() == framebuffer_,
+                 "Frame-buffer changed since the draws were recorded");
+
+  /* Counting sort of the instances by group, keeping the recorded order inside each group. */
+  uint32_t offset = 0;
+  for (BatchInstanceGroup &group : groups_) {
+    group.offset = offset;
+    offset += group.len;
+  }
+  sorted_.resize(instances_.size());
+  for (const int64_t i : instances_.index_range()) {
+    BatchInstanceGroup &group = groups_[instance_groups_[i]];
+    sorted_[group.offset++] = instances_[i];
+  }
+
+  /* Upload the instances of all the groups at once. */
+  if (instance_buf_ == nullptr) {
+    instance_buf_ = GPU_vertbuf_create_with_format_ex(&instance_format(), GPU_USAGE_STREAM);
+  }
+  const uint32_t len = uint32_t(sorted_.size());
+  if (GPU_vertbuf_get_vertex_alloc(instance_buf_) < len) {
+    GPU_vertbuf_data_alloc(instance_buf_, power_of_2_max_u(len));
+  }
+  GPU_vertbuf_data_len_set(instance_buf_, len);
+  memcpy(GPU_vertbuf_get_data(instance_buf_), sorted_.data(), sizeof(BatchInstance) * len);
+  GPU_vertbuf_tag_dirty(instance_buf_);
+
+  StateManager *state_manager = Context::get()->state_manager;
+  const GPUState prev_state = state_manager->state;
+  const GPUStateMutable prev_mutable_state = state_manager->mutable_state;
+
+  GPUShader *shader = nullptr;
+  for (const BatchInstanceGroup &group : groups_) {
+    /* #offset is now the end of the group. */
+    const uint32_t first = group.offset - group.len;
+    GPUBatch *batch = this->proxy_get(group.key.batch);
+    if (group.key.shader != shader) {
+      shader = group.key.shader;
+      GPU_shader_bind(shader);
+    }
+    state_manager->state = group.key.state;
+    state_manager->mutable_state = group.key.mutable_state;
+    GPU_batch_draw_advanced(batch, 0, 0, int(first), int(group.len));
+  }
+  this->proxies_prune();
+  stats.draw_len += uint32_t(instances_.size());
+  stats.call_len += uint32_t(groups_.size());
+
+  state_manager->state = prev_state;
+  state_manager->mutable_state = prev_mutable_state;
+
+  this->clear();
+}
+
+void BatchInstancer::clear()
+{
+  groups_.clear();
+  group_ids_.clear();
+  instances_.clear();
+  instance_groups_.clear();
+  framebuffer_ = nullptr;
+}
+
+/* -------------------------------------------------------------------- */
+/* Statistics */
+
+void BatchInstancerStats::frame_step()
+{
+  last_frame.draw_len = draw_len.exchange(0);
+  last_frame.call_len = call_len.exchange(0);
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+static inline BatchInstancer *unwrap(GPUBatchInstancer *instancer)
+{
+  return reinterpret_cast<BatchInstancer *>(instancer);
+}
+
+GPUBatchInstancer *GPU_batch_instancer_create()
+{
+  return reinterpret_cast<GPUBatchInstancer *>(new BatchInstancer());
+}
+
+void GPU_batch_instancer_free(GPUBatchInstancer *instancer)
+{
+  delete unwrap(instancer);
+}
+
+void GPU_batch_instancer_draw(GPUBatchInstancer *instancer,
+                              GPUBatch *batch,
+                              GPUShader *shader,
+                              const float model_matrix[4][4],
+                              const float color[4])
+{
+  unwrap(instancer)->draw(batch, shader, model_matrix, color);
+}
+
+void GPU_batch_instancer_submit(GPUBatchInstancer *instancer)
+{
+  unwrap(instancer)->submit();
+}
+
+void GPU_batch_instancer_clear(GPUBatchInstancer *instancer)
+{
+  unwrap(instancer)->clear();
+}
+
+void GPU_batch_instancer_stats_get(GPUBatchInstancerStats *r_stats)
+{
+  *r_stats = BatchInstancer::stats.last_frame;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_map.hh"
+#include "LIB_vector.hh"
+
+#include "GPU_batch_instancer.h"
+#include "GPU_framebuffer.h"
+
+#include "gpu_state_private.hh"
+
+namespace dust::gpu {
+
+/** Layout of the instance buffer. */
+struct BatchInstance {
+  float model_matrix[4][4];
+  float color[4];
+};
+
+/** What the draws of a group share. */
+struct BatchInstanceKey {
+  GPUBatch *batch;
+  GPUShader *shader;
+  GPUState state;
+  GPUStateMutable mutable_state;
+
+  uint64_t hash() const;
+  bool operator==(const BatchInstanceKey &other) const
+  {
+    return batch == other.batch && shader == other.shader && state == other.state &&
+           mutable_state == other.mutable_state;
+  }
+};
+
+struct BatchInstanceGroup {
+  BatchInstanceKey key;
+  /** Number of draws, then offset of the first one in #BatchInstancer::sorted_. */
+  uint32_t len;
+  uint32_t offset;
+};
+
+/** Copy of a recorded batch, with the instance buffer added. */
+struct BatchInstanceProxy {
+  GPUBatch *batch;
+  /** Drawn by the current submission. Proxies unused by a submission are freed. */
+  bool is_used;
+};
+
+/** Cumulative counters of the current frame and values of the last frame. */
+struct BatchInstancerStats {
+  std::atomic<uint32_t> draw_len = 0;
+  std::atomic<uint32_t> call_len = 0;
+  GPUBatchInstancerStats last_frame = {};
+
+  /** Called by the back-ends at the end of every frame. */
+  void frame_step();
+};
+
+class BatchInstancer {
+ public:
+  static BatchInstancerStats stats;
+
+ private:
+  Vector<BatchInstanceGroup> groups_;
+  Map<BatchInstanceKey, int> group_ids_;
+  /** Recorded instances and the group of each, in recorded order. */
+  Vector<BatchInstance> instances_;
+  Vector<int> instance_groups_;
+  /** Instances ordered by group, filled on submission. */
+  Vector<BatchInstance> sorted_;
+  /**
+   * All the instances of a submission. Each group draws its own range, so that groups of the
+   * same batch don't overwrite the instances of each other before the device reads them.
+   */
+  GPUVertBuf *instance_buf_ = nullptr;
+
+  /**
+   * Kept between consecutive submissions drawing the same batches, rebuilt when the recorded
+   * batch changes. The batches are only known by their address, which can be reused once they
+   * are freed: proxies not drawn by a submission are dropped at its end.
+   */
+  Map<GPUBatch *, BatchInstanceProxy> proxies_;
+
+  /** Active when the first draw was recorded, the groups are all drawn into it. */
+  GPUFrameBuffer *framebuffer_ = nullptr;
+
+ public:
+  BatchInstancer(){};
+  ~BatchInstancer();
+
+  void draw(GPUBatch *batch,
+            GPUShader *shader,
+            const float model_matrix[4][4],
+            const float color[4]);
+  void submit();
+  void clear();
+
+ private:
+  /** Proxy of \a batch reading its instances from #instance_buf_. */
+  GPUBatch *proxy_get(GPUBatch *batch);
+  /** Free the proxies unused since the previous call. */
+  void proxies_prune();
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("BatchInstancer");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,338 @@
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_assert.h"
+#include "LIB_vector.hh"
+
+#include "GPU_command_list.h"
+#include "GPU_shader.h"
+
+#include "gpu_context_private.hh"
+#include "gpu_shader_private.hh"
+
+namespace dust::gpu {
+
+enum class CommandType : uint8_t {
+  SHADER_BIND = 0,
+  BLEND,
+  DEPTH_TEST,
+  FACE_CULLING,
+  WRITE_MASK,
+  LINE_WIDTH,
+  POINT_SIZE,
+  TEXTURE_BIND,
+  UNIFORMBUF_BIND,
+  UNIFORM_FLOAT,
+  UNIFORM_INT,
+  DRAW,
+};
+
+struct Command {
+  CommandType type;
+  union {
+    GPUShader *shader;
+    /** Value of the state enums. */
+    int state;
+    float size;
+    struct {
+      GPUTexture *tex;
+      int unit;
+    } texture;
+    struct {
+      GPUUniformBuf *ubo;
+      int slot;
+    } uniformbuf;
+    struct {
+      int location, length, arraysize;
+      /** Offset of the values in #CommandList::uniform_data_. */
+      int offset;
+    } uniform;
+    struct {
+      GPUBatch *batch;
+      int v_first, v_count, i_first, i_count;
+    } draw;
+  };
+};
+
+class CommandList {
+ private:
+  Vector<Command> commands_;
+  /** Values of the uniform commands, floats and ints stored as 32bit words. */
+  Vector<uint32_t> uniform_data_;
+  /** Last shader bound by the recorded commands, for uniform lookups. */
+  GPUShader *shader_ = nullptr;
+
+ public:
+  void reset()
+  {
+    commands_.clear();
+    uniform_data_.clear();
+    shader_ = nullptr;
+  }
+
+  bool is_empty() const
+  {
+    return commands_.is_empty();
+  }
+
+  Command &append(CommandType type)
+  {
+    commands_.append({});
+    Command &command = commands_.last();
+    command.type = type;
+    return command;
+  }
+
+  void shader_bind(GPUShader *shader)
+  {
+    this->append(CommandType::SHADER_BIND).shader = shader;
+    shader_ = shader;
+  }
+
+  int uniform_location(const char *name)
+  {
+    return shader_ ? GPU_shader_get_uniform(shader_, name) : -1;
+  }
+
+  void uniform(CommandType type, int location, int length, int arraysize, const void *value)
+  {
+    LIB_assert_msg(shader_ != nullptr, "Uniform recorded without a shader");
+    if (location == -1) {
+      return;
+    }
+    Command &command = this->append(type);
+    command.uniform.location = location;
+    command.uniform.length = length;
+    command.uniform.arraysize = arraysize;
+    command.uniform.offset = int(uniform_data_.size());
+    const int64_t word_len = int64_t(length) * arraysize;
+    uniform_data_.resize(uniform_data_.size() + word_len);
+    memcpy(&uniform_data_[command.uniform.offset], value, sizeof(uint32_t) * word_len);
+  }
+
+  void replay();
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("CommandList");
+};
+
+void CommandList::replay()
+{
+  Context *ctx = Context::get();
+  StateManager *state_manager = ctx->state_manager;
+  const GPUState prev_state = state_manager->state;
+  const GPUStateMutable prev_mutable_state = state_manager->mutable_state;
+  Shader *prev_shader = ctx->shader;
+  /* Resources bound by the list, unbound at the end. */
+  Vector<GPUTexture *> textures;
+  Vector<GPUUniformBuf *> ubos;
+
+  GPUShader *shader = nullptr;
+  for (const Command &command : commands_) {
+    switch (command.type) {
+      case CommandType::SHADER_BIND:
+        shader = command.shader;
+        GPU_shader_bind(shader);
+        break;
+      case CommandType::BLEND:
+        GPU_blend(eGPUBlend(command.state));
+        break;
+      case CommandType::DEPTH_TEST:
+        GPU_depth_test(eGPUDepthTest(command.state));
+        break;
+      case CommandType::FACE_CULLING:
+        GPU_face_culling(eGPUFaceCullTest(command.state));
+        break;
+      case CommandType::WRITE_MASK:
+        GPU_write_mask(eGPUWriteMask(command.state));
+        break;
+      case CommandType::LINE_WIDTH:
+        GPU_line_width(command.size);
+        break;
+      case CommandType::POINT_SIZE:
+        GPU_point_size(command.size);
+        break;
+      case CommandType::TEXTURE_BIND:
+        GPU_texture_bind(command.texture.tex, command.texture.unit);
+        textures.append(command.texture.tex);
+        break;
+      case CommandType::UNIFORMBUF_BIND:
+        GPU_uniformbuf_bind(command.uniformbuf.ubo, command.uniformbuf.slot);
+        ubos.append(command.uniformbuf.ubo);
+        break;
+      case CommandType::UNIFORM_FLOAT:
+        GPU_shader_uniform_vector(shader,
+                                  command.uniform.location,
+                                  command.uniform.length,
+                                  command.uniform.arraysize,
+                                  (const float *)&uniform_data_[command.uniform.offset]);
+        break;
+      case CommandType::UNIFORM_INT:
+        GPU_shader_uniform_vector_int(shader,
+                                      command.uniform.location,
+                                      command.uniform.length,
+                                      command.uniform.arraysize,
+                                      (const int *)&uniform_data_[command.uniform.offset]);
+        break;
+      case CommandType::DRAW:
+        LIB_assert_msg(shader != nullptr, "Draw recorded without a shader");
+        GPU_batch_draw_advanced(command.draw.batch,
+                                command.draw.v_first,
+                                command.draw.v_count,
+                                command.draw.i_first,
+                                command.draw.i_count);
+        break;
+    }
+  }
+
+  for (GPUTexture *tex : textures) {
+    GPU_texture_unbind(tex);
+  }
+  for (GPUUniformBuf *ubo : ubos) {
+    GPU_uniformbuf_unbind(ubo);
+  }
+  if (ctx->shader != prev_shader) {
+    if (prev_shader) {
+      GPU_shader_bind(wrap(prev_shader));
+    }
+    else {
+      GPU_shader_unbind();
+    }
+  }
+  state_manager->state = prev_state;
+  state_manager->mutable_state = prev_mutable_state;
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+static inline CommandList *unwrap(GPUCommandList *list)
+{
+  return reinterpret_cast<CommandList *>(list);
+}
+
+GPUCommandList *GPU_command_list_create()
+{
+  return reinterpret_cast<GPUCommandList *>(new CommandList());
+}
+
+void GPU_command_list_free(GPUCommandList *list)
+{
+  delete unwrap(list);
+}
+
+void GPU_command_list_reset(GPUCommandList *list)
+{
+  unwrap(list)->reset();
+}
+
+bool GPU_command_list_is_empty(const GPUCommandList *list)
+{
+  return reinterpret_cast<const CommandList *>(list)->is_empty();
+}
+
+void GPU_command_list_replay(GPUCommandList *list)
+{
+  unwrap(list)->replay();
+}
+
+void GPU_command_list_shader_bind(GPUCommandList *list, GPUShader *shader)
+{
+  unwrap(list)->shader_bind(shader);
+}
+
+void GPU_command_list_blend(GPUCommandList *list, eGPUBlend blend)
+{
+  unwrap(list)->append(CommandType::BLEND).state = int(blend);
+}
+
+void GPU_command_list_depth_test(GPUCommandList *list, eGPUDepthTest test)
+{
+  unwrap(list)->append(CommandType::DEPTH_TEST).state = int(test);
+}
+
+void GPU_command_list_face_culling(GPUCommandList *list, eGPUFaceCullTest culling)
+{
+  unwrap(list)->append(CommandType::FACE_CULLING).state = int(culling);
+}
+
+void GPU_command_list_write_mask(GPUCommandList *list, eGPUWriteMask mask)
+{
+  unwrap(list)->append(CommandType::WRITE_MASK).state = int(mask);
+}
+
+void GPU_command_list_line_width(GPUCommandList *list, float width)
+{
+  unwrap(list)->append(CommandType::LINE_WIDTH).size = width;
+}
+
+void GPU_command_list_point_size(GPUCommandList *list, float size)
+{
+  unwrap(list)->append(CommandType::POINT_SIZE).size = size;
+}
+
+void GPU_command_list_texture_bind(GPUCommandList *list, GPUTexture *tex, int unit)
+{
+  Command &command = unwrap(list)->append(CommandType::TEXTURE_BIND);
+  command.texture.tex = tex;
+  command.texture.unit = unit;
+}
+
+void GPU_command_list_uniformbuf_bind(GPUCommandList *list, GPUUniformBuf *ubo, int slot)
+{
+  Command &command = unwrap(list)->append(CommandType::UNIFORMBUF_BIND);
+  command.uniformbuf.ubo = ubo;
+  command.uniformbuf.slot = slot;
+}
+
+void GPU_command_list_uniform_vector(
+    GPUCommandList *list, int location, int length, int arraysize, const float *value)
+{
+  unwrap(list)->uniform(CommandType::UNIFORM_FLOAT, location, length, arraysize, value);
+}
+
+void GPU_command_list_uniform_vector_int(
+    GPUCommandList *list, int location, int length, int arraysize, const int *value)
+{
+  unwrap(list)->uniform(CommandType::UNIFORM_INT, location, length, arraysize, value);
+}
+
+void GPU_command_list_uniform_1i(GPUCommandList *list, const char *name, int value)
+{
+  CommandList *cmd_list = unwrap(list);
+  cmd_list->uniform(CommandType::UNIFORM_INT, cmd_list->uniform_location(name), 1, 1, &value);
+}
+
+void GPU_command_list_uniform_1f(GPUCommandList *list, const char *name, float value)
+{
+  CommandList *cmd_list = unwrap(list);
+  cmd_list->uniform(CommandType::UNIFORM_FLOAT, cmd_list->uniform_location(name), 1, 1, &value);
+}
+
+void GPU_command_list_uniform_4fv(GPUCommandList *list, const char *name, const float data[4])
+{
+  CommandList *cmd_list = unwrap(list);
+  cmd_list->uniform(CommandType::UNIFORM_FLOAT, cmd_list->uniform_location(name), 4, 1, data);
+}
+
+void GPU_command_list_uniform_mat4(GPUCommandList *list, const char *name, const float data[4][4])
+{
+  CommandList *cmd_list = unwrap(list);
+  cmd_list->uniform(
+      CommandType::UNIFORM_FLOAT, cmd_list->uniform_location(name), 16, 1, &data[0][0]);
+}
+
+void GPU_command_list_draw_ex(
+    GPUCommandList *list, GPUBatch *batch, int v_first, int v_count, int i_first, int i_count)
+{
+  Command &command = unwrap(list)->append(CommandType::DRAW);
+  command.draw.batch = batch;
+  command.draw.v_first = v_first;
+  command.draw.v_count = v_count;
+  command.draw.i_first = i_first;
+  command.draw.i_count = i_count;
+}
@@ -0,0 +1,124 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+
+#include "gpu_drawlist_indirect.hh"
+
+namespace dust::gpu {
+
+static const GPUVertFormat &staging_format()
+{
+  /* Raw 32 bit words, the commands are never read as vertices. */
+  static const GPUVertFormat format = []() {
+    GPUVertFormat format = {0};
+    GPU_vertformat_attr_add(&format, "data", GPU_COMP_U32, 1, GPU_FETCH_INT);
+    return format;
+  }();
+  return format;
+}
+
+IndirectDrawList::IndirectDrawList(int length, bool use_multi_draw)
+    : command_max_(max_ii(length, 1)), use_multi_draw_(use_multi_draw)
+{
+  commands_.reserve(command_max_);
+}
+
+IndirectDrawList::~IndirectDrawList()
+{
+  if (command_buf_) {
+    GPU_storagebuf_free(command_buf_);
+  }
+  if (staging_buf_) {
+    GPU_vertbuf_discard(staging_buf_);
+  }
+}
+
+void IndirectDrawList::append(GPUBatch *batch, int i_first, int i_count)
+{
+  if (batch != batch_ || commands_.size() == command_max_) {
+    this->submit();
+    batch_ = batch;
+    int i_count_unused;
+    GPU_batch_draw_parameter_get(batch, &v_count_, &v_first_, &base_index_, &i_count_unused);
+  }
+  if (i_count == 0) {
+    return;
+  }
+
+  GPUDrawCommand command;
+  command.v_count = uint(v_count_);
+  command.i_count = uint(i_count);
+  command.v_first = uint(v_first_);
+  if (base_index_ == -1) {
+    /* Non-indexed commands have the first instance in place of the base index. */
+    command.base_index = i_first;
+    command.i_first = 0;
+  }
+  else {
+    command.base_index = base_index_;
+    command.i_first = uint(i_first);
+  }
+  commands_.append(command);
+}
+
+void IndirectDrawList::submit()
+{
+  if (commands_.is_empty()) {
+    batch_ = nullptr;
+    return;
+  }
+
+  if (!use_multi_draw_ || commands_.size() == 1) {
+    /* Nothing to gain from the indirect path. */
+    for (const GPUDrawCommand &command : commands_) {
+      const int i_first = (base_index_ == -1) ? command.base_index : int(command.i_first);
+      GPU_batch_draw_advanced(
+          batch_, int(command.v_first), int(command.v_count), i_first, int(command.i_count));
+    }
+  }
+  else {
+    const int command_len = int(commands_.size());
+    const uint command_word_len = uint(sizeof(GPUDrawCommand) / sizeof(uint32_t));
+    const uint word_len = command_word_len * uint(command_len);
+    if (staging_buf_ == nullptr) {
+      staging_buf_ = GPU_vertbuf_create_with_format_ex(&staging_format(), GPU_USAGE_STREAM);
+      GPU_vertbuf_data_alloc(staging_buf_, command_word_len * uint(command_max_));
+    }
+    /* Only upload the commands of the run, the rest of the buffer is left as it is. */
+    GPU_vertbuf_data_len_set(staging_buf_, word_len);
+    memcpy(GPU_vertbuf_get_data(staging_buf_), commands_.data(), word_len * sizeof(uint32_t));
+    GPU_vertbuf_tag_dirty(staging_buf_);
+    GPU_vertbuf_use(staging_buf_);
+    GPU_storagebuf_copy_sub_from_vertbuf(
+        this->command_buf_get(), staging_buf_, 0, 0, word_len * sizeof(uint32_t));
+    GPU_batch_multi_draw_indirect(batch_, command_buf_, command_len, 0, sizeof(GPUDrawCommand));
+  }
+
+  commands_.clear();
+  batch_ = nullptr;
+}
+
+GPUStorageBuf *IndirectDrawList::command_buf_get()
+{
+  if (command_buf_ == nullptr) {
+    command_buf_ = GPU_storagebuf_create_ex(
+        sizeof(GPUDrawCommand) * command_max_, nullptr, GPU_USAGE_STREAM, "DrawList");
+  }
+  return command_buf_;
+}
+
+void IndirectDrawList::submit_device(GPUBatch *batch, int command_len)
+{
+  LIB_assert(command_len <= command_max_);
+  this->submit();
+  if (command_len == 0) {
+    return;
+  }
+  /* Even back-ends without multi-draw read the arguments from the buffer, there is no copy of
+   * them on the host. */
+  GPU_batch_multi_draw_indirect(
+      batch, this->command_buf_get(), command_len, 0, sizeof(GPUDrawCommand));
+}
+
+}  // namespace dust::gpu
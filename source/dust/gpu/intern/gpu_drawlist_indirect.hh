@@ -0,0 +1,61 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_vector.hh"
+
+#include "GPU_batch.h"
+#include "GPU_storage_buffer.h"
+
+#include "gpu_drawlist_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Draw list writing the draw arguments into a storage buffer, submitted with one multi-draw
+ * indirect call per run of consecutive draws of the same batch.
+ *
+ * Back-ends which can't read draw arguments from a buffer disable #use_multi_draw: the commands
+ * are then drawn one by one on submission, still without any per draw work until then.
+ *
+ * The arguments can also be written on the device, by a culling compute shader for instance:
+ * the shader writes #command_buf_get and #submit_device draws them without any upload.
+ * The CPU back-end reads them from the host copy of the buffer, which only holds what the host
+ * wrote since compute shaders are not executed there.
+ */
+class IndirectDrawList : public DrawList {
+ private:
+  /** Arguments of the current run, uploaded to #command_buf_ on submission. */
+  Vector<GPUDrawCommand> commands_;
+  int command_max_;
+  GPUStorageBuf *command_buf_ = nullptr;
+  /**
+   * The commands of a run are uploaded here then copied to #command_buf_, storage buffers only
+   * being updated whole.
+   */
+  GPUVertBuf *staging_buf_ = nullptr;
+  bool use_multi_draw_;
+
+  /** Batch of the current run and its draw parameters. */
+  GPUBatch *batch_ = nullptr;
+  int v_count_ = 0, v_first_ = 0, base_index_ = 0;
+
+ public:
+  IndirectDrawList(int length, bool use_multi_draw);
+  ~IndirectDrawList();
+
+  void append(GPUBatch *batch, int i_first, int i_count) override;
+  void submit() override;
+
+  /** Buffer of the #GPUDrawCommand of a run, room for as many as the list length. */
+  GPUStorageBuf *command_buf_get();
+  /**
+   * Draw \a batch with the \a command_len first commands written in #command_buf_get by the
+   * device. The commands appended before are submitted first.
+   */
+  void submit_device(GPUBatch *batch, int command_len);
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("IndirectDrawList");
+};
+
+}  // namespace dust::gpu
@@ -5,11 +5,14 @@
 
 #include "GPU_batch.h"
 #include "GPU_capabilities.h"
+#include "GPU_memory_budget.h"
 #include "GPU_shader.h"
 #include "GPU_texture.h"
+#include "GPU_texture_pool.h"
 
 #include "gpu_backend.hh"
 #include "gpu_context_private.hh"
+#include "gpu_readback_private.hh"
 #include "gpu_texture_private.hh"
 
 #include "gpu_framebuffer_private.hh"
@@ -137,6 +140,16 @@ void FrameBuffer::load_store_config_array(const GPULoadStore *load_store_actions
   }
 }
 
+void FrameBuffer::read_async(eGPUFrameBufferBits planes,
+                             eGPUDataFormat format,
+                             const int area[4],
+                             int channel_len,
+                             int slot,
+                             StagingBuffer *dst)
+{
+  this->read(planes, format, area, channel_len, slot, dst->host_data_get());
+}
+
 uint FrameBuffer::get_bits_per_pixel()
 {
   uint total_bits = 0;
@@ -154,6 +167,18 @@ void FrameBuffer::recursive_downsample(int max_lvl,
                                        void (*callback)(void *userData, int level),
                                        void *userData)
 {
+  /* With a callback, each level is rendered by the caller's own filter shader reading the
+   * previous level: it can't be folded into the single dispatch of #GPU_texture_downsample. */
+  if (callback == nullptr) {
+    /* Plain box filter: no need to render each level, let the textures generate their chain. */
+    for (GPUAttachment &attachment : attachments_) {
+      if (attachment.tex != nullptr) {
+        GPU_texture_downsample(attachment.tex, max_lvl);
+      }
+    }
+    return;
+  }
+
   /* Bind to make sure the frame-buffer is up to date. */
   this->bind(true);
 
@@ -431,6 +456,23 @@ void GPU_framebuffer_read_color(GPUFrameBuffer *gpu_fb,
   unwrap(gpu_fb)->read(GPU_COLOR_BIT, format, rect, channels, slot, data);
 }
 
+GPUReadback *GPU_framebuffer_read_color_async(GPUFrameBuffer *gpu_fb,
+                                              int x,
+                                              int y,
+                                              int w,
+                                              int h,
+                                              int channels,
+                                              int slot,
+                                              eGPUDataFormat format)
+{
+  int rect[4] = {x, y, w, h};
+  const size_t size = size_t(w) * h * channels * to_bytesize(format);
+  Readback *readback = ReadbackRing::get().acquire(size);
+  unwrap(gpu_fb)->read_async(GPU_COLOR_BIT, format, rect, channels, slot, readback->buffer);
+  readback->buffer->fence_insert();
+  return wrap(readback);
+}
+
 /* TODO(fclem): rename to read_color. */
 void GPU_frontbuffer_read_pixels(
     int x, int y, int w, int h, int channels, eGPUDataFormat format, void *data)
@@ -605,11 +647,11 @@ GPUOffScreen *GPU_offscreen_create(
   height = max_ii(1, height);
   width = max_ii(1, width);
 
-  ofs->color = GPU_texture_create_2d("ofs_color", width, height, 1, format, nullptr);
+  /* Off-screens are recreated on every region resize, recycle their textures. */
+  ofs->color = GPU_texture_pool_acquire("ofs_color", width, height, 1, format);
 
   if (depth) {
-    ofs->depth = GPU_texture_create_2d(
-        "ofs_depth", width, height, 1, GPU_DEPTH24_STENCIL8, nullptr);
+    ofs->depth = GPU_texture_pool_acquire("ofs_depth", width, height, 1, GPU_DEPTH24_STENCIL8);
   }
 
   if ((depth && !ofs->depth) || !ofs->color) {
@@ -623,6 +665,10 @@ GPUOffScreen *GPU_offscreen_create(
     GPU_offscreen_free(ofs);
     return nullptr;
   }
+  GPU_texture_memory_category_set(ofs->color, GPU_MEMORY_CATEGORY_OFFSCREEN);
+  if (ofs->depth) {
+    GPU_texture_memory_category_set(ofs->depth, GPU_MEMORY_CATEGORY_OFFSCREEN);
+  }
 
   GPUFrameBuffer *fb = gpu_offscreen_fb_get(ofs);
 
@@ -643,10 +689,10 @@ void GPU_offscreen_free(GPUOffScreen *ofs)
     }
   }
   if (ofs->color) {
-    GPU_texture_free(ofs->color);
+    GPU_texture_pool_release(ofs->color);
   }
   if (ofs->depth) {
-    GPU_texture_free(ofs->depth);
+    GPU_texture_pool_release(ofs->depth);
   }
 
   MEM_freeN(ofs);
@@ -694,6 +740,17 @@ void GPU_offscreen_read_pixels(GPUOffScreen *ofs, eGPUDataFormat format, void *p
   GPU_framebuffer_read_color(ofs_fb, 0, 0, w, h, 4, 0, format, pixels);
 }
 
+GPUReadback *GPU_offscreen_read_pixels_async(GPUOffScreen *ofs, eGPUDataFormat format)
+{
+  BLI_assert(ELEM(format, GPU_DATA_UBYTE, GPU_DATA_FLOAT));
+
+  const int w = GPU_texture_width(ofs->color);
+  const int h = GPU_texture_height(ofs->color);
+
+  GPUFrameBuffer *ofs_fb = gpu_offscreen_fb_get(ofs);
+  return GPU_framebuffer_read_color_async(ofs_fb, 0, 0, w, h, 4, 0, format);
+}
+
 int GPU_offscreen_width(const GPUOffScreen *ofs)
 {
   return GPU_texture_width(ofs->color);
@@ -56,6 +56,8 @@ inline GPUAttachmentType &operator--(GPUAttachmentType &a)
 namespace blender {
 namespace gpu {
 
+class StagingBuffer;
+
 #ifdef DEBUG
 #  define DEBUG_NAME_LEN 64
 #else
@@ -112,6 +114,16 @@ class FrameBuffer {
                     int channel_len,
                     int slot,
                     void *r_data) = 0;
+  /**
+   * Same as #read but the copy might complete later. \a dst is already large enough and its
+   * fence is inserted by the caller. Default implementation reads synchronously.
+   */
+  virtual void read_async(eGPUFrameBufferBits planes,
+                          eGPUDataFormat format,
+                          const int area[4],
+                          int channel_len,
+                          int slot,
+                          StagingBuffer *dst);
 
   virtual void blit_to(eGPUFrameBufferBits planes,
                        int src_slot,
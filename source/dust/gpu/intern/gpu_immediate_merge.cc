@@ -0,0 +1,221 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_utildefines.h"
+
+#include "GPU_matrix.h"
+
+#include "gpu_context_private.hh"
+#include "gpu_vertex_format_private.hh"
+
+namespace dust::gpu {
+
+bool Immediate::use_merge = true;
+
+/* -------------------------------------------------------------------- */
+/* Merging */
+
+static inline bool prim_type_is_mergeable(GPUPrimType prim_type)
+{
+  /* Line strips, loops and fans can't be joined without changing what they draw. */
+  return ELEM(prim_type, GPU_PRIM_POINTS, GPU_PRIM_LINES, GPU_PRIM_TRIS, GPU_PRIM_TRI_STRIP);
+}
+
+/**
+ * Vertices of the complete primitives among the \a vertex_len first ones. With #immBeginAtMost
+ * the draw can end in the middle of a primitive, whose vertices would be taken as the start of a
+ * primitive of the next merged draw.
+ */
+static uint prim_vertex_len_complete(GPUPrimType prim_type, uint vertex_len)
+{
+  switch (prim_type) {
+    case GPU_PRIM_LINES:
+      return vertex_len - vertex_len % 2;
+    case GPU_PRIM_TRIS:
+      return vertex_len - vertex_len % 3;
+    case GPU_PRIM_TRI_STRIP:
+      return (vertex_len < 3) ? 0 : vertex_len;
+    default:
+      return vertex_len;
+  }
+}
+
+bool Immediate::merge_compatible() const
+{
+  if (merged_.vertex_len == 0 || !use_merge || !prim_type_is_mergeable(prim_type)) {
+    return false;
+  }
+  if (merged_.prim_type != prim_type || merged_.shader != shader) {
+    return false;
+  }
+  /* The matrices of the merged draws are already in the shader uniforms. */
+  if (GPU_matrix_dirty_get()) {
+    return false;
+  }
+  if (memcmp(&merged_.vertex_format, &vertex_format, sizeof(vertex_format)) != 0) {
+    return false;
+  }
+  const Context *ctx = Context::get();
+  const StateManager *state_manager = ctx->state_manager;
+  if (merged_.state != state_manager->state ||
+      merged_.mutable_state != state_manager->mutable_state)
+  {
+    return false;
+  }
+  const FrameBuffer *fb = ctx->active_fb;
+  if (merged_.framebuffer != fb) {
+    return false;
+  }
+  if (fb) {
+    int viewport[4], scissor[4];
+    fb->viewport_get(viewport);
+    fb->scissor_get(scissor);
+    if (!equals_v4v4_int(merged_.viewport, viewport) ||
+        !equals_v4v4_int(merged_.scissor, scissor) ||
+        merged_.scissor_test != fb->scissor_test_get())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+uchar *Immediate::begin()
+{
+  merging_ = false;
+  join_len_ = 0;
+
+  if (this->merge_compatible()) {
+    /* Join triangle strips with degenerate triangles, keeping the winding of the new strip. */
+    const uint join_len = (prim_type == GPU_PRIM_TRI_STRIP) ? ((merged_.vertex_len & 1) ? 3 : 2) :
+                                                              0;
+    uchar *data = ring->alloc_append(vertex_buffer_size(&vertex_format, join_len + vertex_len));
+    if (data) {
+      merging_ = true;
+      join_len_ = join_len;
+      return data + join_len * vertex_format.stride;
+    }
+  }
+
+  this->flush();
+  return ring->alloc(vertex_buffer_size(&vertex_format, vertex_len));
+}
+
+void Immediate::end()
+{
+  LIB_assert(prim_type != GPU_PRIM_NONE); /* Make sure we're between a Begin/End pair. */
+
+  /* The vertices of an incomplete primitive are dropped, as the device would. */
+  const uint vertex_len_used = prim_type_is_mergeable(prim_type) ?
+                                   prim_vertex_len_complete(prim_type, vertex_idx) :
+                                   vertex_idx;
+  if (vertex_len_used == 0) {
+    return;
+  }
+  if (GPU_matrix_dirty_get()) {
+    GPU_matrix_bind(shader);
+  }
+
+  uchar *data = ring->current_data();
+  const uint stride = vertex_format.stride;
+  if (join_len_ > 0) {
+    /* Repeat the last vertex of the merged strip, then the first one of the new strip. */
+    for (uint i = 0; i < join_len_ - 1; i++) {
+      memcpy(data + i * stride, data - stride, stride);
+    }
+    memcpy(data + (join_len_ - 1) * stride, data + join_len_ * stride, stride);
+  }
+  ring->commit(vertex_buffer_size(&vertex_format, join_len_ + vertex_len_used));
+
+  if (merging_) {
+    merged_.vertex_len += join_len_ + vertex_len_used;
+    ImmediateRing::stats.merged_len++;
+    return;
+  }
+
+  if (!use_merge || !prim_type_is_mergeable(prim_type)) {
+    this->draw(prim_type, shader, &vertex_format, data, vertex_len_used);
+    ring->submit();
+    return;
+  }
+
+  /* Keep the draw for the next ones to be appended to it. */
+  const Context *ctx = Context::get();
+  merged_.prim_type = prim_type;
+  merged_.shader = shader;
+  merged_.vertex_format = vertex_format;
+  merged_.state = ctx->state_manager->state;
+  merged_.mutable_state = ctx->state_manager->mutable_state;
+  merged_.framebuffer = ctx->active_fb;
+  if (ctx->active_fb) {
+    ctx->active_fb->viewport_get(merged_.viewport);
+    ctx->active_fb->scissor_get(merged_.scissor);
+    merged_.scissor_test = ctx->active_fb->scissor_test_get();
+  }
+  merged_.data = data;
+  merged_.vertex_len = vertex_len_used;
+}
+
+void Immediate::flush()
+{
+  if (merged_.vertex_len == 0) {
+    return;
+  }
+  /* Reset first, drawing can end up calling back here. */
+  const ImmediateMergedDraw merged = merged_;
+  merged_.vertex_len = 0;
+
+  /* Draw with the context as it was when the draws were recorded. */
+  Context *ctx = Context::get();
+  StateManager *state_manager = ctx->state_manager;
+  const GPUState prev_state = state_manager->state;
+  const GPUStateMutable prev_mutable_state = state_manager->mutable_state;
+  state_manager->state = merged.state;
+  state_manager->mutable_state = merged.mutable_state;
+
+  FrameBuffer *fb = ctx->active_fb;
+  LIB_assert_msg(fb == merged.framebuffer, "Frame-buffer changed without flushing");
+  int prev_viewport[4], prev_scissor[4];
+  bool prev_scissor_test = false;
+  if (fb) {
+    fb->viewport_get(prev_viewport);
+    fb->scissor_get(prev_scissor);
+    prev_scissor_test = fb->scissor_test_get();
+    fb->viewport_set(merged.viewport);
+    fb->scissor_set(merged.scissor);
+    fb->scissor_test_set(merged.scissor_test);
+  }
+
+  this->draw(
+      merged.prim_type, merged.shader, &merged.vertex_format, merged.data, merged.vertex_len);
+  ring->submit();
+
+  if (fb) {
+    fb->viewport_set(prev_viewport);
+    fb->scissor_set(prev_scissor);
+    fb->scissor_test_set(prev_scissor_test);
+  }
+  state_manager->state = prev_state;
+  state_manager->mutable_state = prev_mutable_state;
+}
+
+void imm_flush_merged()
+{
+  Context *ctx = Context::get();
+  if (ctx && ctx->imm) {
+    ctx->imm->flush();
+  }
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+void GPU_immediate_merge_set(bool enable)
+{
+  imm_flush_merged();
+  Immediate::use_merge = enable;
+}
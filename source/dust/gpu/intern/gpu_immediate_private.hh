@@ -2,16 +2,167 @@
 
 #pragma once
 
+#include <atomic>
 #include <optional>
 
+#include "MEM_guardedalloc.h"
+
+#include "LIB_vector.hh"
+
 #include "GPU_batch.h"
+#include "GPU_immediate_ring.h"
 #include "GPU_primitive.h"
 #include "GPU_shader.h"
 #include "GPU_vertex_format.h"
 
+#include "gpu_state_private.hh"
+
 namespace dust::gpu {
 
+class FrameBuffer;
+
+/** Cumulative counters of the current frame and values of the last frame. */
+struct ImmediateRingStats {
+  std::atomic<uint64_t> bytes_streamed = 0;
+  std::atomic<uint32_t> draw_len = 0;
+  std::atomic<uint32_t> wrap_len = 0;
+  std::atomic<uint32_t> stall_len = 0;
+  std::atomic<uint32_t> merged_len = 0;
+  GPUImmediateRingStats last_frame = {};
+
+  /** Called by the back-ends at the end of every frame. */
+  void frame_step();
+};
+
+/**
+ * Vertex stream of the immediate mode. One buffer, mapped once, in which each draw takes the
+ * range following the previous one. A fence is inserted every #IMM_RING_FENCE_LEN-th of the
+ * buffer, and a range is only overwritten once the fence following it is signaled. Fences only
+ * cover the ranges of submitted draws: merged draws are committed long before they are drawn.
+ *
+ * The base implementation is host memory with fences that are always signaled, for back-ends
+ * consuming the vertices during #Immediate::end. Other back-ends override the buffer and fence
+ * methods (persistent mapping, sync objects, ...).
+ */
+class ImmediateRing {
+ public:
+  static ImmediateRingStats stats;
+
+ protected:
+  /** Mapped memory. */
+  uchar *data_ = nullptr;
+  size_t size_ = 0;
+
+ private:
+  struct Fence {
+    uint64_t handle;
+    /** Value of #submitted_ when the fence was inserted. */
+    uint64_t end;
+  };
+
+  /* Positions are counted in bytes since creation, the offset in the buffer is the modulo. */
+  /** End of the last draw. */
+  uint64_t head_ = 0;
+  /** End of the last draw submitted to the device, see #submit. */
+  uint64_t submitted_ = 0;
+  /** Start of the oldest range the device can still read. */
+  uint64_t tail_ = 0;
+  /** Value of #submitted_ when the last fence was inserted. */
+  uint64_t fenced_ = 0;
+  /** Offset of the range of the current draw. */
+  size_t current_ = 0;
+  /** Pending fences, oldest at #first_fence_. */
+  Vector<Fence> fences_;
+  int64_t first_fence_ = 0;
+
+ public:
+  ImmediateRing(){};
+  virtual ~ImmediateRing();
+
+  /** Range of at least \a size bytes for the next draw. */
+  uchar *alloc(size_t size);
+  /**
+   * Range starting right where the previous draw ended, so that both are contiguous.
+   * Return nullptr if the range would cross the end of the buffer.
+   */
+  uchar *alloc_append(size_t size);
+  /** End the draw started with #alloc, of which \a size bytes were written. */
+  void commit(size_t size);
+  /**
+   * Called once the draw commands reading everything committed so far are submitted. Inserts
+   * the fences, which must come after the commands reading the ranges they release.
+   */
+  void submit();
+  /** Start of the range of the current draw. */
+  uchar *current_data() const
+  {
+    return data_ + current_;
+  }
+  size_t current_offset() const
+  {
+    return current_;
+  }
+
+ protected:
+  /** Create and map #data_ of \a size bytes. The previous buffer is unused when called. */
+  virtual void buffer_create(size_t size);
+  virtual void buffer_free();
+  /** Make the bytes written in a range visible to the device, for non-coherent mappings. */
+  virtual void flush_range(size_t /*offset*/, size_t /*size*/){};
+
+  /** Insert a fence after the commands submitted so far and return its handle. */
+  virtual uint64_t fence_insert()
+  {
+    return 0;
+  }
+  virtual bool fence_is_signaled(uint64_t /*handle*/)
+  {
+    return true;
+  }
+  /** Wait for the fence then free it. */
+  virtual void fence_wait(uint64_t /*handle*/){};
+  /** Free a signaled fence. */
+  virtual void fence_free(uint64_t /*handle*/){};
+
+ private:
+  void fence_push();
+  /** Wait for the device until everything before \a position can be overwritten. */
+  void reclaim(uint64_t position);
+  uchar *reserve(size_t offset, size_t size);
+
+ protected:
+  /** Wait until the device is done with the whole buffer. */
+  void finish();
+
+ public:
+  MEM_CXX_CLASS_ALLOC_FUNCS("ImmediateRing");
+};
+
+/**
+ * Consecutive immediate draws which only differ by their vertices, merged into one draw call.
+ * Everything the draws depend on is kept so they can be drawn after the context changed.
+ */
+struct ImmediateMergedDraw {
+  GPUPrimType prim_type;
+  GPUShader *shader;
+  GPUVertFormat vertex_format;
+  GPUState state;
+  GPUStateMutable mutable_state;
+  FrameBuffer *framebuffer;
+  int viewport[4];
+  int scissor[4];
+  bool scissor_test;
+  /** Vertices of all the draws, contiguous in the ring. */
+  uchar *data;
+  /** Zero if there is nothing to draw. */
+  uint vertex_len;
+};
+
 class Immediate {
+ public:
+  /** Merge consecutive compatible draws. See #GPU_immediate_merge_set. */
+  static bool use_merge;
+
  public:
   /** Pointer to the mapped buffer data for the current vertex. */
   uchar *vertex_data = nullptr;
@@ -43,14 +194,52 @@ class Immediate {
   /** Uniform color: Kept here to update the wide-line shader just before #immBegin. */
   float uniform_color[4];
 
+ public:
+  /** Where the vertices are written. Created by the back-end. */
+  ImmediateRing *ring = nullptr;
+
  public:
   Immediate(){};
-  virtual ~Immediate(){};
+  virtual ~Immediate()
+  {
+    delete ring;
+  }
 
-  virtual uchar *begin() = 0;
-  virtual void end() = 0;
+  /**
+   * Streams the vertices into #ring and merges compatible draws, calling #draw once the merged
+   * draws can't be extended anymore.
+   */
+  virtual uchar *begin();
+  virtual void end();
+  /** Draw the merged draws, if any. */
+  void flush();
+
+ protected:
+  /** Draw \a vertex_len vertices at \a data using the state of the active context. */
+  virtual void draw(GPUPrimType prim_type,
+                    GPUShader *shader,
+                    const GPUVertFormat *format,
+                    const uchar *data,
+                    uint vertex_len) = 0;
+
+ private:
+  ImmediateMergedDraw merged_ = {};
+  /** True if the current draw is appended to #merged_. */
+  bool merging_ = false;
+  /** Degenerate vertices written before the current draw to join triangle strips. */
+  uint join_len_ = 0;
+
+  /** True if the draw being started can be appended to #merged_. */
+  bool merge_compatible() const;
 };
 
+/**
+ * Draw the merged immediate draws of the active context, if any. Must be called before changing
+ * anything the draws depend on that #Immediate can't detect by itself: uniforms, bindings,
+ * frame-buffer content, ...
+ */
+void imm_flush_merged();
+
 }  // namespace dust::gpu
 
 void immActivate();
@@ -0,0 +1,172 @@
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+
+#include "gpu_immediate_private.hh"
+
+namespace dust::gpu {
+
+/* Alignment of each draw inside the ring. */
+#define IMM_RING_ALIGN 16
+/* Number of fences per buffer length. More fences reclaim memory sooner but cost more syncs. */
+#define IMM_RING_FENCE_LEN 8
+
+ImmediateRingStats ImmediateRing::stats;
+
+ImmediateRing::~ImmediateRing()
+{
+  /* Virtual methods can't be called from here. Sub-classes overriding #buffer_create call
+   * #finish and free their buffer in their own destructor. */
+  MEM_SAFE_FREE(data_);
+}
+
+void ImmediateRing::buffer_create(size_t size)
+{
+  data_ = (uchar *)MEM_mallocN(size, "GPUImmediateRing");
+  size_ = size;
+}
+
+void ImmediateRing::buffer_free()
+{
+  MEM_SAFE_FREE(data_);
+  size_ = 0;
+}
+
+/* -------------------------------------------------------------------- */
+/* Fences */
+
+void ImmediateRing::fence_push()
+{
+  fences_.append({this->fence_insert(), submitted_});
+  fenced_ = submitted_;
+}
+
+void ImmediateRing::reclaim(uint64_t position)
+{
+  while (tail_ < position) {
+    if (first_fence_ == fences_.size()) {
+      /* What is needed was written after the last fence. Ranges are only reclaimed before the
+       * merged draw, which is the only one not submitted yet. */
+      LIB_assert(position <= submitted_);
+      this->fence_push();
+    }
+    const Fence &fence = fences_[first_fence_++];
+    if (this->fence_is_signaled(fence.handle)) {
+      this->fence_free(fence.handle);
+    }
+    else {
+      this->fence_wait(fence.handle);
+      stats.stall_len++;
+    }
+    tail_ = fence.end;
+  }
+  if (first_fence_ == fences_.size()) {
+    fences_.clear();
+    first_fence_ = 0;
+  }
+}
+
+void ImmediateRing::finish()
+{
+  /* Draws committed but never submitted don't read anything. */
+  if (fenced_ != submitted_) {
+    this->fence_push();
+  }
+  this->reclaim(submitted_);
+}
+
+/* -------------------------------------------------------------------- */
+/* Allocation */
+
+uchar *ImmediateRing::reserve(size_t offset, size_t size)
+{
+  /* Everything the range overlaps must be released by the device. */
+  if (head_ + size > tail_ + size_) {
+    this->reclaim(head_ + size - size_);
+  }
+  current_ = offset;
+  return data_ + offset;
+}
+
+uchar *ImmediateRing::alloc(size_t size)
+{
+  size = max_zz(size, 1);
+  if (size > size_) {
+    /* The first draw, or a draw larger than the whole ring: recreate it. */
+    if (data_) {
+      this->finish();
+      this->buffer_free();
+    }
+    this->buffer_create(max_zz(power_of_2_max_u(uint(size)), GPU_IMMEDIATE_RING_SIZE));
+    /* Restart on a fresh buffer. */
+    tail_ = head_ = submitted_ = fenced_ = 0;
+  }
+
+  head_ = ceil_to_multiple_ul(head_, IMM_RING_ALIGN);
+  size_t offset = head_ % size_;
+  if (offset + size > size_) {
+    /* Does not fit before the end of the buffer, skip what is left. */
+    head_ += size_ - offset;
+    offset = 0;
+    stats.wrap_len++;
+  }
+  /* Merged draws are flushed before starting a new one: nothing is pending and the padding is
+   * never read. */
+  submitted_ = head_;
+  return this->reserve(offset, size);
+}
+
+uchar *ImmediateRing::alloc_append(size_t size)
+{
+  if (data_ == nullptr) {
+    return nullptr;
+  }
+  const size_t offset = head_ % size_;
+  /* An offset of zero means the previous draw ended at the end of the buffer. */
+  if (offset == 0 || offset + size > size_) {
+    return nullptr;
+  }
+  return this->reserve(offset, size);
+}
+
+void ImmediateRing::commit(size_t size)
+{
+  if (size == 0) {
+    return;
+  }
+  this->flush_range(current_, size);
+  stats.bytes_streamed += size;
+  stats.draw_len++;
+  head_ += size;
+}
+
+void ImmediateRing::submit()
+{
+  submitted_ = head_;
+  if (submitted_ - fenced_ >= size_ / IMM_RING_FENCE_LEN) {
+    this->fence_push();
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Statistics */
+
+void ImmediateRingStats::frame_step()
+{
+  last_frame.bytes_streamed = bytes_streamed.exchange(0);
+  last_frame.draw_len = draw_len.exchange(0);
+  last_frame.wrap_len = wrap_len.exchange(0);
+  last_frame.stall_len = stall_len.exchange(0);
+  last_frame.merged_len = merged_len.exchange(0);
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+void GPU_immediate_ring_stats_get(GPUImmediateRingStats *r_stats)
+{
+  *r_stats = ImmediateRing::stats.last_frame;
+}
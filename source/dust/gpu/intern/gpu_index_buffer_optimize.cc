@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_index_range.hh"
+#include "LIB_math_base.h"
+#include "LIB_math_geom.h"
+#include "LIB_math_vector.h"
+#include "LIB_span.hh"
+#include "LIB_utildefines.h"
+#include "LIB_vector.hh"
+
+#include "GPU_index_buffer.h"
+
+namespace dust::gpu {
+
+/* Size of the simulated post-transform vertex cache. The result is not very sensitive to it. */
+#define INDEX_OPTIMIZE_CACHE_SIZE 16
+
+/* -------------------------------------------------------------------- */
+/* Vertex Cache
+ * Tipsify, from "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+ * (Sander et al. 2007): fan around vertices that are still in the cache, and jump to the most
+ * recent vertex with triangles left when there are none. */
+
+struct TriangleOrder {
+  Vector<uint32_t> tris;
+  /** First element of #tris of each cluster, a new cluster starts when the cache is flushed. */
+  Vector<uint32_t> cluster_starts;
+};
+
+/** Vertex to triangle adjacency, as offsets in a flat triangle array. */
+struct VertexTris {
+  Vector<uint32_t> offsets;
+  Vector<uint32_t> tris;
+
+  VertexTris(const uint32_t *indices, uint tri_len, uint vertex_len)
+      : offsets(vertex_len + 1, 0), tris(tri_len * 3)
+  {
+    for (uint i = 0; i < tri_len * 3; i++) {
+      offsets[indices[i] + 1]++;
+    }
+    for (uint v = 0; v < vertex_len; v++) {
+      offsets[v + 1] += offsets[v];
+    }
+    Vector<uint32_t> fill(offsets.as_span().drop_back(1));
+    for (uint i = 0; i < tri_len * 3; i++) {
+      tris[fill[indices[i]]++] = i / 3;
+    }
+  }
+
+  Span<uint32_t> lookup(uint v) const
+  {
+    return tris.as_span().slice(offsets[v], offsets[v + 1] - offsets[v]);
+  }
+};
+
+static int64_t skip_dead_end(Span<uint32_t> live,
+                             Vector<uint32_t> &dead_end,
+                             uint &cursor,
+                             uint vertex_len)
+{
+  while (!dead_end.is_empty()) {
+    const uint32_t v = dead_end.pop_last();
+    if (live[v] > 0) {
+      return v;
+    }
+  }
+  for (; cursor < vertex_len; cursor++) {
+    if (live[cursor] > 0) {
+      return cursor;
+    }
+  }
+  return -1;
+}
+
+static void tipsify(const uint32_t *indices,
+                    uint tri_len,
+                    uint vertex_len,
+                    int cache_size,
+                    TriangleOrder &r_order)
+{
+  const VertexTris adjacency(indices, tri_len, vertex_len);
+  /* Number of triangles not yet emitted using each vertex. */
+  Vector<uint32_t> live(vertex_len);
+  for (uint v = 0; v < vertex_len; v++) {
+    live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+  }
+  Vector<int> cache_time(vertex_len, 0);
+  Vector<bool> emitted(tri_len, false);
+  Vector<uint32_t> dead_end;
+  Vector<uint32_t> candidates;
+
+  r_order.tris.reserve(tri_len);
+  int time = cache_size + 1;
+  uint cursor = 0;
+  int64_t fan = skip_dead_end(live, dead_end, cursor, vertex_len);
+  while (fan >= 0) {
+    if (time - cache_time[fan] > cache_size) {
+      r_order.cluster_starts.append(uint32_t(r_order.tris.size()));
+    }
+
+    candidates.clear();
+    for (const uint32_t t : adjacency.lookup(uint(fan))) {
+      if (emitted[t]) {
+        continue;
+      }
+      for (int c = 0; c < 3; c++) {
+        const uint32_t v = indices[t * 3 + c];
+        dead_end.append(v);
+        candidates.append(v);
+        live[v]--;
+        if (time - cache_time[v] > cache_size) {
+          cache_time[v] = time++;
+        }
+      }
+      emitted[t] = true;
+      r_order.tris.append(t);
+    }
+
+    /* Prefer the oldest candidate that stays in the cache while its triangles are emitted. */
+    fan = -1;
+    int best_priority = -1;
+    for (const uint32_t v : candidates) {
+      if (live[v] == 0) {
+        continue;
+      }
+      int priority = 0;
+      if (time - cache_time[v] + 2 * int(live[v]) <= cache_size) {
+        priority = time - cache_time[v];
+      }
+      if (priority > best_priority) {
+        best_priority = priority;
+        fan = v;
+      }
+    }
+    if (fan == -1) {
+      fan = skip_dead_end(live, dead_end, cursor, vertex_len);
+    }
+  }
+  LIB_assert(r_order.tris.size() == tri_len);
+}
+
+/* -------------------------------------------------------------------- */
+/* Overdraw
+ * Triangles facing away from the center of the mesh are the most likely to occlude the others,
+ * draw their clusters first so that the depth test rejects more fragments. */
+
+static void clusters_sort(const uint32_t *indices,
+                          const float (*positions)[3],
+                          TriangleOrder &order)
+{
+  const int64_t cluster_len = order.cluster_starts.size();
+  if (cluster_len < 2) {
+    return;
+  }
+  Vector<float> cluster_centers(cluster_len * 3);
+  Vector<float> cluster_normals(cluster_len * 3);
+  float mesh_center[3] = {0.0f, 0.0f, 0.0f};
+  float mesh_area = 0.0f;
+
+  for (const int64_t c : IndexRange(cluster_len)) {
+    const uint32_t start = order.cluster_starts[c];
+    const uint32_t end = (c + 1 < cluster_len) ? order.cluster_starts[c + 1] :
+                                                 uint32_t(order.tris.size());
+    float center[3] = {0.0f, 0.0f, 0.0f};
+    float normal[3] = {0.0f, 0.0f, 0.0f};
+    float area = 0.0f;
+    for (uint32_t i = start; i < end; i++) {
+      const uint32_t *tri = &indices[order.tris[i] * 3];
+      const float *v1 = positions[tri[0]], *v2 = positions[tri[1]], *v3 = positions[tri[2]];
+      float tri_normal[3], tri_center[3];
+      /* Its length is twice the area of the triangle. */
+      cross_tri_v3(tri_normal, v1, v2, v3);
+      const float tri_area = len_v3(tri_normal) * 0.5f;
+      add_v3_v3v3(tri_center, v1, v2);
+      add_v3_v3(tri_center, v3);
+      madd_v3_v3fl(center, tri_center, tri_area / 3.0f);
+      add_v3_v3(normal, tri_normal);
+      area += tri_area;
+    }
+    add_v3_v3(mesh_center, center);
+    mesh_area += area;
+    if (area > 0.0f) {
+      mul_v3_fl(center, 1.0f / area);
+    }
+    normalize_v3(normal);
+    copy_v3_v3(&cluster_centers[c * 3], center);
+    copy_v3_v3(&cluster_normals[c * 3], normal);
+  }
+  if (mesh_area > 0.0f) {
+    mul_v3_fl(mesh_center, 1.0f / mesh_area);
+  }
+
+  Vector<float> sort_keys(cluster_len);
+  Vector<int> cluster_order(cluster_len);
+  for (const int64_t c : IndexRange(cluster_len)) {
+    float offset[3];
+    sub_v3_v3v3(offset, &cluster_centers[c * 3], mesh_center);
+    sort_keys[c] = dot_v3v3(offset, &cluster_normals[c * 3]);
+    cluster_order[c] = int(c);
+  }
+  std::stable_sort(cluster_order.begin(), cluster_order.end(), [&](int a, int b) {
+    return sort_keys[a] > sort_keys[b];
+  });
+
+  Vector<uint32_t> tris;
+  tris.reserve(order.tris.size());
+  Vector<uint32_t> cluster_starts;
+  cluster_starts.reserve(cluster_len);
+  for (const int c : cluster_order) {
+    const uint32_t start = order.cluster_starts[c];
+    const uint32_t end = (c + 1 < cluster_len) ? order.cluster_starts[c + 1] :
+                                                 uint32_t(order.tris.size());
+    cluster_starts.append(uint32_t(tris.size()));
+    tris.extend(order.tris.as_span().slice(start, end - start));
+  }
+  order.tris = std::move(tris);
+  order.cluster_starts = std::move(cluster_starts);
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust;
+using namespace dust::gpu;
+
+void GPU_indexbuf_optimize(GPUIndexBufBuilder *builder,
+                           eGPUIndexBufOptimize flags,
+                           const float (*positions)[3])
+{
+  LIB_assert(builder->prim_type == GPU_PRIM_TRIS);
+  LIB_assert(!(flags & GPU_INDEXBUF_OPTIMIZE_OVERDRAW) || positions != nullptr);
+  if (flags == GPU_INDEXBUF_OPTIMIZE_NONE) {
+    return;
+  }
+
+  /* Work on a copy without the restart triangles. */
+  Vector<uint32_t> indices;
+  indices.reserve(builder->index_len);
+  uint vertex_len = 0;
+  for (uint t = 0; t + 3 <= builder->index_len; t += 3) {
+    const uint32_t *tri = &builder->data[t];
+    if (builder->uses_restart_indices &&
+        ELEM(builder->restart_index_value, tri[0], tri[1], tri[2]))
+    {
+      continue;
+    }
+    indices.extend({tri[0], tri[1], tri[2]});
+    vertex_len = max_uu(vertex_len, max_uu(tri[0], max_uu(tri[1], tri[2])) + 1);
+  }
+  const uint tri_len = uint(indices.size() / 3);
+
+  TriangleOrder order;
+  tipsify(indices.data(), tri_len, vertex_len, INDEX_OPTIMIZE_CACHE_SIZE, order);
+  if (flags & GPU_INDEXBUF_OPTIMIZE_OVERDRAW) {
+    clusters_sort(indices.data(), positions, order);
+  }
+
+  for (const int64_t i : order.tris.index_range()) {
+    memcpy(&builder->data[i * 3], &indices[order.tris[i] * 3], sizeof(uint32_t[3]));
+  }
+  builder->index_len = tri_len * 3;
+}
@@ -0,0 +1,57 @@
+#include "LIB_assert.h"
+#include "LIB_index_range.hh"
+#include "LIB_math_base.h"
+#include "LIB_task.hh"
+#include "LIB_vector.hh"
+
+#include "GPU_index_buffer.h"
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust;
+
+void GPU_indexbuf_subbuilder_init(const GPUIndexBufBuilder *builder,
+                                  GPUIndexBufBuilder *r_subbuilder)
+{
+  *r_subbuilder = *builder;
+  /* Only track what the sub-builder writes, the data pointer is shared. */
+  r_subbuilder->index_len = 0;
+  r_subbuilder->index_min = UINT32_MAX;
+  r_subbuilder->index_max = 0;
+  r_subbuilder->uses_restart_indices = false;
+}
+
+void GPU_indexbuf_subbuilder_finish(GPUIndexBufBuilder *builder,
+                                    const GPUIndexBufBuilder *subbuilder)
+{
+  LIB_assert(builder->data == subbuilder->data);
+  GPU_indexbuf_join(builder, subbuilder);
+  builder->uses_restart_indices |= subbuilder->uses_restart_indices;
+}
+
+void GPU_indexbuf_fill_parallel(GPUIndexBufBuilder *builder,
+                                uint prim_len,
+                                uint grain_size,
+                                GPUIndexBufFillFn fill_fn,
+                                void *user_data)
+{
+  LIB_assert(grain_size > 0);
+  if (prim_len == 0) {
+    return;
+  }
+  /* One sub-builder per range, so the threads never write to the same one. */
+  const uint range_len = (prim_len + grain_size - 1) / grain_size;
+  Vector<GPUIndexBufBuilder> subbuilders(range_len);
+  threading::parallel_for(IndexRange(range_len), 1, [&](IndexRange range) {
+    for (const int64_t i : range) {
+      GPUIndexBufBuilder &subbuilder = subbuilders[i];
+      GPU_indexbuf_subbuilder_init(builder, &subbuilder);
+      const uint prim_start = uint(i) * grain_size;
+      fill_fn(user_data, &subbuilder, prim_start, min_uu(prim_start + grain_size, prim_len));
+    }
+  });
+  for (const GPUIndexBufBuilder &subbuilder : subbuilders) {
+    GPU_indexbuf_subbuilder_finish(builder, &subbuilder);
+  }
+}
@@ -0,0 +1,245 @@
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+
+#include "GPU_texture_pool.h"
+
+#include "gpu_memory_budget_private.hh"
+#include "gpu_texture_private.hh"
+
+namespace dust::gpu {
+
+/* -------------------------------------------------------------------- */
+/* Accounting */
+
+void MemoryBudget::usage_add(eGPUMemoryCategory category, size_t size)
+{
+  GPUMemoryUsage &usage = usage_[category];
+  usage.used += size;
+  usage.peak = max_zz(usage.peak, usage.used);
+  usage.resource_len++;
+}
+
+void MemoryBudget::usage_remove(eGPUMemoryCategory category, size_t size)
+{
+  GPUMemoryUsage &usage = usage_[category];
+  LIB_assert(usage.used >= size && usage.resource_len > 0);
+  usage.used -= size;
+  usage.resource_len--;
+}
+
+void MemoryBudget::texture_add(Texture *tex)
+{
+  const eGPUTextureFormat format = tex->format_get();
+  const bool is_compressed = (tex->format_flag_get() & GPU_FORMAT_COMPRESSED) != 0;
+  size_t size = 0;
+  for (int mip = 0; mip < tex->mip_count(); mip++) {
+    int extent[3] = {1, 1, 1};
+    tex->mip_size_get(mip, extent);
+    if (is_compressed) {
+      /* Compressed formats store blocks of 4x4 texels. */
+      size += size_t(divide_ceil_u(extent[0], 4)) * divide_ceil_u(extent[1], 4) * extent[2] *
+              to_block_size(format);
+    }
+    else {
+      size += size_t(extent[0]) * extent[1] * extent[2] * to_bytesize(format);
+    }
+  }
+
+  std::scoped_lock lock(mutex_);
+  tex->memory_size = size;
+  texture_memory_ += size;
+  this->usage_add(tex->memory_category, size);
+}
+
+void MemoryBudget::texture_remove(Texture *tex)
+{
+  std::scoped_lock lock(mutex_);
+  if (tex->memory_size != 0) {
+    texture_memory_ -= tex->memory_size;
+    this->usage_remove(tex->memory_category, tex->memory_size);
+    tex->memory_size = 0;
+  }
+  if (tex->memory_evict_fn != nullptr) {
+    evictables_.remove_first_occurrence_and_reorder(tex);
+    tex->memory_evict_fn = nullptr;
+  }
+}
+
+void MemoryBudget::texture_category_set(Texture *tex, eGPUMemoryCategory category)
+{
+  std::scoped_lock lock(mutex_);
+  if (tex->memory_size != 0) {
+    this->usage_remove(tex->memory_category, tex->memory_size);
+    this->usage_add(category, tex->memory_size);
+  }
+  tex->memory_category = category;
+}
+
+void MemoryBudget::texture_evict_callback_set(Texture *tex,
+                                              GPUTextureEvictFn evict_fn,
+                                              void *user_data)
+{
+  std::scoped_lock lock(mutex_);
+  if (tex->memory_evict_fn == nullptr && evict_fn != nullptr) {
+    evictables_.append(tex);
+  }
+  else if (tex->memory_evict_fn != nullptr && evict_fn == nullptr) {
+    evictables_.remove_first_occurrence_and_reorder(tex);
+  }
+  tex->memory_evict_fn = evict_fn;
+  tex->memory_evict_user_data = user_data;
+}
+
+void MemoryBudget::buffer_size_set(const VertBuf *buf, size_t size)
+{
+  std::scoped_lock lock(mutex_);
+  MemoryBuffer &entry = buffers_.lookup_or_add(buf, {0, GPU_MEMORY_CATEGORY_OTHER});
+  if (entry.size != 0) {
+    this->usage_remove(entry.category, entry.size);
+  }
+  entry.size = size;
+  if (entry.size != 0) {
+    this->usage_add(entry.category, entry.size);
+  }
+}
+
+void MemoryBudget::buffer_category_set(const VertBuf *buf, eGPUMemoryCategory category)
+{
+  std::scoped_lock lock(mutex_);
+  MemoryBuffer &entry = buffers_.lookup_or_add(buf, {0, GPU_MEMORY_CATEGORY_OTHER});
+  if (entry.size != 0) {
+    this->usage_remove(entry.category, entry.size);
+    this->usage_add(category, entry.size);
+  }
+  entry.category = category;
+}
+
+void MemoryBudget::buffer_remove(const VertBuf *buf)
+{
+  std::scoped_lock lock(mutex_);
+  const MemoryBuffer *entry = buffers_.lookup_ptr(buf);
+  if (entry == nullptr) {
+    return;
+  }
+  if (entry->size != 0) {
+    this->usage_remove(entry->category, entry->size);
+  }
+  buffers_.remove(buf);
+}
+
+/* -------------------------------------------------------------------- */
+/* Budget */
+
+void MemoryBudget::budget_set(eGPUMemoryCategory category, size_t budget)
+{
+  std::scoped_lock lock(mutex_);
+  usage_[category].budget = budget;
+}
+
+GPUMemoryUsage MemoryBudget::usage_get(eGPUMemoryCategory category)
+{
+  std::scoped_lock lock(mutex_);
+  return usage_[category];
+}
+
+static bool usage_is_over_budget(const GPUMemoryUsage &usage)
+{
+  return usage.budget != 0 && usage.used > usage.budget;
+}
+
+void MemoryBudget::step()
+{
+  bool over_budget = false;
+  {
+    std::scoped_lock lock(mutex_);
+    for (const GPUMemoryUsage &usage : usage_) {
+      over_budget = over_budget || usage_is_over_budget(usage);
+    }
+  }
+  if (over_budget) {
+    /* Released pool textures are the cheapest memory to give back. */
+    GPU_texture_pool_free_unused();
+
+    for (int category = 0; category < GPU_MEMORY_CATEGORY_LEN; category++) {
+      this->evict(eGPUMemoryCategory(category));
+    }
+  }
+
+  std::scoped_lock lock(mutex_);
+  frame_++;
+}
+
+void MemoryBudget::evict(eGPUMemoryCategory category)
+{
+  /* Evict one texture at a time: the callbacks free textures, which can change the usage and the
+   * evictable textures, so the next victim is chosen again under the lock. */
+  while (true) {
+    Texture *victim = nullptr;
+    GPUTextureEvictFn evict_fn;
+    void *user_data;
+    {
+      std::scoped_lock lock(mutex_);
+      GPUMemoryUsage &usage = usage_[category];
+      if (!usage_is_over_budget(usage)) {
+        return;
+      }
+      for (Texture *tex : evictables_) {
+        /* Textures bound during this frame may still be used by the commands in flight. */
+        if (tex->memory_category != category || tex->memory_last_use == frame_) {
+          continue;
+        }
+        if (victim == nullptr || tex->memory_last_use < victim->memory_last_use) {
+          victim = tex;
+        }
+      }
+      if (victim == nullptr) {
+        return;
+      }
+      evict_fn = victim->memory_evict_fn;
+      user_data = victim->memory_evict_user_data;
+      evictables_.remove_first_occurrence_and_reorder(victim);
+      victim->memory_evict_fn = nullptr;
+      victim->memory_evict_user_data = nullptr;
+      usage.evicted_len++;
+    }
+    evict_fn(reinterpret_cast<GPUTexture *>(victim), user_data);
+  }
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+void GPU_texture_memory_category_set(GPUTexture *tex, eGPUMemoryCategory category)
+{
+  MemoryBudget::get().texture_category_set(reinterpret_cast<Texture *>(tex), category);
+}
+
+void GPU_vertbuf_memory_category_set(GPUVertBuf *verts, eGPUMemoryCategory category)
+{
+  MemoryBudget::get().buffer_category_set(reinterpret_cast<VertBuf *>(verts), category);
+}
+
+void GPU_texture_evict_callback_set(GPUTexture *tex, GPUTextureEvictFn evict_fn, void *user_data)
+{
+  MemoryBudget::get().texture_evict_callback_set(
+      reinterpret_cast<Texture *>(tex), evict_fn, user_data);
+}
+
+void GPU_memory_budget_set(eGPUMemoryCategory category, size_t budget)
+{
+  MemoryBudget::get().budget_set(category, budget);
+}
+
+void GPU_memory_budget_step()
+{
+  MemoryBudget::get().step();
+}
+
+void GPU_memory_usage_get(eGPUMemoryCategory category, GPUMemoryUsage *r_usage)
+{
+  *r_usage = MemoryBudget::get().usage_get(category);
+}
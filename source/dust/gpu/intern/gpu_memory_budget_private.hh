@@ -0,0 +1,75 @@
+/* Internal side of #GPU_memory_budget.h, used by textures and by the back-ends. */
+
+#pragma once
+
+#include <mutex>
+
+#include "LIB_map.hh"
+#include "LIB_vector.hh"
+
+#include "GPU_memory_budget.h"
+
+namespace dust::gpu {
+
+class Texture;
+class VertBuf;
+
+struct MemoryBuffer {
+  size_t size;
+  eGPUMemoryCategory category;
+};
+
+class MemoryBudget {
+ private:
+  std::mutex mutex_;
+  GPUMemoryUsage usage_[GPU_MEMORY_CATEGORY_LEN] = {};
+  /** Textures with an eviction callback. */
+  Vector<Texture *> evictables_;
+  /** Vertex buffers holding memory. */
+  Map<const VertBuf *, MemoryBuffer> buffers_;
+  /** Total texture memory, for #GPU_texture_memory_usage_get. */
+  size_t texture_memory_ = 0;
+  uint64_t frame_ = 1;
+
+ public:
+  static MemoryBudget &get()
+  {
+    static MemoryBudget budget;
+    return budget;
+  }
+
+  /** Used to tag the last use of textures. Not locked, only compared for ordering. */
+  uint64_t frame_get() const
+  {
+    return frame_;
+  }
+
+  size_t texture_memory_get() const
+  {
+    return texture_memory_;
+  }
+
+  /** Called once \a tex storage is allocated. */
+  void texture_add(Texture *tex);
+  /** Called when \a tex is destroyed. */
+  void texture_remove(Texture *tex);
+  void texture_category_set(Texture *tex, eGPUMemoryCategory category);
+  void texture_evict_callback_set(Texture *tex, GPUTextureEvictFn evict_fn, void *user_data);
+
+  /** Called by the back-ends when the device data of a vertex buffer is (re)allocated. */
+  void buffer_size_set(const VertBuf *buf, size_t size);
+  void buffer_category_set(const VertBuf *buf, eGPUMemoryCategory category);
+  /** Called by the back-ends when a vertex buffer is destroyed. */
+  void buffer_remove(const VertBuf *buf);
+
+  void budget_set(eGPUMemoryCategory category, size_t budget);
+  void step();
+  GPUMemoryUsage usage_get(eGPUMemoryCategory category);
+
+ private:
+  void usage_add(eGPUMemoryCategory category, size_t size);
+  void usage_remove(eGPUMemoryCategory category, size_t size);
+  void evict(eGPUMemoryCategory category);
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,433 @@
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+
+#include "LIB_assert.h"
+#include "LIB_string.h"
+#include "LIB_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "gpu_context_private.hh"
+#include "gpu_pipeline_cache_private.hh"
+#include "gpu_shader_interface.hh"
+#include "gpu_texture_private.hh"
+
+namespace fs = std::filesystem;
+
+namespace dust::gpu {
+
+#define PIPELINE_KEYS_VERSION 1
+
+LIB_STATIC_ASSERT(sizeof(PipelineVertexAttr) == 10, "PipelineVertexAttr must not be padded");
+LIB_STATIC_ASSERT(sizeof(PipelineDesc) == 32 + sizeof(PipelineVertexAttr) * GPU_VERT_ATTR_MAX_LEN,
+                  "PipelineDesc must not be padded");
+
+/** Key files are this header followed by the records. */
+struct PipelineKeysHeader {
+  char magic[4];
+  uint32_t version;
+  /** Changes with #GPU_FB_MAX_COLOR_ATTACHMENT and #GPU_VERT_ATTR_MAX_LEN. */
+  uint32_t record_size;
+  uint32_t record_len;
+};
+
+static const char pipeline_keys_magic[4] = {'D', 'P', 'S', 'K'};
+
+PipelineCacheStats PipelineCache::stats;
+
+/* -------------------------------------------------------------------- */
+/* Keys */
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+  const uchar *bytes = static_cast<const uchar *>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+uint64_t PipelineKey::hash() const
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  hash = (hash ^ uint64_t(uintptr_t(shader))) * 0x100000001b3ull;
+  return hash_bytes(hash, &desc, sizeof(desc));
+}
+
+uint64_t PipelineRecord::hash() const
+{
+  return hash_bytes(0xcbf29ce484222325ull, this, sizeof(*this));
+}
+
+/** Add the attributes of \a format read by \a shader. The first buffer having an input wins. */
+static void layout_vertex_attrs_add(PipelineVertexLayout &layout,
+                                    const ShaderInterface &interface,
+                                    const GPUVertFormat *format,
+                                    int buffer,
+                                    bool is_instanced,
+                                    uint16_t &r_location_mask)
+{
+  for (uint a_idx = 0; a_idx < format->attr_len; a_idx++) {
+    const GPUVertAttr *attr = &format->attrs[a_idx];
+    for (uint n_idx = 0; n_idx < attr->name_len; n_idx++) {
+      const ShaderInput *input = interface.attr_get(
+          GPU_vertformat_attr_name_get(format, attr, n_idx));
+      if (input == nullptr || input->location < 0 || input->location >= GPU_VERT_ATTR_MAX_LEN ||
+          (r_location_mask & (1 << input->location))) {
+        continue;
+      }
+      r_location_mask |= 1 << input->location;
+
+      PipelineVertexAttr &dst = layout.attrs[layout.attr_len++];
+      dst.location = uint8_t(input->location);
+      dst.buffer = uint8_t(buffer);
+      dst.is_instanced = is_instanced;
+      dst.comp_type = uint8_t(attr->comp_type);
+      dst.fetch_mode = uint8_t(attr->fetch_mode);
+      dst.comp_len = uint8_t(attr->comp_len);
+      dst.offset = format->deinterleaved ? 0 : uint16_t(attr->offset);
+      dst.stride = format->deinterleaved ? uint16_t(attr->size) : uint16_t(format->stride);
+    }
+  }
+}
+
+static int16_t attachment_format_get(GPUTexture *tex)
+{
+  return tex ? int16_t(unwrap(tex)->format_get()) : -1;
+}
+
+void PipelineCache::vertex_layout_build(const Shader &shader,
+                                        Span<const GPUVertFormat *> vertex_formats,
+                                        Span<const GPUVertFormat *> instance_formats,
+                                        PipelineVertexLayout &r_layout)
+{
+  /* Clear the unused attributes too, they are copied into the keys. */
+  memset(&r_layout, 0, sizeof(r_layout));
+  uint16_t location_mask = 0;
+  for (const int64_t i : vertex_formats.index_range()) {
+    if (vertex_formats[i]) {
+      layout_vertex_attrs_add(
+          r_layout, *shader.interface, vertex_formats[i], i, false, location_mask);
+    }
+  }
+  for (const int64_t i : instance_formats.index_range()) {
+    if (instance_formats[i]) {
+      layout_vertex_attrs_add(
+          r_layout, *shader.interface, instance_formats[i], i, true, location_mask);
+    }
+  }
+}
+
+static PipelineKey key_build(const Shader &shader,
+                             GPUPrimType prim_type,
+                             const PipelineVertexLayout &vertex_layout)
+{
+  const Context *ctx = Context::get();
+  PipelineKey key;
+  /* Clear the padding of #PipelineKey too, the unused fields are compared. */
+  memset(&key, 0, sizeof(key));
+  key.shader = &shader;
+
+  PipelineDesc &desc = key.desc;
+  desc.state = ctx->state_manager->state.data;
+  desc.prim_type = uint8_t(prim_type);
+  desc.vertex_attr_len = vertex_layout.attr_len;
+  memcpy(desc.vertex_attrs, vertex_layout.attrs, sizeof(desc.vertex_attrs));
+
+  const FrameBuffer *fb = ctx->active_fb;
+  desc.depth_format = fb ? attachment_format_get(fb->depth_tex()) : -1;
+  for (int i = 0; i < GPU_FB_MAX_COLOR_ATTACHMENT; i++) {
+    desc.color_formats[i] = fb ? attachment_format_get(fb->color_tex(i)) : -1;
+  }
+  return key;
+}
+
+/* -------------------------------------------------------------------- */
+/* Pipelines */
+
+void *PipelineCache::pipeline_get(const Shader &shader,
+                                  GPUPrimType prim_type,
+                                  Span<const GPUVertFormat *> vertex_formats,
+                                  Span<const GPUVertFormat *> instance_formats)
+{
+  PipelineVertexLayout vertex_layout;
+  vertex_layout_build(shader, vertex_formats, instance_formats, vertex_layout);
+  return this->pipeline_get(shader, prim_type, vertex_layout);
+}
+
+void *PipelineCache::pipeline_get(const Shader &shader,
+                                  GPUPrimType prim_type,
+                                  const PipelineVertexLayout &vertex_layout)
+{
+  const PipelineKey key = key_build(shader, prim_type, vertex_layout);
+  {
+    /* Hits are the common case, they don't wait for each other. */
+    std::shared_lock lock(mutex_);
+    void **pipeline = pipelines_.lookup_ptr(key);
+    if (pipeline) {
+      stats.hit_len.fetch_add(1, std::memory_order_relaxed);
+      return *pipeline;
+    }
+  }
+  stats.miss_len.fetch_add(1, std::memory_order_relaxed);
+  return this->pipeline_create(key);
+}
+
+void *PipelineCache::pipeline_create(const PipelineKey &key)
+{
+  StateManager *state_manager = Context::get()->state_manager;
+  const double start = PIL_check_seconds_timer();
+  void *pipeline = state_manager->pipeline_create(key);
+  const double time = PIL_check_seconds_timer() - start;
+
+  PipelineRecord record;
+  memset(&record, 0, sizeof(record));
+  LIB_strncpy(record.shader_name, key.shader->name_get(), sizeof(record.shader_name));
+  record.desc = key.desc;
+
+  std::scoped_lock lock(mutex_);
+  create_time_ += time;
+  records_.add(record);
+  void **existing = pipelines_.lookup_ptr(key);
+  if (existing) {
+    /* Another context created it meanwhile. */
+    if (pipeline) {
+      state_manager->pipeline_free(pipeline);
+    }
+    return *existing;
+  }
+  pipelines_.add_new(key, pipeline);
+  return pipeline;
+}
+
+int PipelineCache::warm(const Shader &shader)
+{
+  Vector<PipelineKey> keys;
+  {
+    std::scoped_lock lock(mutex_);
+    for (const PipelineRecord &record : records_) {
+      if (!STREQ(record.shader_name, shader.name_get())) {
+        continue;
+      }
+      PipelineKey key;
+      memset(&key, 0, sizeof(key));
+      key.shader = &shader;
+      key.desc = record.desc;
+      if (!pipelines_.contains(key)) {
+        keys.append(key);
+      }
+    }
+  }
+
+  for (const PipelineKey &key : keys) {
+    this->pipeline_create(key);
+  }
+
+  std::scoped_lock lock(mutex_);
+  warm_len_ += uint32_t(keys.size());
+  return int(keys.size());
+}
+
+void PipelineCache::shader_free(const Shader *shader)
+{
+  Vector<PipelineKey> keys;
+  Vector<void *> pipelines;
+  {
+    std::scoped_lock lock(mutex_);
+    for (const auto item : pipelines_.items()) {
+      if (item.key.shader == shader) {
+        keys.append(item.key);
+        pipelines.append(item.value);
+      }
+    }
+    for (const PipelineKey &key : keys) {
+      pipelines_.remove(key);
+    }
+  }
+
+  /* The pipelines of shaders freed without any active context are leaked. */
+  Context *ctx = Context::get();
+  if (ctx == nullptr) {
+    return;
+  }
+  for (void *pipeline : pipelines) {
+    if (pipeline) {
+      ctx->state_manager->pipeline_free(pipeline);
+    }
+  }
+}
+
+void PipelineCache::clear()
+{
+  std::scoped_lock lock(mutex_);
+  Context *ctx = Context::get();
+  if (ctx) {
+    for (void *pipeline : pipelines_.values()) {
+      if (pipeline) {
+        ctx->state_manager->pipeline_free(pipeline);
+      }
+    }
+  }
+  pipelines_.clear();
+}
+
+/* -------------------------------------------------------------------- */
+/* Key Files */
+
+bool PipelineCache::keys_load(const char *filepath)
+{
+  std::error_code error;
+  const uintmax_t file_size = fs::file_size(filepath, error);
+  if (error) {
+    return false;
+  }
+  FILE *file = fopen(filepath, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  PipelineKeysHeader header;
+  Vector<PipelineRecord> records;
+  /* Check the record count before allocating, a truncated or corrupted file could ask for any
+   * size. */
+  bool is_valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                  memcmp(header.magic, pipeline_keys_magic, sizeof(header.magic)) == 0 &&
+                  header.version == PIPELINE_KEYS_VERSION &&
+                  header.record_size == sizeof(PipelineRecord) &&
+                  uintmax_t(header.record_len) * sizeof(PipelineRecord) ==
+                      file_size - sizeof(header);
+  if (is_valid) {
+    records.resize(header.record_len);
+    is_valid = fread(records.data(), sizeof(PipelineRecord), records.size(), file) ==
+               size_t(records.size());
+  }
+  fclose(file);
+  if (!is_valid) {
+    return false;
+  }
+
+  std::scoped_lock lock(mutex_);
+  for (PipelineRecord &record : records) {
+    /* Don't trust the file to be null terminated. */
+    record.shader_name[sizeof(record.shader_name) - 1] = '\0';
+    records_.add(record);
+  }
+  return true;
+}
+
+bool PipelineCache::keys_save(const char *filepath)
+{
+  Vector<PipelineRecord> records;
+  {
+    std::scoped_lock lock(mutex_);
+    records.reserve(records_.size());
+    for (const PipelineRecord &record : records_) {
+      records.append(record);
+    }
+  }
+
+  PipelineKeysHeader header;
+  memcpy(header.magic, pipeline_keys_magic, sizeof(header.magic));
+  header.version = PIPELINE_KEYS_VERSION;
+  header.record_size = sizeof(PipelineRecord);
+  header.record_len = uint32_t(records.size());
+
+  /* Write to a temporary file first, a crash while saving must not lose the previous keys. */
+  const std::string tmp_path = std::string(filepath) + "." +
+                               std::to_string(std::random_device()()) + ".tmp";
+  FILE *file = fopen(tmp_path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool is_written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                          fwrite(records.data(), sizeof(PipelineRecord), records.size(), file) ==
+                              size_t(records.size());
+  std::error_code error;
+  if (fclose(file) != 0 || !is_written) {
+    fs::remove(tmp_path, error);
+    return false;
+  }
+  fs::rename(tmp_path, filepath, error);
+  if (error) {
+    fs::remove(tmp_path, error);
+    return false;
+  }
+  return true;
+}
+
+void PipelineCache::keys_path_set(const char *filepath)
+{
+  keys_path_ = filepath ? filepath : "";
+}
+
+void PipelineCache::init()
+{
+  const char *env_path = getenv("DUST_GPU_PIPELINE_KEYS");
+  if (env_path != nullptr && env_path[0] != '\0') {
+    keys_path_ = env_path;
+  }
+  if (!keys_path_.empty()) {
+    /* Missing on the first run. */
+    this->keys_load(keys_path_.c_str());
+  }
+}
+
+void PipelineCache::exit()
+{
+  if (!keys_path_.empty() && !this->keys_save(keys_path_.c_str())) {
+    fprintf(stderr, "PipelineCache: Error: can't write \"%s\".\n", keys_path_.c_str());
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Statistics */
+
+void PipelineCacheStats::frame_step()
+{
+  last_frame.hit_len = hit_len.exchange(0);
+  last_frame.miss_len = miss_len.exchange(0);
+}
+
+void PipelineCache::stats_get(GPUPipelineCacheStats *r_stats)
+{
+  std::scoped_lock lock(mutex_);
+  *r_stats = stats.last_frame;
+  r_stats->warm_len = warm_len_;
+  r_stats->pipeline_len = uint(pipelines_.size());
+  r_stats->record_len = uint(records_.size());
+  r_stats->create_time = create_time_;
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+bool GPU_pipeline_cache_keys_load(const char *filepath)
+{
+  return PipelineCache::get().keys_load(filepath);
+}
+
+bool GPU_pipeline_cache_keys_save(const char *filepath)
+{
+  return PipelineCache::get().keys_save(filepath);
+}
+
+void GPU_pipeline_cache_keys_path_set(const char *filepath)
+{
+  PipelineCache::get().keys_path_set(filepath);
+}
+
+int GPU_pipeline_cache_warm(GPUShader *shader)
+{
+  return PipelineCache::get().warm(*unwrap(shader));
+}
+
+void GPU_pipeline_cache_stats_get(GPUPipelineCacheStats *r_stats)
+{
+  PipelineCache::get().stats_get(r_stats);
+}
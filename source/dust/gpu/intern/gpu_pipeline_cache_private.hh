@@ -0,0 +1,167 @@
+/* Cache of immutable pipeline objects, see GPU_pipeline_cache.h. */
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include "LIB_map.hh"
+#include "LIB_set.hh"
+#include "LIB_span.hh"
+#include "LIB_vector.hh"
+
+#include "GPU_pipeline_cache.h"
+#include "GPU_primitive.h"
+#include "GPU_vertex_format.h"
+
+#include "gpu_framebuffer_private.hh"
+#include "gpu_shader_private.hh"
+#include "gpu_state_private.hh"
+
+namespace dust::gpu {
+
+/** Fetch of one vertex input of the shader. */
+struct PipelineVertexAttr {
+  uint8_t location;
+  /** Slot of the vertex buffer in the draw, instance buffers use their own slots. */
+  uint8_t buffer;
+  uint8_t is_instanced;
+  /* #GPUVertCompType, #GPUVertFetchMode. */
+  uint8_t comp_type;
+  uint8_t fetch_mode;
+  uint8_t comp_len;
+  /** De-interleaved attributes have their own binding, their offset is only known on bind. */
+  uint16_t offset;
+  uint16_t stride;
+};
+
+/**
+ * Vertex inputs of a shader resolved against the vertex formats of a draw. Resolving looks the
+ * attributes up by name, batches keep their layout as long as they and their shader don't change.
+ */
+struct PipelineVertexLayout {
+  uint8_t attr_len;
+  PipelineVertexAttr attrs[GPU_VERT_ATTR_MAX_LEN];
+};
+
+/**
+ * Everything in a pipeline but the shader. The fields are bytes that are hashed and compared as
+ * is, so the struct has no implicit padding and unused fields must be zero.
+ */
+struct PipelineDesc {
+  /** #GPUState::data. The #GPUStateMutable values are dynamic states, set on bind. */
+  uint64_t state;
+  /** #GPUPrimType. */
+  uint8_t prim_type;
+  uint8_t vertex_attr_len;
+  /** #eGPUTextureFormat of the depth and color attachments, -1 when unused. */
+  int16_t depth_format;
+  int16_t color_formats[GPU_FB_MAX_COLOR_ATTACHMENT];
+  int16_t _pad[2];
+  PipelineVertexAttr vertex_attrs[GPU_VERT_ATTR_MAX_LEN];
+};
+
+struct PipelineKey {
+  const Shader *shader;
+  PipelineDesc desc;
+
+  uint64_t hash() const;
+  bool operator==(const PipelineKey &other) const
+  {
+    return shader == other.shader && memcmp(&desc, &other.desc, sizeof(desc)) == 0;
+  }
+};
+
+/** Key saved across sessions, the shader is only known by its name. */
+struct PipelineRecord {
+  char shader_name[64];
+  PipelineDesc desc;
+
+  uint64_t hash() const;
+  bool operator==(const PipelineRecord &other) const
+  {
+    return memcmp(this, &other, sizeof(*this)) == 0;
+  }
+};
+
+/** Cumulative counters of the current frame and values of the last frame. */
+struct PipelineCacheStats {
+  std::atomic<uint32_t> hit_len = 0;
+  std::atomic<uint32_t> miss_len = 0;
+  GPUPipelineCacheStats last_frame = {};
+
+  /** Called by the back-ends at the end of every frame. */
+  void frame_step();
+};
+
+/**
+ * Pipelines of all the contexts. They are created and freed by the #StateManager of the active
+ * context, back-ends without pipeline objects create none and never call #pipeline_get.
+ * Thread safe, the pipelines are created outside of the lock.
+ */
+class PipelineCache {
+ public:
+  static PipelineCacheStats stats;
+
+ private:
+  /** Shared by the lookups, draws only take it exclusively when creating a pipeline. */
+  std::shared_mutex mutex_;
+  Map<PipelineKey, void *> pipelines_;
+  Set<PipelineRecord> records_;
+  uint32_t warm_len_ = 0;
+  double create_time_ = 0.0;
+  /** See #GPU_pipeline_cache_keys_path_set, empty when disabled. */
+  std::string keys_path_;
+
+ public:
+  static PipelineCache &get()
+  {
+    static PipelineCache cache;
+    return cache;
+  }
+
+  /** Null entries of the buffer spans are unused slots. */
+  static void vertex_layout_build(const Shader &shader,
+                                  Span<const GPUVertFormat *> vertex_formats,
+                                  Span<const GPUVertFormat *> instance_formats,
+                                  PipelineVertexLayout &r_layout);
+
+  /**
+   * Pipeline of a draw of \a shader with the active frame-buffer and state, created on the first
+   * use. \a vertex_layout must have been built for \a shader.
+   */
+  void *pipeline_get(const Shader &shader,
+                     GPUPrimType prim_type,
+                     const PipelineVertexLayout &vertex_layout);
+  /** Same as above, for draws whose vertex formats change every time. */
+  void *pipeline_get(const Shader &shader,
+                     GPUPrimType prim_type,
+                     Span<const GPUVertFormat *> vertex_formats,
+                     Span<const GPUVertFormat *> instance_formats);
+
+  /** Create the recorded pipelines of \a shader. Return how many were created. */
+  int warm(const Shader &shader);
+  /** Free the pipelines of \a shader, called before it is freed. */
+  void shader_free(const Shader *shader);
+  /** Free all the pipelines, the records are kept. */
+  void clear();
+
+  bool keys_load(const char *filepath);
+  bool keys_save(const char *filepath);
+  /** Load the keys of #keys_path_, called when the back-end is created. */
+  void init();
+  /** Save the keys to #keys_path_, called when the back-end is freed. */
+  void exit();
+  void keys_path_set(const char *filepath);
+
+  void stats_get(GPUPipelineCacheStats *r_stats);
+
+ private:
+  /** Create the pipeline of \a key and add it. Return the one already added by another thread. */
+  void *pipeline_create(const PipelineKey &key);
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,207 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+
+#include "GPU_storage_buffer.h"
+
+#include "gpu_backend.hh"
+#include "gpu_readback_private.hh"
+#include "gpu_storage_buffer_private.hh"
+
+namespace dust::gpu {
+
+/* -------------------------------------------------------------------- */
+/* Staging Buffer */
+
+StagingBuffer::~StagingBuffer()
+{
+  MEM_SAFE_FREE(data_);
+}
+
+void StagingBuffer::resize(size_t size)
+{
+  if (size <= size_) {
+    return;
+  }
+  MEM_SAFE_FREE(data_);
+  data_ = MEM_mallocN(size, __func__);
+  size_ = size;
+}
+
+StagingBuffer *GPUBackend::stagingbuf_alloc()
+{
+  return new StagingBuffer();
+}
+
+/* -------------------------------------------------------------------- */
+/* Ring */
+
+ReadbackRing::~ReadbackRing()
+{
+  /* Staging buffers are back-end objects, they must have been freed by #free. */
+  LIB_assert(pending_.is_empty());
+  LIB_assert(idle_.is_empty());
+}
+
+ReadbackRing &ReadbackRing::get()
+{
+  static ReadbackRing ring;
+  return ring;
+}
+
+Readback *ReadbackRing::acquire(size_t size)
+{
+  Readback *readback = new Readback();
+  readback->size = size;
+  {
+    std::scoped_lock lock(mutex_);
+    if (!idle_.is_empty()) {
+      readback->buffer = idle_[0];
+      idle_.remove(0);
+    }
+  }
+  if (readback->buffer == nullptr) {
+    readback->buffer = GPUBackend::get()->stagingbuf_alloc();
+  }
+  readback->buffer->resize(size);
+  return readback;
+}
+
+void ReadbackRing::release(Readback *readback)
+{
+  /* The device must not write to the buffer once it is reused. */
+  readback->buffer->fence_wait();
+  {
+    std::scoped_lock lock(mutex_);
+    if (idle_.size() < GPU_READBACK_RING_LEN) {
+      idle_.append(readback->buffer);
+      readback->buffer = nullptr;
+    }
+  }
+  delete readback->buffer;
+  delete readback;
+}
+
+void ReadbackRing::callback_add(Readback *readback)
+{
+  std::scoped_lock lock(mutex_);
+  pending_.append(readback);
+}
+
+void ReadbackRing::poll()
+{
+  Vector<Readback *> finished;
+  {
+    std::scoped_lock lock(mutex_);
+    /* Keep submission order so callbacks are called in the order the reads were issued. */
+    int64_t kept_len = 0;
+    for (Readback *readback : pending_) {
+      if (readback->buffer->fence_is_signaled()) {
+        finished.append(readback);
+      }
+      else {
+        pending_[kept_len++] = readback;
+      }
+    }
+    pending_.resize(kept_len);
+  }
+  /* Callbacks are called without the lock so they can issue new readbacks. */
+  for (Readback *readback : finished) {
+    readback->callback(readback->buffer->data_get(), readback->size, readback->user_data);
+    this->release(readback);
+  }
+}
+
+void ReadbackRing::free()
+{
+  Vector<Readback *> pending;
+  {
+    std::scoped_lock lock(mutex_);
+    pending = std::move(pending_);
+    pending_.clear();
+  }
+  for (Readback *readback : pending) {
+    readback->buffer->fence_wait();
+    readback->callback(readback->buffer->data_get(), readback->size, readback->user_data);
+    this->release(readback);
+  }
+
+  std::scoped_lock lock(mutex_);
+  for (StagingBuffer *buffer : idle_) {
+    delete buffer;
+  }
+  idle_.clear();
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+bool GPU_readback_is_ready(GPUReadback *readback)
+{
+  return unwrap(readback)->buffer->fence_is_signaled();
+}
+
+const void *GPU_readback_data_get(GPUReadback *readback)
+{
+  StagingBuffer *buffer = unwrap(readback)->buffer;
+  buffer->fence_wait();
+  return buffer->data_get();
+}
+
+size_t GPU_readback_size_get(const GPUReadback *readback)
+{
+  return unwrap(readback)->size;
+}
+
+void GPU_readback_free(GPUReadback *readback)
+{
+  ReadbackRing::get().release(unwrap(readback));
+}
+
+void GPU_readback_callback_set(GPUReadback *readback_,
+                               GPUReadbackCallback callback,
+                               void *user_data)
+{
+  LIB_assert(callback != nullptr);
+  Readback *readback = unwrap(readback_);
+  readback->callback = callback;
+  readback->user_data = user_data;
+  ReadbackRing::get().callback_add(readback);
+}
+
+void GPU_readback_poll()
+{
+  ReadbackRing::get().poll();
+}
+
+/**
+ * #StorageBuf has no size accessor. A member pointer named through a derived class is allowed to
+ * read the protected size of any storage buffer.
+ */
+class StorageBufSize : public StorageBuf {
+ public:
+  static size_t get(const StorageBuf *ssbo)
+  {
+    return ssbo->*(&StorageBufSize::size_in_bytes_);
+  }
+};
+
+GPUReadback *GPU_storagebuf_read_async(GPUStorageBuf *ssbo, size_t size)
+{
+  const size_t ssbo_size = StorageBufSize::get(reinterpret_cast<StorageBuf *>(ssbo));
+  LIB_assert_msg(size <= ssbo_size, "Reading past the end of the storage buffer");
+  size = min_zz(size, ssbo_size);
+  /* Storage buffers have no asynchronous copy of their own yet, the copy into the staging buffer
+   * is synchronous like the default #Texture::read_async. The whole buffer is read, the staging
+   * buffer must fit it. */
+  Readback *readback = ReadbackRing::get().acquire(size);
+  readback->buffer->resize(ssbo_size);
+  GPU_storagebuf_read(ssbo, readback->buffer->host_data_get());
+  readback->buffer->fence_insert();
+  return wrap(readback);
+}
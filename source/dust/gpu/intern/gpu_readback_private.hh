@@ -0,0 +1,116 @@
+#pragma once
+
+#include <mutex>
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_vector.hh"
+
+#include "GPU_readback.h"
+
+namespace dust::gpu {
+
+/**
+ * Host visible buffer receiving an asynchronous copy, and the fence signaled once the copy is
+ * done. The base implementation is plain host memory written synchronously by the default
+ * #FrameBuffer::read_async and #Texture::read_async. Back-ends able to overlap the transfer with
+ * rendering override it together with these methods.
+ */
+class StagingBuffer {
+ protected:
+  void *data_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  StagingBuffer(){};
+  virtual ~StagingBuffer();
+
+  /** Make sure at least \a size bytes can be written. Never called while a copy is in flight. */
+  virtual void resize(size_t size);
+
+  /** Called once the copy commands were submitted. */
+  virtual void fence_insert(){};
+  /** True if the copy is done. Must not block. */
+  virtual bool fence_is_signaled()
+  {
+    return true;
+  }
+  /** Block until the copy is done. */
+  virtual void fence_wait(){};
+
+  /** Data of the finished copy. */
+  virtual const void *data_get()
+  {
+    return data_;
+  }
+  /** Destination for synchronous copies done on the host. */
+  void *host_data_get()
+  {
+    return data_;
+  }
+  size_t size_get() const
+  {
+    return size_;
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("StagingBuffer");
+};
+
+/** A read request and the staging buffer it writes into. */
+class Readback {
+ public:
+  StagingBuffer *buffer = nullptr;
+  /** Size of the requested data, the buffer can be larger. */
+  size_t size = 0;
+  GPUReadbackCallback callback = nullptr;
+  void *user_data = nullptr;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("Readback");
+};
+
+/**
+ * Staging buffers shared by all contexts. Buffers are reused in the order they were released so
+ * that the oldest one, the most likely to have its fence signaled, is reused first.
+ * At most #GPU_READBACK_RING_LEN idle buffers are kept; more are created if the callers keep
+ * more readbacks in flight.
+ */
+class ReadbackRing {
+ private:
+  std::mutex mutex_;
+  Vector<StagingBuffer *> idle_;
+  /** Readbacks handed over with #GPU_readback_callback_set. */
+  Vector<Readback *> pending_;
+
+ public:
+  ~ReadbackRing();
+
+  static ReadbackRing &get();
+
+  /** Return a readback with a buffer of at least \a size bytes. */
+  Readback *acquire(size_t size);
+  void release(Readback *readback);
+
+  void callback_add(Readback *readback);
+  void poll();
+  /**
+   * Wait for the pending readbacks and call their callbacks, then free the idle buffers.
+   * Called before the back-end owning the buffers is freed.
+   */
+  void free();
+};
+
+/* Syntactic sugar. */
+static inline GPUReadback *wrap(Readback *readback)
+{
+  return reinterpret_cast<GPUReadback *>(readback);
+}
+static inline Readback *unwrap(GPUReadback *readback)
+{
+  return reinterpret_cast<Readback *>(readback);
+}
+static inline const Readback *unwrap(const GPUReadback *readback)
+{
+  return reinterpret_cast<const Readback *>(readback);
+}
+
+}  // namespace dust::gpu
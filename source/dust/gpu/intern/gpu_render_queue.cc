@@ -0,0 +1,355 @@
+#include <cstring>
+#include <utility>
+
+#include "LIB_assert.h"
+
+#include "GPU_render_queue.h"
+#include "GPU_shader.h"
+
+#include "gpu_context_private.hh"
+#include "gpu_render_queue_private.hh"
+
+namespace dust::gpu {
+
+/** Draws use 16bit ids for their shader, state and resources. */
+#define RENDER_QUEUE_ID_LEN (UINT16_MAX + 1)
+
+RenderQueueStats RenderQueue::stats;
+
+/* -------------------------------------------------------------------- */
+/* Keys */
+
+static inline uint64_t hash_combine(uint64_t hash, uint64_t value)
+{
+  return (hash ^ value) * 0x100000001b3ull;
+}
+
+uint64_t RenderQueueState::hash() const
+{
+  uint64_t hash = hash_combine(0xcbf29ce484222325ull, state.data);
+  for (int i = 0; i < ARRAY_SIZE(mutable_state.data); i++) {
+    hash = hash_combine(hash, mutable_state.data[i]);
+  }
+  return hash;
+}
+
+uint64_t RenderQueueResources::hash() const
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (int i = 0; i < GPU_RENDER_QUEUE_TEXTURE_MAX; i++) {
+    hash = hash_combine(hash, uint64_t(uintptr_t(textures[i])));
+  }
+  for (int i = 0; i < GPU_RENDER_QUEUE_UBO_MAX; i++) {
+    hash = hash_combine(hash, uint64_t(uintptr_t(ubos[i])));
+  }
+  return hash;
+}
+
+bool RenderQueueResources::operator==(const RenderQueueResources &other) const
+{
+  return memcmp(textures, other.textures, sizeof(textures)) == 0 &&
+         memcmp(ubos, other.ubos, sizeof(ubos)) == 0;
+}
+
+template<typename T>
+static uint16_t unique_id_get(Vector<T> &values, Map<T, uint16_t> &ids, const T &value)
+{
+  const uint16_t *id = ids.lookup_ptr(value);
+  if (id) {
+    return *id;
+  }
+  const uint16_t new_id = uint16_t(values.size());
+  values.append(value);
+  ids.add_new(value, new_id);
+  return new_id;
+}
+
+/** 16 most significant bits of \a depth, in an order matching the order of the values. */
+static inline uint64_t depth_key(float depth)
+{
+  uint32_t bits;
+  memcpy(&bits, &depth, sizeof(bits));
+  bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  return bits >> 16;
+}
+
+uint64_t RenderQueue::sort_key(const RenderQueueDraw &draw) const
+{
+  const uint64_t depth = depth_key(draw.depth);
+  if (order_ == GPU_RENDER_QUEUE_TRANSPARENT) {
+    /* Farthest first. */
+    return ((depth ^ 0xFFFFu) << 48) | (uint64_t(draw.shader) << 32) |
+           (uint64_t(draw.state) << 16) | uint64_t(draw.resources);
+  }
+  return (uint64_t(draw.shader) << 48) | (uint64_t(draw.state) << 32) |
+         (uint64_t(draw.resources) << 16) | depth;
+}
+
+/* -------------------------------------------------------------------- */
+/* Recording */
+
+void RenderQueue::texture_bind(GPUTexture *tex, int unit)
+{
+  LIB_assert(unit >= 0 && unit < GPU_RENDER_QUEUE_TEXTURE_MAX);
+  if (bound_.textures[unit] != tex) {
+    bound_.textures[unit] = tex;
+    bound_valid_ = false;
+  }
+}
+
+void RenderQueue::uniformbuf_bind(GPUUniformBuf *ubo, int slot)
+{
+  LIB_assert(slot >= 0 && slot < GPU_RENDER_QUEUE_UBO_MAX);
+  if (bound_.ubos[slot] != ubo) {
+    bound_.ubos[slot] = ubo;
+    bound_valid_ = false;
+  }
+}
+
+void RenderQueue::draw(GPUBatch *batch,
+                       GPUShader *shader,
+                       float depth,
+                       int v_first,
+                       int v_count,
+                       int i_first,
+                       int i_count)
+{
+  if (shaders_.size() == RENDER_QUEUE_ID_LEN || states_.size() == RENDER_QUEUE_ID_LEN ||
+      resources_.size() == RENDER_QUEUE_ID_LEN)
+  {
+    /* Out of ids, draw what was recorded so far. */
+    const RenderQueueResources bound = bound_;
+    this->submit();
+    bound_ = bound;
+  }
+
+  const StateManager *state_manager = Context::get()->state_manager;
+  RenderQueueState state;
+  state.state = state_manager->state;
+  state.mutable_state = state_manager->mutable_state;
+
+  if (!bound_valid_) {
+    bound_id_ = unique_id_get(resources_, resource_ids_, bound_);
+    bound_valid_ = true;
+  }
+
+  RenderQueueDraw draw;
+  draw.batch = batch;
+  draw.v_first = v_first;
+  draw.v_count = v_count;
+  draw.i_first = i_first;
+  draw.i_count = i_count;
+  draw.depth = depth;
+  draw.shader = unique_id_get(shaders_, shader_ids_, shader);
+  draw.state = unique_id_get(states_, state_ids_, state);
+  draw.resources = bound_id_;
+  draws_.append(draw);
+}
+
+/* -------------------------------------------------------------------- */
+/* Submission */
+
+void RenderQueue::sort()
+{
+  const int64_t len = draws_.size();
+  keys_.resize(len);
+  keys_tmp_.resize(len);
+  order_a_.resize(len);
+  order_b_.resize(len);
+
+  /* Least significant digit radix sort, 8 bits at a time. Stable, so draws with equal keys keep
+   * their recorded order. */
+  uint32_t histograms[8][256] = {{0}};
+  for (int64_t i = 0; i < len; i++) {
+    const uint64_t key = this->sort_key(draws_[i]);
+    keys_[i] = key;
+    order_a_[i] = uint32_t(i);
+    for (int pass = 0; pass < 8; pass++) {
+      histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+    }
+  }
+
+  for (int pass = 0; pass < 8; pass++) {
+    const int shift = pass * 8;
+    uint32_t *histogram = histograms[pass];
+    /* All keys share this digit, nothing would move. */
+    if (histogram[(keys_[0] >> shift) & 0xFF] == uint32_t(len)) {
+      continue;
+    }
+    uint32_t offset = 0;
+    for (int digit = 0; digit < 256; digit++) {
+      const uint32_t count = histogram[digit];
+      histogram[digit] = offset;
+      offset += count;
+    }
+    for (int64_t i = 0; i < len; i++) {
+      const uint32_t dst = histogram[(keys_[i] >> shift) & 0xFF]++;
+      keys_tmp_[dst] = keys_[i];
+      order_b_[dst] = order_a_[i];
+    }
+    std::swap(keys_, keys_tmp_);
+    std::swap(order_a_, order_b_);
+  }
+}
+
+void RenderQueue::submit()
+{
+  if (draws_.is_empty()) {
+    this->clear();
+    return;
+  }
+
+  /* Transitions the draws would have needed in recording order. Counted here so that the draws
+   * of a queue cleared without being submitted are not. */
+  uint32_t transitions_recorded = 3;
+  for (const int64_t i : draws_.index_range().drop_front(1)) {
+    const RenderQueueDraw &prev = draws_[i - 1];
+    const RenderQueueDraw &draw = draws_[i];
+    transitions_recorded += uint32_t(prev.shader != draw.shader) +
+                            uint32_t(prev.state != draw.state) +
+                            uint32_t(prev.resources != draw.resources);
+  }
+  stats.transitions_recorded += transitions_recorded;
+
+  this->sort();
+
+  StateManager *state_manager = Context::get()->state_manager;
+  const GPUState prev_state = state_manager->state;
+  const GPUStateMutable prev_mutable_state = state_manager->mutable_state;
+
+  const RenderQueueDraw *prev = nullptr;
+  for (const uint32_t index : order_a_) {
+    const RenderQueueDraw &draw = draws_[index];
+    if (prev == nullptr || prev->shader != draw.shader) {
+      GPU_shader_bind(shaders_[draw.shader]);
+      stats.transitions_submitted++;
+    }
+    if (prev == nullptr || prev->state != draw.state) {
+      state_manager->state = states_[draw.state].state;
+      state_manager->mutable_state = states_[draw.state].mutable_state;
+      stats.transitions_submitted++;
+    }
+    if (prev == nullptr || prev->resources != draw.resources) {
+      const RenderQueueResources &resources = resources_[draw.resources];
+      const RenderQueueResources *prev_resources = prev ? &resources_[prev->resources] : nullptr;
+      /* Slots left empty by a draw are unbound, so that it can't read the previous draw's. */
+      for (int unit = 0; unit < GPU_RENDER_QUEUE_TEXTURE_MAX; unit++) {
+        GPUTexture *tex = resources.textures[unit];
+        GPUTexture *prev_tex = prev_resources ? prev_resources->textures[unit] : nullptr;
+        if (tex == prev_tex) {
+          continue;
+        }
+        if (tex) {
+          GPU_texture_bind(tex, unit);
+        }
+        else {
+          GPU_texture_unbind(prev_tex);
+        }
+      }
+      for (int slot = 0; slot < GPU_RENDER_QUEUE_UBO_MAX; slot++) {
+        GPUUniformBuf *ubo = resources.ubos[slot];
+        GPUUniformBuf *prev_ubo = prev_resources ? prev_resources->ubos[slot] : nullptr;
+        if (ubo == prev_ubo) {
+          continue;
+        }
+        if (ubo) {
+          GPU_uniformbuf_bind(ubo, slot);
+        }
+        else {
+          GPU_uniformbuf_unbind(prev_ubo);
+        }
+      }
+      stats.transitions_submitted++;
+    }
+    GPU_batch_draw_advanced(draw.batch, draw.v_first, draw.v_count, draw.i_first, draw.i_count);
+    prev = &draw;
+  }
+  stats.draw_len += uint32_t(draws_.size());
+
+  state_manager->state = prev_state;
+  state_manager->mutable_state = prev_mutable_state;
+
+  this->clear();
+}
+
+void RenderQueue::clear()
+{
+  draws_.clear();
+  shaders_.clear();
+  shader_ids_.clear();
+  states_.clear();
+  state_ids_.clear();
+  resources_.clear();
+  resource_ids_.clear();
+  bound_ = RenderQueueResources();
+  bound_valid_ = false;
+}
+
+/* -------------------------------------------------------------------- */
+/* Statistics */
+
+void RenderQueueStats::frame_step()
+{
+  last_frame.draw_len = draw_len.exchange(0);
+  last_frame.transitions_recorded = transitions_recorded.exchange(0);
+  last_frame.transitions_submitted = transitions_submitted.exchange(0);
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+static inline RenderQueue *unwrap(GPURenderQueue *queue)
+{
+  return reinterpret_cast<RenderQueue *>(queue);
+}
+
+GPURenderQueue *GPU_render_queue_create(eGPURenderQueueOrder order)
+{
+  return reinterpret_cast<GPURenderQueue *>(new RenderQueue(order));
+}
+
+void GPU_render_queue_free(GPURenderQueue *queue)
+{
+  delete unwrap(queue);
+}
+
+void GPU_render_queue_texture_bind(GPURenderQueue *queue, GPUTexture *tex, int unit)
+{
+  unwrap(queue)->texture_bind(tex, unit);
+}
+
+void GPU_render_queue_uniformbuf_bind(GPURenderQueue *queue, GPUUniformBuf *ubo, int slot)
+{
+  unwrap(queue)->uniformbuf_bind(ubo, slot);
+}
+
+void GPU_render_queue_draw_ex(GPURenderQueue *queue,
+                              GPUBatch *batch,
+                              GPUShader *shader,
+                              float depth,
+                              int v_first,
+                              int v_count,
+                              int i_first,
+                              int i_count)
+{
+  unwrap(queue)->draw(batch, shader, depth, v_first, v_count, i_first, i_count);
+}
+
+void GPU_render_queue_submit(GPURenderQueue *queue)
+{
+  unwrap(queue)->submit();
+}
+
+void GPU_render_queue_clear(GPURenderQueue *queue)
+{
+  unwrap(queue)->clear();
+}
+
+void GPU_render_queue_stats_get(GPURenderQueueStats *r_stats)
+{
+  *r_stats = RenderQueue::stats.last_frame;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_map.hh"
+#include "LIB_vector.hh"
+
+#include "GPU_render_queue.h"
+
+#include "gpu_state_private.hh"
+
+namespace dust::gpu {
+
+/** Pipeline state of a draw. */
+struct RenderQueueState {
+  GPUState state;
+  GPUStateMutable mutable_state;
+
+  uint64_t hash() const;
+  bool operator==(const RenderQueueState &other) const
+  {
+    return state == other.state && mutable_state == other.mutable_state;
+  }
+};
+
+/** Resources bound with the queue functions. */
+struct RenderQueueResources {
+  GPUTexture *textures[GPU_RENDER_QUEUE_TEXTURE_MAX] = {nullptr};
+  GPUUniformBuf *ubos[GPU_RENDER_QUEUE_UBO_MAX] = {nullptr};
+
+  uint64_t hash() const;
+  bool operator==(const RenderQueueResources &other) const;
+};
+
+struct RenderQueueDraw {
+  GPUBatch *batch;
+  int v_first, v_count, i_first, i_count;
+  float depth;
+  /* Indices in the unique shader, state and resource lists of the queue. */
+  uint16_t shader;
+  uint16_t state;
+  uint16_t resources;
+};
+
+/** Cumulative counters of the current frame and values of the last frame. */
+struct RenderQueueStats {
+  std::atomic<uint32_t> draw_len = 0;
+  std::atomic<uint32_t> transitions_recorded = 0;
+  std::atomic<uint32_t> transitions_submitted = 0;
+  GPURenderQueueStats last_frame = {};
+
+  /** Called by the back-ends at the end of every frame. */
+  void frame_step();
+};
+
+class RenderQueue {
+ public:
+  static RenderQueueStats stats;
+
+ private:
+  eGPURenderQueueOrder order_;
+  Vector<RenderQueueDraw> draws_;
+
+  /* Unique values used by the draws, indexed by the draw ids. */
+  Vector<GPUShader *> shaders_;
+  Map<GPUShader *, uint16_t> shader_ids_;
+  Vector<RenderQueueState> states_;
+  Map<RenderQueueState, uint16_t> state_ids_;
+  Vector<RenderQueueResources> resources_;
+  Map<RenderQueueResources, uint16_t> resource_ids_;
+
+  /** Bindings for the next draws. */
+  RenderQueueResources bound_;
+  /** False if #bound_ changed since it was added to #resources_. */
+  bool bound_valid_ = false;
+  uint16_t bound_id_ = 0;
+
+  /* Sort buffers, kept to avoid allocations every frame. */
+  Vector<uint64_t> keys_;
+  Vector<uint32_t> order_a_, order_b_;
+  Vector<uint64_t> keys_tmp_;
+
+ public:
+  RenderQueue(eGPURenderQueueOrder order) : order_(order){};
+
+  void texture_bind(GPUTexture *tex, int unit);
+  void uniformbuf_bind(GPUUniformBuf *ubo, int slot);
+  void draw(GPUBatch *batch,
+            GPUShader *shader,
+            float depth,
+            int v_first,
+            int v_count,
+            int i_first,
+            int i_count);
+  void submit();
+  void clear();
+
+ private:
+  uint64_t sort_key(const RenderQueueDraw &draw) const;
+  /** Fill #order_a_ with the draw indices sorted by key. */
+  void sort();
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("RenderQueue");
+};
+
+}  // namespace dust::gpu
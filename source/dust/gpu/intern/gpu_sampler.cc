@@ -0,0 +1,110 @@
+#include "LIB_math_base.h"
+
+#include "gpu_sampler_private.hh"
+
+namespace dust::gpu {
+
+/* -------------------------------------------------------------------- */
+/* Table */
+
+static SamplerWrap sampler_wrap(eGPUSamplerState state, eGPUSamplerState repeat_flag)
+{
+  if (state & repeat_flag) {
+    return SamplerWrap::REPEAT;
+  }
+  return (state & GPU_SAMPLER_CLAMP_BORDER) ? SamplerWrap::CLAMP_TO_BORDER :
+                                             SamplerWrap::CLAMP_TO_EDGE;
+}
+
+void SamplerTable::build()
+{
+  /* Every combination of the flags below #GPU_SAMPLER_ICON. */
+  for (int i = 0; i < GPU_SAMPLER_ICON; i++) {
+    const eGPUSamplerState state = eGPUSamplerState(i);
+    SamplerState &sampler = states_[i];
+    const SamplerFilter filter = (state & GPU_SAMPLER_FILTER) ? SamplerFilter::LINEAR :
+                                                                SamplerFilter::NEAREST;
+    sampler.mag_filter = filter;
+    sampler.min_filter = filter;
+    sampler.mip_filter = SamplerFilter::LINEAR;
+    sampler.use_mipmap = (state & GPU_SAMPLER_MIPMAP) != 0;
+    sampler.use_compare = (state & GPU_SAMPLER_COMPARE) != 0;
+    sampler.wrap[0] = sampler_wrap(state, GPU_SAMPLER_REPEAT_S);
+    sampler.wrap[1] = sampler_wrap(state, GPU_SAMPLER_REPEAT_T);
+    sampler.wrap[2] = sampler_wrap(state, GPU_SAMPLER_REPEAT_R);
+    /* Anisotropy only makes sense with mip-maps. */
+    sampler.anisotropy = ((state & GPU_SAMPLER_MIPMAP) && (state & GPU_SAMPLER_ANISO)) ?
+                             anisotropy_ :
+                             1.0f;
+    sampler.lod_bias = 0.0f;
+  }
+
+  /* Icons are drawn small, bias towards the sharper level. */
+  SamplerState &icon = states_[GPU_SAMPLER_ICON];
+  icon.mag_filter = SamplerFilter::LINEAR;
+  icon.min_filter = SamplerFilter::LINEAR;
+  icon.mip_filter = SamplerFilter::NEAREST;
+  icon.use_mipmap = true;
+  icon.use_compare = false;
+  icon.wrap[0] = icon.wrap[1] = icon.wrap[2] = SamplerWrap::CLAMP_TO_EDGE;
+  icon.anisotropy = 1.0f;
+  icon.lod_bias = -0.5f;
+
+  rebuild_count_++;
+}
+
+void SamplerTable::init(float anisotropy_max)
+{
+  anisotropy_max_ = max_ff(anisotropy_max, 1.0f);
+  this->update();
+}
+
+void SamplerTable::anisotropy_set(float anisotropy)
+{
+  anisotropy_pref_ = anisotropy;
+}
+
+bool SamplerTable::update()
+{
+  const float anisotropy = clamp_f(anisotropy_pref_, 1.0f, anisotropy_max_);
+  if (anisotropy == anisotropy_) {
+    return false;
+  }
+  anisotropy_ = anisotropy;
+  this->build();
+  return true;
+}
+
+/* -------------------------------------------------------------------- */
+/* Statistics */
+
+void SamplerTable::frame_step()
+{
+  binds_last_ = binds_.exchange(0, std::memory_order_relaxed);
+  rebinds_last_ = rebinds_.exchange(0, std::memory_order_relaxed);
+}
+
+void SamplerTable::stats_get(GPUSamplerStats *r_stats) const
+{
+  r_stats->binds = binds_last_;
+  r_stats->rebinds = rebinds_last_;
+  r_stats->rebuild_count = rebuild_count_;
+  r_stats->anisotropy = anisotropy_;
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+void GPU_samplers_anisotropic_filter_set(float level)
+{
+  SamplerTable::get().anisotropy_set(level);
+}
+
+void GPU_samplers_stats_get(GPUSamplerStats *r_stats)
+{
+  SamplerTable::get().stats_get(r_stats);
+}
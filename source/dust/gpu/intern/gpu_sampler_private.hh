@@ -0,0 +1,105 @@
+/* Sampler parameters of every #eGPUSamplerState, shared by all contexts and back-ends. */
+
+#pragma once
+
+#include <atomic>
+
+#include "LIB_assert.h"
+
+#include "GPU_texture.h"
+
+namespace dust::gpu {
+
+enum class SamplerFilter : uint8_t {
+  NEAREST = 0,
+  LINEAR,
+};
+
+enum class SamplerWrap : uint8_t {
+  CLAMP_TO_EDGE = 0,
+  REPEAT,
+  CLAMP_TO_BORDER,
+};
+
+/** Fully resolved sampler parameters, what a back-end needs to create a sampler object. */
+struct SamplerState {
+  SamplerFilter mag_filter;
+  SamplerFilter min_filter;
+  /** Filtering between mip levels, only used if #use_mipmap is set. */
+  SamplerFilter mip_filter;
+  bool use_mipmap;
+  bool use_compare;
+  /** S, T and R axes. */
+  SamplerWrap wrap[3];
+  /** 1 when anisotropic filtering is disabled. */
+  float anisotropy;
+  float lod_bias;
+};
+
+/**
+ * Table of all the sampler states, built when the first context is created.
+ * Binding a texture is then only an index into the table. Back-ends owning device sampler
+ * objects create them from this table and recreate them in #GPUBackend::samplers_update.
+ */
+class SamplerTable {
+ private:
+  SamplerState states_[GPU_SAMPLER_MAX];
+  /** Device limit. */
+  float anisotropy_max_ = 1.0f;
+  /** User preference, applied by the next #update. */
+  float anisotropy_pref_ = 1.0f;
+  /** Level the table was built with, zero if it was never built. */
+  float anisotropy_ = 0.0f;
+
+  /* Bind counters of the current frame. Relaxed atomics, contexts can live on other threads. */
+  std::atomic<uint32_t> binds_ = 0;
+  std::atomic<uint32_t> rebinds_ = 0;
+  /* Bind counters of the last finished frame. */
+  uint32_t binds_last_ = 0;
+  uint32_t rebinds_last_ = 0;
+  uint32_t rebuild_count_ = 0;
+
+ public:
+  static SamplerTable &get()
+  {
+    static SamplerTable table;
+    return table;
+  }
+
+  /** Called on context creation with the highest anisotropy the device supports. */
+  void init(float anisotropy_max);
+  void anisotropy_set(float anisotropy);
+  /** Rebuild the table if the anisotropy changed. Return true if it was rebuilt. */
+  bool update();
+
+  const SamplerState &operator[](eGPUSamplerState state) const
+  {
+    LIB_assert(state < GPU_SAMPLER_MAX);
+    return states_[state];
+  }
+
+  /** Inverse of the above, \a sampler must be an entry of the table. */
+  eGPUSamplerState state_get(const SamplerState &sampler) const
+  {
+    LIB_assert(&sampler >= states_ && &sampler < states_ + GPU_SAMPLER_MAX);
+    return eGPUSamplerState(&sampler - states_);
+  }
+
+  /** Called by the state managers on every texture bind. */
+  void bind_count(bool sampler_changed)
+  {
+    binds_.fetch_add(1, std::memory_order_relaxed);
+    if (sampler_changed) {
+      rebinds_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /** Called by the back-ends at the end of every frame. */
+  void frame_step();
+  void stats_get(GPUSamplerStats *r_stats) const;
+
+ private:
+  void build();
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,484 @@
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+#include "LIB_assert.h"
+#include "LIB_string.h"
+#include "LIB_vector.hh"
+
+#include "PIL_time.h"
+
+#include "GPU_shader_cache.h"
+
+#include "gpu_shader_cache_private.hh"
+
+namespace fs = std::filesystem;
+
+namespace dust::gpu {
+
+using namespace shader;
+
+#define SHADER_CACHE_VERSION 1
+#define SHADER_CACHE_EXTENSION ".bin"
+
+/** Entries are this header followed by the binary. */
+struct ShaderCacheEntryHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  uint64_t driver_hash;
+  uint32_t binary_format;
+  uint32_t binary_size;
+  uint64_t binary_hash;
+};
+
+static const char shader_cache_magic[4] = {'D', 'S', 'C', 'B'};
+
+/* -------------------------------------------------------------------- */
+/* Hashing
+ * FNV-1a, the keys must stay the same across sessions and platforms. */
+
+struct ShaderCacheHasher {
+  uint64_t value = 0xcbf29ce484222325ull;
+
+  void add(const void *data, size_t size)
+  {
+    const uchar *bytes = static_cast<const uchar *>(data);
+    for (size_t i = 0; i < size; i++) {
+      value = (value ^ bytes[i]) * 0x100000001b3ull;
+    }
+  }
+  void add_int(uint64_t number)
+  {
+    for (int i = 0; i < 8; i++) {
+      value = (value ^ ((number >> (i * 8)) & 0xFF)) * 0x100000001b3ull;
+    }
+  }
+  /** The length is included, so that consecutive strings can't be confused. */
+  void add_str(StringRef str)
+  {
+    this->add_int(uint64_t(str.size()));
+    this->add(str.data(), size_t(str.size()));
+  }
+};
+
+static void hash_resource(ShaderCacheHasher &hasher, const ShaderCreateInfo::Resource &res)
+{
+  hasher.add_int(uint64_t(res.bind_type));
+  hasher.add_int(uint64_t(res.slot));
+  switch (res.bind_type) {
+    case ShaderCreateInfo::Resource::UNIFORM_BUFFER:
+      hasher.add_str(res.uniformbuf.type_name);
+      hasher.add_str(res.uniformbuf.name);
+      break;
+    case ShaderCreateInfo::Resource::STORAGE_BUFFER:
+      hasher.add_int(uint64_t(res.storagebuf.qualifiers));
+      hasher.add_str(res.storagebuf.type_name);
+      hasher.add_str(res.storagebuf.name);
+      break;
+    case ShaderCreateInfo::Resource::SAMPLER:
+      /* #ShaderCreateInfo::sampler doesn't set the sampler state, it is not part of the key. */
+      hasher.add_int(uint64_t(res.sampler.type));
+      hasher.add_str(res.sampler.name);
+      break;
+    case ShaderCreateInfo::Resource::IMAGE:
+      hasher.add_int(uint64_t(res.image.format));
+      hasher.add_int(uint64_t(res.image.type));
+      hasher.add_int(uint64_t(res.image.qualifiers));
+      hasher.add_str(res.image.name);
+      break;
+  }
+}
+
+static void hash_interfaces(ShaderCacheHasher &hasher, Span<StageInterfaceInfo *> interfaces)
+{
+  hasher.add_int(uint64_t(interfaces.size()));
+  for (const StageInterfaceInfo *iface : interfaces) {
+    hasher.add_str(iface->name);
+    hasher.add_str(iface->instance_name);
+    hasher.add_int(uint64_t(iface->inouts.size()));
+    for (const StageInterfaceInfo::InOut &inout : iface->inouts) {
+      hasher.add_int(uint64_t(inout.interp));
+      hasher.add_int(uint64_t(inout.type));
+      hasher.add_str(inout.name);
+    }
+  }
+}
+
+uint64_t ShaderCache::key_get(const ShaderCreateInfo &info, Span<const char *> sources) const
+{
+  ShaderCacheHasher hasher;
+  hasher.add_int(SHADER_CACHE_VERSION);
+  hasher.add_int(driver_hash_);
+
+  hasher.add_int(uint64_t(info.builtins_));
+  hasher.add_int(uint64_t(info.depth_write_));
+  hasher.add_int(uint64_t(info.early_fragment_test_));
+  hasher.add_int(uint64_t(info.auto_resource_location_));
+  hasher.add_int(uint64_t(info.legacy_resource_location_));
+  hasher.add_str(info.vertex_source_generated);
+  hasher.add_str(info.fragment_source_generated);
+  hasher.add_str(info.compute_source_generated);
+  hasher.add_str(info.geometry_source_generated);
+  hasher.add_str(info.typedef_source_generated);
+
+  hasher.add_int(uint64_t(info.vertex_inputs_.size()));
+  for (const ShaderCreateInfo::VertIn &input : info.vertex_inputs_) {
+    hasher.add_int(uint64_t(input.index));
+    hasher.add_int(uint64_t(input.type));
+    hasher.add_str(input.name);
+  }
+  /* The layout is left uninitialized when there is no geometry stage. */
+  if (!info.geometry_source_.is_empty()) {
+    hasher.add_int(uint64_t(info.geometry_layout_.primitive_in));
+    hasher.add_int(uint64_t(info.geometry_layout_.invocations));
+    hasher.add_int(uint64_t(info.geometry_layout_.primitive_out));
+    hasher.add_int(uint64_t(info.geometry_layout_.max_vertices));
+  }
+  hasher.add_int(uint64_t(info.compute_layout_.local_size_x));
+  hasher.add_int(uint64_t(info.compute_layout_.local_size_y));
+  hasher.add_int(uint64_t(info.compute_layout_.local_size_z));
+  hasher.add_int(uint64_t(info.fragment_outputs_.size()));
+  for (const ShaderCreateInfo::FragOut &output : info.fragment_outputs_) {
+    hasher.add_int(uint64_t(output.index));
+    hasher.add_int(uint64_t(output.type));
+    hasher.add_int(uint64_t(output.blend));
+    hasher.add_str(output.name);
+  }
+  for (const Vector<ShaderCreateInfo::Resource> *resources :
+       {&info.pass_resources_, &info.batch_resources_})
+  {
+    hasher.add_int(uint64_t(resources->size()));
+    for (const ShaderCreateInfo::Resource &res : *resources) {
+      hash_resource(hasher, res);
+    }
+  }
+  hash_interfaces(hasher, info.vertex_out_interfaces_);
+  hash_interfaces(hasher, info.geometry_out_interfaces_);
+  hasher.add_int(uint64_t(info.push_constants_.size()));
+  for (const ShaderCreateInfo::PushConst &push_constant : info.push_constants_) {
+    hasher.add_int(uint64_t(push_constant.type));
+    hasher.add_str(push_constant.name);
+    hasher.add_int(uint64_t(push_constant.array_size));
+  }
+
+  hasher.add_int(uint64_t(info.typedef_sources_.size()));
+  for (const StringRefNull &name : info.typedef_sources_) {
+    hasher.add_str(name);
+  }
+  hasher.add_str(info.vertex_source_);
+  hasher.add_str(info.geometry_source_);
+  hasher.add_str(info.fragment_source_);
+  hasher.add_str(info.compute_source_);
+  hasher.add_int(uint64_t(info.defines_.size()));
+  for (const std::array<StringRefNull, 2> &define : info.defines_) {
+    hasher.add_str(define[0]);
+    hasher.add_str(define[1]);
+  }
+  hasher.add_int(uint64_t(info.additional_infos_.size()));
+  for (const StringRefNull &name : info.additional_infos_) {
+    hasher.add_str(name);
+  }
+
+  /* The file names above don't change when the files do, the resolved sources do. */
+  hasher.add_int(uint64_t(sources.size()));
+  for (const char *source : sources) {
+    hasher.add_str(source ? source : "");
+  }
+  return hasher.value;
+}
+
+/* -------------------------------------------------------------------- */
+/* Initialization */
+
+void ShaderCache::init(const char *directory, size_t size_max)
+{
+  std::scoped_lock lock(mutex_);
+  directory_.clear();
+  disk_size_ = 0;
+  this->enabled_update();
+  if (directory == nullptr || directory[0] == '\0') {
+    return;
+  }
+  std::error_code error;
+  fs::create_directories(directory, error);
+  if (error) {
+    fprintf(stderr,
+            "GPUShaderCache: Error: can't create \"%s\": %s, cache disabled.\n",
+            directory,
+            error.message().c_str());
+    return;
+  }
+  directory_ = directory;
+  size_max_ = size_max;
+  this->enabled_update();
+
+  for (const fs::directory_entry &entry : fs::directory_iterator(directory_, error)) {
+    if (!entry.is_regular_file(error)) {
+      continue;
+    }
+    if (entry.path().extension() == SHADER_CACHE_EXTENSION) {
+      disk_size_ += size_t(entry.file_size(error));
+    }
+    else if (entry.path().extension() == ".tmp") {
+      /* Left over by a session that stopped while storing. */
+      fs::remove(entry.path(), error);
+    }
+  }
+  this->trim();
+}
+
+void ShaderCache::exit()
+{
+  std::scoped_lock lock(mutex_);
+  directory_.clear();
+  disk_size_ = 0;
+  this->enabled_update();
+}
+
+void ShaderCache::clear()
+{
+  std::scoped_lock lock(mutex_);
+  if (directory_.empty()) {
+    return;
+  }
+  std::error_code error;
+  for (const fs::directory_entry &entry : fs::directory_iterator(directory_, error)) {
+    if (entry.path().extension() == SHADER_CACHE_EXTENSION) {
+      fs::remove(entry.path(), error);
+    }
+  }
+  disk_size_ = 0;
+}
+
+void ShaderCache::driver_set(StringRef identity)
+{
+  ShaderCacheHasher hasher;
+  hasher.add_str(identity);
+  std::scoped_lock lock(mutex_);
+  /* Zero means unknown. */
+  driver_hash_ = hasher.value ? hasher.value : 1;
+  this->enabled_update();
+}
+
+/* -------------------------------------------------------------------- */
+/* Entries */
+
+std::string ShaderCache::entry_path(uint64_t key) const
+{
+  char name[32];
+  LIB_snprintf(name, sizeof(name), "%016" PRIx64 SHADER_CACHE_EXTENSION, key);
+  return (fs::path(directory_) / name).string();
+}
+
+void ShaderCache::entry_remove(const std::string &path)
+{
+  std::error_code error;
+  const uintmax_t size = fs::file_size(path, error);
+  if (!error && fs::remove(path, error)) {
+    disk_size_ -= std::min(disk_size_, size_t(size));
+  }
+}
+
+void ShaderCache::trim()
+{
+  if (disk_size_ <= size_max_) {
+    return;
+  }
+  struct Entry {
+    fs::path path;
+    fs::file_time_type time;
+    size_t size;
+  };
+  Vector<Entry> entries;
+  std::error_code error;
+  for (const fs::directory_entry &entry : fs::directory_iterator(directory_, error)) {
+    if (entry.path().extension() == SHADER_CACHE_EXTENSION) {
+      entries.append({entry.path(), entry.last_write_time(error), size_t(entry.file_size(error))});
+    }
+  }
+  /* Hits touch their entry, the oldest ones are the least recently used. */
+  std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+    return a.time < b.time;
+  });
+  for (const Entry &entry : entries) {
+    if (disk_size_ <= size_max_) {
+      break;
+    }
+    if (fs::remove(entry.path, error)) {
+      disk_size_ -= std::min(disk_size_, entry.size);
+    }
+  }
+}
+
+bool ShaderCache::load(Shader &shader, uint64_t key, const ShaderCreateInfo *info)
+{
+  if (!this->is_enabled()) {
+    return false;
+  }
+  const double start_time = PIL_check_seconds_timer();
+  std::string path;
+  {
+    std::scoped_lock lock(mutex_);
+    /* Disabled by #exit meanwhile. */
+    if (directory_.empty()) {
+      return false;
+    }
+    path = this->entry_path(key);
+  }
+
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    miss_len_++;
+    if (use_debug_) {
+      printf("GPUShaderCache: miss %s\n", shader.name_get());
+    }
+    return false;
+  }
+
+  ShaderCacheEntryHeader header;
+  Vector<uint8_t> binary;
+  bool is_valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                  memcmp(header.magic, shader_cache_magic, sizeof(header.magic)) == 0 &&
+                  header.version == SHADER_CACHE_VERSION && header.key == key &&
+                  header.driver_hash == driver_hash_;
+  if (is_valid) {
+    binary.resize(header.binary_size);
+    is_valid = fread(binary.data(), 1, binary.size(), file) == binary.size() &&
+               fgetc(file) == EOF;
+  }
+  fclose(file);
+  if (is_valid) {
+    ShaderCacheHasher hasher;
+    hasher.add(binary.data(), binary.size());
+    is_valid = hasher.value == header.binary_hash;
+  }
+
+  /* The driver call can be long, don't hold the lock during it. */
+  if (!is_valid || !shader.binary_load(binary, header.binary_format, info)) {
+    std::scoped_lock lock(mutex_);
+    this->entry_remove(path);
+    reject_len_++;
+    miss_len_++;
+    if (use_debug_) {
+      printf("GPUShaderCache: rejected %s\n", shader.name_get());
+    }
+    return false;
+  }
+
+  const double time = PIL_check_seconds_timer() - start_time;
+  std::scoped_lock lock(mutex_);
+  /* Keep track of the use for #trim. */
+  std::error_code error;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+  load_time_ += time;
+  hit_len_++;
+  if (use_debug_) {
+    printf("GPUShaderCache: hit %s, loaded in %.2f ms\n", shader.name_get(), time * 1000.0);
+  }
+  return true;
+}
+
+void ShaderCache::store(const Shader &shader, uint64_t key, double compile_time)
+{
+  if (!this->is_enabled()) {
+    return;
+  }
+  Vector<uint8_t> binary;
+  uint32_t binary_format = 0;
+  const bool has_binary = shader.binary_get(binary, binary_format);
+
+  std::scoped_lock lock(mutex_);
+  if (directory_.empty()) {
+    return;
+  }
+  compile_time_ += compile_time;
+  if (use_debug_) {
+    printf("GPUShaderCache: compiled %s in %.2f ms\n", shader.name_get(), compile_time * 1000.0);
+  }
+  if (!has_binary || binary.is_empty()) {
+    return;
+  }
+
+  ShaderCacheEntryHeader header;
+  memcpy(header.magic, shader_cache_magic, sizeof(header.magic));
+  header.version = SHADER_CACHE_VERSION;
+  header.key = key;
+  header.driver_hash = driver_hash_;
+  header.binary_format = binary_format;
+  header.binary_size = uint32_t(binary.size());
+  ShaderCacheHasher hasher;
+  hasher.add(binary.data(), binary.size());
+  header.binary_hash = hasher.value;
+
+  /* Write to a temporary file first, other processes can read the cache at the same time. */
+  const std::string path = this->entry_path(key);
+  const std::string tmp_path = path + "." + std::to_string(std::random_device()()) + ".tmp";
+  FILE *file = fopen(tmp_path.c_str(), "wb");
+  if (file == nullptr) {
+    return;
+  }
+  const bool is_written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                          fwrite(binary.data(), 1, binary.size(), file) == binary.size();
+  if (fclose(file) != 0 || !is_written) {
+    std::error_code error;
+    fs::remove(tmp_path, error);
+    return;
+  }
+
+  this->entry_remove(path);
+  std::error_code error;
+  fs::rename(tmp_path, path, error);
+  if (error) {
+    fs::remove(tmp_path, error);
+    return;
+  }
+  disk_size_ += sizeof(header) + binary.size();
+  this->trim();
+}
+
+void ShaderCache::stats_get(GPUShaderCacheStats &r_stats)
+{
+  std::scoped_lock lock(mutex_);
+  r_stats.hit_len = hit_len_;
+  r_stats.miss_len = miss_len_;
+  r_stats.reject_len = reject_len_;
+  r_stats.load_time = load_time_;
+  r_stats.compile_time = compile_time_;
+  r_stats.disk_size = disk_size_;
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+void GPU_shader_cache_init(const char *directory, size_t size_max)
+{
+  ShaderCache::get().init(directory, size_max);
+}
+
+void GPU_shader_cache_exit()
+{
+  ShaderCache::get().exit();
+}
+
+void GPU_shader_cache_clear()
+{
+  ShaderCache::get().clear();
+}
+
+void GPU_shader_cache_debug_set(bool enable)
+{
+  ShaderCache::get().debug_set(enable);
+}
+
+void GPU_shader_cache_stats_get(GPUShaderCacheStats *r_stats)
+{
+  ShaderCache::get().stats_get(*r_stats);
+}
@@ -0,0 +1,91 @@
+/* On-disk cache of shader program binaries, see GPU_shader_cache.h. */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "LIB_span.hh"
+#include "LIB_string_ref.hh"
+
+#include "GPU_shader_cache.h"
+
+#include "gpu_shader_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Shader creation looks up the cache once the sources of all stages are resolved:
+ * - #key_get, then #load. On a hit the shader is ready, nothing is compiled.
+ * - On a miss, compile and finalize the shader as usual, then #store it.
+ * Thread safe, shaders can be compiled from several threads.
+ */
+class ShaderCache {
+ private:
+  /** Protects the disk operations and the fields below. */
+  std::mutex mutex_;
+  /** Empty if the cache is disabled. */
+  std::string directory_;
+  size_t size_max_ = 0;
+  /** Hash of the driver identity, zero until the back-end sets it. */
+  std::atomic<uint64_t> driver_hash_ = 0;
+  /** Both of the above are set. Updated under the lock, read without it. */
+  std::atomic<bool> is_enabled_ = false;
+  bool use_debug_ = false;
+
+  size_t disk_size_ = 0;
+  double load_time_ = 0.0;
+  double compile_time_ = 0.0;
+
+  std::atomic<uint32_t> hit_len_ = 0;
+  std::atomic<uint32_t> miss_len_ = 0;
+  std::atomic<uint32_t> reject_len_ = 0;
+
+ public:
+  static ShaderCache &get()
+  {
+    static ShaderCache cache;
+    return cache;
+  }
+
+  void init(const char *directory, size_t size_max);
+  void exit();
+  void clear();
+
+  /**
+   * Called by back-ends supporting program binaries once the driver is known, with everything
+   * that identifies its compiler (vendor, renderer and version strings for example).
+   */
+  void driver_set(StringRef identity);
+  bool is_enabled() const
+  {
+    return is_enabled_;
+  }
+  void debug_set(bool enable)
+  {
+    use_debug_ = enable;
+  }
+
+  /** Key of a shader, from its finalized create info and the final sources of its stages. */
+  uint64_t key_get(const shader::ShaderCreateInfo &info, Span<const char *> sources) const;
+  /** Create \a shader from the entry of \a key. Return false on a miss. */
+  bool load(Shader &shader, uint64_t key, const shader::ShaderCreateInfo *info);
+  /** Store \a shader after a miss. \a compile_time is the time its compilation took. */
+  void store(const Shader &shader, uint64_t key, double compile_time);
+
+  void stats_get(GPUShaderCacheStats &r_stats);
+
+ private:
+  /** Called with the lock held when #directory_ or #driver_hash_ change. */
+  void enabled_update()
+  {
+    is_enabled_ = !directory_.empty() && driver_hash_ != 0;
+  }
+  std::string entry_path(uint64_t key) const;
+  void entry_remove(const std::string &path);
+  /** Delete the least recently used entries until the cache fits in #size_max_. */
+  void trim();
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_assert.h"
+#include "LIB_span.hh"
+#include "LIB_vector.hh"
+
+#include "GPU_pipeline_cache.h"
+#include "GPU_shader_compiler.h"
+
+#include "gpu_shader_create_info.hh"
+
+namespace dust::gpu {
+
+/** Shaders of one #GPU_shader_compile_async or #GPU_shader_batch_compile_async call. */
+struct ShaderCompileBatch {
+  Vector<const GPUShaderCreateInfo *> infos;
+  Vector<GPUShader *> shaders;
+  /** Compilations not finished yet. Protected by the mutex of the compiler. */
+  int pending_len = 0;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("ShaderCompileBatch");
+};
+
+struct ShaderCompileWork {
+  ShaderCompileBatch *batch;
+  int index;
+};
+
+class ShaderCompiler {
+ private:
+  Vector<std::thread> workers_;
+  GPUShaderCompilerContextCreateFn context_create_fn_ = nullptr;
+  GPUShaderCompilerContextFreeFn context_free_fn_ = nullptr;
+  void *user_data_ = nullptr;
+
+  std::mutex mutex_;
+  /** Signaled when work is queued or on exit. */
+  std::condition_variable work_condition_;
+  /** Signaled when a compilation finishes. */
+  std::condition_variable done_condition_;
+  bool exit_ = false;
+  /** Single shaders requested on demand are compiled before the batches. */
+  std::deque<ShaderCompileWork> urgent_;
+  std::deque<ShaderCompileWork> batched_;
+
+ public:
+  static ShaderCompiler &get()
+  {
+    static ShaderCompiler compiler;
+    return compiler;
+  }
+
+  ~ShaderCompiler()
+  {
+    this->exit();
+  }
+
+  void init(int thread_len,
+            GPUShaderCompilerContextCreateFn context_create_fn,
+            GPUShaderCompilerContextFreeFn context_free_fn,
+            void *user_data)
+  {
+    this->exit();
+    if (thread_len <= 0) {
+      thread_len = std::max(1, int(std::thread::hardware_concurrency()) - 1);
+    }
+    context_create_fn_ = context_create_fn;
+    context_free_fn_ = context_free_fn;
+    user_data_ = user_data;
+    for (int i = 0; i < thread_len; i++) {
+      workers_.append(std::thread([this]() { this->worker_run(); }));
+    }
+  }
+
+  void exit()
+  {
+    if (workers_.is_empty()) {
+      return;
+    }
+    {
+      std::scoped_lock lock(mutex_);
+      exit_ = true;
+    }
+    work_condition_.notify_all();
+    for (std::thread &worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+
+    std::scoped_lock lock(mutex_);
+    exit_ = false;
+    for (std::deque<ShaderCompileWork> *queue : {&urgent_, &batched_}) {
+      for (const ShaderCompileWork &work : *queue) {
+        work.batch->pending_len--;
+      }
+      queue->clear();
+    }
+    done_condition_.notify_all();
+  }
+
+  ShaderCompileBatch *compile(Span<const GPUShaderCreateInfo *> infos, bool is_urgent)
+  {
+    ShaderCompileBatch *batch = new ShaderCompileBatch();
+    batch->infos.extend(infos);
+    batch->shaders.append_n_times(nullptr, infos.size());
+
+    /* Finalizing merges the additional infos into each info, and additional infos are shared by
+     * many of them: the workers must only read them. */
+    for (const GPUShaderCreateInfo *info : infos) {
+      const_cast<shader::ShaderCreateInfo *>(
+          reinterpret_cast<const shader::ShaderCreateInfo *>(info))
+          ->finalize();
+    }
+
+    if (workers_.is_empty()) {
+      for (const int64_t i : infos.index_range()) {
+        batch->shaders[i] = GPU_shader_create_from_info(infos[i]);
+      }
+      return batch;
+    }
+
+    {
+      std::scoped_lock lock(mutex_);
+      std::deque<ShaderCompileWork> &queue = is_urgent ? urgent_ : batched_;
+      for (const int64_t i : infos.index_range()) {
+        queue.push_back({batch, int(i)});
+      }
+      batch->pending_len = int(infos.size());
+    }
+    work_condition_.notify_all();
+    return batch;
+  }
+
+  bool is_ready(const ShaderCompileBatch &batch)
+  {
+    std::scoped_lock lock(mutex_);
+    return batch.pending_len == 0;
+  }
+
+  void finalize(ShaderCompileBatch *batch, GPUShader **r_shaders)
+  {
+    {
+      std::unique_lock lock(mutex_);
+      done_condition_.wait(lock, [&]() { return batch->pending_len == 0; });
+    }
+    /* Called by the draw code, with its context active. */
+    for (GPUShader *shader : batch->shaders) {
+      if (shader) {
+        GPU_pipeline_cache_warm(shader);
+      }
+    }
+    std::copy(batch->shaders.begin(), batch->shaders.end(), r_shaders);
+    delete batch;
+  }
+
+  void cancel(ShaderCompileBatch *batch)
+  {
+    {
+      std::unique_lock lock(mutex_);
+      auto is_cancelled = [&](const ShaderCompileWork &work) {
+        if (work.batch != batch) {
+          return false;
+        }
+        batch->pending_len--;
+        return true;
+      };
+      for (std::deque<ShaderCompileWork> *queue : {&urgent_, &batched_}) {
+        queue->erase(std::remove_if(queue->begin(), queue->end(), is_cancelled), queue->end());
+      }
+      /* The compilations in progress can't be interrupted. */
+      done_condition_.wait(lock, [&]() { return batch->pending_len == 0; });
+    }
+    for (GPUShader *shader : batch->shaders) {
+      if (shader) {
+        GPU_shader_free(shader);
+      }
+    }
+    delete batch;
+  }
+
+ private:
+  void worker_run()
+  {
+    void *context = context_create_fn_ ? context_create_fn_(user_data_) : nullptr;
+    while (true) {
+      ShaderCompileWork work;
+      {
+        std::unique_lock lock(mutex_);
+        work_condition_.wait(lock,
+                             [&]() { return exit_ || !urgent_.empty() || !batched_.empty(); });
+        if (exit_) {
+          break;
+        }
+        std::deque<ShaderCompileWork> &queue = urgent_.empty() ? batched_ : urgent_;
+        work = queue.front();
+        queue.pop_front();
+      }
+
+      GPUShader *shader = GPU_shader_create_from_info(work.batch->infos[work.index]);
+
+      {
+        std::scoped_lock lock(mutex_);
+        work.batch->shaders[work.index] = shader;
+        work.batch->pending_len--;
+      }
+      done_condition_.notify_all();
+    }
+    if (context) {
+      context_free_fn_(context, user_data_);
+    }
+  }
+};
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust;
+using namespace dust::gpu;
+
+static inline ShaderCompileBatch *unwrap(GPUShaderCompileHandle *handle)
+{
+  return reinterpret_cast<ShaderCompileBatch *>(handle);
+}
+static inline const ShaderCompileBatch *unwrap(const GPUShaderCompileHandle *handle)
+{
+  return reinterpret_cast<const ShaderCompileBatch *>(handle);
+}
+static inline GPUShaderCompileHandle *wrap(ShaderCompileBatch *batch)
+{
+  return reinterpret_cast<GPUShaderCompileHandle *>(batch);
+}
+
+void GPU_shader_compiler_init(int thread_len,
+                              GPUShaderCompilerContextCreateFn context_create_fn,
+                              GPUShaderCompilerContextFreeFn context_free_fn,
+                              void *user_data)
+{
+  ShaderCompiler::get().init(thread_len, context_create_fn, context_free_fn, user_data);
+}
+
+void GPU_shader_compiler_exit()
+{
+  ShaderCompiler::get().exit();
+}
+
+GPUShaderCompileHandle *GPU_shader_compile_async(const GPUShaderCreateInfo *info)
+{
+  return wrap(ShaderCompiler::get().compile(Span<const GPUShaderCreateInfo *>(&info, 1), true));
+}
+
+GPUShaderCompileHandle *GPU_shader_batch_compile_async(const GPUShaderCreateInfo **infos,
+                                                       int infos_len)
+{
+  return wrap(ShaderCompiler::get().compile(
+      Span<const GPUShaderCreateInfo *>(infos, infos_len), false));
+}
+
+bool GPU_shader_compile_is_ready(const GPUShaderCompileHandle *handle)
+{
+  return ShaderCompiler::get().is_ready(*unwrap(handle));
+}
+
+void GPU_shader_compile_finalize(GPUShaderCompileHandle **handle, GPUShader **r_shaders)
+{
+  ShaderCompiler::get().finalize(unwrap(*handle), r_shaders);
+  *handle = nullptr;
+}
+
+void GPU_shader_compile_cancel(GPUShaderCompileHandle **handle)
+{
+  ShaderCompiler::get().cancel(unwrap(*handle));
+  *handle = nullptr;
+}
@@ -0,0 +1,380 @@
+#include <sstream>
+
+#include "LIB_assert.h"
+
+#include "gpu_shader_create_info_flat.hh"
+
+namespace dust::gpu::shader {
+
+/* -------------------------------------------------------------------- */
+/* Flattening
+ * Runs at build time, it doesn't need to be fast. */
+
+/* Length after which literals are split into adjacent ones. MSVC refuses single literals longer
+ * than 16380 bytes, the concatenated string can still be up to 65535 bytes. */
+#define LITERAL_PIECE_LEN 4096
+
+/** C++ literal of \a str. */
+static std::string literal(StringRef str)
+{
+  LIB_assert_msg(str.size() < 65535, "String too long for a literal");
+  std::string result = "\"";
+  size_t piece_start = 0;
+  for (const char c : str) {
+    if (result.size() - piece_start >= LITERAL_PIECE_LEN) {
+      /* Only between characters, never inside an escape sequence. */
+      result += "\"\n    \"";
+      piece_start = result.size() - 1;
+    }
+    switch (c) {
+      case '"':
+      case '\\':
+        result += '\\';
+        result += c;
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      case '\r':
+        result += "\\r";
+        break;
+      case '\t':
+        result += "\\t";
+        break;
+      default:
+        if (uchar(c) < 0x20 || c == 0x7F) {
+          /* Octal escapes stop after 3 digits, unlike hexadecimal ones which would swallow the
+           * digits following them. */
+          const char octal[] = {'\\',
+                                char('0' + ((uchar(c) >> 6) & 7)),
+                                char('0' + ((uchar(c) >> 3) & 7)),
+                                char('0' + (uchar(c) & 7)),
+                                '\0'};
+          result += octal;
+        }
+        else {
+          result += c;
+        }
+        break;
+    }
+  }
+  return result + "\"";
+}
+
+/** Array name and length fields of a table, the table is not written when empty. */
+static std::string table_ref(const std::string &name, int64_t len)
+{
+  return (len > 0) ? (name + ", " + std::to_string(len)) : "nullptr, 0";
+}
+
+template<typename T> static std::string enum_value(const char *type, T value)
+{
+  return std::string(type) + "(" + std::to_string(int64_t(value)) + ")";
+}
+
+static void flatten_resource(std::stringstream &ss,
+                             const ShaderCreateInfo::Resource &res,
+                             Frequency frequency)
+{
+  using Resource = ShaderCreateInfo::Resource;
+  ImageType image_type = ImageType(0);
+  eGPUTextureFormat format = eGPUTextureFormat(0);
+  Qualifier qualifiers = Qualifier(0);
+  StringRefNull type_name = "", name = "";
+  switch (res.bind_type) {
+    case Resource::UNIFORM_BUFFER:
+      type_name = res.uniformbuf.type_name;
+      name = res.uniformbuf.name;
+      break;
+    case Resource::STORAGE_BUFFER:
+      qualifiers = res.storagebuf.qualifiers;
+      type_name = res.storagebuf.type_name;
+      name = res.storagebuf.name;
+      break;
+    case Resource::SAMPLER:
+      image_type = res.sampler.type;
+      name = res.sampler.name;
+      break;
+    case Resource::IMAGE:
+      image_type = res.image.type;
+      format = res.image.format;
+      qualifiers = res.image.qualifiers;
+      name = res.image.name;
+      break;
+  }
+  ss << "    {" << enum_value("ShaderCreateInfo::Resource::BindType", res.bind_type) << ", "
+     << enum_value("Frequency", frequency) << ", " << res.slot << ", "
+     << enum_value("ImageType", image_type) << ", " << enum_value("eGPUTextureFormat", format)
+     << ", " << enum_value("Qualifier", qualifiers) << ", " << literal(type_name) << ", "
+     << literal(name) << "},\n";
+}
+
+static void flatten_interfaces(std::stringstream &ss,
+                               const std::string &prefix,
+                               Span<StageInterfaceInfo *> interfaces)
+{
+  for (const int64_t i : interfaces.index_range()) {
+    const StageInterfaceInfo &iface = *interfaces[i];
+    if (iface.inouts.is_empty()) {
+      continue;
+    }
+    ss << "static const FlatInOut " << prefix << i << "_inouts[] = {\n";
+    for (const StageInterfaceInfo::InOut &inout : iface.inouts) {
+      ss << "    {" << enum_value("Interpolation", inout.interp) << ", "
+         << enum_value("Type", inout.type) << ", " << literal(inout.name) << "},\n";
+    }
+    ss << "};\n";
+  }
+  if (interfaces.is_empty()) {
+    return;
+  }
+  ss << "static const FlatInterface " << prefix << "[] = {\n";
+  for (const int64_t i : interfaces.index_range()) {
+    const StageInterfaceInfo &iface = *interfaces[i];
+    ss << "    {" << literal(iface.name) << ", " << literal(iface.instance_name) << ", "
+       << table_ref(prefix + std::to_string(i) + "_inouts", iface.inouts.size()) << "},\n";
+  }
+  ss << "};\n";
+}
+
+static void flatten_info(std::stringstream &ss, const ShaderCreateInfo &info, int64_t index)
+{
+  const std::string prefix = "info" + std::to_string(index);
+
+  if (!info.vertex_inputs_.is_empty()) {
+    ss << "static const FlatVertIn " << prefix << "_vertex_inputs[] = {\n";
+    for (const ShaderCreateInfo::VertIn &input : info.vertex_inputs_) {
+      ss << "    {" << input.index << ", " << enum_value("Type", input.type) << ", "
+         << literal(input.name) << "},\n";
+    }
+    ss << "};\n";
+  }
+  if (!info.fragment_outputs_.is_empty()) {
+    ss << "static const FlatFragOut " << prefix << "_fragment_outputs[] = {\n";
+    for (const ShaderCreateInfo::FragOut &output : info.fragment_outputs_) {
+      ss << "    {" << output.index << ", " << enum_value("Type", output.type) << ", "
+         << enum_value("DualBlend", output.blend) << ", " << literal(output.name) << "},\n";
+    }
+    ss << "};\n";
+  }
+  const int64_t resources_len = info.pass_resources_.size() + info.batch_resources_.size();
+  if (resources_len > 0) {
+    ss << "static const FlatResource " << prefix << "_resources[] = {\n";
+    for (const ShaderCreateInfo::Resource &res : info.pass_resources_) {
+      flatten_resource(ss, res, Frequency::PASS);
+    }
+    for (const ShaderCreateInfo::Resource &res : info.batch_resources_) {
+      flatten_resource(ss, res, Frequency::BATCH);
+    }
+    ss << "};\n";
+  }
+  flatten_interfaces(ss, prefix + "_vertex_out", info.vertex_out_interfaces_);
+  flatten_interfaces(ss, prefix + "_geometry_out", info.geometry_out_interfaces_);
+  if (!info.push_constants_.is_empty()) {
+    ss << "static const FlatPushConst " << prefix << "_push_constants[] = {\n";
+    for (const ShaderCreateInfo::PushConst &push_constant : info.push_constants_) {
+      ss << "    {" << enum_value("Type", push_constant.type) << ", "
+         << literal(push_constant.name) << ", " << push_constant.array_size << "},\n";
+    }
+    ss << "};\n";
+  }
+  if (!info.typedef_sources_.is_empty()) {
+    ss << "static const char *const " << prefix << "_typedef_sources[] = {\n";
+    for (const StringRefNull &name : info.typedef_sources_) {
+      ss << "    " << literal(name) << ",\n";
+    }
+    ss << "};\n";
+  }
+  if (!info.defines_.is_empty()) {
+    ss << "static const FlatDefine " << prefix << "_defines[] = {\n";
+    for (const std::array<StringRefNull, 2> &define : info.defines_) {
+      ss << "    {" << literal(define[0]) << ", " << literal(define[1]) << "},\n";
+    }
+    ss << "};\n";
+  }
+  ss << "\n";
+}
+
+static void flatten_info_entry(std::stringstream &ss, const ShaderCreateInfo &info, int64_t index)
+{
+  const std::string prefix = "info" + std::to_string(index);
+  const int64_t resources_len = info.pass_resources_.size() + info.batch_resources_.size();
+  ss << "    {" << literal(info.name_) << ",\n";
+  ss << "     " << info.do_static_compilation_ << ", " << info.auto_resource_location_ << ", "
+     << info.early_fragment_test_ << ", " << info.legacy_resource_location_ << ", "
+     << enum_value("DepthWrite", info.depth_write_) << ", "
+     << enum_value("BuiltinBits", info.builtins_) << ", " << info.interface_names_size_ << ",\n";
+  ss << "     " << literal(info.vertex_source_) << ", " << literal(info.geometry_source_) << ", "
+     << literal(info.fragment_source_) << ", " << literal(info.compute_source_) << ",\n";
+  /* The layout is left uninitialized when there is no geometry stage. */
+  ShaderCreateInfo::GeometryStageLayout geometry_layout = {
+      PrimitiveIn::POINTS, -1, PrimitiveOut::POINTS, -1};
+  if (!info.geometry_source_.is_empty()) {
+    geometry_layout = info.geometry_layout_;
+  }
+  ss << "     " << enum_value("PrimitiveIn", geometry_layout.primitive_in) << ", "
+     << enum_value("PrimitiveOut", geometry_layout.primitive_out) << ", "
+     << geometry_layout.max_vertices << ", " << geometry_layout.invocations << ", {"
+     << info.compute_layout_.local_size_x << ", " << info.compute_layout_.local_size_y
+     << ", " << info.compute_layout_.local_size_z << "},\n";
+  ss << "     " << table_ref(prefix + "_vertex_inputs", info.vertex_inputs_.size()) << ", "
+     << table_ref(prefix + "_fragment_outputs", info.fragment_outputs_.size()) << ", "
+     << table_ref(prefix + "_resources", resources_len) << ",\n";
+  ss << "     " << table_ref(prefix + "_vertex_out", info.vertex_out_interfaces_.size()) << ", "
+     << table_ref(prefix + "_geometry_out", info.geometry_out_interfaces_.size()) << ", "
+     << table_ref(prefix + "_push_constants", info.push_constants_.size()) << ",\n";
+  ss << "     " << table_ref(prefix + "_typedef_sources", info.typedef_sources_.size()) << ", "
+     << table_ref(prefix + "_defines", info.defines_.size()) << "},\n";
+}
+
+bool shader_create_info_flatten(Span<const ShaderCreateInfo *> infos,
+                                std::string &r_source,
+                                std::string &r_error)
+{
+  r_error.clear();
+  for (const ShaderCreateInfo *info : infos) {
+    LIB_assert_msg(info->finalized_, "Create infos must be finalized before flattening");
+    /* Generated sources are only used by materials, which are created at runtime. */
+    LIB_assert(info->vertex_source_generated.empty() && info->typedef_source_generated.empty());
+    const std::string error = info->check_error();
+    if (!error.empty()) {
+      r_error += std::string(info->name_) + ": " + error + "\n";
+    }
+  }
+  if (!r_error.empty()) {
+    return false;
+  }
+
+  std::stringstream ss;
+  ss << "/* Generated by shader_create_info_flatten, do not edit. */\n\n";
+  ss << "#include \"gpu_shader_create_info_flat.hh\"\n\n";
+  ss << "namespace dust::gpu::shader {\n\n";
+  for (const int64_t i : infos.index_range()) {
+    flatten_info(ss, *infos[i], i);
+  }
+  ss << "const FlatShaderCreateInfo flat_create_infos[] = {\n";
+  for (const int64_t i : infos.index_range()) {
+    flatten_info_entry(ss, *infos[i], i);
+  }
+  if (infos.is_empty()) {
+    /* Arrays can't be empty. */
+    ss << "    {nullptr},\n";
+  }
+  ss << "};\n";
+  ss << "const int flat_create_infos_len = " << infos.size() << ";\n\n";
+  ss << "}  // namespace dust::gpu::shader\n";
+  r_source = ss.str();
+  return true;
+}
+
+/* -------------------------------------------------------------------- */
+/* Unflattening */
+
+static void unflatten_interfaces(const FlatInterface *flat_interfaces,
+                                 int interfaces_len,
+                                 Vector<StageInterfaceInfo *> &r_info_interfaces,
+                                 Vector<StageInterfaceInfo *> &r_interfaces)
+{
+  for (int i = 0; i < interfaces_len; i++) {
+    const FlatInterface &flat = flat_interfaces[i];
+    StageInterfaceInfo *iface = new StageInterfaceInfo(flat.name, flat.instance_name);
+    for (int j = 0; j < flat.inouts_len; j++) {
+      iface->inouts.append({flat.inouts[j].interp, flat.inouts[j].type, flat.inouts[j].name});
+    }
+    r_info_interfaces.append(iface);
+    r_interfaces.append(iface);
+  }
+}
+
+ShaderCreateInfo *shader_create_info_unflatten(const FlatShaderCreateInfo &flat,
+                                               Vector<StageInterfaceInfo *> &r_interfaces)
+{
+  using Resource = ShaderCreateInfo::Resource;
+
+  ShaderCreateInfo *info = new ShaderCreateInfo(flat.name);
+  /* The additional infos were merged and the result validated when the tables were built. */
+  info->finalized_ = true;
+  info->do_static_compilation_ = flat.do_static_compilation;
+  info->auto_resource_location_ = flat.auto_resource_location;
+  info->early_fragment_test_ = flat.early_fragment_test;
+  info->legacy_resource_location_ = flat.legacy_resource_location;
+  info->depth_write_ = flat.depth_write;
+  info->builtins_ = flat.builtins;
+  info->interface_names_size_ = flat.interface_names_size;
+
+  info->vertex_source_ = flat.vertex_source;
+  info->geometry_source_ = flat.geometry_source;
+  info->fragment_source_ = flat.fragment_source;
+  info->compute_source_ = flat.compute_source;
+
+  info->geometry_layout_.primitive_in = flat.geometry_primitive_in;
+  info->geometry_layout_.primitive_out = flat.geometry_primitive_out;
+  info->geometry_layout_.max_vertices = flat.geometry_max_vertices;
+  info->geometry_layout_.invocations = flat.geometry_invocations;
+  info->compute_layout_.local_size_x = flat.local_size[0];
+  info->compute_layout_.local_size_y = flat.local_size[1];
+  info->compute_layout_.local_size_z = flat.local_size[2];
+
+  info->vertex_inputs_.reserve(flat.vertex_inputs_len);
+  for (int i = 0; i < flat.vertex_inputs_len; i++) {
+    const FlatVertIn &input = flat.vertex_inputs[i];
+    info->vertex_inputs_.append({input.index, input.type, input.name});
+  }
+  info->fragment_outputs_.reserve(flat.fragment_outputs_len);
+  for (int i = 0; i < flat.fragment_outputs_len; i++) {
+    const FlatFragOut &output = flat.fragment_outputs[i];
+    info->fragment_outputs_.append({output.index, output.type, output.blend, output.name});
+  }
+  for (int i = 0; i < flat.resources_len; i++) {
+    const FlatResource &flat_res = flat.resources[i];
+    Resource res(flat_res.bind_type, flat_res.slot);
+    switch (flat_res.bind_type) {
+      case Resource::UNIFORM_BUFFER:
+        res.uniformbuf.type_name = flat_res.type_name;
+        res.uniformbuf.name = flat_res.name;
+        break;
+      case Resource::STORAGE_BUFFER:
+        res.storagebuf.qualifiers = flat_res.qualifiers;
+        res.storagebuf.type_name = flat_res.type_name;
+        res.storagebuf.name = flat_res.name;
+        break;
+      case Resource::SAMPLER:
+        res.sampler.type = flat_res.image_type;
+        res.sampler.name = flat_res.name;
+        break;
+      case Resource::IMAGE:
+        res.image.format = flat_res.format;
+        res.image.qualifiers = flat_res.qualifiers;
+        res.image.type = flat_res.image_type;
+        res.image.name = flat_res.name;
+        break;
+    }
+    ((flat_res.frequency == Frequency::PASS) ? info->pass_resources_ : info->batch_resources_)
+        .append(res);
+  }
+  unflatten_interfaces(flat.vertex_out_interfaces,
+                       flat.vertex_out_interfaces_len,
+                       info->vertex_out_interfaces_,
+                       r_interfaces);
+  unflatten_interfaces(flat.geometry_out_interfaces,
+                       flat.geometry_out_interfaces_len,
+                       info->geometry_out_interfaces_,
+                       r_interfaces);
+  info->push_constants_.reserve(flat.push_constants_len);
+  for (int i = 0; i < flat.push_constants_len; i++) {
+    const FlatPushConst &push_constant = flat.push_constants[i];
+    info->push_constants_.append(
+        {push_constant.type, push_constant.name, push_constant.array_size});
+  }
+  info->typedef_sources_.reserve(flat.typedef_sources_len);
+  for (int i = 0; i < flat.typedef_sources_len; i++) {
+    info->typedef_sources_.append(flat.typedef_sources[i]);
+  }
+  info->defines_.reserve(flat.defines_len);
+  for (int i = 0; i < flat.defines_len; i++) {
+    info->defines_.append({flat.defines[i].name, flat.defines[i].value});
+  }
+  return info;
+}
+
+}  // namespace dust::gpu::shader
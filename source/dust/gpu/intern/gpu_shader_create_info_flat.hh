@@ -0,0 +1,128 @@
+/*
+ * Flat constant tables of finalized #ShaderCreateInfo.
+ *
+ * A build step (tools/shader_create_info_flatten.cc) finalizes every create info, merging its
+ * additional infos, validates it and writes it as the tables below with
+ * #shader_create_info_flatten. The generated file is compiled into the binary, and the registry
+ * rebuilds the infos from it at startup without merging or validating anything.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "LIB_span.hh"
+#include "LIB_vector.hh"
+
+#include "gpu_shader_create_info.hh"
+
+namespace dust::gpu::shader {
+
+struct FlatVertIn {
+  int index;
+  Type type;
+  const char *name;
+};
+
+struct FlatFragOut {
+  int index;
+  Type type;
+  DualBlend blend;
+  const char *name;
+};
+
+/** Union of the fields of all the resource types, the unused ones are zero. */
+struct FlatResource {
+  ShaderCreateInfo::Resource::BindType bind_type;
+  Frequency frequency;
+  int slot;
+  ImageType image_type;
+  eGPUTextureFormat format;
+  Qualifier qualifiers;
+  const char *type_name;
+  const char *name;
+};
+
+struct FlatInOut {
+  Interpolation interp;
+  Type type;
+  const char *name;
+};
+
+struct FlatInterface {
+  const char *name;
+  const char *instance_name;
+  const FlatInOut *inouts;
+  int inouts_len;
+};
+
+struct FlatPushConst {
+  Type type;
+  const char *name;
+  int array_size;
+};
+
+struct FlatDefine {
+  const char *name;
+  const char *value;
+};
+
+struct FlatShaderCreateInfo {
+  const char *name;
+  bool do_static_compilation;
+  bool auto_resource_location;
+  bool early_fragment_test;
+  bool legacy_resource_location;
+  DepthWrite depth_write;
+  BuiltinBits builtins;
+  size_t interface_names_size;
+
+  const char *vertex_source;
+  const char *geometry_source;
+  const char *fragment_source;
+  const char *compute_source;
+
+  PrimitiveIn geometry_primitive_in;
+  PrimitiveOut geometry_primitive_out;
+  int geometry_max_vertices;
+  int geometry_invocations;
+  int local_size[3];
+
+  const FlatVertIn *vertex_inputs;
+  int vertex_inputs_len;
+  const FlatFragOut *fragment_outputs;
+  int fragment_outputs_len;
+  const FlatResource *resources;
+  int resources_len;
+  const FlatInterface *vertex_out_interfaces;
+  int vertex_out_interfaces_len;
+  const FlatInterface *geometry_out_interfaces;
+  int geometry_out_interfaces_len;
+  const FlatPushConst *push_constants;
+  int push_constants_len;
+  const char *const *typedef_sources;
+  int typedef_sources_len;
+  const FlatDefine *defines;
+  int defines_len;
+};
+
+/** Defined by the generated file. */
+extern const FlatShaderCreateInfo flat_create_infos[];
+extern const int flat_create_infos_len;
+
+/**
+ * Write the C++ source defining #flat_create_infos for \a infos, which must be finalized.
+ * Return false and the errors of #ShaderCreateInfo::check_error if an info is invalid.
+ */
+bool shader_create_info_flatten(Span<const ShaderCreateInfo *> infos,
+                                std::string &r_source,
+                                std::string &r_error);
+
+/**
+ * Rebuild a finalized create info from its tables. Its interfaces are appended to
+ * \a r_interfaces, they have to be freed with the info.
+ */
+ShaderCreateInfo *shader_create_info_unflatten(const FlatShaderCreateInfo &flat,
+                                               Vector<StageInterfaceInfo *> &r_interfaces);
+
+}  // namespace dust::gpu::shader
@@ -0,0 +1,208 @@
+#include <random>
+
+#include "LIB_assert.h"
+
+#include "GPU_shader.h"
+
+#include "gpu_shader_input_table.hh"
+#include "gpu_shader_private.hh"
+
+namespace dust::gpu {
+
+using namespace shader;
+
+#define SHADER_INPUT_KEY_NONE UINT32_MAX
+
+/* -------------------------------------------------------------------- */
+/* Name Table */
+
+int ShaderNameTable::id_get(StringRef name)
+{
+  std::scoped_lock lock(mutex_);
+  std::string key = name;
+  const int *id = ids_.lookup_ptr(key);
+  if (id) {
+    return *id;
+  }
+  const int new_id = int(ids_.size());
+  /* Two bits of the keys of #ShaderInputTable are the input type. */
+  LIB_assert(new_id < (1 << 30));
+  ids_.add_new(std::move(key), new_id);
+  return new_id;
+}
+
+/* -------------------------------------------------------------------- */
+/* Input Table */
+
+void ShaderInputTable::build(const ShaderInterface &interface, const ShaderCreateInfo &info)
+{
+  using BindType = ShaderCreateInfo::Resource::BindType;
+
+  Vector<Slot> entries;
+  auto entry_add = [&](ShaderInputType type, const ShaderInput *input, StringRefNull name) {
+    if (input == nullptr) {
+      return;
+    }
+    const uint32_t key = key_get(type, ShaderNameTable::get().id_get(name));
+    for (const Slot &entry : entries) {
+      if (entry.key == key) {
+        return;
+      }
+    }
+    entries.append({key, input});
+  };
+
+  for (const ShaderCreateInfo::VertIn &attr : info.vertex_inputs_) {
+    entry_add(ShaderInputType::ATTRIBUTE, interface.attr_get(attr.name.c_str()), attr.name);
+  }
+  Vector<ShaderCreateInfo::Resource> all_resources;
+  all_resources.extend(info.pass_resources_);
+  all_resources.extend(info.batch_resources_);
+  for (const ShaderCreateInfo::Resource &res : all_resources) {
+    switch (res.bind_type) {
+      case BindType::UNIFORM_BUFFER:
+        entry_add(ShaderInputType::UNIFORM_BLOCK,
+                  interface.ubo_get(res.uniformbuf.name.c_str()),
+                  res.uniformbuf.name);
+        break;
+      case BindType::STORAGE_BUFFER:
+        entry_add(ShaderInputType::STORAGE_BUFFER,
+                  interface.ssbo_get(res.storagebuf.name.c_str()),
+                  res.storagebuf.name);
+        break;
+      case BindType::SAMPLER:
+        entry_add(ShaderInputType::UNIFORM,
+                  interface.uniform_get(res.sampler.name.c_str()),
+                  res.sampler.name);
+        break;
+      case BindType::IMAGE:
+        entry_add(ShaderInputType::UNIFORM,
+                  interface.uniform_get(res.image.name.c_str()),
+                  res.image.name);
+        break;
+    }
+  }
+  for (const ShaderCreateInfo::PushConst &uni : info.push_constants_) {
+    entry_add(ShaderInputType::UNIFORM, interface.uniform_get(uni.name.c_str()), uni.name);
+  }
+
+  slots_.clear();
+  if (entries.is_empty()) {
+    return;
+  }
+
+  /* Try a few multipliers at a load factor of one half at most, then grow the table. Keys are
+   * distinct, so a table of 2^32 slots always works: in practice a few tries are enough. The
+   * seed is fixed so that the tables are the same on every run. */
+  std::mt19937 rng(uint32_t(entries.size()));
+  uint32_t bits = 1;
+  while ((int64_t(1) << bits) < entries.size() * 2) {
+    bits++;
+  }
+  Vector<Slot> slots;
+  for (;; bits++) {
+    for (int attempt = 0; attempt < 64; attempt++) {
+      const uint32_t multiplier = uint32_t(rng()) | 1u;
+      const uint32_t shift = 32 - bits;
+      slots.clear();
+      slots.append_n_times({SHADER_INPUT_KEY_NONE, nullptr}, int64_t(1) << bits);
+
+      bool is_perfect = true;
+      for (const Slot &entry : entries) {
+        Slot &slot = slots[(entry.key * multiplier) >> shift];
+        if (slot.key != SHADER_INPUT_KEY_NONE) {
+          is_perfect = false;
+          break;
+        }
+        slot = entry;
+      }
+      if (is_perfect) {
+        slots_ = std::move(slots);
+        multiplier_ = multiplier;
+        shift_ = shift;
+        return;
+      }
+    }
+  }
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+static const ShaderInput *shader_input_get(GPUShader *shader, ShaderInputType type, int name_id)
+{
+  return unwrap(shader)->input_table.get(type, name_id);
+}
+
+int GPU_shader_name_id_get(const char *name)
+{
+  return ShaderNameTable::get().id_get(name);
+}
+
+int GPU_shader_get_uniform_by_id(GPUShader *shader, int name_id)
+{
+  const ShaderInput *uniform = shader_input_get(shader, ShaderInputType::UNIFORM, name_id);
+  return uniform ? uniform->location : -1;
+}
+
+int GPU_shader_get_uniform_block_binding_by_id(GPUShader *shader, int name_id)
+{
+  const ShaderInput *ubo = shader_input_get(shader, ShaderInputType::UNIFORM_BLOCK, name_id);
+  return ubo ? ubo->binding : -1;
+}
+
+int GPU_shader_get_ssbo_by_id(GPUShader *shader, int name_id)
+{
+  const ShaderInput *ssbo = shader_input_get(shader, ShaderInputType::STORAGE_BUFFER, name_id);
+  return ssbo ? ssbo->binding : -1;
+}
+
+int GPU_shader_get_texture_binding_by_id(GPUShader *shader, int name_id)
+{
+  const ShaderInput *tex = shader_input_get(shader, ShaderInputType::UNIFORM, name_id);
+  return tex ? tex->binding : -1;
+}
+
+int GPU_shader_get_attribute_by_id(GPUShader *shader, int name_id)
+{
+  const ShaderInput *attr = shader_input_get(shader, ShaderInputType::ATTRIBUTE, name_id);
+  return attr ? attr->location : -1;
+}
+
+void GPU_shader_uniform_vector_by_id(
+    GPUShader *shader, int name_id, int length, int arraysize, const float *value)
+{
+  const int location = GPU_shader_get_uniform_by_id(shader, name_id);
+  unwrap(shader)->uniform_float(location, length, arraysize, value);
+}
+
+void GPU_shader_uniform_vector_int_by_id(
+    GPUShader *shader, int name_id, int length, int arraysize, const int *value)
+{
+  const int location = GPU_shader_get_uniform_by_id(shader, name_id);
+  unwrap(shader)->uniform_int(location, length, arraysize, value);
+}
+
+void GPU_shader_uniform_1i_by_id(GPUShader *sh, int name_id, int value)
+{
+  GPU_shader_uniform_vector_int_by_id(sh, name_id, 1, 1, &value);
+}
+
+void GPU_shader_uniform_1f_by_id(GPUShader *sh, int name_id, float value)
+{
+  GPU_shader_uniform_vector_by_id(sh, name_id, 1, 1, &value);
+}
+
+void GPU_shader_uniform_4fv_by_id(GPUShader *sh, int name_id, const float data[4])
+{
+  GPU_shader_uniform_vector_by_id(sh, name_id, 4, 1, data);
+}
+
+void GPU_shader_uniform_mat4_by_id(GPUShader *sh, int name_id, const float data[4][4])
+{
+  GPU_shader_uniform_vector_by_id(sh, name_id, 16, 1, &data[0][0]);
+}
@@ -0,0 +1,87 @@
+/*
+ * Lookup of shader inputs by interned name.
+ *
+ * Looking an input up by name hashes and compares strings, which adds up when uniforms are set by
+ * name on every draw. Names are interned once into small integer ids shared by all shaders, and
+ * each shader has a perfect hash table from ids to its inputs, built by #Shader::finalize.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+
+#include "LIB_map.hh"
+#include "LIB_string_ref.hh"
+#include "LIB_vector.hh"
+
+#include "gpu_shader_create_info.hh"
+#include "gpu_shader_interface.hh"
+
+namespace dust::gpu {
+
+/** Interned names of all the shader inputs. Thread safe, shaders are finalized on workers. */
+class ShaderNameTable {
+ private:
+  std::mutex mutex_;
+  Map<std::string, int> ids_;
+
+ public:
+  static ShaderNameTable &get()
+  {
+    static ShaderNameTable table;
+    return table;
+  }
+
+  /** Id of \a name, added on the first call. Ids are dense and start at zero. */
+  int id_get(StringRef name);
+};
+
+enum class ShaderInputType : uint8_t {
+  ATTRIBUTE = 0,
+  UNIFORM,
+  UNIFORM_BLOCK,
+  STORAGE_BUFFER,
+};
+
+/**
+ * Inputs of one shader by name id. Keys are hashed by a multiplication and a shift, the
+ * multiplier is searched when building so that no two keys collide: a lookup reads one slot.
+ */
+class ShaderInputTable {
+ private:
+  struct Slot {
+    /** Name id and #ShaderInputType, #SHADER_INPUT_KEY_NONE if empty. */
+    uint32_t key;
+    const ShaderInput *input;
+  };
+
+  Vector<Slot> slots_;
+  uint32_t multiplier_ = 1;
+  uint32_t shift_ = 31;
+
+ public:
+  /**
+   * Add the inputs of \a info found in \a interface. The table must be rebuilt if the interface
+   * is, it points to its inputs.
+   */
+  void build(const ShaderInterface &interface, const shader::ShaderCreateInfo &info);
+
+  const ShaderInput *get(ShaderInputType type, int name_id) const
+  {
+    if (slots_.is_empty()) {
+      return nullptr;
+    }
+    const uint32_t key = key_get(type, name_id);
+    const Slot &slot = slots_[(key * multiplier_) >> shift_];
+    return (slot.key == key) ? slot.input : nullptr;
+  }
+
+ private:
+  static uint32_t key_get(ShaderInputType type, int name_id)
+  {
+    return (uint32_t(name_id) << 2) | uint32_t(type);
+  }
+};
+
+}  // namespace dust::gpu
@@ -2,9 +2,11 @@
 
 #include "LIB_span.hh"
 #include "LIB_string_ref.hh"
+#include "LIB_vector.hh"
 
 #include "GPU_shader.h"
 #include "gpu_shader_create_info.hh"
+#include "gpu_shader_input_table.hh"
 #include "gpu_shader_interface.hh"
 #include "gpu_vertex_buffer_private.hh"
 
@@ -23,6 +25,8 @@ class Shader {
  public:
   /** Uniform & attribute locations for shader. */
   ShaderInterface *interface = nullptr;
+  /** Inputs of #interface by name id, built with it. */
+  ShaderInputTable input_table;
 
  protected:
   /** For debugging purpose. */
@@ -38,6 +42,26 @@ class Shader {
   virtual void compute_shader_from_glsl(MutableSpan<const char *> sources) = 0;
   virtual bool finalize(const shader::ShaderCreateInfo *info = nullptr) = 0;
 
+  /**
+   * Program binary for the shader cache, of the driver format \a r_format.
+   * Return false if the back-end doesn't support program binaries.
+   */
+  virtual bool binary_get(Vector<uint8_t> & /*r_binary*/, uint32_t & /*r_format*/) const
+  {
+    return false;
+  }
+  /**
+   * Create the program from a binary given by #binary_get, replacing the compilation of the
+   * stages and #finalize. Return false if the driver refused it, the shader needs to be compiled
+   * then.
+   */
+  virtual bool binary_load(Span<uint8_t> /*binary*/,
+                           uint32_t /*format*/,
+                           const shader::ShaderCreateInfo * /*info*/)
+  {
+    return false;
+  }
+
   virtual void transform_feedback_names_set(Span<const char *> name_list,
                                             eGPUShaderTFBType geom_type) = 0;
   virtual bool transform_feedback_enable(GPUVertBuf *) = 0;
@@ -123,6 +123,8 @@ inline GPUStateMutable operator~(const GPUStateMutable &a)
   return r;
 }
 
+struct PipelineKey;
+
 /**
  * State manager keeping track of the draw state and applying it before drawing.
  * Base class which is then specialized for each implementation (GL, VK, ...).
@@ -150,7 +152,25 @@ class StateManager {
   virtual void image_unbind(Texture *tex) = 0;
   virtual void image_unbind_all() = 0;
 
+  /**
+   * What is bound to \a unit, null if nothing. Used by internal passes to restore the bindings
+   * of the caller.
+   */
+  virtual Texture *texture_bound_get(int unit, eGPUSamplerState *r_sampler) const = 0;
+  virtual Texture *image_bound_get(int unit) const = 0;
+
   virtual void texture_unpack_row_length_set(uint len) = 0;
+  virtual uint texture_unpack_row_length_get() const = 0;
+
+  /**
+   * Create the immutable pipeline object of \a key, for back-ends that need one.
+   * Only called by #PipelineCache, the pipelines are shared by all contexts.
+   */
+  virtual void *pipeline_create(const PipelineKey & /*key*/)
+  {
+    return nullptr;
+  }
+  virtual void pipeline_free(void * /*pipeline*/){};
 };
 
 }  // namespace gpu
@@ -1,3 +1,6 @@
+#include <climits>
+#include <cstring>
+
 #include "LIB_string.h"
 
 #include "GPU_framebuffer.h"
@@ -6,6 +9,10 @@
 #include "gpu_backend.hh"
 #include "gpu_context_private.hh"
 #include "gpu_framebuffer_private.hh"
+#include "gpu_memory_budget_private.hh"
+#include "gpu_readback_private.hh"
+#include "gpu_sampler_private.hh"
+#include "gpu_texture_convert.hh"
 
 #include "gpu_texture_private.hh"
 
@@ -30,6 +37,9 @@ Texture::Texture(const char *name)
 
 Texture::~Texture()
 {
+  if (memory_size != 0 || memory_evict_fn != nullptr) {
+    MemoryBudget::get().texture_remove(this);
+  }
   for (int i = 0; i < ARRAY_SIZE(fb_); i++) {
     if (fb_[i] != nullptr) {
       fb_[i]->attachment_remove(fb_attachment_[i]);
@@ -56,7 +66,11 @@ bool Texture::init_1D(int w, int layers, int mip_len, eGPUTextureFormat format)
   if ((format_flag_ & (GPU_FORMAT_DEPTH_STENCIL | GPU_FORMAT_INTEGER)) == 0) {
     sampler_state = GPU_SAMPLER_FILTER;
   }
-  return this->init_internal();
+  if (!this->init_internal()) {
+    return false;
+  }
+  MemoryBudget::get().texture_add(this);
+  return true;
 }
 
 bool Texture::init_2D(int w, int h, int layers, int mip_len, eGPUTextureFormat format)
@@ -72,7 +86,11 @@ bool Texture::init_2D(int w, int h, int layers, int mip_len, eGPUTextureFormat f
   if ((format_flag_ & (GPU_FORMAT_DEPTH_STENCIL | GPU_FORMAT_INTEGER)) == 0) {
     sampler_state = GPU_SAMPLER_FILTER;
   }
-  return this->init_internal();
+  if (!this->init_internal()) {
+    return false;
+  }
+  MemoryBudget::get().texture_add(this);
+  return true;
 }
 
 bool Texture::init_3D(int w, int h, int d, int mip_len, eGPUTextureFormat format)
@@ -88,7 +106,11 @@ bool Texture::init_3D(int w, int h, int d, int mip_len, eGPUTextureFormat format
   if ((format_flag_ & (GPU_FORMAT_DEPTH_STENCIL | GPU_FORMAT_INTEGER)) == 0) {
     sampler_state = GPU_SAMPLER_FILTER;
   }
-  return this->init_internal();
+  if (!this->init_internal()) {
+    return false;
+  }
+  MemoryBudget::get().texture_add(this);
+  return true;
 }
 
 bool Texture::init_cubemap(int w, int layers, int mip_len, eGPUTextureFormat format)
@@ -104,7 +126,11 @@ bool Texture::init_cubemap(int w, int layers, int mip_len, eGPUTextureFormat for
   if ((format_flag_ & (GPU_FORMAT_DEPTH_STENCIL | GPU_FORMAT_INTEGER)) == 0) {
     sampler_state = GPU_SAMPLER_FILTER;
   }
-  return this->init_internal();
+  if (!this->init_internal()) {
+    return false;
+  }
+  MemoryBudget::get().texture_add(this);
+  return true;
 }
 
 bool Texture::init_buffer(GPUVertBuf *vbo, eGPUTextureFormat format)
@@ -192,12 +218,69 @@ void Texture::detach_from(FrameBuffer *fb)
   LIB_assert_msg(0, "GPU: Error: Texture: Framebuffer is not attached");
 }
 
+bool Texture::data_format_is_native(eGPUDataFormat format) const
+{
+  return (format == to_data_format(format_)) || (format_flag_ & GPU_FORMAT_COMPRESSED);
+}
+
 void Texture::update(eGPUDataFormat format, const void *data)
 {
   int mip = 0;
   int extent[3], offset[3] = {0, 0, 0};
   this->mip_size_get(mip, extent);
-  this->update_sub(mip, offset, extent, format, data);
+  this->update_sub_converted(mip, offset, extent, format, data);
+}
+
+void Texture::update_sub_converted(
+    int mip, int offset[3], int extent[3], eGPUDataFormat format, const void *data)
+{
+  if (this->data_format_is_native(format)) {
+    this->update_sub(mip, offset, extent, format, data);
+    return;
+  }
+  /* Convert the whole rows, the unpack row length then applies to the converted data too. */
+  const uint row_length = Context::get()->state_manager->texture_unpack_row_length_get();
+  const int w = max_ii(1, extent[0]), h = max_ii(1, extent[1]), d = max_ii(1, extent[2]);
+  const size_t row_stride = (row_length > 0) ? size_t(row_length) : size_t(w);
+  const size_t texel_len = row_stride * (size_t(h) * d - 1) + w;
+  const eGPUDataFormat native_format = to_data_format(format_);
+  const int component_len = to_component_len(format_);
+  void *converted = MEM_mallocN(convert_buffer_size(native_format, component_len, texel_len),
+                                __func__);
+  convert_texels(data, format, converted, native_format, format_, component_len, texel_len);
+  this->update_sub(mip, offset, extent, native_format, converted);
+  MEM_freeN(converted);
+}
+
+void *Texture::read_converted(int mip, eGPUDataFormat format)
+{
+  if (this->data_format_is_native(format)) {
+    return this->read(mip, format);
+  }
+  const eGPUDataFormat native_format = to_data_format(format_);
+  const int component_len = to_component_len(format_);
+  int extent[3] = {1, 1, 1};
+  this->mip_size_get(mip, extent);
+  const size_t texel_len = size_t(extent[0]) * max_ii(1, extent[1]) * max_ii(1, extent[2]);
+  void *data = this->read(mip, native_format);
+  void *converted = MEM_mallocN(this->read_size_get(mip, format), __func__);
+  convert_texels(data, native_format, converted, format, format_, component_len, texel_len);
+  MEM_freeN(data);
+  return converted;
+}
+
+size_t Texture::read_size_get(int mip, eGPUDataFormat format) const
+{
+  int extent[3] = {1, 1, 1};
+  this->mip_size_get(mip, extent);
+  return size_t(extent[0]) * extent[1] * extent[2] * to_bytesize(format_, format);
+}
+
+void Texture::read_async(int mip, eGPUDataFormat format, StagingBuffer *dst)
+{
+  void *data = this->read_converted(mip, format);
+  memcpy(dst->host_data_get(), data, this->read_size_get(mip, format));
+  MEM_freeN(data);
 }
 
 }  // namespace engine::gpu
@@ -212,8 +295,7 @@ using namespace dust::gpu;
 
 uint GPU_texture_memory_usage_get()
 {
-  /* TODO(fclem): Do that inside the new Texture class. */
-  return 0;
+  return uint(min_zz(MemoryBudget::get().texture_memory_get(), UINT_MAX));
 }
 
 /* ------ Creation ------ */
@@ -423,7 +505,8 @@ void GPU_texture_update_mipmap(GPUTexture *tex_,
   Texture *tex = reinterpret_cast<Texture *>(tex_);
   int extent[3] = {1, 1, 1}, offset[3] = {0, 0, 0};
   tex->mip_size_get(miplvl, extent);
-  reinterpret_cast<Texture *>(tex)->update_sub(miplvl, offset, extent, data_format, pixels);
+  imm_flush_merged();
+  tex->update_sub_converted(miplvl, offset, extent, data_format, pixels);
 }
 
 void GPU_texture_update_sub(GPUTexture *tex,
@@ -438,23 +521,37 @@ void GPU_texture_update_sub(GPUTexture *tex,
 {
   int offset[3] = {offset_x, offset_y, offset_z};
   int extent[3] = {width, height, depth};
-  reinterpret_cast<Texture *>(tex)->update_sub(0, offset, extent, data_format, pixels);
+  imm_flush_merged();
+  reinterpret_cast<Texture *>(tex)->update_sub_converted(0, offset, extent, data_format, pixels);
 }
 
 void *GPU_texture_read(GPUTexture *tex_, eGPUDataFormat data_format, int miplvl)
 {
   Texture *tex = reinterpret_cast<Texture *>(tex_);
-  return tex->read(miplvl, data_format);
+  imm_flush_merged();
+  return tex->read_converted(miplvl, data_format);
+}
+
+GPUReadback *GPU_texture_read_async(GPUTexture *tex_, eGPUDataFormat data_format, int miplvl)
+{
+  Texture *tex = reinterpret_cast<Texture *>(tex_);
+  Readback *readback = ReadbackRing::get().acquire(tex->read_size_get(miplvl, data_format));
+  imm_flush_merged();
+  tex->read_async(miplvl, data_format, readback->buffer);
+  readback->buffer->fence_insert();
+  return wrap(readback);
 }
 
 void GPU_texture_clear(GPUTexture *tex, eGPUDataFormat data_format, const void *data)
 {
   LIB_assert(data != nullptr); /* Do not accept NULL as parameter. */
+  imm_flush_merged();
   reinterpret_cast<Texture *>(tex)->clear(data_format, data);
 }
 
 void GPU_texture_update(GPUTexture *tex, eGPUDataFormat data_format, const void *data)
 {
+  imm_flush_merged();
   reinterpret_cast<Texture *>(tex)->update(data_format, data);
 }
 
@@ -472,12 +569,14 @@ void GPU_texture_bind_ex(GPUTexture *tex_,
 {
   Texture *tex = reinterpret_cast<Texture *>(tex_);
   state = (state >= GPU_SAMPLER_MAX) ? tex->sampler_state : state;
+  tex->memory_last_use = MemoryBudget::get().frame_get();
   Context::get()->state_manager->texture_bind(tex, state, unit);
 }
 
 void GPU_texture_bind(GPUTexture *tex_, int unit)
 {
   Texture *tex = reinterpret_cast<Texture *>(tex_);
+  tex->memory_last_use = MemoryBudget::get().frame_get();
   Context::get()->state_manager->texture_bind(tex, tex->sampler_state, unit);
 }
 
@@ -509,13 +608,16 @@ void GPU_texture_image_unbind_all()
 
 void GPU_texture_generate_mipmap(GPUTexture *tex)
 {
-  reinterpret_cast<Texture *>(tex)->generate_mipmap();
+  imm_flush_merged();
+  /* Same box filter, in a single dispatch when supported. Falls back to #generate_mipmap. */
+  GPU_texture_downsample(tex, reinterpret_cast<Texture *>(tex)->mip_count() - 1);
 }
 
 void GPU_texture_copy(GPUTexture *dst_, GPUTexture *src_)
 {
   Texture *src = reinterpret_cast<Texture *>(src_);
   Texture *dst = reinterpret_cast<Texture *>(dst_);
+  imm_flush_merged();
   src->copy_to(dst);
 }
 
@@ -818,7 +920,11 @@ void GPU_texture_get_mipmap_size(GPUTexture *tex, int lvl, int *r_size)
 void GPU_samplers_update()
 {
   /* Backend may not exist when we are updating preferences from background mode. */
-  GPUBackend *backend = GPUBackend::get();
+  GPUBackend *backend = GPUBackend::get_if_created();
+  /* The table is only rebuilt when its anisotropy changed. The back-ends read the other
+   * preferences (mipmapping, anisotropy set through the preferences) themselves, so they are
+   * always updated. */
+  SamplerTable::get().update();
   if (backend) {
     backend->samplers_update();
   }
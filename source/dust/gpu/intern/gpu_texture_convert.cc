@@ -0,0 +1,500 @@
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+#if defined(__F16C__) || defined(__AVX2__)
+#  include <immintrin.h>
+#endif
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+
+#include "gpu_texture_convert.hh"
+#include "gpu_texture_private.hh"
+
+namespace dust::gpu {
+
+/* Number of texels converted at once when going through an intermediate buffer.
+ * Keeps the intermediate buffer (4 components per texel) on the stack and in the L1 cache. */
+#define CONVERT_CHUNK_TEXEL_LEN 256
+
+/* -------------------------------------------------------------------- */
+/* Scalar Helpers */
+
+static inline float uint_as_float(uint32_t i)
+{
+  float f;
+  memcpy(&f, &i, sizeof(f));
+  return f;
+}
+
+static inline uint32_t float_as_uint(float f)
+{
+  uint32_t i;
+  memcpy(&i, &f, sizeof(i));
+  return i;
+}
+
+/** Round to nearest even, overflow to infinity, NaN stays NaN. */
+static inline uint16_t float_to_half(float value)
+{
+  const uint32_t bits = float_as_uint(value);
+  const uint16_t sign = uint16_t((bits >> 16) & 0x8000u);
+  uint32_t abs = bits & 0x7FFFFFFFu;
+  if (abs >= 0x7F800000u) {
+    return sign | ((abs > 0x7F800000u) ? 0x7E00u : 0x7C00u);
+  }
+  if (abs >= 0x477FF000u) {
+    /* Values that round above the largest half (65504). */
+    return sign | 0x7C00u;
+  }
+  if (abs < 0x38800000u) {
+    /* Result is a half sub-normal: the float math does the rounding. */
+    return sign | uint16_t(lrintf(uint_as_float(abs) * 16777216.0f));
+  }
+  /* Re-bias the exponent and round the mantissa to 10 bits, ties to even. */
+  abs += 0xC8000FFFu + ((abs >> 13) & 1u);
+  return sign | uint16_t(abs >> 13);
+}
+
+static inline float half_to_float(uint16_t value)
+{
+  const uint32_t sign = uint32_t(value & 0x8000u) << 16;
+  const uint32_t exponent = (value >> 10) & 0x1Fu;
+  const uint32_t mantissa = value & 0x3FFu;
+  if (exponent == 0) {
+    const float f = float(mantissa) * (1.0f / 16777216.0f);
+    return sign ? -f : f;
+  }
+  if (exponent == 31) {
+    return uint_as_float(sign | 0x7F800000u | (mantissa << 13));
+  }
+  return uint_as_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+/** Clamp to [0..1], NaN gives 0 like `max(v, 0)` in the vector kernels. */
+static inline float unorm_clamp(float value)
+{
+  return (value > 0.0f) ? min_ff(value, 1.0f) : 0.0f;
+}
+
+static inline uchar float_to_unorm8(float value)
+{
+  return uchar(unorm_clamp(value) * 255.0f + 0.5f);
+}
+
+/** Saturate out of range values instead of the undefined float to integer cast, NaN gives 0. */
+static inline uint32_t float_to_uint32(float value)
+{
+  if (!(value > 0.0f)) {
+    return 0;
+  }
+  return (value >= 4294967296.0f) ? 0xFFFFFFFFu : uint32_t(value);
+}
+
+static inline int32_t float_to_int32(float value)
+{
+  if (std::isnan(value)) {
+    return 0;
+  }
+  if (value >= 2147483648.0f) {
+    return INT32_MAX;
+  }
+  return (value <= -2147483648.0f) ? INT32_MIN : int32_t(value);
+}
+
+/** Unsigned float with 5 bits exponent and no sign bit, as used by `R11F_G11F_B10F`. */
+static float small_float_to_float(uint32_t bits, int mantissa_bits)
+{
+  const uint32_t exponent = bits >> mantissa_bits;
+  const uint32_t mantissa = bits & ((1u << mantissa_bits) - 1);
+  const float mantissa_max = float(1u << mantissa_bits);
+  if (exponent == 0) {
+    return ldexpf(float(mantissa) / mantissa_max, -14);
+  }
+  if (exponent == 31) {
+    return (mantissa == 0) ? INFINITY : NAN;
+  }
+  return ldexpf(1.0f + float(mantissa) / mantissa_max, int(exponent) - 15);
+}
+
+static uint32_t float_to_small_float(float value, int mantissa_bits)
+{
+  const uint32_t mantissa_max = 1u << mantissa_bits;
+  const uint32_t largest = (30u << mantissa_bits) | (mantissa_max - 1);
+  if (!(value > 0.0f)) {
+    /* Negative and NaN. */
+    return 0;
+  }
+  if (value == INFINITY) {
+    return 31u << mantissa_bits;
+  }
+  int exp;
+  const float m = frexpf(value, &exp);
+  int exponent = exp - 1 + 15;
+  if (exponent <= 0) {
+    return min_uu(uint32_t(ldexpf(value, 14) * float(mantissa_max) + 0.5f), mantissa_max - 1);
+  }
+  uint32_t mantissa = uint32_t((m * 2.0f - 1.0f) * float(mantissa_max) + 0.5f);
+  if (mantissa == mantissa_max) {
+    mantissa = 0;
+    exponent++;
+  }
+  if (exponent >= 31) {
+    return largest;
+  }
+  return (uint32_t(exponent) << mantissa_bits) | mantissa;
+}
+
+/* -------------------------------------------------------------------- */
+/* Vectorized Kernels */
+
+void convert_float_to_half(const float *src, uint16_t *dst, size_t len)
+{
+  size_t i = 0;
+#if defined(__F16C__)
+  for (; i + 8 <= len; i += 8) {
+    const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), half);
+  }
+#endif
+  for (; i < len; i++) {
+    dst[i] = float_to_half(src[i]);
+  }
+}
+
+void convert_half_to_float(const uint16_t *src, float *dst, size_t len)
+{
+  size_t i = 0;
+#if defined(__F16C__)
+  for (; i + 8 <= len; i += 8) {
+    const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(half));
+  }
+#endif
+  for (; i < len; i++) {
+    dst[i] = half_to_float(src[i]);
+  }
+}
+
+void convert_float_to_unorm8(const float *src, uchar *dst, size_t len)
+{
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(255.0f);
+  const __m128 bias = _mm_set1_ps(0.5f);
+  for (; i + 16 <= len; i += 16) {
+    __m128i quantized[4];
+    for (int j = 0; j < 4; j++) {
+      /* `max(v, 0)` also turns NaN into zero. */
+      __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + j * 4), zero), one);
+      quantized[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), bias));
+    }
+    const __m128i lo = _mm_packs_epi32(quantized[0], quantized[1]);
+    const __m128i hi = _mm_packs_epi32(quantized[2], quantized[3]);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < len; i++) {
+    dst[i] = float_to_unorm8(src[i]);
+  }
+}
+
+void convert_unorm8_to_float(const uchar *src, float *dst, size_t len)
+{
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256 scale_avx = _mm256_set1_ps(1.0f / 255.0f);
+  for (; i + 8 <= len; i += 8) {
+    const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i));
+    const __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    _mm256_storeu_ps(dst + i, _mm256_mul_ps(v, scale_avx));
+  }
+#elif defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+  for (; i + 16 <= len; i += 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    const __m128i words[2] = {_mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero)};
+    for (int j = 0; j < 2; j++) {
+      const __m128i lo = _mm_unpacklo_epi16(words[j], zero);
+      const __m128i hi = _mm_unpackhi_epi16(words[j], zero);
+      _mm_storeu_ps(dst + i + j * 8, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+      _mm_storeu_ps(dst + i + j * 8 + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+  }
+#endif
+  for (; i < len; i++) {
+    dst[i] = float(src[i]) * (1.0f / 255.0f);
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Generic Conversion */
+
+static bool data_format_is_packed(eGPUDataFormat format)
+{
+  return ELEM(format, GPU_DATA_UINT_24_8, GPU_DATA_10_11_11_REV, GPU_DATA_2_10_10_10_REV);
+}
+
+static int packed_component_len(eGPUDataFormat format)
+{
+  switch (format) {
+    case GPU_DATA_UINT_24_8:
+      return 1;
+    case GPU_DATA_10_11_11_REV:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+size_t convert_buffer_size(eGPUDataFormat format, int component_len, size_t texel_len)
+{
+  if (data_format_is_packed(format)) {
+    return sizeof(uint32_t) * texel_len;
+  }
+  return to_bytesize(format) * component_len * texel_len;
+}
+
+/** Decode \a texel_len texels of a non integer texture to floats. */
+static void to_float(const void *src,
+                     eGPUDataFormat format,
+                     bool is_depth,
+                     int component_len,
+                     size_t texel_len,
+                     float *dst)
+{
+  const size_t value_len = texel_len * component_len;
+  const uint32_t *src_ui = static_cast<const uint32_t *>(src);
+  switch (format) {
+    case GPU_DATA_FLOAT:
+      memcpy(dst, src, sizeof(float) * value_len);
+      break;
+    case GPU_DATA_HALF_FLOAT:
+      convert_half_to_float(static_cast<const uint16_t *>(src), dst, value_len);
+      break;
+    case GPU_DATA_UBYTE:
+      convert_unorm8_to_float(static_cast<const uchar *>(src), dst, value_len);
+      break;
+    case GPU_DATA_UINT:
+      for (size_t i = 0; i < value_len; i++) {
+        /* Unsigned integer depth is normalized, like OpenGL does. */
+        dst[i] = is_depth ? float(double(src_ui[i]) / double(0xFFFFFFFFu)) : float(src_ui[i]);
+      }
+      break;
+    case GPU_DATA_INT:
+      for (size_t i = 0; i < value_len; i++) {
+        dst[i] = float(static_cast<const int32_t *>(src)[i]);
+      }
+      break;
+    case GPU_DATA_UINT_24_8:
+      for (size_t i = 0; i < texel_len; i++) {
+        dst[i] = float(src_ui[i] >> 8) * (1.0f / float(0xFFFFFF));
+      }
+      break;
+    case GPU_DATA_10_11_11_REV:
+      for (size_t i = 0; i < texel_len; i++) {
+        const uint32_t v = src_ui[i];
+        dst[i * 3 + 0] = small_float_to_float(v & 0x7FF, 6);
+        dst[i * 3 + 1] = small_float_to_float((v >> 11) & 0x7FF, 6);
+        dst[i * 3 + 2] = small_float_to_float(v >> 22, 5);
+      }
+      break;
+    case GPU_DATA_2_10_10_10_REV:
+      for (size_t i = 0; i < texel_len; i++) {
+        const uint32_t v = src_ui[i];
+        dst[i * 4 + 0] = float(v & 0x3FF) / 1023.0f;
+        dst[i * 4 + 1] = float((v >> 10) & 0x3FF) / 1023.0f;
+        dst[i * 4 + 2] = float((v >> 20) & 0x3FF) / 1023.0f;
+        dst[i * 4 + 3] = float(v >> 30) / 3.0f;
+      }
+      break;
+  }
+}
+
+/** Encode \a texel_len texels of a non integer texture from floats. */
+static void from_float(const float *src,
+                       eGPUDataFormat format,
+                       bool is_depth,
+                       int component_len,
+                       size_t texel_len,
+                       void *dst)
+{
+  const size_t value_len = texel_len * component_len;
+  uint32_t *dst_ui = static_cast<uint32_t *>(dst);
+  switch (format) {
+    case GPU_DATA_FLOAT:
+      memcpy(dst, src, sizeof(float) * value_len);
+      break;
+    case GPU_DATA_HALF_FLOAT:
+      convert_float_to_half(src, static_cast<uint16_t *>(dst), value_len);
+      break;
+    case GPU_DATA_UBYTE:
+      convert_float_to_unorm8(src, static_cast<uchar *>(dst), value_len);
+      break;
+    case GPU_DATA_UINT:
+      for (size_t i = 0; i < value_len; i++) {
+        dst_ui[i] = is_depth ? uint32_t(double(unorm_clamp(src[i])) * double(0xFFFFFFFFu)) :
+                               float_to_uint32(src[i]);
+      }
+      break;
+    case GPU_DATA_INT:
+      for (size_t i = 0; i < value_len; i++) {
+        static_cast<int32_t *>(dst)[i] = float_to_int32(src[i]);
+      }
+      break;
+    case GPU_DATA_UINT_24_8:
+      for (size_t i = 0; i < texel_len; i++) {
+        dst_ui[i] = uint32_t(unorm_clamp(src[i]) * float(0xFFFFFF)) << 8;
+      }
+      break;
+    case GPU_DATA_10_11_11_REV:
+      for (size_t i = 0; i < texel_len; i++) {
+        dst_ui[i] = float_to_small_float(src[i * 3 + 0], 6) |
+                    (float_to_small_float(src[i * 3 + 1], 6) << 11) |
+                    (float_to_small_float(src[i * 3 + 2], 5) << 22);
+      }
+      break;
+    case GPU_DATA_2_10_10_10_REV:
+      for (size_t i = 0; i < texel_len; i++) {
+        const uint32_t r = uint32_t(unorm_clamp(src[i * 4 + 0]) * 1023.0f + 0.5f);
+        const uint32_t g = uint32_t(unorm_clamp(src[i * 4 + 1]) * 1023.0f + 0.5f);
+        const uint32_t b = uint32_t(unorm_clamp(src[i * 4 + 2]) * 1023.0f + 0.5f);
+        const uint32_t a = uint32_t(unorm_clamp(src[i * 4 + 3]) * 3.0f + 0.5f);
+        dst_ui[i] = r | (g << 10) | (b << 20) | (a << 30);
+      }
+      break;
+  }
+}
+
+/** Decode \a value_len components of an integer texture. */
+static void to_int(const void *src, eGPUDataFormat format, size_t value_len, int64_t *dst)
+{
+  for (size_t i = 0; i < value_len; i++) {
+    switch (format) {
+      case GPU_DATA_UBYTE:
+        dst[i] = static_cast<const uchar *>(src)[i];
+        break;
+      case GPU_DATA_UINT:
+        dst[i] = static_cast<const uint32_t *>(src)[i];
+        break;
+      case GPU_DATA_INT:
+        dst[i] = static_cast<const int32_t *>(src)[i];
+        break;
+      case GPU_DATA_FLOAT:
+        dst[i] = int64_t(static_cast<const float *>(src)[i]);
+        break;
+      case GPU_DATA_HALF_FLOAT:
+        dst[i] = int64_t(half_to_float(static_cast<const uint16_t *>(src)[i]));
+        break;
+      default:
+        LIB_assert_msg(0, "Packed data formats are not supported by integer textures");
+        dst[i] = 0;
+        break;
+    }
+  }
+}
+
+/** Encode \a value_len components of an integer texture. Out of range values wrap. */
+static void from_int(const int64_t *src, eGPUDataFormat format, size_t value_len, void *dst)
+{
+  for (size_t i = 0; i < value_len; i++) {
+    switch (format) {
+      case GPU_DATA_UBYTE:
+        static_cast<uchar *>(dst)[i] = uchar(src[i]);
+        break;
+      case GPU_DATA_UINT:
+        static_cast<uint32_t *>(dst)[i] = uint32_t(src[i]);
+        break;
+      case GPU_DATA_INT:
+        static_cast<int32_t *>(dst)[i] = float_to_int32(src[i]);
+        break;
+      case GPU_DATA_FLOAT:
+        static_cast<float *>(dst)[i] = float(src[i]);
+        break;
+      case GPU_DATA_HALF_FLOAT:
+        static_cast<uint16_t *>(dst)[i] = float_to_half(float(src[i]));
+        break;
+      default:
+        LIB_assert_msg(0, "Packed data formats are not supported by integer textures");
+        break;
+    }
+  }
+}
+
+void convert_texels(const void *src,
+                    eGPUDataFormat src_format,
+                    void *dst,
+                    eGPUDataFormat dst_format,
+                    eGPUTextureFormat tex_format,
+                    int component_len,
+                    size_t texel_len)
+{
+  LIB_assert(!data_format_is_packed(src_format) ||
+             packed_component_len(src_format) == component_len);
+  LIB_assert(!data_format_is_packed(dst_format) ||
+             packed_component_len(dst_format) == component_len);
+  LIB_assert(component_len <= 4);
+
+  if (src_format == dst_format) {
+    memcpy(dst, src, convert_buffer_size(src_format, component_len, texel_len));
+    return;
+  }
+
+  const eGPUTextureFormatFlag tex_flag = to_format_flag(tex_format);
+  const bool is_integer = (tex_flag & GPU_FORMAT_INTEGER) != 0;
+  const bool is_depth = (tex_flag & GPU_FORMAT_DEPTH) != 0;
+
+  if (!is_integer) {
+    /* Single pass kernels. */
+    const size_t value_len = texel_len * component_len;
+    if (src_format == GPU_DATA_FLOAT && dst_format == GPU_DATA_HALF_FLOAT) {
+      convert_float_to_half(
+          static_cast<const float *>(src), static_cast<uint16_t *>(dst), value_len);
+      return;
+    }
+    if (src_format == GPU_DATA_HALF_FLOAT && dst_format == GPU_DATA_FLOAT) {
+      convert_half_to_float(
+          static_cast<const uint16_t *>(src), static_cast<float *>(dst), value_len);
+      return;
+    }
+    if (src_format == GPU_DATA_FLOAT && dst_format == GPU_DATA_UBYTE) {
+      convert_float_to_unorm8(static_cast<const float *>(src), static_cast<uchar *>(dst), value_len);
+      return;
+    }
+    if (src_format == GPU_DATA_UBYTE && dst_format == GPU_DATA_FLOAT) {
+      convert_unorm8_to_float(static_cast<const uchar *>(src), static_cast<float *>(dst), value_len);
+      return;
+    }
+  }
+
+  const size_t src_chunk_size = convert_buffer_size(
+      src_format, component_len, CONVERT_CHUNK_TEXEL_LEN);
+  const size_t dst_chunk_size = convert_buffer_size(
+      dst_format, component_len, CONVERT_CHUNK_TEXEL_LEN);
+  const uchar *src_chunk = static_cast<const uchar *>(src);
+  uchar *dst_chunk = static_cast<uchar *>(dst);
+
+  for (size_t texel = 0; texel < texel_len; texel += CONVERT_CHUNK_TEXEL_LEN) {
+    const size_t chunk_len = min_zz(CONVERT_CHUNK_TEXEL_LEN, texel_len - texel);
+    if (is_integer) {
+      int64_t values[CONVERT_CHUNK_TEXEL_LEN * 4];
+      to_int(src_chunk, src_format, chunk_len * component_len, values);
+      from_int(values, dst_format, chunk_len * component_len, dst_chunk);
+    }
+    else {
+      float values[CONVERT_CHUNK_TEXEL_LEN * 4];
+      to_float(src_chunk, src_format, is_depth, component_len, chunk_len, values);
+      from_float(values, dst_format, is_depth, component_len, chunk_len, dst_chunk);
+    }
+    src_chunk += src_chunk_size;
+    dst_chunk += dst_chunk_size;
+  }
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,47 @@
+/* Conversion of pixel data between the data formats of the API (#eGPUDataFormat).
+ *
+ * Used by back-ends that need to convert on the host, either because the device does not
+ * support the data format or because the texture storage lives in system memory.
+ * The most common conversions (float to half, float to unsigned normalized byte and back) are
+ * vectorized using SSE2, F16C and AVX2 when the compiler targets them. Every other pair goes
+ * through a float (or 64bit integer for integer textures) intermediate buffer.
+ */
+
+#pragma once
+
+#include "LIB_sys_types.h"
+
+#include "GPU_texture.h"
+
+namespace dust::gpu {
+
+/**
+ * Convert \a texel_len texels of a texture using \a tex_format from \a src_format to
+ * \a dst_format. \a component_len is the number of components per texel for the non-packed data
+ * formats; packed formats (`UINT_24_8`, `10_11_11_REV`, `2_10_10_10_REV`) always store one 32bit
+ * value per texel and expect respectively 1, 3 and 4 components.
+ * \a tex_format decides how values are interpreted: integer textures convert values as integers,
+ * other textures treat bytes and packed formats as normalized and unsigned integers as
+ * normalized depth for depth textures.
+ * \a src and \a dst must not overlap.
+ */
+void convert_texels(const void *src,
+                    eGPUDataFormat src_format,
+                    void *dst,
+                    eGPUDataFormat dst_format,
+                    eGPUTextureFormat tex_format,
+                    int component_len,
+                    size_t texel_len);
+
+/** Size in bytes of \a texel_len texels using \a format. See #convert_texels. */
+size_t convert_buffer_size(eGPUDataFormat format, int component_len, size_t texel_len);
+
+/* Kernels used by #convert_texels, exposed for code dealing with single formats. */
+
+void convert_float_to_half(const float *src, uint16_t *dst, size_t len);
+void convert_half_to_float(const uint16_t *src, float *dst, size_t len);
+/** Clamp to [0..1] and round to the nearest 8bit value. */
+void convert_float_to_unorm8(const float *src, uchar *dst, size_t len);
+void convert_unorm8_to_float(const uchar *src, float *dst, size_t len);
+
+}  // namespace dust::gpu
@@ -0,0 +1,392 @@
+#include <cmath>
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+#include "LIB_string.h"
+#include "LIB_vector.hh"
+
+#include "GPU_capabilities.h"
+#include "GPU_shader.h"
+#include "GPU_state.h"
+#include "GPU_storage_buffer.h"
+#include "GPU_texture.h"
+
+#include "gpu_backend.hh"
+#include "gpu_context_private.hh"
+#include "gpu_shader_private.hh"
+#include "gpu_texture_downsample.hh"
+#include "gpu_texture_private.hh"
+
+namespace dust::gpu {
+
+/* Number of levels written by one dispatch. Limited by the number of image units (8 minimum). */
+#define DOWNSAMPLE_LEVEL_MAX 8
+/* Each work group reduces a tile of `1 << DOWNSAMPLE_TILE_LEVELS` texels of the base level. */
+#define DOWNSAMPLE_TILE_LEVELS 6
+
+static const char *downsample_comp_glsl = R"(
+layout(local_size_x = 256) in;
+
+layout(binding = 0) uniform sampler2D src_tx;
+layout(IMAGE_FORMAT, binding = 0) uniform coherent image2D mip_img[DOWNSAMPLE_LEVEL_MAX];
+layout(std430, binding = 0) buffer downsample_counter_buf
+{
+  uint group_finished_len;
+};
+
+/* Extent of the base level, bound as level 0 of `src_tx`. */
+uniform ivec2 src_size;
+/* Number of levels to write after the base level. */
+uniform int level_len;
+
+shared vec4 tile[32 * 32];
+shared bool is_last_group;
+
+ivec2 level_size(int level)
+{
+  return max(ivec2(1), src_size >> level);
+}
+
+vec4 level_load(int level, ivec2 co)
+{
+  co = min(co, level_size(level) - 1);
+  if (level == 0) {
+    return texelFetch(src_tx, co, 0);
+  }
+  return imageLoad(mip_img[level - 1], co);
+}
+
+void level_store(int level, ivec2 co, vec4 value)
+{
+  if (all(lessThan(co, level_size(level)))) {
+    imageStore(mip_img[level - 1], co, value);
+  }
+}
+
+/* Reduce the 64x64 texels of the `base` level starting at `origin` to levels `base + 1` up to
+ * `last`. Intermediate levels stay in shared memory. */
+void downsample_tile(int base, ivec2 origin, int last)
+{
+  uint index = gl_LocalInvocationIndex;
+  for (uint i = index; i < 32u * 32u; i += 256u) {
+    ivec2 co = (origin >> 1) + ivec2(i % 32u, i / 32u);
+    vec4 value = level_load(base, co * 2) + level_load(base, co * 2 + ivec2(1, 0)) +
+                 level_load(base, co * 2 + ivec2(0, 1)) + level_load(base, co * 2 + ivec2(1, 1));
+    value *= 0.25;
+    tile[i] = value;
+    level_store(base + 1, co, value);
+  }
+  int width = 32;
+  for (int level = base + 2; level <= last; level++) {
+    barrier();
+    int half_width = width / 2;
+    ivec2 prev_origin = origin >> (level - 1 - base);
+    ivec2 prev_max = level_size(level - 1) - 1;
+    bool active = index < uint(half_width * half_width);
+    ivec2 local = ivec2(int(index) % half_width, int(index) / half_width);
+    ivec2 co = (origin >> (level - base)) + local;
+    vec4 value = vec4(0.0);
+    if (active) {
+      for (int j = 0; j < 4; j++) {
+        ivec2 child = min(co * 2 + ivec2(j & 1, j >> 1), prev_max) - prev_origin;
+        child = clamp(child, ivec2(0), ivec2(width - 1));
+        value += tile[child.y * width + child.x];
+      }
+      value *= 0.25;
+    }
+    barrier();
+    if (active) {
+      tile[local.y * half_width + local.x] = value;
+      level_store(level, co, value);
+    }
+    width = half_width;
+  }
+}
+
+void main()
+{
+  downsample_tile(0, ivec2(gl_WorkGroupID.xy) * 64, min(level_len, 6));
+  if (level_len <= 6) {
+    return;
+  }
+  /* Publish the levels of this group, then let the last group to finish reduce the rest. */
+  memoryBarrierImage();
+  barrier();
+  if (gl_LocalInvocationIndex == 0u) {
+    uint group_len = gl_NumWorkGroups.x * gl_NumWorkGroups.y;
+    is_last_group = atomicAdd(group_finished_len, 1u) == group_len - 1u;
+  }
+  barrier();
+  if (!is_last_group) {
+    return;
+  }
+  downsample_tile(6, ivec2(0), level_len);
+  if (gl_LocalInvocationIndex == 0u) {
+    /* Ready for the next dispatch. */
+    group_finished_len = 0u;
+  }
+}
+)";
+
+/** Layout qualifier of the formats that can be written by the shader, nullptr otherwise. */
+static const char *image_format_qualifier(eGPUTextureFormat format)
+{
+  switch (format) {
+    case GPU_RGBA32F:
+      return "rgba32f";
+    case GPU_RGBA16F:
+      return "rgba16f";
+    case GPU_RGBA16:
+      return "rgba16";
+    case GPU_RGBA8:
+      return "rgba8";
+    case GPU_RG32F:
+      return "rg32f";
+    case GPU_RG16F:
+      return "rg16f";
+    case GPU_RG16:
+      return "rg16";
+    case GPU_RG8:
+      return "rg8";
+    case GPU_R32F:
+      return "r32f";
+    case GPU_R16F:
+      return "r16f";
+    case GPU_R16:
+      return "r16";
+    case GPU_R8:
+      return "r8";
+    case GPU_R11F_G11F_B10F:
+      return "r11f_g11f_b10f";
+    case GPU_RGB10_A2:
+      return "rgb10_a2";
+    default:
+      return nullptr;
+  }
+}
+
+struct DownsampleShader {
+  eGPUTextureFormat format;
+  GPUShader *shader;
+};
+
+/** Shaders are created on first use for each image format. */
+struct TextureDownsample {
+  Vector<DownsampleShader> shaders;
+  GPUStorageBuf *counter = nullptr;
+
+  static TextureDownsample &get()
+  {
+    static TextureDownsample downsample;
+    return downsample;
+  }
+
+  GPUShader *shader_get(eGPUTextureFormat format)
+  {
+    for (const DownsampleShader &entry : shaders) {
+      if (entry.format == format) {
+        return entry.shader;
+      }
+    }
+    char defines[128];
+    LIB_snprintf(defines,
+                 sizeof(defines),
+                 "#define IMAGE_FORMAT %s\n#define DOWNSAMPLE_LEVEL_MAX %d\n",
+                 image_format_qualifier(format),
+                 DOWNSAMPLE_LEVEL_MAX);
+    GPUShader *shader = GPU_shader_create_compute(
+        downsample_comp_glsl, nullptr, defines, "gpu_texture_downsample");
+    /* Failed compilations are cached too, to not retry every call. */
+    shaders.append({format, shader});
+    return shader;
+  }
+
+  GPUStorageBuf *counter_get()
+  {
+    if (counter == nullptr) {
+      counter = GPU_storagebuf_create_ex(
+          sizeof(uint32_t), nullptr, GPU_USAGE_DEVICE_ONLY, "gpu_texture_downsample_counter");
+      GPU_storagebuf_clear_to_zero(counter);
+    }
+    return counter;
+  }
+
+  void free()
+  {
+    for (const DownsampleShader &entry : shaders) {
+      if (entry.shader) {
+        GPU_shader_free(entry.shader);
+      }
+    }
+    shaders.clear();
+    if (counter) {
+      GPU_storagebuf_free(counter);
+      counter = nullptr;
+    }
+  }
+};
+
+static bool texture_downsample_supported(const Texture *tex)
+{
+  return GPU_compute_shader_support() && GPU_shader_image_load_store_support() &&
+         tex->type_get() == GPU_TEXTURE_2D && image_format_qualifier(tex->format_get()) != nullptr;
+}
+
+/* -------------------------------------------------------------------- */
+/* CPU Reference */
+
+void texture_downsample_reference(const float *src,
+                                  const int src_size[2],
+                                  int component_len,
+                                  float *dst)
+{
+  const int dst_w = max_ii(1, src_size[0] / 2);
+  const int dst_h = max_ii(1, src_size[1] / 2);
+  for (int y = 0; y < dst_h; y++) {
+    const int y0 = min_ii(y * 2, src_size[1] - 1);
+    const int y1 = min_ii(y * 2 + 1, src_size[1] - 1);
+    for (int x = 0; x < dst_w; x++) {
+      const int x0 = min_ii(x * 2, src_size[0] - 1);
+      const int x1 = min_ii(x * 2 + 1, src_size[0] - 1);
+      const float *s00 = src + (size_t(y0) * src_size[0] + x0) * component_len;
+      const float *s10 = src + (size_t(y0) * src_size[0] + x1) * component_len;
+      const float *s01 = src + (size_t(y1) * src_size[0] + x0) * component_len;
+      const float *s11 = src + (size_t(y1) * src_size[0] + x1) * component_len;
+      float *texel = dst + (size_t(y) * dst_w + x) * component_len;
+      /* Same summation order as the shader. */
+      for (int c = 0; c < component_len; c++) {
+        texel[c] = (s00[c] + s10[c] + s01[c] + s11[c]) * 0.25f;
+      }
+    }
+  }
+}
+
+float texture_downsample_validate(Texture *tex, int max_lvl)
+{
+  LIB_assert(tex->type_get() == GPU_TEXTURE_2D);
+  /* NOTE: Formats with less precision than float accumulate rounding differences per level. */
+  const int component_len = to_component_len(tex->format_get());
+  int size[2] = {tex->width_get(), tex->height_get()};
+  float *expected = (float *)tex->read(0, GPU_DATA_FLOAT);
+  float max_error = 0.0f;
+  for (int mip = 1; mip <= min_ii(max_lvl, tex->mip_count() - 1); mip++) {
+    const int mip_size[2] = {max_ii(1, size[0] / 2), max_ii(1, size[1] / 2)};
+    const size_t value_len = size_t(mip_size[0]) * mip_size[1] * component_len;
+    float *next = (float *)MEM_mallocN(sizeof(float) * value_len, __func__);
+    texture_downsample_reference(expected, size, component_len, next);
+    MEM_freeN(expected);
+    expected = next;
+
+    float *actual = (float *)tex->read(mip, GPU_DATA_FLOAT);
+    for (size_t i = 0; i < value_len; i++) {
+      max_error = max_ff(max_error, fabsf(actual[i] - expected[i]));
+    }
+    MEM_freeN(actual);
+    size[0] = mip_size[0];
+    size[1] = mip_size[1];
+  }
+  MEM_freeN(expected);
+  return max_error;
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+void GPU_texture_downsample(GPUTexture *tex_, int max_lvl)
+{
+  Texture *tex = reinterpret_cast<Texture *>(tex_);
+  max_lvl = min_ii(max_lvl, tex->mip_count() - 1);
+  if (max_lvl < 1) {
+    return;
+  }
+
+  TextureDownsample &downsample = TextureDownsample::get();
+  GPUShader *shader = texture_downsample_supported(tex) ?
+                          downsample.shader_get(tex->format_get()) :
+                          nullptr;
+  if (shader == nullptr) {
+    tex->generate_mipmap();
+    return;
+  }
+
+  /* Everything bound here is restored, callers can generate mipmaps between binding their own
+   * shader and textures and drawing. */
+  Context *ctx = Context::get();
+  StateManager *state_manager = ctx->state_manager;
+  Shader *prev_shader = ctx->shader;
+  eGPUSamplerState prev_sampler = GPU_SAMPLER_DEFAULT;
+  Texture *prev_texture = state_manager->texture_bound_get(0, &prev_sampler);
+  Texture *prev_images[DOWNSAMPLE_LEVEL_MAX];
+  for (int i = 0; i < DOWNSAMPLE_LEVEL_MAX; i++) {
+    prev_images[i] = state_manager->image_bound_get(i);
+  }
+  int prev_mip_min, prev_mip_max;
+  tex->mip_range_get(&prev_mip_min, &prev_mip_max);
+
+  GPUStorageBuf *counter = downsample.counter_get();
+  GPU_shader_bind(shader);
+  GPU_storagebuf_bind(counter, 0);
+
+  const int tile_size = 1 << DOWNSAMPLE_TILE_LEVELS;
+  for (int base = 0; base < max_lvl;) {
+    const int size[2] = {max_ii(1, tex->width_get() >> base),
+                         max_ii(1, tex->height_get() >> base)};
+    int level_len = min_ii(max_lvl - base, DOWNSAMPLE_LEVEL_MAX);
+    if (max_ii(size[0], size[1]) > tile_size * tile_size) {
+      /* The remaining levels would not fit in the single tile of the last work group. */
+      level_len = min_ii(level_len, DOWNSAMPLE_TILE_LEVELS);
+    }
+
+    GPUTexture *views[DOWNSAMPLE_LEVEL_MAX];
+    for (int i = 0; i < level_len; i++) {
+      views[i] = GPU_texture_create_view(
+          "downsample_level", tex_, tex->format_get(), base + 1 + i, 1, 0, 1, false);
+      GPU_texture_image_bind(views[i], i);
+    }
+    /* Only fetch from the base level, so there is no feedback with the written levels. */
+    tex->mip_range_set(base, base);
+    GPU_texture_bind(tex_, 0);
+    GPU_shader_uniform_2iv(shader, "src_size", size);
+    GPU_shader_uniform_1i(shader, "level_len", level_len);
+
+    GPUBackend::get()->compute_dispatch(
+        divide_ceil_u(size[0], tile_size), divide_ceil_u(size[1], tile_size), 1);
+    GPU_memory_barrier(GPU_BARRIER_SHADER_IMAGE_ACCESS | GPU_BARRIER_TEXTURE_FETCH);
+
+    for (int i = 0; i < level_len; i++) {
+      GPU_texture_image_unbind(views[i]);
+      GPU_texture_free(views[i]);
+    }
+    base += level_len;
+  }
+
+  GPU_texture_unbind(tex_);
+  GPU_storagebuf_unbind(counter);
+  tex->mip_range_set(prev_mip_min, prev_mip_max);
+
+  if (prev_shader) {
+    GPU_shader_bind(wrap(prev_shader));
+  }
+  else {
+    GPU_shader_unbind();
+  }
+  if (prev_texture) {
+    state_manager->texture_bind(prev_texture, prev_sampler, 0);
+  }
+  for (int i = 0; i < DOWNSAMPLE_LEVEL_MAX; i++) {
+    if (prev_images[i]) {
+      state_manager->image_bind(prev_images[i], i);
+    }
+  }
+}
+
+void GPU_texture_downsample_free()
+{
+  TextureDownsample::get().free();
+}
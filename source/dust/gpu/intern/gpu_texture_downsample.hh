@@ -0,0 +1,33 @@
+/* Mip chain generation of #GPU_texture_downsample.
+ *
+ * The compute shader reduces 64x64 tiles of the base level down to 1x1 inside each work group,
+ * then the last work group to finish reduces the remaining levels. The CPU functions below use the
+ * exact same filter (and summation order) and are used to validate the GPU result.
+ */
+
+#pragma once
+
+#include "LIB_sys_types.h"
+
+namespace dust::gpu {
+
+class Texture;
+
+/**
+ * Compute the level following \a src (\a src_size texels of \a component_len floats).
+ * Each destination texel is the average of the 2x2 source texels, fetched with clamping for odd
+ * and one texel wide sources. \a dst has `max(1, src_size / 2)` texels.
+ */
+void texture_downsample_reference(const float *src,
+                                  const int src_size[2],
+                                  int component_len,
+                                  float *dst);
+
+/**
+ * Compare levels 1 to \a max_lvl of \a tex against #texture_downsample_reference computed from
+ * its level 0. Reads the texture back so this is only meant for debugging.
+ * Return the largest absolute difference.
+ */
+float texture_downsample_validate(Texture *tex, int max_lvl);
+
+}  // namespace dust::gpu
@@ -0,0 +1,162 @@
+#include <mutex>
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+#include "LIB_vector.hh"
+
+#include "GPU_texture_pool.h"
+
+#include "gpu_texture_private.hh"
+
+namespace dust::gpu {
+
+struct TexturePoolKey {
+  eGPUTextureFormat format;
+  int w, h;
+  int mip_len;
+
+  bool operator==(const TexturePoolKey &other) const
+  {
+    return format == other.format && w == other.w && h == other.h && mip_len == other.mip_len;
+  }
+};
+
+struct TexturePoolEntry {
+  GPUTexture *tex;
+  TexturePoolKey key;
+  /** Value of #TexturePool::frame_ when the texture was released. */
+  uint64_t release_frame;
+};
+
+/**
+ * Textures are shared between all contexts, so there is only one pool.
+ * The lists are expected to stay small (a few dozen textures) so linear searches are fine.
+ */
+struct TexturePool {
+  std::mutex mutex;
+  /** Textures currently used by the callers of #GPU_texture_pool_acquire. */
+  Vector<TexturePoolEntry> acquired;
+  /** Released textures, most recently released last. */
+  Vector<TexturePoolEntry> unused;
+  uint64_t frame = 0;
+};
+
+static TexturePool &texture_pool_get()
+{
+  static TexturePool pool;
+  return pool;
+}
+
+static size_t texture_pool_entry_memory(const TexturePoolEntry &entry)
+{
+  size_t size = 0;
+  int w = entry.key.w, h = entry.key.h;
+  for (int mip = 0; mip < entry.key.mip_len; mip++) {
+    size += size_t(w) * size_t(h) * to_bytesize(entry.key.format);
+    w = max_ii(1, w / 2);
+    h = max_ii(1, h / 2);
+  }
+  return size;
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+GPUTexture *GPU_texture_pool_acquire(
+    const char *name, int w, int h, int mip_len, eGPUTextureFormat format)
+{
+  const TexturePoolKey key = {format, w, h, mip_len};
+  TexturePool &pool = texture_pool_get();
+  {
+    std::scoped_lock lock(pool.mutex);
+    /* Most recently released first, it is the most likely to still be resident. */
+    for (int64_t i = pool.unused.size() - 1; i >= 0; i--) {
+      if (pool.unused[i].key == key) {
+        TexturePoolEntry entry = pool.unused[i];
+        pool.unused.remove(i);
+        pool.acquired.append(entry);
+        /* Do not leak the sampler state of the previous user. */
+        reinterpret_cast<Texture *>(entry.tex)->sampler_state = GPU_SAMPLER_DEFAULT;
+        return entry.tex;
+      }
+    }
+  }
+
+  GPUTexture *tex = GPU_texture_create_2d(name, w, h, mip_len, format, nullptr);
+  if (tex == nullptr) {
+    return nullptr;
+  }
+  std::scoped_lock lock(pool.mutex);
+  pool.acquired.append({tex, key, 0});
+  return tex;
+}
+
+void GPU_texture_pool_release(GPUTexture *tex)
+{
+  TexturePool &pool = texture_pool_get();
+  std::scoped_lock lock(pool.mutex);
+
+  for (const int64_t i : pool.acquired.index_range()) {
+    TexturePoolEntry entry = pool.acquired[i];
+    if (entry.tex != tex) {
+      continue;
+    }
+    pool.acquired.remove_and_reorder(i);
+    if (reinterpret_cast<Texture *>(tex)->refcount > 1) {
+      /* Still used somewhere else, let the last user free it. */
+      GPU_texture_free(tex);
+      return;
+    }
+    entry.release_frame = pool.frame;
+    pool.unused.append(entry);
+    return;
+  }
+  LIB_assert_msg(0, "GPUTexture: texture was not acquired from the texture pool");
+  GPU_texture_free(tex);
+}
+
+void GPU_texture_pool_step()
+{
+  TexturePool &pool = texture_pool_get();
+  std::scoped_lock lock(pool.mutex);
+
+  pool.frame++;
+  /* Keep the release order of the remaining textures. */
+  int64_t kept_len = 0;
+  for (const TexturePoolEntry &entry : pool.unused) {
+    if (pool.frame - entry.release_frame > GPU_TEXTURE_POOL_MAX_AGE) {
+      GPU_texture_free(entry.tex);
+    }
+    else {
+      pool.unused[kept_len++] = entry;
+    }
+  }
+  pool.unused.resize(kept_len);
+}
+
+void GPU_texture_pool_free_unused()
+{
+  TexturePool &pool = texture_pool_get();
+  std::scoped_lock lock(pool.mutex);
+
+  for (const TexturePoolEntry &entry : pool.unused) {
+    GPU_texture_free(entry.tex);
+  }
+  pool.unused.clear();
+}
+
+void GPU_texture_pool_stats_get(int *r_unused_len, size_t *r_unused_memory)
+{
+  TexturePool &pool = texture_pool_get();
+  std::scoped_lock lock(pool.mutex);
+
+  *r_unused_len = int(pool.unused.size());
+  *r_unused_memory = 0;
+  for (const TexturePoolEntry &entry : pool.unused) {
+    *r_unused_memory += texture_pool_entry_memory(entry);
+  }
+}
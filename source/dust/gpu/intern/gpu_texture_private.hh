@@ -2,6 +2,7 @@
 
 #include "LIB_assert.h"
 
+#include "GPU_memory_budget.h"
 #include "GPU_vertex_buffer.h"
 
 #include "gpu_framebuffer_private.hh"
@@ -57,6 +58,13 @@ class Texture {
   int refcount = 1;
   /** Width & Height (of source data), optional. */
   int src_w = 0, src_h = 0;
+  /** Memory accounting, see #GPU_memory_budget.h. Size is zero for views and buffer textures. */
+  size_t memory_size = 0;
+  eGPUMemoryCategory memory_category = GPU_MEMORY_CATEGORY_OTHER;
+  /** Frame of the last bind, least recently used evictable textures are evicted first. */
+  uint64_t memory_last_use = 0;
+  GPUTextureEvictFn memory_evict_fn = nullptr;
+  void *memory_evict_user_data = nullptr;
 #ifndef GPU_NO_USE_PY_REFERENCES
   /**
    * Reference of a pointer that needs to be cleaned when deallocating the texture.
@@ -114,11 +122,33 @@ class Texture {
   virtual void swizzle_set(const char swizzle_mask[4]) = 0;
   virtual void stencil_texture_mode_set(bool use_stencil) = 0;
   virtual void mip_range_set(int min, int max) = 0;
+  void mip_range_get(int *r_min, int *r_max) const
+  {
+    *r_min = mip_min_;
+    *r_max = mip_max_;
+  }
   virtual void *read(int mip, eGPUDataFormat format) = 0;
+  /**
+   * Whether #update_sub and #read take \a format as is. Other data formats are converted on the
+   * host by #update and #read_converted. Defaults to the format matching the storage.
+   */
+  virtual bool data_format_is_native(eGPUDataFormat format) const;
+  /** #read going through a host conversion if \a format is not native. */
+  void *read_converted(int mip, eGPUDataFormat format);
+  /**
+   * Same as #read but the copy might complete later. \a dst is already large enough and its
+   * fence is inserted by the caller. Default implementation reads synchronously.
+   */
+  virtual void read_async(int mip, eGPUDataFormat format, StagingBuffer *dst);
+  /** Size in bytes of the data returned by #read. */
+  size_t read_size_get(int mip, eGPUDataFormat format) const;
 
   void attach_to(FrameBuffer *fb, GPUAttachmentType type);
   void detach_from(FrameBuffer *fb);
   void update(eGPUDataFormat format, const void *data);
+  /** #update_sub going through a host conversion if \a format is not native. */
+  void update_sub_converted(
+      int mip, int offset[3], int extent[3], eGPUDataFormat format, const void *data);
 
   virtual void update_sub(
       int mip, int offset[3], int extent[3], eGPUDataFormat format, const void *data) = 0;
@@ -398,6 +428,8 @@ inline size_t to_bytesize(eGPUDataFormat data_format)
   switch (data_format) {
     case GPU_DATA_UBYTE:
       return 1;
+    case GPU_DATA_HALF_FLOAT:
+      return 2;
     case GPU_DATA_FLOAT:
     case GPU_DATA_INT:
     case GPU_DATA_UINT:
@@ -414,6 +446,10 @@ inline size_t to_bytesize(eGPUDataFormat data_format)
 
 inline size_t to_bytesize(eGPUTextureFormat tex_format, eGPUDataFormat data_format)
 {
+  /* Packed formats store all components of a texel in one 32-bit value. */
+  if (ELEM(data_format, GPU_DATA_UINT_24_8, GPU_DATA_10_11_11_REV, GPU_DATA_2_10_10_10_REV)) {
+    return to_bytesize(data_format);
+  }
   return to_component_len(tex_format) * to_bytesize(data_format);
 }
 
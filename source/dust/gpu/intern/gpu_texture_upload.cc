@@ -0,0 +1,267 @@
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+#include "LIB_vector.hh"
+
+#include "PIL_time.h"
+
+#include "GPU_texture.h"
+
+#include "gpu_context_private.hh"
+#include "gpu_texture_private.hh"
+
+namespace dust::gpu {
+
+/* Alignment of each update inside the ring. */
+#define UPLOAD_RING_ALIGN 16
+
+struct TextureUpload {
+  Texture *tex;
+  eGPUDataFormat format;
+  int offset[3];
+  int extent[3];
+  /** Location of the pixels inside the ring. */
+  size_t ring_offset;
+  size_t size;
+};
+
+/**
+ * Ring data is tightly packed: the unpack row length is reset for the uploads of the queue, then
+ * set back to the one of the caller.
+ */
+class UnpackRowLengthScope {
+ private:
+  StateManager *state_manager_;
+  uint prev_len_;
+
+ public:
+  UnpackRowLengthScope() : state_manager_(Context::get()->state_manager)
+  {
+    prev_len_ = state_manager_->texture_unpack_row_length_get();
+    state_manager_->texture_unpack_row_length_set(0);
+  }
+  ~UnpackRowLengthScope()
+  {
+    state_manager_->texture_unpack_row_length_set(prev_len_);
+  }
+};
+
+/**
+ * FIFO of pending updates whose pixels live in a circular staging buffer.
+ * Updates are allocated at #head_ and consumed from #tail_, so the ring memory is reused in
+ * order without any per-update allocation.
+ *
+ * The ring is host memory: this only queues and paces the updates, each one still goes through
+ * #Texture::update_sub_converted and the copy of the driver.
+ */
+class TextureUploadQueue {
+ private:
+  uchar *ring_ = nullptr;
+  size_t head_ = 0;
+  size_t tail_ = 0;
+  /** Pending updates, oldest at #first_. */
+  Vector<TextureUpload> uploads_;
+  int64_t first_ = 0;
+
+ public:
+  size_t budget = 0;
+  GPUTextureUploadStats stats = {};
+
+  ~TextureUploadQueue()
+  {
+    LIB_assert(this->is_empty());
+    MEM_SAFE_FREE(ring_);
+  }
+
+  static TextureUploadQueue &get()
+  {
+    static TextureUploadQueue queue;
+    return queue;
+  }
+
+  bool is_empty() const
+  {
+    return first_ == uploads_.size();
+  }
+
+  void push(Texture *tex,
+            eGPUDataFormat format,
+            const int offset[3],
+            const int extent[3],
+            const void *pixels,
+            size_t size)
+  {
+    if (size > GPU_TEXTURE_UPLOAD_RING_SIZE) {
+      /* Would never fit, keep the order with the pending updates and upload directly. */
+      this->finish();
+      const double start = PIL_check_seconds_timer();
+      int offset_copy[3] = {offset[0], offset[1], offset[2]};
+      int extent_copy[3] = {extent[0], extent[1], extent[2]};
+      UnpackRowLengthScope row_length_scope;
+      tex->update_sub_converted(0, offset_copy, extent_copy, format, pixels);
+      stats.stall_count++;
+      stats.stall_time += PIL_check_seconds_timer() - start;
+      stats.bytes_uploaded += size;
+      stats.updates_uploaded++;
+      return;
+    }
+    if (ring_ == nullptr) {
+      ring_ = (uchar *)MEM_mallocN(GPU_TEXTURE_UPLOAD_RING_SIZE, "GPUTextureUploadRing");
+    }
+
+    size_t ring_offset;
+    if (!this->ring_alloc(size, &ring_offset)) {
+      /* Ring is full: upload the oldest updates until there is enough room. */
+      const double start = PIL_check_seconds_timer();
+      while (!this->ring_alloc(size, &ring_offset)) {
+        this->pop();
+      }
+      stats.stall_count++;
+      stats.stall_time += PIL_check_seconds_timer() - start;
+    }
+    memcpy(ring_ + ring_offset, pixels, size);
+
+    GPU_texture_ref(reinterpret_cast<GPUTexture *>(tex));
+    TextureUpload upload = {tex, format, {0}, {0}, ring_offset, size};
+    memcpy(upload.offset, offset, sizeof(upload.offset));
+    memcpy(upload.extent, extent, sizeof(upload.extent));
+    uploads_.append(upload);
+    stats.bytes_pending += size;
+    stats.updates_pending++;
+  }
+
+  /** Upload the oldest pending update. */
+  void pop()
+  {
+    LIB_assert(!this->is_empty());
+    TextureUpload &upload = uploads_[first_++];
+    if (upload.tex->refcount > 1) {
+      UnpackRowLengthScope row_length_scope;
+      upload.tex->update_sub_converted(
+          0, upload.offset, upload.extent, upload.format, ring_ + upload.ring_offset);
+      stats.bytes_uploaded += upload.size;
+      stats.updates_uploaded++;
+    }
+    /* Otherwise the texture was freed by its owner in the meantime. */
+    GPU_texture_free(reinterpret_cast<GPUTexture *>(upload.tex));
+    stats.bytes_pending -= upload.size;
+    stats.updates_pending--;
+
+    tail_ = upload.ring_offset + upload.size;
+    if (this->is_empty()) {
+      uploads_.clear();
+      first_ = 0;
+      head_ = tail_ = 0;
+    }
+  }
+
+  void flush()
+  {
+    size_t uploaded = 0;
+    while (!this->is_empty()) {
+      const size_t size = uploads_[first_].size;
+      /* Always upload at least one update so that the queue makes progress. */
+      if (budget != 0 && uploaded != 0 && uploaded + size > budget) {
+        break;
+      }
+      this->pop();
+      uploaded += size;
+    }
+  }
+
+  void finish()
+  {
+    while (!this->is_empty()) {
+      this->pop();
+    }
+  }
+
+  void free_ring()
+  {
+    this->finish();
+    MEM_SAFE_FREE(ring_);
+  }
+
+ private:
+  bool ring_alloc(size_t size, size_t *r_offset)
+  {
+    const size_t size_aligned = (size + UPLOAD_RING_ALIGN - 1) & ~size_t(UPLOAD_RING_ALIGN - 1);
+    if (this->is_empty()) {
+      head_ = tail_ = 0;
+    }
+    const bool wrapped = !this->is_empty() && head_ <= tail_;
+    if (!wrapped) {
+      /* Free space is after the head, then before the tail once wrapped around. */
+      if (GPU_TEXTURE_UPLOAD_RING_SIZE - head_ >= size_aligned) {
+        *r_offset = head_;
+      }
+      else if (tail_ >= size_aligned) {
+        *r_offset = 0;
+      }
+      else {
+        return false;
+      }
+    }
+    else if (tail_ - head_ >= size_aligned) {
+      *r_offset = head_;
+    }
+    else {
+      return false;
+    }
+    head_ = *r_offset + size_aligned;
+    return true;
+  }
+};
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+void GPU_texture_update_sub_queued(GPUTexture *tex_,
+                                   eGPUDataFormat data_format,
+                                   const void *pixels,
+                                   int offset_x,
+                                   int offset_y,
+                                   int offset_z,
+                                   int width,
+                                   int height,
+                                   int depth)
+{
+  Texture *tex = reinterpret_cast<Texture *>(tex_);
+  const int offset[3] = {offset_x, offset_y, offset_z};
+  const int extent[3] = {width, height, depth};
+  const size_t size = size_t(max_ii(1, width)) * max_ii(1, height) * max_ii(1, depth) *
+                      to_bytesize(tex->format_get(), data_format);
+  TextureUploadQueue::get().push(tex, data_format, offset, extent, pixels, size);
+}
+
+void GPU_texture_upload_queue_flush()
+{
+  TextureUploadQueue::get().flush();
+}
+
+void GPU_texture_upload_queue_finish()
+{
+  TextureUploadQueue::get().finish();
+}
+
+void GPU_texture_upload_queue_free()
+{
+  TextureUploadQueue::get().free_ring();
+}
+
+void GPU_texture_upload_budget_set(size_t bytes_per_frame)
+{
+  TextureUploadQueue::get().budget = bytes_per_frame;
+}
+
+void GPU_texture_upload_stats_get(GPUTextureUploadStats *r_stats)
+{
+  *r_stats = TextureUploadQueue::get().stats;
+}
@@ -0,0 +1,295 @@
+#include <cmath>
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_index_range.hh"
+#include "LIB_math_base.h"
+#include "LIB_task.hh"
+
+#include "GPU_vertex_compress.h"
+
+#include "gpu_texture_convert.hh"
+
+namespace dust::gpu {
+
+/* Vertices converted at once by each task. The gathered components stay in cache. */
+#define VERT_COMPRESS_CHUNK_LEN 1024
+/* Vertices handled by each task. */
+#define VERT_COMPRESS_GRAIN_SIZE 8192
+
+struct AttrEncoding {
+  GPUVertCompType comp_type;
+  /** Zero to keep the number of components of the float attribute. */
+  uint comp_len;
+  /** Largest difference between a value and its decoded encoding. */
+  float max_error;
+};
+
+/* Ordered from the smallest encoding. */
+static const AttrEncoding normal_encodings[] = {
+    /* #GPU_normal_convert_i10_v3 truncates. */
+    {GPU_COMP_I10, 4, 1.0f / 511.0f},
+    {GPU_COMP_I16, 3, 0.5f / 32767.0f},
+};
+static const AttrEncoding unorm_encodings[] = {
+    {GPU_COMP_U8, 0, 0.5f / 255.0f},
+    {GPU_COMP_U16, 0, 0.5f / 65535.0f},
+};
+
+static const AttrEncoding *encoding_find(const GPUVertAttr &attr, const GPUVertAttrHint &hint)
+{
+  if (attr.comp_type != GPU_COMP_F32 || attr.fetch_mode != GPU_FETCH_FLOAT) {
+    return nullptr;
+  }
+  const AttrEncoding *encodings;
+  int encoding_len, usual;
+  switch (hint.usage) {
+    case GPU_VERT_ATTR_USAGE_NORMAL:
+      if (attr.comp_len != 3) {
+        return nullptr;
+      }
+      encodings = normal_encodings;
+      encoding_len = ARRAY_SIZE(normal_encodings);
+      usual = 0;
+      break;
+    case GPU_VERT_ATTR_USAGE_UV:
+    case GPU_VERT_ATTR_USAGE_COLOR:
+      if (attr.comp_len > 4) {
+        return nullptr;
+      }
+      encodings = unorm_encodings;
+      encoding_len = ARRAY_SIZE(unorm_encodings);
+      usual = (hint.usage == GPU_VERT_ATTR_USAGE_UV) ? 1 : 0;
+      break;
+    default:
+      return nullptr;
+  }
+  if (hint.tolerance <= 0.0f) {
+    return &encodings[usual];
+  }
+  for (int i = 0; i < encoding_len; i++) {
+    if (encodings[i].max_error <= hint.tolerance) {
+      return &encodings[i];
+    }
+  }
+  return nullptr;
+}
+
+static void format_build(const GPUVertFormat *format,
+                         const AttrEncoding *const *encodings,
+                         GPUVertFormat *r_format)
+{
+  GPU_vertformat_clear(r_format);
+  for (int a = 0; a < format->attr_len; a++) {
+    const GPUVertAttr &attr = format->attrs[a];
+    const AttrEncoding *encoding = encodings[a];
+    const char *name = GPU_vertformat_attr_name_get(format, &attr, 0);
+    if (encoding) {
+      const uint comp_len = encoding->comp_len ? encoding->comp_len : attr.comp_len;
+      GPU_vertformat_attr_add(
+          r_format, name, encoding->comp_type, comp_len, GPU_FETCH_INT_TO_FLOAT_UNIT);
+    }
+    else {
+      GPU_vertformat_attr_add(r_format,
+                              name,
+                              GPUVertCompType(attr.comp_type),
+                              attr.comp_len,
+                              GPUVertFetchMode(attr.fetch_mode));
+    }
+    for (int n = 1; n < attr.name_len; n++) {
+      GPU_vertformat_alias_add(r_format, GPU_vertformat_attr_name_get(format, &attr, n));
+    }
+  }
+}
+
+/** True if all the values of the attribute are in the range its encoding can represent. */
+static bool attr_values_fit(const uchar *data,
+                            uint vertex_len,
+                            uint stride,
+                            const GPUVertAttr &attr,
+                            const AttrEncoding &encoding)
+{
+  const bool is_signed = ELEM(encoding.comp_type, GPU_COMP_I10, GPU_COMP_I16);
+  const float min = (is_signed ? -1.0f : 0.0f) - encoding.max_error;
+  const float max = 1.0f + encoding.max_error;
+  for (uint v = 0; v < vertex_len; v++) {
+    float value[4];
+    memcpy(value, data + size_t(v) * stride + attr.offset, sizeof(float) * attr.comp_len);
+    for (int c = 0; c < attr.comp_len; c++) {
+      /* Also rejects NaN. */
+      if (!(value[c] >= min && value[c] <= max)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* -------------------------------------------------------------------- */
+/* Kernels
+ * Work on contiguous components so that the loops vectorize. */
+
+static void convert_float_to_unorm16(const float *src, uint16_t *dst, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    dst[i] = uint16_t(clamp_f(src[i], 0.0f, 1.0f) * 65535.0f + 0.5f);
+  }
+}
+
+static void convert_float_to_snorm16(const float *src, int16_t *dst, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    dst[i] = int16_t(roundf(clamp_f(src[i], -1.0f, 1.0f) * 32767.0f));
+  }
+}
+
+static void convert_float_to_i10(const float *src, GPUPackedNormal *dst, size_t len)
+{
+  GPU_normal_convert_i10_v3_array(
+      reinterpret_cast<const float(*)[3]>(src), dst, sizeof(GPUPackedNormal), uint(len));
+}
+
+/** Convert the attribute of the vertices in \a range, a chunk at a time. */
+static void attr_convert(const uchar *src,
+                         uint src_stride,
+                         const GPUVertAttr &src_attr,
+                         uchar *dst,
+                         uint dst_stride,
+                         const GPUVertAttr &dst_attr,
+                         IndexRange range)
+{
+  float values[VERT_COMPRESS_CHUNK_LEN * 4];
+  uchar encoded[VERT_COMPRESS_CHUNK_LEN * 8];
+  const uint comp_len = src_attr.comp_len;
+  const size_t value_size = sizeof(float) * comp_len;
+
+  const size_t end = size_t(range.one_after_last());
+  for (size_t start = size_t(range.first()); start < end; start += VERT_COMPRESS_CHUNK_LEN) {
+    const size_t len = min_zz(VERT_COMPRESS_CHUNK_LEN, end - start);
+    for (size_t i = 0; i < len; i++) {
+      memcpy(values + i * comp_len, src + (start + i) * src_stride + src_attr.offset, value_size);
+    }
+    size_t encoded_size;
+    switch (dst_attr.comp_type) {
+      case GPU_COMP_U8:
+        convert_float_to_unorm8(values, encoded, len * comp_len);
+        encoded_size = sizeof(uchar) * comp_len;
+        break;
+      case GPU_COMP_U16:
+        convert_float_to_unorm16(values, reinterpret_cast<uint16_t *>(encoded), len * comp_len);
+        encoded_size = sizeof(uint16_t) * comp_len;
+        break;
+      case GPU_COMP_I16:
+        convert_float_to_snorm16(values, reinterpret_cast<int16_t *>(encoded), len * comp_len);
+        encoded_size = sizeof(int16_t) * comp_len;
+        break;
+      case GPU_COMP_I10:
+        convert_float_to_i10(values, reinterpret_cast<GPUPackedNormal *>(encoded), len);
+        encoded_size = sizeof(GPUPackedNormal);
+        break;
+      default:
+        LIB_assert_unreachable();
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+      memcpy(dst + (start + i) * dst_stride + dst_attr.offset,
+             encoded + i * encoded_size,
+             encoded_size);
+    }
+  }
+}
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust;
+using namespace dust::gpu;
+
+int GPU_vertformat_compress(const GPUVertFormat *format,
+                            const GPUVertAttrHint *hints,
+                            GPUVertFormat *r_format)
+{
+  const AttrEncoding *encodings[GPU_VERT_ATTR_MAX_LEN];
+  int compressed_len = 0;
+  for (int a = 0; a < format->attr_len; a++) {
+    encodings[a] = encoding_find(format->attrs[a], hints[a]);
+    compressed_len += int(encodings[a] != nullptr);
+  }
+  format_build(format, encodings, r_format);
+  return compressed_len;
+}
+
+GPUVertBuf *GPU_vertbuf_compress(GPUVertBuf *verts,
+                                 const GPUVertAttrHint *hints,
+                                 GPUVertBufCompressInfo *r_info)
+{
+  const GPUVertFormat *format = GPU_vertbuf_get_format(verts);
+  const uint vertex_len = GPU_vertbuf_get_vertex_len(verts);
+  if (r_info) {
+    r_info->size_before = r_info->size_after = size_t(format->stride) * vertex_len;
+    r_info->attr_compressed_len = 0;
+  }
+  if (format->deinterleaved || vertex_len == 0) {
+    return nullptr;
+  }
+
+  /* Static buffers don't keep their data once uploaded, read it back. */
+  const uchar *src = static_cast<const uchar *>(GPU_vertbuf_get_data(verts));
+  const void *mapped = nullptr;
+  if (src == nullptr) {
+    mapped = GPU_vertbuf_read(verts);
+    src = static_cast<const uchar *>(mapped);
+  }
+
+  const AttrEncoding *encodings[GPU_VERT_ATTR_MAX_LEN];
+  int compressed_len = 0;
+  for (int a = 0; a < format->attr_len; a++) {
+    const GPUVertAttr &attr = format->attrs[a];
+    encodings[a] = encoding_find(attr, hints[a]);
+    if (encodings[a] && !attr_values_fit(src, vertex_len, format->stride, attr, *encodings[a])) {
+      encodings[a] = nullptr;
+    }
+    compressed_len += int(encodings[a] != nullptr);
+  }
+
+  GPUVertBuf *dst_verts = nullptr;
+  if (compressed_len > 0) {
+    GPUVertFormat dst_format;
+    format_build(format, encodings, &dst_format);
+    dst_verts = GPU_vertbuf_create_with_format(&dst_format);
+    GPU_vertbuf_data_alloc(dst_verts, vertex_len);
+    /* Packed by the allocation. */
+    const GPUVertFormat *dst_packed = GPU_vertbuf_get_format(dst_verts);
+    uchar *dst = static_cast<uchar *>(GPU_vertbuf_get_data(dst_verts));
+
+    threading::parallel_for(
+        IndexRange(vertex_len), VERT_COMPRESS_GRAIN_SIZE, [&](IndexRange range) {
+          for (int a = 0; a < format->attr_len; a++) {
+            const GPUVertAttr &src_attr = format->attrs[a];
+            const GPUVertAttr &dst_attr = dst_packed->attrs[a];
+            if (encodings[a]) {
+              attr_convert(
+                  src, format->stride, src_attr, dst, dst_packed->stride, dst_attr, range);
+              continue;
+            }
+            for (const int64_t v : range) {
+              memcpy(dst + v * dst_packed->stride + dst_attr.offset,
+                     src + v * format->stride + src_attr.offset,
+                     src_attr.size);
+            }
+          }
+        });
+
+    if (r_info) {
+      r_info->size_after = size_t(dst_packed->stride) * vertex_len;
+      r_info->attr_compressed_len = compressed_len;
+    }
+  }
+
+  if (mapped) {
+    GPU_vertbuf_unmap(verts, mapped);
+  }
+  return dst_verts;
+}
@@ -0,0 +1,237 @@
+#include <cstring>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#  include <arm_neon.h>
+#endif
+
+#include "LIB_assert.h"
+#include "LIB_utildefines.h"
+
+#include "GPU_vertex_buffer.h"
+#include "GPU_vertex_format.h"
+
+/* Number of normals handled by each vector iteration. */
+#define NORMAL_CONVERT_AVX2_LEN 8
+#define NORMAL_CONVERT_NEON_LEN 4
+
+/* -------------------------------------------------------------------- */
+/* Helpers */
+
+/** Write the \a len values of \a values every \a stride bytes. */
+static inline void store_strided_u32(const uint32_t *values, int len, uchar *dst, uint stride)
+{
+  for (int i = 0; i < len; i++) {
+    memcpy(dst + size_t(i) * stride, &values[i], sizeof(uint32_t));
+  }
+}
+
+#if defined(__AVX2__)
+static inline __m256i i10_pack_avx2(__m256i x, __m256i y, __m256i z)
+{
+  const __m256i mask = _mm256_set1_epi32(0x3FF);
+  x = _mm256_and_si256(x, mask);
+  y = _mm256_slli_epi32(_mm256_and_si256(y, mask), 10);
+  z = _mm256_slli_epi32(_mm256_and_si256(z, mask), 20);
+  return _mm256_or_si256(x, _mm256_or_si256(y, z));
+}
+
+/** Same as #gpu_convert_normalized_f32_to_i10. */
+static inline __m256i f32_to_i10_avx2(__m256 v)
+{
+  const __m256i q = _mm256_cvttps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(511.0f)));
+  return _mm256_min_epi32(_mm256_max_epi32(q, _mm256_set1_epi32(SIGNED_INT_10_MIN)),
+                          _mm256_set1_epi32(SIGNED_INT_10_MAX));
+}
+
+static inline void store_strided_avx2(__m256i packed, uchar *dst, uint stride)
+{
+  if (stride == sizeof(uint32_t)) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), packed);
+    return;
+  }
+  uint32_t values[NORMAL_CONVERT_AVX2_LEN];
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(values), packed);
+  store_strided_u32(values, NORMAL_CONVERT_AVX2_LEN, dst, stride);
+}
+#endif
+
+#if defined(__ARM_NEON)
+static inline uint32x4_t i10_pack_neon(int32x4_t x, int32x4_t y, int32x4_t z)
+{
+  const uint32x4_t mask = vdupq_n_u32(0x3FF);
+  const uint32x4_t ux = vandq_u32(vreinterpretq_u32_s32(x), mask);
+  const uint32x4_t uy = vshlq_n_u32(vandq_u32(vreinterpretq_u32_s32(y), mask), 10);
+  const uint32x4_t uz = vshlq_n_u32(vandq_u32(vreinterpretq_u32_s32(z), mask), 20);
+  return vorrq_u32(ux, vorrq_u32(uy, uz));
+}
+
+/** Same as #gpu_convert_normalized_f32_to_i10. Conversion truncates like the scalar cast. */
+static inline int32x4_t f32_to_i10_neon(float32x4_t v)
+{
+  const int32x4_t q = vcvtq_s32_f32(vmulq_n_f32(v, 511.0f));
+  return vminq_s32(vmaxq_s32(q, vdupq_n_s32(SIGNED_INT_10_MIN)), vdupq_n_s32(SIGNED_INT_10_MAX));
+}
+
+static inline void store_strided_neon(uint32x4_t packed, uchar *dst, uint stride)
+{
+  uint32_t values[NORMAL_CONVERT_NEON_LEN];
+  vst1q_u32(values, packed);
+  store_strided_u32(values, NORMAL_CONVERT_NEON_LEN, dst, stride);
+}
+#endif
+
+/* -------------------------------------------------------------------- */
+/* Array Conversions */
+
+void GPU_normal_convert_i10_v3_array(const float (*src)[3], void *dst, uint dst_stride, uint len)
+{
+  uchar *dst_bytes = static_cast<uchar *>(dst);
+  uint i = 0;
+#if defined(__AVX2__)
+  /* Offsets of the x components of 8 consecutive normals. */
+  const __m256i offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+  for (; i + NORMAL_CONVERT_AVX2_LEN <= len; i += NORMAL_CONVERT_AVX2_LEN) {
+    const float *base = src[i];
+    const __m256i x = f32_to_i10_avx2(_mm256_i32gather_ps(base + 0, offsets, 4));
+    const __m256i y = f32_to_i10_avx2(_mm256_i32gather_ps(base + 1, offsets, 4));
+    const __m256i z = f32_to_i10_avx2(_mm256_i32gather_ps(base + 2, offsets, 4));
+    store_strided_avx2(i10_pack_avx2(x, y, z), dst_bytes + size_t(i) * dst_stride, dst_stride);
+  }
+#elif defined(__ARM_NEON)
+  for (; i + NORMAL_CONVERT_NEON_LEN <= len; i += NORMAL_CONVERT_NEON_LEN) {
+    const float32x4x3_t v = vld3q_f32(src[i]);
+    const uint32x4_t packed = i10_pack_neon(
+        f32_to_i10_neon(v.val[0]), f32_to_i10_neon(v.val[1]), f32_to_i10_neon(v.val[2]));
+    store_strided_neon(packed, dst_bytes + size_t(i) * dst_stride, dst_stride);
+  }
+#endif
+  for (; i < len; i++) {
+    const GPUPackedNormal n = GPU_normal_convert_i10_v3(src[i]);
+    memcpy(dst_bytes + size_t(i) * dst_stride, &n, sizeof(n));
+  }
+}
+
+void GPU_normal_convert_i10_s3_array(const short (*src)[3], void *dst, uint dst_stride, uint len)
+{
+  uchar *dst_bytes = static_cast<uchar *>(dst);
+  uint i = 0;
+#if defined(__AVX2__)
+  /* Byte offsets of the x components of 8 consecutive normals. Each gather reads 32 bits, so the
+   * last normal of a batch reads 2 bytes of the next one: keep one normal after the batch. */
+  const __m256i offsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+  for (; i + NORMAL_CONVERT_AVX2_LEN < len; i += NORMAL_CONVERT_AVX2_LEN) {
+    const int *base = reinterpret_cast<const int *>(src[i]);
+    __m256i comps[3];
+    for (int c = 0; c < 3; c++) {
+      const __m256i words = _mm256_i32gather_epi32(
+          reinterpret_cast<const int *>(reinterpret_cast<const short *>(base) + c), offsets, 1);
+      /* Sign extend the low 16 bits, then #gpu_convert_i16_to_i10. */
+      comps[c] = _mm256_srai_epi32(_mm256_slli_epi32(words, 16), 16 + 6);
+    }
+    store_strided_avx2(i10_pack_avx2(comps[0], comps[1], comps[2]),
+                       dst_bytes + size_t(i) * dst_stride,
+                       dst_stride);
+  }
+#elif defined(__ARM_NEON)
+  for (; i + NORMAL_CONVERT_NEON_LEN <= len; i += NORMAL_CONVERT_NEON_LEN) {
+    const int16x4x3_t v = vld3_s16(src[i]);
+    const uint32x4_t packed = i10_pack_neon(vshrq_n_s32(vmovl_s16(v.val[0]), 6),
+                                            vshrq_n_s32(vmovl_s16(v.val[1]), 6),
+                                            vshrq_n_s32(vmovl_s16(v.val[2]), 6));
+    store_strided_neon(packed, dst_bytes + size_t(i) * dst_stride, dst_stride);
+  }
+#endif
+  for (; i < len; i++) {
+    const GPUPackedNormal n = GPU_normal_convert_i10_s3(src[i]);
+    memcpy(dst_bytes + size_t(i) * dst_stride, &n, sizeof(n));
+  }
+}
+
+/** Same as #normal_float_to_short_v3 for each normal. */
+static void normal_convert_s3_array(const float (*src)[3], uchar *dst, uint dst_stride, uint len)
+{
+  uint i = 0;
+#if defined(__AVX2__)
+  const __m256i offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+  const __m256 scale = _mm256_set1_ps(32767.0f);
+  for (; i + NORMAL_CONVERT_AVX2_LEN <= len; i += NORMAL_CONVERT_AVX2_LEN) {
+    int32_t comps[3][NORMAL_CONVERT_AVX2_LEN];
+    for (int c = 0; c < 3; c++) {
+      const __m256 v = _mm256_i32gather_ps(src[i] + c, offsets, 4);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(comps[c]),
+                          _mm256_cvttps_epi32(_mm256_mul_ps(v, scale)));
+    }
+    for (int j = 0; j < NORMAL_CONVERT_AVX2_LEN; j++) {
+      const short n[3] = {short(comps[0][j]), short(comps[1][j]), short(comps[2][j])};
+      memcpy(dst + size_t(i + j) * dst_stride, n, sizeof(n));
+    }
+  }
+#elif defined(__ARM_NEON)
+  for (; i + NORMAL_CONVERT_NEON_LEN <= len; i += NORMAL_CONVERT_NEON_LEN) {
+    const float32x4x3_t v = vld3q_f32(src[i]);
+    int16x4x3_t n;
+    for (int c = 0; c < 3; c++) {
+      n.val[c] = vmovn_s32(vcvtq_s32_f32(vmulq_n_f32(v.val[c], 32767.0f)));
+    }
+    if (dst_stride == sizeof(short[3])) {
+      vst3_s16(reinterpret_cast<short *>(dst + size_t(i) * dst_stride), n);
+      continue;
+    }
+    short values[NORMAL_CONVERT_NEON_LEN][3];
+    vst3_s16(values[0], n);
+    for (int j = 0; j < NORMAL_CONVERT_NEON_LEN; j++) {
+      memcpy(dst + size_t(i + j) * dst_stride, values[j], sizeof(values[j]));
+    }
+  }
+#endif
+  for (; i < len; i++) {
+    short n[3];
+    normal_float_to_short_v3(n, src[i]);
+    memcpy(dst + size_t(i) * dst_stride, n, sizeof(n));
+  }
+}
+
+void GPU_normal_convert_v3_array(
+    const float (*src)[3], void *dst, uint dst_stride, uint len, const bool do_hq_normals)
+{
+  if (do_hq_normals) {
+    normal_convert_s3_array(src, static_cast<uchar *>(dst), dst_stride, len);
+  }
+  else {
+    GPU_normal_convert_i10_v3_array(src, dst, dst_stride, len);
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Vertex Buffers */
+
+void GPU_vertbuf_raw_normals_fill(GPUVertBufRaw *access,
+                                  const float (*normals)[3],
+                                  uint len,
+                                  const bool do_hq_normals)
+{
+  GPU_normal_convert_v3_array(normals, access->data, access->stride, len, do_hq_normals);
+  access->data += size_t(len) * access->stride;
+#ifdef DEBUG
+  LIB_assert(access->data <= access->_data_end);
+#endif
+}
+
+void GPU_vertbuf_attr_fill_normals(GPUVertBuf *verts, uint a_idx, const float (*normals)[3])
+{
+  const GPUVertFormat *format = GPU_vertbuf_get_format(verts);
+  const GPUVertAttr *attr = &format->attrs[a_idx];
+  if (attr->comp_type == GPU_COMP_F32) {
+    GPU_vertbuf_attr_fill_stride(verts, a_idx, sizeof(float[3]), normals);
+    return;
+  }
+  LIB_assert_msg(ELEM(attr->comp_type, GPU_COMP_I10, GPU_COMP_I16),
+                 "Normals can only be converted to 10_10_10_2 or 16bit integers");
+  GPUVertBufRaw access;
+  GPU_vertbuf_attr_get_raw_data(verts, a_idx, &access);
+  GPU_vertbuf_raw_normals_fill(
+      &access, normals, GPU_vertbuf_get_vertex_len(verts), attr->comp_type == GPU_COMP_I16);
+}
@@ -0,0 +1,553 @@
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+#include "LIB_set.hh"
+#include "LIB_utildefines.h"
+#include "LIB_vector.hh"
+
+#include "GPU_memory_budget.h"
+#include "GPU_readback.h"
+#include "GPU_storage_buffer.h"
+#include "GPU_virtual_texture.h"
+
+namespace dust::gpu {
+
+/* Texels per page side in the cache, including the borders. */
+#define PAGE_SLOT_SIZE (GPU_VIRTUAL_PAGE_SIZE + 2 * GPU_VIRTUAL_PAGE_BORDER)
+
+/* Limits of the page key packing, see #page_key. */
+#define PAGE_TILE_MAX 1024
+#define PAGE_MIP_MAX 16
+#define PAGE_COORD_MAX 512
+
+/* Size of the feedback buffers: the request count followed by the requests. */
+#define FEEDBACK_BUF_SIZE (sizeof(uint32_t) * (1 + GPU_VIRTUAL_FEEDBACK_LEN))
+
+static const char *virtual_texture_lib_glsl =
+    "#define VT_PAGE_SIZE " STRINGIFY(GPU_VIRTUAL_PAGE_SIZE) "\n"
+    "#define VT_PAGE_BORDER " STRINGIFY(GPU_VIRTUAL_PAGE_BORDER) "\n"
+    "#define VT_FEEDBACK_LEN " STRINGIFY(GPU_VIRTUAL_FEEDBACK_LEN) "\n"
+    R"(
+uniform sampler2D vt_cache_tx;
+layout(std430) readonly buffer vt_page_table_buf
+{
+  uint vt_page_table[];
+};
+layout(std430) buffer vt_feedback_buf
+{
+  uint vt_feedback_len;
+  uint vt_feedback[];
+};
+uniform ivec2 vt_tile_size;
+uniform int vt_mip_len;
+uniform int vt_cache_slots_x;
+uniform ivec2 vt_feedback_offset;
+
+ivec2 vt_level_size(int mip)
+{
+  return max(ivec2(1), vt_tile_size >> mip);
+}
+
+ivec2 vt_level_pages(int mip)
+{
+  return (vt_level_size(mip) + (VT_PAGE_SIZE - 1)) / VT_PAGE_SIZE;
+}
+
+void vt_request(int tile, int mip, ivec2 page)
+{
+  /* Only one pixel out of 64 reports, at a different location each frame. */
+  if (any(notEqual(ivec2(gl_FragCoord.xy) & 7, vt_feedback_offset))) {
+    return;
+  }
+  uint index = atomicAdd(vt_feedback_len, 1u);
+  if (index < uint(VT_FEEDBACK_LEN)) {
+    vt_feedback[index] = (uint(tile) << 22u) | (uint(mip) << 18u) | (uint(page.y) << 9u) |
+                         uint(page.x);
+  }
+}
+
+vec4 virtual_texture_sample(int tile, vec2 uv)
+{
+  uv = clamp(uv, 0.0, 1.0);
+  vec2 texel = uv * vec2(vt_tile_size);
+  vec2 texel_dx = dFdx(texel);
+  vec2 texel_dy = dFdy(texel);
+  float lod = 0.5 * log2(max(max(dot(texel_dx, texel_dx), dot(texel_dy, texel_dy)), 1e-8));
+  int mip = clamp(int(floor(lod)), 0, vt_mip_len - 1);
+
+  /* Fall back to coarser levels until a resident page is found. */
+  for (int level = mip; level < vt_mip_len; level++) {
+    vec2 level_texel = uv * vec2(vt_level_size(level));
+    ivec2 page = min(ivec2(level_texel) / VT_PAGE_SIZE, vt_level_pages(level) - 1);
+    if (level == mip) {
+      vt_request(tile, level, page);
+    }
+    uint base = vt_page_table[tile * vt_mip_len + level];
+    uint entry = vt_page_table[base + uint(page.y * vt_level_pages(level).x + page.x)];
+    if (entry == 0u) {
+      continue;
+    }
+    int slot = int(entry) - 1;
+    ivec2 slot_origin = ivec2(slot % vt_cache_slots_x, slot / vt_cache_slots_x) *
+                            (VT_PAGE_SIZE + 2 * VT_PAGE_BORDER) +
+                        VT_PAGE_BORDER;
+    vec2 co = vec2(slot_origin) + level_texel - vec2(page * VT_PAGE_SIZE);
+    return textureLod(vt_cache_tx, co / vec2(textureSize(vt_cache_tx, 0)), 0.0);
+  }
+  return vec4(0.0);
+}
+)";
+
+/** Same packing as `vt_request` in the shader library. */
+static inline uint32_t page_key(int tile, int mip, int x, int y)
+{
+  return (uint32_t(tile) << 22) | (uint32_t(mip) << 18) | (uint32_t(y) << 9) | uint32_t(x);
+}
+
+struct PageCoord {
+  int tile, mip, x, y;
+};
+
+static inline PageCoord page_coord(uint32_t key)
+{
+  return {int(key >> 22), int((key >> 18) & 0xF), int(key & 0x1FF), int((key >> 9) & 0x1FF)};
+}
+
+struct PageSlot {
+  uint32_t key;
+  uint64_t last_use;
+  /** Coarsest page of a tile, never evicted. */
+  bool pinned;
+};
+
+struct LoadedPage {
+  uint32_t key;
+  /** #PAGE_SLOT_SIZE squared RGBA float texels. */
+  float *pixels;
+};
+
+class VirtualTexture {
+ private:
+  int tile_len_;
+  int tile_size_[2];
+  /** Levels down to the first one fitting in a single page. */
+  int mip_len_;
+  GPUVirtualPageLoadFn load_fn_;
+  void *user_data_;
+
+  /* Physical cache. */
+  GPUTexture *cache_ = nullptr;
+  int slots_x_;
+  Vector<PageSlot> slots_;
+  Vector<int> free_slots_;
+
+  /**
+   * Offset of the pages of each tile and level, followed by one entry per page.
+   * An entry is zero if the page is not resident, its slot index plus one otherwise.
+   */
+  Vector<uint32_t> page_table_;
+  GPUStorageBuf *page_table_buf_ = nullptr;
+  bool page_table_dirty_ = true;
+
+  GPUStorageBuf *feedback_[GPU_VIRTUAL_FEEDBACK_RING_LEN];
+  /** Buffer written by the current frame. */
+  int feedback_index_ = 0;
+  /** Copies of the feedback of the previous frames, oldest first. */
+  Vector<GPUReadback *> feedback_readbacks_;
+  uint64_t frame_ = 1;
+
+  /** Pages requested and not yet uploaded. Only accessed from the main thread. */
+  Set<uint32_t> pending_;
+
+  /* Loader thread. */
+  std::thread worker_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool exit_ = false;
+  /** Pages to load, the last one first. */
+  Vector<uint32_t> requests_;
+  /** Loaded pages waiting for upload, oldest first. */
+  Vector<LoadedPage> loaded_;
+
+ public:
+  GPUVirtualTextureStats stats = {};
+
+  VirtualTexture(const char *name,
+                 int tile_len,
+                 int tile_width,
+                 int tile_height,
+                 eGPUTextureFormat cache_format,
+                 int cache_page_len,
+                 GPUVirtualPageLoadFn load_fn,
+                 void *user_data)
+      : tile_len_(tile_len), load_fn_(load_fn), user_data_(user_data)
+  {
+    LIB_assert(tile_len > 0 && tile_len <= PAGE_TILE_MAX);
+    LIB_assert(cache_page_len > tile_len);
+    tile_size_[0] = tile_width;
+    tile_size_[1] = tile_height;
+    LIB_assert(this->level_pages(0, 0) <= PAGE_COORD_MAX &&
+               this->level_pages(0, 1) <= PAGE_COORD_MAX);
+
+    mip_len_ = 1;
+    while (this->level_pages(mip_len_ - 1, 0) > 1 || this->level_pages(mip_len_ - 1, 1) > 1) {
+      mip_len_++;
+    }
+    LIB_assert(mip_len_ <= PAGE_MIP_MAX);
+
+    /* Page table. */
+    page_table_.resize(tile_len_ * mip_len_);
+    for (int tile = 0; tile < tile_len_; tile++) {
+      for (int mip = 0; mip < mip_len_; mip++) {
+        page_table_[tile * mip_len_ + mip] = uint32_t(page_table_.size());
+        page_table_.append_n_times(0, this->level_pages(mip, 0) * this->level_pages(mip, 1));
+      }
+    }
+    page_table_buf_ = GPU_storagebuf_create_ex(
+        sizeof(uint32_t) * page_table_.size(), nullptr, GPU_USAGE_DYNAMIC, "vt_page_table");
+
+    /* Cache, as square as possible. */
+    slots_x_ = int(ceilf(sqrtf(float(cache_page_len))));
+    const int slots_y = divide_ceil_u(cache_page_len, slots_x_);
+    cache_ = GPU_texture_create_2d(
+        name, slots_x_ * PAGE_SLOT_SIZE, slots_y * PAGE_SLOT_SIZE, 1, cache_format, nullptr);
+    if (cache_) {
+      GPU_texture_filter_mode(cache_, true);
+      GPU_texture_memory_category_set(cache_, GPU_MEMORY_CATEGORY_IMAGE);
+    }
+    slots_.resize(slots_x_ * slots_y);
+    for (int slot = int(slots_.size()) - 1; slot >= 0; slot--) {
+      free_slots_.append(slot);
+    }
+
+    /* Feedback, the buffers that were not written yet are read as empty. */
+    for (int i = 0; i < GPU_VIRTUAL_FEEDBACK_RING_LEN; i++) {
+      feedback_[i] = GPU_storagebuf_create_ex(
+          FEEDBACK_BUF_SIZE, nullptr, GPU_USAGE_DYNAMIC, "vt_feedback");
+      GPU_storagebuf_clear_to_zero(feedback_[i]);
+    }
+
+    /* The coarsest pages are the fallback of every other page. */
+    for (int tile = 0; tile < tile_len_; tile++) {
+      const uint32_t key = page_key(tile, mip_len_ - 1, 0, 0);
+      pending_.add(key);
+      requests_.append(key);
+    }
+    stats.pending_len = tile_len_;
+
+    worker_ = std::thread([this]() { this->worker_run(); });
+  }
+
+  ~VirtualTexture()
+  {
+    {
+      std::scoped_lock lock(mutex_);
+      exit_ = true;
+    }
+    condition_.notify_all();
+    worker_.join();
+
+    for (const LoadedPage &page : loaded_) {
+      MEM_freeN(page.pixels);
+    }
+    GPU_TEXTURE_FREE_SAFE(cache_);
+    GPU_storagebuf_free(page_table_buf_);
+    for (GPUStorageBuf *feedback : feedback_) {
+      GPU_storagebuf_free(feedback);
+    }
+    for (GPUReadback *readback : feedback_readbacks_) {
+      GPU_readback_free(readback);
+    }
+  }
+
+  bool is_valid() const
+  {
+    return cache_ != nullptr;
+  }
+
+  void update()
+  {
+    frame_++;
+    this->feedback_process();
+    this->pages_upload();
+    if (page_table_dirty_) {
+      GPU_storagebuf_update(page_table_buf_, page_table_.data());
+      page_table_dirty_ = false;
+    }
+  }
+
+  void bind(GPUShader *shader)
+  {
+    const int cache_binding = GPU_shader_get_texture_binding(shader, "vt_cache_tx");
+    if (cache_binding != -1) {
+      GPU_texture_bind(cache_, cache_binding);
+    }
+    const int page_table_binding = GPU_shader_get_ssbo(shader, "vt_page_table_buf");
+    if (page_table_binding != -1) {
+      GPU_storagebuf_bind(page_table_buf_, page_table_binding);
+    }
+    const int feedback_binding = GPU_shader_get_ssbo(shader, "vt_feedback_buf");
+    if (feedback_binding != -1) {
+      GPU_storagebuf_bind(feedback_[feedback_index_], feedback_binding);
+    }
+    const int feedback_offset[2] = {int(frame_ % 8), int((frame_ / 8) % 8)};
+    GPU_shader_uniform_2iv(shader, "vt_tile_size", tile_size_);
+    GPU_shader_uniform_1i(shader, "vt_mip_len", mip_len_);
+    GPU_shader_uniform_1i(shader, "vt_cache_slots_x", slots_x_);
+    GPU_shader_uniform_2iv(shader, "vt_feedback_offset", feedback_offset);
+  }
+
+ private:
+  int level_pages(int mip, int axis) const
+  {
+    return divide_ceil_u(max_ii(1, tile_size_[axis] >> mip), GPU_VIRTUAL_PAGE_SIZE);
+  }
+
+  uint32_t &page_entry(const PageCoord &coord)
+  {
+    const uint32_t base = page_table_[coord.tile * mip_len_ + coord.mip];
+    return page_table_[base + coord.y * this->level_pages(coord.mip, 0) + coord.x];
+  }
+
+  bool page_is_valid(const PageCoord &coord) const
+  {
+    return coord.tile < tile_len_ && coord.mip < mip_len_ &&
+           coord.x < this->level_pages(coord.mip, 0) && coord.y < this->level_pages(coord.mip, 1);
+  }
+
+  /**
+   * Copy the requests of the frame that just ended, and queue the missing pages of the copies
+   * that are done. Only waits for a copy if more than #GPU_VIRTUAL_FEEDBACK_RING_LEN are late.
+   */
+  void feedback_process()
+  {
+    GPUStorageBuf *feedback = feedback_[feedback_index_];
+    feedback_readbacks_.append(GPU_storagebuf_read_async(feedback, FEEDBACK_BUF_SIZE));
+    GPU_storagebuf_clear_to_zero(feedback);
+    /* The oldest buffer is written again by the coming frame. */
+    feedback_index_ = (feedback_index_ + 1) % GPU_VIRTUAL_FEEDBACK_RING_LEN;
+
+    while (!feedback_readbacks_.is_empty()) {
+      GPUReadback *readback = feedback_readbacks_.first();
+      if (!GPU_readback_is_ready(readback) &&
+          feedback_readbacks_.size() <= GPU_VIRTUAL_FEEDBACK_RING_LEN) {
+        break;
+      }
+      this->feedback_requests_add(static_cast<const uint32_t *>(GPU_readback_data_get(readback)));
+      GPU_readback_free(readback);
+      feedback_readbacks_.remove(0);
+    }
+  }
+
+  /** Queue the missing pages of \a feedback_data, the content of a feedback buffer. */
+  void feedback_requests_add(const uint32_t *feedback_data)
+  {
+    const uint32_t request_len = min_uu(feedback_data[0], GPU_VIRTUAL_FEEDBACK_LEN);
+    Vector<uint32_t> new_requests;
+    for (uint32_t i = 0; i < request_len; i++) {
+      PageCoord coord = page_coord(feedback_data[1 + i]);
+      if (!this->page_is_valid(coord)) {
+        continue;
+      }
+      /* Also keep the coarser levels used as fallback. */
+      for (; coord.mip < mip_len_; coord.mip++, coord.x /= 2, coord.y /= 2) {
+        const uint32_t entry = this->page_entry(coord);
+        if (entry != 0) {
+          slots_[entry - 1].last_use = frame_;
+          continue;
+        }
+        const uint32_t key = page_key(coord.tile, coord.mip, coord.x, coord.y);
+        if (pending_.add(key)) {
+          new_requests.append(key);
+        }
+      }
+    }
+    if (new_requests.is_empty()) {
+      return;
+    }
+    /* Coarse levels are loaded first since they are the fallback of the finer ones. */
+    std::sort(new_requests.begin(), new_requests.end(), [](uint32_t a, uint32_t b) {
+      return page_coord(a).mip < page_coord(b).mip;
+    });
+    stats.pending_len += int(new_requests.size());
+    {
+      std::scoped_lock lock(mutex_);
+      requests_.extend(new_requests);
+    }
+    condition_.notify_one();
+  }
+
+  void pages_upload()
+  {
+    Vector<LoadedPage> uploads;
+    {
+      std::scoped_lock lock(mutex_);
+      const int64_t upload_len = min_ii(int(loaded_.size()), GPU_VIRTUAL_UPLOAD_MAX);
+      for (int64_t i = 0; i < loaded_.size(); i++) {
+        if (i < upload_len) {
+          uploads.append(loaded_[i]);
+        }
+        else {
+          loaded_[i - upload_len] = loaded_[i];
+        }
+      }
+      loaded_.resize(loaded_.size() - upload_len);
+    }
+
+    GPU_unpack_row_length_set(0);
+    int64_t uploaded_len = 0;
+    for (; uploaded_len < uploads.size(); uploaded_len++) {
+      const LoadedPage &page = uploads[uploaded_len];
+      const int slot = this->slot_alloc();
+      if (slot == -1) {
+        /* Every page is in use by the current frame, retry on the next one. */
+        break;
+      }
+      pending_.remove(page.key);
+      stats.pending_len--;
+      GPU_texture_update_sub(cache_,
+                             GPU_DATA_FLOAT,
+                             page.pixels,
+                             (slot % slots_x_) * PAGE_SLOT_SIZE,
+                             (slot / slots_x_) * PAGE_SLOT_SIZE,
+                             0,
+                             PAGE_SLOT_SIZE,
+                             PAGE_SLOT_SIZE,
+                             1);
+      MEM_freeN(page.pixels);
+
+      const PageCoord coord = page_coord(page.key);
+      slots_[slot] = {page.key, frame_, coord.mip == mip_len_ - 1};
+      this->page_entry(coord) = uint32_t(slot + 1);
+      page_table_dirty_ = true;
+      stats.resident_len++;
+      stats.loaded_len++;
+    }
+
+    if (uploaded_len < uploads.size()) {
+      /* Put the remaining pages back in front of the queue, in the same order. */
+      std::scoped_lock lock(mutex_);
+      Vector<LoadedPage> remaining(uploads.as_span().drop_front(uploaded_len));
+      remaining.extend(loaded_);
+      loaded_ = std::move(remaining);
+    }
+  }
+
+  /** Return a free slot, evicting the least recently used page if needed. -1 if none. */
+  int slot_alloc()
+  {
+    if (!free_slots_.is_empty()) {
+      return free_slots_.pop_last();
+    }
+    int lru = -1;
+    for (const int slot : slots_.index_range()) {
+      const PageSlot &page = slots_[slot];
+      if (page.pinned || page.last_use >= frame_) {
+        continue;
+      }
+      if (lru == -1 || page.last_use < slots_[lru].last_use) {
+        lru = slot;
+      }
+    }
+    if (lru != -1) {
+      this->page_entry(page_coord(slots_[lru].key)) = 0;
+      page_table_dirty_ = true;
+      stats.resident_len--;
+      stats.evicted_len++;
+    }
+    return lru;
+  }
+
+  void worker_run()
+  {
+    const size_t pixels_size = sizeof(float[4]) * PAGE_SLOT_SIZE * PAGE_SLOT_SIZE;
+    while (true) {
+      uint32_t key;
+      {
+        std::unique_lock lock(mutex_);
+        condition_.wait(lock, [&]() { return exit_ || !requests_.is_empty(); });
+        if (exit_) {
+          return;
+        }
+        key = requests_.pop_last();
+      }
+
+      const PageCoord coord = page_coord(key);
+      float *pixels = (float *)MEM_mallocN(pixels_size, "vt_page");
+      const bool loaded = load_fn_(user_data_,
+                                   coord.tile,
+                                   coord.mip,
+                                   coord.x * GPU_VIRTUAL_PAGE_SIZE - GPU_VIRTUAL_PAGE_BORDER,
+                                   coord.y * GPU_VIRTUAL_PAGE_SIZE - GPU_VIRTUAL_PAGE_BORDER,
+                                   PAGE_SLOT_SIZE,
+                                   PAGE_SLOT_SIZE,
+                                   pixels);
+      if (!loaded) {
+        memset(pixels, 0, pixels_size);
+      }
+
+      std::scoped_lock lock(mutex_);
+      loaded_.append({key, pixels});
+    }
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("VirtualTexture");
+};
+
+}  // namespace dust::gpu
+
+/* -------------------------------------------------------------------- */
+/* C-API */
+
+using namespace dust::gpu;
+
+GPUVirtualTexture *GPU_virtual_texture_create(const char *name,
+                                              int tile_len,
+                                              int tile_width,
+                                              int tile_height,
+                                              eGPUTextureFormat cache_format,
+                                              int cache_page_len,
+                                              GPUVirtualPageLoadFn load_fn,
+                                              void *user_data)
+{
+  VirtualTexture *vt = new VirtualTexture(
+      name, tile_len, tile_width, tile_height, cache_format, cache_page_len, load_fn, user_data);
+  if (!vt->is_valid()) {
+    delete vt;
+    return nullptr;
+  }
+  return reinterpret_cast<GPUVirtualTexture *>(vt);
+}
+
+void GPU_virtual_texture_free(GPUVirtualTexture *vt)
+{
+  delete reinterpret_cast<VirtualTexture *>(vt);
+}
+
+void GPU_virtual_texture_update(GPUVirtualTexture *vt)
+{
+  reinterpret_cast<VirtualTexture *>(vt)->update();
+}
+
+void GPU_virtual_texture_bind(GPUVirtualTexture *vt, GPUShader *shader)
+{
+  reinterpret_cast<VirtualTexture *>(vt)->bind(shader);
+}
+
+const char *GPU_virtual_texture_shader_lib()
+{
+  return virtual_texture_lib_glsl;
+}
+
+void GPU_virtual_texture_stats_get(GPUVirtualTexture *vt, GPUVirtualTextureStats *r_stats)
+{
+  *r_stats = reinterpret_cast<VirtualTexture *>(vt)->stats;
+}
@@ -0,0 +1,149 @@
+#include <initializer_list>
+
+#include "null_backend.hh"
+#include "null_batch.hh"
+#include "null_context.hh"
+#include "null_framebuffer.hh"
+#include "null_index_buffer.hh"
+#include "null_query.hh"
+#include "null_shader.hh"
+#include "null_storage_buffer.hh"
+#include "null_texture.hh"
+#include "null_uniform_buffer.hh"
+#include "null_vertex_buffer.hh"
+
+#include "gpu_batch_instancer_private.hh"
+#include "gpu_drawlist_indirect.hh"
+#include "gpu_pipeline_cache_private.hh"
+#include "gpu_render_queue_private.hh"
+#include "gpu_sampler_private.hh"
+
+namespace dust::gpu {
+
+NullStats NullBackend::stats;
+
+void NullStats::reset()
+{
+  for (std::atomic<uint64_t> *counter : {&draw_calls,
+                                         &compute_dispatches,
+                                         &imm_draws,
+                                         &state_changes,
+                                         &shader_binds,
+                                         &texture_binds,
+                                         &framebuffer_binds,
+                                         &framebuffer_clears,
+                                         &framebuffer_reads,
+                                         &framebuffer_blits,
+                                         &texture_uploads,
+                                         &texture_upload_bytes,
+                                         &texture_reads,
+                                         &buffer_uploads,
+                                         &buffer_upload_bytes})
+  {
+    *counter = 0;
+  }
+  /* Objects of a previous back-end are gone by now, live counts restart as well. */
+  textures_len = 0;
+  texture_memory = 0;
+  buffers_len = 0;
+  buffer_memory = 0;
+}
+
+/* -------------------------------------------------------------------- */
+/* Back-end */
+
+NullBackend::NullBackend()
+{
+  /* Each back-end instance starts from a clean slate so that consecutive profiling runs inside
+   * the same process are comparable. */
+  stats.reset();
+}
+
+NullBackend::~NullBackend()
+{
+  NullBackend::delete_resources();
+}
+
+void NullBackend::delete_resources()
+{
+  /* Nothing is ever allocated on a device, but the pipeline keys refer to the shaders. */
+  PipelineCache::get().clear();
+}
+
+void NullBackend::compute_dispatch(int /*groups_x_len*/,
+                                   int /*groups_y_len*/,
+                                   int /*groups_z_len*/)
+{
+  stats.compute_dispatches++;
+}
+
+void NullBackend::compute_dispatch_indirect(StorageBuf * /*indirect_buf*/)
+{
+  stats.compute_dispatches++;
+}
+
+void NullBackend::render_step()
+{
+  SamplerTable::get().frame_step();
+  RenderQueue::stats.frame_step();
+  ImmediateRing::stats.frame_step();
+  BatchInstancer::stats.frame_step();
+  PipelineCache::stats.frame_step();
+}
+
+Context *NullBackend::context_alloc(void *ghost_window, void * /*ghost_context*/)
+{
+  return new NullContext(ghost_window);
+}
+
+Batch *NullBackend::batch_alloc()
+{
+  return new NullBatch();
+}
+
+DrawList *NullBackend::drawlist_alloc(int list_length)
+{
+  return new IndirectDrawList(list_length, true);
+}
+
+FrameBuffer *NullBackend::framebuffer_alloc(const char *name)
+{
+  return new NullFrameBuffer(name);
+}
+
+IndexBuf *NullBackend::indexbuf_alloc()
+{
+  return new NullIndexBuf();
+}
+
+QueryPool *NullBackend::querypool_alloc()
+{
+  return new NullQueryPool();
+}
+
+Shader *NullBackend::shader_alloc(const char *name)
+{
+  return new NullShader(name);
+}
+
+Texture *NullBackend::texture_alloc(const char *name)
+{
+  return new NullTexture(name);
+}
+
+UniformBuf *NullBackend::uniformbuf_alloc(int size, const char *name)
+{
+  return new NullUniformBuf(size, name);
+}
+
+StorageBuf *NullBackend::storagebuf_alloc(int size, GPUUsageType /*usage*/, const char *name)
+{
+  return new NullStorageBuf(size, name);
+}
+
+VertBuf *NullBackend::vertbuf_alloc()
+{
+  return new NullVertBuf();
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,78 @@
+/*
+ * Null back-end.
+ * Implements every GPU object without issuing any device call. Objects still keep their
+ * CPU side state (sizes, attachments, bindings, host copies of buffer data) so the whole GPU
+ * module can run and be profiled on machines without a GPU.
+ */
+
+#pragma once
+
+#include <atomic>
+
+#include "gpu_backend.hh"
+
+namespace dust::gpu {
+
+/**
+ * Counters updated by all null objects. Cumulative since the back-end was created.
+ * Atomic since buffers and textures can be created from any thread.
+ */
+struct NullStats {
+  std::atomic<uint64_t> draw_calls = 0;
+  std::atomic<uint64_t> compute_dispatches = 0;
+  std::atomic<uint64_t> imm_draws = 0;
+  std::atomic<uint64_t> state_changes = 0;
+  std::atomic<uint64_t> shader_binds = 0;
+  std::atomic<uint64_t> texture_binds = 0;
+  std::atomic<uint64_t> framebuffer_binds = 0;
+  std::atomic<uint64_t> framebuffer_clears = 0;
+  std::atomic<uint64_t> framebuffer_reads = 0;
+  std::atomic<uint64_t> framebuffer_blits = 0;
+  std::atomic<uint64_t> texture_uploads = 0;
+  std::atomic<uint64_t> texture_upload_bytes = 0;
+  std::atomic<uint64_t> texture_reads = 0;
+  std::atomic<uint64_t> buffer_uploads = 0;
+  std::atomic<uint64_t> buffer_upload_bytes = 0;
+
+  /** Live objects and the size of the device memory they would use. */
+  std::atomic<int64_t> textures_len = 0;
+  std::atomic<int64_t> texture_memory = 0;
+  std::atomic<int64_t> buffers_len = 0;
+  std::atomic<int64_t> buffer_memory = 0;
+
+  void reset();
+};
+
+class NullBackend : public GPUBackend {
+ public:
+  static NullStats stats;
+
+ public:
+  NullBackend();
+  ~NullBackend();
+
+  void delete_resources() override;
+
+  void samplers_update() override{};
+  void compute_dispatch(int groups_x_len, int groups_y_len, int groups_z_len) override;
+  void compute_dispatch_indirect(StorageBuf *indirect_buf) override;
+
+  Context *context_alloc(void *ghost_window, void *ghost_context) override;
+
+  Batch *batch_alloc() override;
+  DrawList *drawlist_alloc(int list_length) override;
+  FrameBuffer *framebuffer_alloc(const char *name) override;
+  IndexBuf *indexbuf_alloc() override;
+  QueryPool *querypool_alloc() override;
+  Shader *shader_alloc(const char *name) override;
+  Texture *texture_alloc(const char *name) override;
+  UniformBuf *uniformbuf_alloc(int size, const char *name) override;
+  StorageBuf *storagebuf_alloc(int size, GPUUsageType usage, const char *name) override;
+  VertBuf *vertbuf_alloc() override;
+
+  void render_begin() override{};
+  void render_end() override{};
+  void render_step() override;
+};
+
+}  // namespace dust::gpu
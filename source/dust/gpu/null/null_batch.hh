@@ -0,0 +1,83 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_batch_private.hh"
+#include "gpu_context_private.hh"
+#include "gpu_pipeline_cache_private.hh"
+#include "gpu_vertex_buffer_private.hh"
+
+#include "null_backend.hh"
+
+namespace dust::gpu {
+
+/**
+ * Batch which only applies the pending state and counts its draws.
+ * Pipelines are looked up like a back-end with pipeline objects does, to profile the cache.
+ */
+class NullBatch : public Batch {
+ public:
+  void draw(int /*v_first*/, int /*v_count*/, int /*i_first*/, int /*i_count*/) override
+  {
+    imm_flush_merged();
+    Context::get()->state_manager->apply_state();
+    this->pipeline_get();
+    NullBackend::stats.draw_calls++;
+  }
+
+  void draw_indirect(GPUStorageBuf * /*indirect_buf*/, intptr_t /*offset*/) override
+  {
+    imm_flush_merged();
+    Context::get()->state_manager->apply_state();
+    this->pipeline_get();
+    NullBackend::stats.draw_calls++;
+  }
+
+  void multi_draw_indirect(GPUStorageBuf * /*indirect_buf*/,
+                           int count,
+                           intptr_t /*offset*/,
+                           intptr_t /*stride*/) override
+  {
+    imm_flush_merged();
+    Context::get()->state_manager->apply_state();
+    this->pipeline_get();
+    NullBackend::stats.draw_calls += count;
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullBatch");
+
+ private:
+  /** Layout of the last shader drawn with, rebuilt when the batch is dirty. */
+  PipelineVertexLayout vertex_layout_;
+  const Shader *vertex_layout_shader_ = nullptr;
+
+  void pipeline_get()
+  {
+    Shader *shader = Context::get()->shader;
+    if (shader == nullptr) {
+      return;
+    }
+    if (shader != vertex_layout_shader_ || (flag & GPU_BATCH_DIRTY)) {
+      const GPUVertFormat *vertex_formats[GPU_BATCH_VBO_MAX_LEN];
+      const GPUVertFormat *instance_formats[GPU_BATCH_INST_VBO_MAX_LEN];
+      for (int v = 0; v < GPU_BATCH_VBO_MAX_LEN; v++) {
+        VertBuf *vbo = this->verts_(v);
+        vertex_formats[v] = vbo ? &vbo->format : nullptr;
+      }
+      for (int v = 0; v < GPU_BATCH_INST_VBO_MAX_LEN; v++) {
+        VertBuf *vbo = this->inst_(v);
+        instance_formats[v] = vbo ? &vbo->format : nullptr;
+      }
+      PipelineCache::vertex_layout_build(
+          *shader,
+          Span<const GPUVertFormat *>(vertex_formats, GPU_BATCH_VBO_MAX_LEN),
+          Span<const GPUVertFormat *>(instance_formats, GPU_BATCH_INST_VBO_MAX_LEN),
+          vertex_layout_);
+      vertex_layout_shader_ = shader;
+      flag &= ~GPU_BATCH_DIRTY;
+    }
+    PipelineCache::get().pipeline_get(*shader, prim_type, vertex_layout_);
+  }
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,106 @@
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+
+#include "null_backend.hh"
+#include "null_context.hh"
+#include "null_framebuffer.hh"
+#include "null_immediate.hh"
+#include "null_state.hh"
+
+namespace dust::gpu {
+
+/* Size of the default frame-buffers. There is no window surface to query so use a common
+ * window size, large enough for region drawing code to behave as usual. */
+#define NULL_WINDOW_DEFAULT_WIDTH 1920
+#define NULL_WINDOW_DEFAULT_HEIGHT 1080
+
+/* Amount of device memory reported by #memory_statistics_get (in KiB like other back-ends). */
+#define NULL_DEVICE_MEMORY_KB (4 * 1024 * 1024)
+
+/* Anisotropic filter limit of common desktop hardware. */
+#define NULL_ANISOTROPY_MAX 16.0f
+
+/* -------------------------------------------------------------------- */
+/* Constructor / Destructor */
+
+NullContext::NullContext(void *ghost_window)
+{
+  ghost_window_ = ghost_window;
+
+  SamplerTable::get().init(NULL_ANISOTROPY_MAX);
+  state_manager = new NullStateManager();
+  imm = new NullImmediate();
+
+  /* Window frame-buffers are always valid, even for off-screen contexts, so that code drawing to
+   * the back-buffer does not need to special case this back-end. */
+  NullFrameBuffer *back = new NullFrameBuffer("back_left");
+  back->size_set(NULL_WINDOW_DEFAULT_WIDTH, NULL_WINDOW_DEFAULT_HEIGHT);
+  back->viewport_reset();
+  back->scissor_reset();
+  NullFrameBuffer *front = new NullFrameBuffer("front_left");
+  front->size_set(NULL_WINDOW_DEFAULT_WIDTH, NULL_WINDOW_DEFAULT_HEIGHT);
+  front->viewport_reset();
+  front->scissor_reset();
+
+  back_left = back;
+  front_left = front;
+  active_fb = back_left;
+}
+
+NullContext::~NullContext()
+{
+  /* Frame-buffers, state manager and immediate are freed by the base class. */
+  LIB_assert(!in_frame_);
+}
+
+/* -------------------------------------------------------------------- */
+/* Activate / Deactivate context */
+
+void NullContext::activate()
+{
+  /* Make sure no other context is already bound to this thread. */
+  LIB_assert(is_active_ == false);
+
+  is_active_ = true;
+  thread_ = pthread_self();
+
+  /* Same as the other back-ends: the window size might have changed while inactive. */
+  back_left->viewport_reset();
+  back_left->scissor_reset();
+
+  immActivate();
+}
+
+void NullContext::deactivate()
+{
+  imm_flush_merged();
+  immDeactivate();
+  is_active_ = false;
+}
+
+void NullContext::begin_frame()
+{
+  LIB_assert(!in_frame_);
+  in_frame_ = true;
+}
+
+void NullContext::end_frame()
+{
+  LIB_assert(in_frame_);
+  imm_flush_merged();
+  in_frame_ = false;
+  frame_count_++;
+}
+
+/* -------------------------------------------------------------------- */
+/* Memory Management */
+
+void NullContext::memory_statistics_get(int *total_mem, int *free_mem)
+{
+  const int64_t used_kb = (NullBackend::stats.texture_memory + NullBackend::stats.buffer_memory) /
+                          1024;
+  *total_mem = NULL_DEVICE_MEMORY_KB;
+  *free_mem = int(max_ii(0, NULL_DEVICE_MEMORY_KB - int(used_kb)));
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "gpu_context_private.hh"
+
+namespace dust::gpu {
+
+class NullContext : public Context {
+ private:
+  /** Number of begin_frame() / end_frame() pairs. */
+  uint64_t frame_count_ = 0;
+  bool in_frame_ = false;
+
+ public:
+  NullContext(void *ghost_window);
+  ~NullContext();
+
+  void activate() override;
+  void deactivate() override;
+  void begin_frame() override;
+  void end_frame() override;
+
+  void flush() override
+  {
+    imm_flush_merged();
+  }
+  void finish() override
+  {
+    imm_flush_merged();
+  }
+
+  void memory_statistics_get(int *total_mem, int *free_mem) override;
+
+  uint64_t frame_count_get() const
+  {
+    return frame_count_;
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullContext");
+};
+
+}  // namespace dust::gpu
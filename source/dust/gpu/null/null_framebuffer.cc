@@ -0,0 +1,180 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_string.h"
+
+#include "gpu_context_private.hh"
+#include "gpu_texture_private.hh"
+
+#include "null_backend.hh"
+#include "null_framebuffer.hh"
+
+namespace dust::gpu {
+
+/* -------------------------------------------------------------------- */
+/* Creation & Deletion */
+
+NullFrameBuffer::NullFrameBuffer(const char *name) : FrameBuffer(name)
+{
+  for (int i = 0; i < GPU_FB_MAX_ATTACHMENT; i++) {
+    load_ops_[i] = GPU_LOADACTION_LOAD;
+    store_ops_[i] = GPU_STOREACTION_STORE;
+  }
+}
+
+NullFrameBuffer::~NullFrameBuffer()
+{
+  Context *ctx = Context::get();
+  if (ctx && ctx->active_fb == this) {
+    ctx->active_fb = nullptr;
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Config */
+
+void NullFrameBuffer::update_attachments()
+{
+  /* The first valid attachment gives the frame-buffer size. */
+  for (GPUAttachmentType type = GPU_FB_MAX_ATTACHMENT - 1; type >= 0; --type) {
+    const GPUAttachment &attach = attachments_[type];
+    if (attach.tex == nullptr) {
+      continue;
+    }
+    int size[3];
+    unwrap(attach.tex)->mip_size_get(attach.mip, size);
+    this->size_set(size[0], size[1]);
+  }
+  dirty_attachments_ = false;
+}
+
+bool NullFrameBuffer::check(char err_out[256])
+{
+  this->bind(true);
+
+  int size[2] = {-1, -1};
+  const char *err = nullptr;
+
+  for (const GPUAttachment &attach : attachments_) {
+    if (attach.tex == nullptr) {
+      continue;
+    }
+    int mip_size[3];
+    unwrap(attach.tex)->mip_size_get(attach.mip, mip_size);
+    if (size[0] == -1) {
+      size[0] = mip_size[0];
+      size[1] = mip_size[1];
+    }
+    else if (size[0] != mip_size[0] || size[1] != mip_size[1]) {
+      err = "Attachments have different sizes";
+      break;
+    }
+  }
+
+  if (err) {
+    const char *format = "GPUFrameBuffer: %s framebuffer incomplete: %s\n";
+    if (err_out) {
+      LIB_snprintf(err_out, 256, format, name_, err);
+    }
+    else {
+      fprintf(stderr, format, name_, err);
+    }
+    return false;
+  }
+  return true;
+}
+
+void NullFrameBuffer::bind(bool enabled_srgb)
+{
+  imm_flush_merged();
+  Context *ctx = Context::get();
+  LIB_assert(ctx);
+
+  if (dirty_attachments_) {
+    this->update_attachments();
+    this->viewport_reset();
+    this->scissor_reset();
+  }
+
+  if (ctx->active_fb != this) {
+    ctx->active_fb = this;
+    NullBackend::stats.framebuffer_binds++;
+  }
+  dirty_state_ = false;
+  srgb_ = enabled_srgb;
+}
+
+/* -------------------------------------------------------------------- */
+/* Operations */
+
+void NullFrameBuffer::clear(eGPUFrameBufferBits buffers,
+                            const float /*clear_col*/[4],
+                            float /*clear_depth*/,
+                            uint /*clear_stencil*/)
+{
+  imm_flush_merged();
+  LIB_assert(Context::get()->active_fb == this);
+  UNUSED_VARS_NDEBUG(buffers);
+  NullBackend::stats.framebuffer_clears++;
+}
+
+void NullFrameBuffer::clear_multi(const float (*/*clear_col*/)[4])
+{
+  imm_flush_merged();
+  NullBackend::stats.framebuffer_clears++;
+}
+
+void NullFrameBuffer::clear_attachment(GPUAttachmentType type,
+                                       eGPUDataFormat /*data_format*/,
+                                       const void *clear_value)
+{
+  imm_flush_merged();
+  LIB_assert(attachments_[type].tex != nullptr);
+  LIB_assert(clear_value != nullptr);
+  UNUSED_VARS_NDEBUG(type, clear_value);
+  NullBackend::stats.framebuffer_clears++;
+}
+
+void NullFrameBuffer::attachment_set_loadstore_op(GPUAttachmentType type,
+                                                  eGPULoadOp load_action,
+                                                  eGPUStoreOp store_action)
+{
+  load_ops_[type] = load_action;
+  store_ops_[type] = store_action;
+}
+
+void NullFrameBuffer::read(eGPUFrameBufferBits planes,
+                           eGPUDataFormat format,
+                           const int area[4],
+                           int channel_len,
+                           int slot,
+                           void *r_data)
+{
+  imm_flush_merged();
+  LIB_assert((planes & GPU_STENCIL_BIT) == 0);
+  LIB_assert(area[2] > 0 && area[3] > 0);
+  UNUSED_VARS_NDEBUG(planes, slot);
+
+  const size_t size = size_t(area[2]) * area[3] * channel_len * to_bytesize(format);
+  memset(r_data, 0, size);
+  NullBackend::stats.framebuffer_reads++;
+}
+
+void NullFrameBuffer::blit_to(eGPUFrameBufferBits planes,
+                              int src_slot,
+                              FrameBuffer *dst,
+                              int dst_slot,
+                              int /*dst_offset_x*/,
+                              int /*dst_offset_y*/)
+{
+  imm_flush_merged();
+  LIB_assert(dst != nullptr);
+  if (planes & GPU_COLOR_BIT) {
+    LIB_assert(this->color_tex(src_slot) || this == Context::get()->back_left ||
+               this == Context::get()->front_left);
+  }
+  UNUSED_VARS_NDEBUG(src_slot, dst, dst_slot);
+  NullBackend::stats.framebuffer_blits++;
+}
+
+}  // namespace dust::gpu
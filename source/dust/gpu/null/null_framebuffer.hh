@@ -0,0 +1,59 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_framebuffer_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Frame-buffer keeping track of its attachments configuration and load/store actions.
+ * Attachment validation follows the same rules as a real back-end.
+ */
+class NullFrameBuffer : public FrameBuffer {
+ private:
+  eGPULoadOp load_ops_[GPU_FB_MAX_ATTACHMENT];
+  eGPUStoreOp store_ops_[GPU_FB_MAX_ATTACHMENT];
+  bool srgb_ = false;
+
+ public:
+  NullFrameBuffer(const char *name);
+  ~NullFrameBuffer();
+
+  void bind(bool enabled_srgb) override;
+  bool check(char err_out[256]) override;
+  void clear(eGPUFrameBufferBits buffers,
+             const float clear_col[4],
+             float clear_depth,
+             uint clear_stencil) override;
+  void clear_multi(const float (*clear_col)[4]) override;
+  void clear_attachment(GPUAttachmentType type,
+                        eGPUDataFormat data_format,
+                        const void *clear_value) override;
+
+  void attachment_set_loadstore_op(GPUAttachmentType type,
+                                   eGPULoadOp load_action,
+                                   eGPUStoreOp store_action) override;
+
+  void read(eGPUFrameBufferBits planes,
+            eGPUDataFormat format,
+            const int area[4],
+            int channel_len,
+            int slot,
+            void *r_data) override;
+
+  void blit_to(eGPUFrameBufferBits planes,
+               int src_slot,
+               FrameBuffer *dst,
+               int dst_slot,
+               int dst_offset_x,
+               int dst_offset_y) override;
+
+ private:
+  /** Update the size from the attachments. */
+  void update_attachments();
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullFrameBuffer");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,23 @@
+#include "gpu_context_private.hh"
+#include "gpu_pipeline_cache_private.hh"
+
+#include "null_backend.hh"
+#include "null_immediate.hh"
+
+namespace dust::gpu {
+
+void NullImmediate::draw(GPUPrimType prim_type,
+                         GPUShader *shader,
+                         const GPUVertFormat *format,
+                         const uchar * /*data*/,
+                         uint vertex_len)
+{
+  Context::get()->state_manager->apply_state();
+  PipelineCache::get().pipeline_get(
+      *unwrap(shader), prim_type, Span<const GPUVertFormat *>(&format, 1), {});
+  NullBackend::stats.imm_draws++;
+  NullBackend::stats.draw_calls++;
+  NullBackend::stats.buffer_upload_bytes += vertex_len * format->stride;
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_immediate_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Immediate mode emulation writing vertices into a host ring that is never uploaded.
+ * Uses the same ring logic as a real back-end, with fences that are always signaled.
+ */
+class NullImmediate : public Immediate {
+ public:
+  NullImmediate()
+  {
+    ring = new ImmediateRing();
+  };
+
+ protected:
+  void draw(GPUPrimType prim_type,
+            GPUShader *shader,
+            const GPUVertFormat *format,
+            const uchar *data,
+            uint vertex_len) override;
+
+ public:
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullImmediate");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,53 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+
+#include "null_backend.hh"
+#include "null_index_buffer.hh"
+
+namespace dust::gpu {
+
+NullIndexBuf::~NullIndexBuf()
+{
+  if (is_uploaded_) {
+    NullBackend::stats.buffers_len--;
+    NullBackend::stats.buffer_memory -= this->size_get();
+  }
+}
+
+void NullIndexBuf::upload_data()
+{
+  if (is_subrange_) {
+    static_cast<NullIndexBuf *>(src_)->upload_data();
+    return;
+  }
+  if (!is_uploaded_) {
+    is_uploaded_ = true;
+    NullBackend::stats.buffers_len++;
+    NullBackend::stats.buffer_memory += this->size_get();
+    NullBackend::stats.buffer_uploads++;
+    NullBackend::stats.buffer_upload_bytes += this->size_get();
+  }
+}
+
+void NullIndexBuf::bind_as_ssbo(uint /*binding*/)
+{
+  this->upload_data();
+}
+
+const uint32_t *NullIndexBuf::read() const
+{
+  LIB_assert(!is_subrange_ && data_ != nullptr);
+  return data_;
+}
+
+void NullIndexBuf::update_sub(uint start, uint len, const void *data)
+{
+  LIB_assert(!is_subrange_ && data_ != nullptr);
+  LIB_assert(start + len <= this->size_get());
+  memcpy((uchar *)data_ + start, data, len);
+  NullBackend::stats.buffer_uploads++;
+  NullBackend::stats.buffer_upload_bytes += len;
+}
+
+}  // namespace dust::gpu
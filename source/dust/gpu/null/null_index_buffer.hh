@@ -0,0 +1,30 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_index_buffer_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Index buffer keeping its host data, so reads return the uploaded indices.
+ * Sub-ranges alias their source buffer.
+ */
+class NullIndexBuf : public IndexBuf {
+ private:
+  bool is_uploaded_ = false;
+
+ public:
+  ~NullIndexBuf();
+
+  void upload_data() override;
+  void bind_as_ssbo(uint binding) override;
+
+  const uint32_t *read() const override;
+
+  void update_sub(uint start, uint len, const void *data) override;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullIndexBuf");
+};
+
+}  // namespace dust::gpu
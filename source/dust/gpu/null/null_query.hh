@@ -0,0 +1,45 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_assert.h"
+
+#include "gpu_query.hh"
+
+namespace dust::gpu {
+
+/** Query pool whose queries always report that nothing passed. */
+class NullQueryPool : public QueryPool {
+ private:
+  int query_issued_ = 0;
+  bool query_running_ = false;
+
+ public:
+  void init(GPUQueryType /*type*/) override
+  {
+    query_issued_ = 0;
+  }
+
+  void begin_query() override
+  {
+    LIB_assert(!query_running_);
+    query_running_ = true;
+  }
+
+  void end_query() override
+  {
+    LIB_assert(query_running_);
+    query_running_ = false;
+    query_issued_++;
+  }
+
+  void get_occlusion_result(MutableSpan<uint32_t> r_values) override
+  {
+    LIB_assert(r_values.size() <= query_issued_);
+    r_values.fill(0);
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullQueryPool");
+};
+
+}  // namespace dust::gpu
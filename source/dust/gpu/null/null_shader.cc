@@ -0,0 +1,139 @@
+#include "LIB_assert.h"
+
+#include "gpu_context_private.hh"
+#include "gpu_pipeline_cache_private.hh"
+
+#include "null_backend.hh"
+#include "null_shader.hh"
+#include "null_shader_interface.hh"
+
+namespace dust::gpu {
+
+/* -------------------------------------------------------------------- */
+/* Creation & Deletion */
+
+NullShader::NullShader(const char *name) : Shader(name)
+{
+}
+
+NullShader::~NullShader()
+{
+  imm_flush_merged();
+  PipelineCache::get().shader_free(this);
+  Context *ctx = Context::get();
+  if (ctx && ctx->shader == this) {
+    ctx->shader = nullptr;
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/* Shader stage creation */
+
+void NullShader::vertex_shader_from_glsl(MutableSpan<const char *> /*sources*/)
+{
+}
+
+void NullShader::geometry_shader_from_glsl(MutableSpan<const char *> /*sources*/)
+{
+}
+
+void NullShader::fragment_shader_from_glsl(MutableSpan<const char *> /*sources*/)
+{
+}
+
+void NullShader::compute_shader_from_glsl(MutableSpan<const char *> /*sources*/)
+{
+}
+
+bool NullShader::finalize(const shader::ShaderCreateInfo *info)
+{
+  LIB_assert(interface == nullptr);
+  interface = new NullShaderInterface(info);
+  if (info != nullptr) {
+    input_table.build(*interface, *info);
+  }
+  return true;
+}
+
+/* -------------------------------------------------------------------- */
+/* Transform feedback */
+
+void NullShader::transform_feedback_names_set(Span<const char *> /*name_list*/,
+                                              eGPUShaderTFBType /*geom_type*/)
+{
+}
+
+bool NullShader::transform_feedback_enable(GPUVertBuf * /*buf*/)
+{
+  return false;
+}
+
+void NullShader::transform_feedback_disable()
+{
+}
+
+/* -------------------------------------------------------------------- */
+/* Binding */
+
+void NullShader::bind()
+{
+  NullBackend::stats.shader_binds++;
+}
+
+void NullShader::unbind()
+{
+}
+
+void NullShader::uniform_float(int /*location*/,
+                               int /*comp_len*/,
+                               int /*array_size*/,
+                               const float * /*data*/)
+{
+  imm_flush_merged();
+}
+
+void NullShader::uniform_int(int /*location*/,
+                             int /*comp_len*/,
+                             int /*array_size*/,
+                             const int * /*data*/)
+{
+  imm_flush_merged();
+}
+
+/* -------------------------------------------------------------------- */
+/* Create Info
+ * Nothing is compiled, so no code needs to be generated. */
+
+std::string NullShader::resources_declare(const shader::ShaderCreateInfo & /*info*/) const
+{
+  return "";
+}
+
+std::string NullShader::vertex_interface_declare(const shader::ShaderCreateInfo & /*info*/) const
+{
+  return "";
+}
+
+std::string NullShader::fragment_interface_declare(
+    const shader::ShaderCreateInfo & /*info*/) const
+{
+  return "";
+}
+
+std::string NullShader::geometry_interface_declare(
+    const shader::ShaderCreateInfo & /*info*/) const
+{
+  return "";
+}
+
+std::string NullShader::geometry_layout_declare(const shader::ShaderCreateInfo & /*info*/) const
+{
+  return "";
+}
+
+std::string NullShader::compute_layout_declare(const shader::ShaderCreateInfo & /*info*/) const
+{
+  return "";
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_shader_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Shader that never compiles anything. Sources are ignored, the interface is built from the
+ * create info so uniform and resource lookups behave like on a real back-end.
+ */
+class NullShader : public Shader {
+ public:
+  NullShader(const char *name);
+  ~NullShader();
+
+  void vertex_shader_from_glsl(MutableSpan<const char *> sources) override;
+  void geometry_shader_from_glsl(MutableSpan<const char *> sources) override;
+  void fragment_shader_from_glsl(MutableSpan<const char *> sources) override;
+  void compute_shader_from_glsl(MutableSpan<const char *> sources) override;
+  bool finalize(const shader::ShaderCreateInfo *info = nullptr) override;
+
+  void transform_feedback_names_set(Span<const char *> name_list,
+                                    eGPUShaderTFBType geom_type) override;
+  bool transform_feedback_enable(GPUVertBuf *buf) override;
+  void transform_feedback_disable() override;
+
+  void bind() override;
+  void unbind() override;
+
+  void uniform_float(int location, int comp_len, int array_size, const float *data) override;
+  void uniform_int(int location, int comp_len, int array_size, const int *data) override;
+
+  std::string resources_declare(const shader::ShaderCreateInfo &info) const override;
+  std::string vertex_interface_declare(const shader::ShaderCreateInfo &info) const override;
+  std::string fragment_interface_declare(const shader::ShaderCreateInfo &info) const override;
+  std::string geometry_interface_declare(const shader::ShaderCreateInfo &info) const override;
+  std::string geometry_layout_declare(const shader::ShaderCreateInfo &info) const override;
+  std::string compute_layout_declare(const shader::ShaderCreateInfo &info) const override;
+
+  int program_handle_get() const override
+  {
+    return 0;
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullShader");
+};
+
+}  // namespace dust::gpu
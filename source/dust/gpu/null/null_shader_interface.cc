@@ -0,0 +1,123 @@
+#include "LIB_math_base.h"
+#include "LIB_vector.hh"
+
+#include "null_shader_interface.hh"
+
+namespace dust::gpu {
+
+using namespace shader;
+
+NullShaderInterface::NullShaderInterface(const ShaderCreateInfo *info)
+{
+  using BindType = ShaderCreateInfo::Resource::BindType;
+
+  Vector<ShaderCreateInfo::Resource> all_resources;
+  uint attr_len = 0, ubo_len = 0, uniform_len = 0, ssbo_len = 0;
+
+  if (info != nullptr) {
+    all_resources.extend(info->pass_resources_);
+    all_resources.extend(info->batch_resources_);
+
+    attr_len = info->vertex_inputs_.size();
+    uniform_len = info->push_constants_.size();
+    for (const ShaderCreateInfo::Resource &res : all_resources) {
+      switch (res.bind_type) {
+        case BindType::UNIFORM_BUFFER:
+          ubo_len++;
+          break;
+        case BindType::STORAGE_BUFFER:
+          ssbo_len++;
+          break;
+        case BindType::SAMPLER:
+          enabled_tex_mask_ |= 1llu << res.slot;
+          uniform_len++;
+          break;
+        case BindType::IMAGE:
+          enabled_ima_mask_ |= 1 << res.slot;
+          uniform_len++;
+          break;
+      }
+    }
+  }
+
+  this->attr_len_ = attr_len;
+  this->ubo_len_ = ubo_len;
+  this->uniform_len_ = uniform_len;
+  this->ssbo_len_ = ssbo_len;
+
+  const uint input_tot_len = attr_len + ubo_len + uniform_len + ssbo_len;
+  inputs_ = (ShaderInput *)MEM_callocN(sizeof(ShaderInput) * max_ii(1, input_tot_len), __func__);
+  name_buffer_ = (char *)MEM_mallocN(info ? max_ii(1, info->interface_names_size_) : 1,
+                                     "name_buffer");
+  ShaderInput *input = inputs_;
+  uint32_t name_buffer_offset = 0;
+  int location = 0;
+
+  if (info != nullptr) {
+    /* Attributes */
+    for (const ShaderCreateInfo::VertIn &attr : info->vertex_inputs_) {
+      copy_input_name(input, attr.name, name_buffer_, name_buffer_offset);
+      input->location = input->binding = attr.index;
+      enabled_attr_mask_ |= (1 << input->location);
+      input++;
+    }
+    /* Uniform Blocks */
+    for (const ShaderCreateInfo::Resource &res : all_resources) {
+      if (res.bind_type == BindType::UNIFORM_BUFFER) {
+        copy_input_name(input, res.uniformbuf.name, name_buffer_, name_buffer_offset);
+        input->location = input->binding = res.slot;
+        enabled_ubo_mask_ |= (1 << input->binding);
+        input++;
+      }
+    }
+    /* Samplers & Images */
+    for (const ShaderCreateInfo::Resource &res : all_resources) {
+      if (res.bind_type == BindType::SAMPLER) {
+        copy_input_name(input, res.sampler.name, name_buffer_, name_buffer_offset);
+        input->location = location++;
+        input->binding = res.slot;
+        input++;
+      }
+      else if (res.bind_type == BindType::IMAGE) {
+        copy_input_name(input, res.image.name, name_buffer_, name_buffer_offset);
+        input->location = location++;
+        input->binding = res.slot;
+        input++;
+      }
+    }
+    /* Push Constants */
+    for (const ShaderCreateInfo::PushConst &uni : info->push_constants_) {
+      copy_input_name(input, uni.name, name_buffer_, name_buffer_offset);
+      input->location = location;
+      input->binding = -1;
+      location += max_ii(1, uni.array_size);
+      input++;
+    }
+    /* Storage Buffers */
+    for (const ShaderCreateInfo::Resource &res : all_resources) {
+      if (res.bind_type == BindType::STORAGE_BUFFER) {
+        copy_input_name(input, res.storagebuf.name, name_buffer_, name_buffer_offset);
+        input->location = input->binding = res.slot;
+        input++;
+      }
+    }
+  }
+
+  /* Builtin Uniforms */
+  for (int32_t u_int = 0; u_int < GPU_NUM_UNIFORMS; u_int++) {
+    GPUUniformBuiltin u = static_cast<GPUUniformBuiltin>(u_int);
+    const ShaderInput *uni = this->uniform_get(builtin_uniform_name(u));
+    builtins_[u] = (uni != nullptr) ? uni->location : -1;
+  }
+
+  /* Builtin Uniforms Blocks */
+  for (int32_t u_int = 0; u_int < GPU_NUM_UNIFORM_BLOCKS; u_int++) {
+    GPUUniformBlockBuiltin u = static_cast<GPUUniformBlockBuiltin>(u_int);
+    const ShaderInput *block = this->ubo_get(builtin_uniform_block_name(u));
+    builtin_blocks_[u] = (block != nullptr) ? block->binding : -1;
+  }
+
+  this->sort_inputs();
+}
+
+}  // namespace dust::gpu
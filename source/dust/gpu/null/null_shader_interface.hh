@@ -0,0 +1,23 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_shader_create_info.hh"
+#include "gpu_shader_interface.hh"
+
+namespace dust::gpu {
+
+/**
+ * Interface built only from the #ShaderCreateInfo, since there is no program to query.
+ * Locations are assigned sequentially and bindings are the resource slots, which is what the
+ * other back-ends end up with when using explicit resource locations.
+ */
+class NullShaderInterface : public ShaderInterface {
+ public:
+  NullShaderInterface(const shader::ShaderCreateInfo *info);
+  ~NullShaderInterface() = default;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullShaderInterface");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,114 @@
+#include "LIB_assert.h"
+
+#include "gpu_immediate_private.hh"
+
+#include "null_backend.hh"
+#include "null_state.hh"
+
+namespace dust::gpu {
+
+NullStateManager::NullStateManager()
+{
+  /* Force update using default state. */
+  current_ = ~state;
+  current_mutable_ = ~mutable_state;
+}
+
+void NullStateManager::apply_state()
+{
+  if (!this->use_bgl) {
+    if (state != current_) {
+      NullBackend::stats.state_changes++;
+      current_ = state;
+    }
+    if (mutable_state != current_mutable_) {
+      NullBackend::stats.state_changes++;
+      current_mutable_ = mutable_state;
+    }
+  }
+}
+
+void NullStateManager::force_state()
+{
+  /* Little exception for clip distances since they need to keep the old count correct. */
+  uint32_t clip_distances = current_.clip_distances;
+  current_ = ~this->state;
+  current_.clip_distances = clip_distances;
+  current_mutable_ = ~this->mutable_state;
+  this->apply_state();
+}
+
+void NullStateManager::issue_barrier(eGPUBarrier /*barrier_bits*/)
+{
+}
+
+/* -------------------------------------------------------------------- */
+/* Texture State Management */
+
+void NullStateManager::texture_bind(Texture *tex, eGPUSamplerState sampler, int unit)
+{
+  LIB_assert(unit >= 0 && unit < NULL_TEXTURE_UNIT_LEN);
+  const SamplerState *sampler_state = &SamplerTable::get()[sampler];
+  const bool sampler_changed = samplers_[unit] != sampler_state;
+  SamplerTable::get().bind_count(sampler_changed);
+  if (textures_[unit] == tex && !sampler_changed) {
+    return;
+  }
+  imm_flush_merged();
+  textures_[unit] = tex;
+  samplers_[unit] = sampler_state;
+  NullBackend::stats.texture_binds++;
+}
+
+void NullStateManager::texture_unbind(Texture *tex)
+{
+  for (int i = 0; i < NULL_TEXTURE_UNIT_LEN; i++) {
+    if (textures_[i] == tex) {
+      imm_flush_merged();
+      textures_[i] = nullptr;
+    }
+  }
+}
+
+void NullStateManager::texture_unbind_all()
+{
+  imm_flush_merged();
+  for (int i = 0; i < NULL_TEXTURE_UNIT_LEN; i++) {
+    textures_[i] = nullptr;
+  }
+}
+
+void NullStateManager::image_bind(Texture *tex, int unit)
+{
+  LIB_assert(unit >= 0 && unit < NULL_IMAGE_UNIT_LEN);
+  if (images_[unit] != tex) {
+    imm_flush_merged();
+    images_[unit] = tex;
+    NullBackend::stats.texture_binds++;
+  }
+}
+
+void NullStateManager::image_unbind(Texture *tex)
+{
+  for (int i = 0; i < NULL_IMAGE_UNIT_LEN; i++) {
+    if (images_[i] == tex) {
+      imm_flush_merged();
+      images_[i] = nullptr;
+    }
+  }
+}
+
+void NullStateManager::image_unbind_all()
+{
+  imm_flush_merged();
+  for (int i = 0; i < NULL_IMAGE_UNIT_LEN; i++) {
+    images_[i] = nullptr;
+  }
+}
+
+void NullStateManager::texture_unpack_row_length_set(uint len)
+{
+  unpack_row_length_ = len;
+}
+
+}  // namespace dust::gpu
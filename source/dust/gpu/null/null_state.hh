@@ -0,0 +1,81 @@
+#pragma once
+
+#include "gpu_sampler_private.hh"
+#include "gpu_state_private.hh"
+
+namespace dust::gpu {
+
+/* Keep the same unit counts as the OpenGL back-end so binding code behaves the same. */
+#define NULL_TEXTURE_UNIT_LEN 64
+#define NULL_IMAGE_UNIT_LEN 8
+
+/**
+ * State manager which only tracks what would be bound.
+ * The tracked state is what #apply_state compares against, like a real back-end does.
+ */
+class NullStateManager : public StateManager {
+ private:
+  /** Last applied state. */
+  GPUState current_;
+  GPUStateMutable current_mutable_;
+
+  Texture *textures_[NULL_TEXTURE_UNIT_LEN] = {nullptr};
+  /** Entries of #SamplerTable. */
+  const SamplerState *samplers_[NULL_TEXTURE_UNIT_LEN] = {nullptr};
+  Texture *images_[NULL_IMAGE_UNIT_LEN] = {nullptr};
+  uint unpack_row_length_ = 0;
+
+ public:
+  NullStateManager();
+
+  void apply_state() override;
+  void force_state() override;
+
+  void issue_barrier(eGPUBarrier barrier_bits) override;
+
+  void texture_bind(Texture *tex, eGPUSamplerState sampler, int unit) override;
+  void texture_unbind(Texture *tex) override;
+  void texture_unbind_all() override;
+
+  void image_bind(Texture *tex, int unit) override;
+  void image_unbind(Texture *tex) override;
+  void image_unbind_all() override;
+
+  Texture *texture_bound_get(int unit, eGPUSamplerState *r_sampler) const override
+  {
+    if (unit < 0 || unit >= NULL_TEXTURE_UNIT_LEN || textures_[unit] == nullptr) {
+      return nullptr;
+    }
+    *r_sampler = SamplerTable::get().state_get(*samplers_[unit]);
+    return textures_[unit];
+  }
+
+  Texture *image_bound_get(int unit) const override
+  {
+    return (unit >= 0 && unit < NULL_IMAGE_UNIT_LEN) ? images_[unit] : nullptr;
+  }
+
+  void texture_unpack_row_length_set(uint len) override;
+
+  uint texture_unpack_row_length_get() const override
+  {
+    return unpack_row_length_;
+  }
+
+  Texture *texture_get(int unit) const
+  {
+    return (unit >= 0 && unit < NULL_TEXTURE_UNIT_LEN) ? textures_[unit] : nullptr;
+  }
+
+  const SamplerState &sampler_get(int unit) const
+  {
+    if (unit >= 0 && unit < NULL_TEXTURE_UNIT_LEN && samplers_[unit]) {
+      return *samplers_[unit];
+    }
+    return SamplerTable::get()[GPU_SAMPLER_DEFAULT];
+  }
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullStateManager");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,75 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+
+#include "null_backend.hh"
+#include "null_storage_buffer.hh"
+
+namespace dust::gpu {
+
+NullStorageBuf::NullStorageBuf(size_t size, const char *name) : StorageBuf(size, name)
+{
+}
+
+NullStorageBuf::~NullStorageBuf()
+{
+  if (is_allocated_) {
+    NullBackend::stats.buffers_len--;
+    NullBackend::stats.buffer_memory -= size_in_bytes_;
+  }
+}
+
+void NullStorageBuf::ensure_allocated()
+{
+  if (!is_allocated_) {
+    is_allocated_ = true;
+    NullBackend::stats.buffers_len++;
+    NullBackend::stats.buffer_memory += size_in_bytes_;
+  }
+}
+
+void NullStorageBuf::update(const void *data)
+{
+  LIB_assert(data != nullptr);
+  UNUSED_VARS_NDEBUG(data);
+  this->ensure_allocated();
+  NullBackend::stats.buffer_uploads++;
+  NullBackend::stats.buffer_upload_bytes += size_in_bytes_;
+}
+
+void NullStorageBuf::bind(int slot)
+{
+  LIB_assert(slot >= 0);
+  UNUSED_VARS_NDEBUG(slot);
+  if (data_ != nullptr) {
+    this->update(data_);
+    MEM_SAFE_FREE(data_);
+  }
+  this->ensure_allocated();
+}
+
+void NullStorageBuf::unbind()
+{
+}
+
+void NullStorageBuf::clear(eGPUTextureFormat /*internal_format*/,
+                           eGPUDataFormat /*data_format*/,
+                           void * /*data*/)
+{
+  this->ensure_allocated();
+}
+
+void NullStorageBuf::copy_sub(VertBuf *src, uint dst_offset, uint src_offset, uint copy_size)
+{
+  LIB_assert(src != nullptr);
+  LIB_assert(dst_offset + copy_size <= size_in_bytes_);
+  UNUSED_VARS_NDEBUG(src, dst_offset, src_offset, copy_size);
+  this->ensure_allocated();
+}
+
+void NullStorageBuf::read(void *data)
+{
+  memset(data, 0, size_in_bytes_);
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_storage_buffer_private.hh"
+
+namespace dust::gpu {
+
+/** Storage buffer which only accounts for the data it would upload. Reads return zeros. */
+class NullStorageBuf : public StorageBuf {
+ private:
+  bool is_allocated_ = false;
+
+ public:
+  NullStorageBuf(size_t size, const char *name);
+  ~NullStorageBuf();
+
+  void update(const void *data) override;
+  void bind(int slot) override;
+  void unbind() override;
+  void clear(eGPUTextureFormat internal_format, eGPUDataFormat data_format, void *data) override;
+  void copy_sub(VertBuf *src, uint dst_offset, uint src_offset, uint copy_size) override;
+  void read(void *data) override;
+
+ private:
+  void ensure_allocated();
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullStorageBuf");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,159 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+#include "LIB_math_base.h"
+
+#include "null_backend.hh"
+#include "null_texture.hh"
+
+namespace dust::gpu {
+
+/* -------------------------------------------------------------------- */
+/* Creation & Deletion */
+
+NullTexture::NullTexture(const char *name) : Texture(name)
+{
+}
+
+NullTexture::~NullTexture()
+{
+  if (owns_memory_) {
+    NullBackend::stats.textures_len--;
+    NullBackend::stats.texture_memory -= device_size_;
+  }
+}
+
+bool NullTexture::init_internal()
+{
+  if ((format_flag_ & GPU_FORMAT_DEPTH) && (type_ & GPU_TEXTURE_3D)) {
+    /* 3D depth textures are not supported by any back-end. */
+    return false;
+  }
+
+  device_size_ = 0;
+  for (int mip = 0; mip < max_ii(1, mipmaps_); mip++) {
+    int extent[3] = {1, 1, 1};
+    this->mip_size_get(mip, extent);
+    const size_t texel_len = size_t(extent[0]) * max_ii(1, extent[1]) * max_ii(1, extent[2]);
+    if (format_flag_ & GPU_FORMAT_COMPRESSED) {
+      const size_t block_len = size_t((extent[0] + 3) / 4) * ((max_ii(1, extent[1]) + 3) / 4) *
+                               max_ii(1, extent[2]);
+      device_size_ += block_len * to_block_size(format_);
+    }
+    else {
+      device_size_ += texel_len * to_bytesize(format_);
+    }
+  }
+
+  owns_memory_ = true;
+  NullBackend::stats.textures_len++;
+  NullBackend::stats.texture_memory += device_size_;
+  return true;
+}
+
+bool NullTexture::init_internal(GPUVertBuf * /*vbo*/)
+{
+  /* Storage is owned by the vertex buffer. */
+  return true;
+}
+
+bool NullTexture::init_internal(const GPUTexture *src, int mip_offset, int layer_offset)
+{
+  LIB_assert(src != nullptr);
+  LIB_assert(mip_offset >= 0 && layer_offset >= 0);
+  UNUSED_VARS_NDEBUG(src, mip_offset, layer_offset);
+  /* Views alias the source storage. */
+  return true;
+}
+
+/* -------------------------------------------------------------------- */
+/* Operations */
+
+void NullTexture::update_sub(
+    int mip, int offset[3], int extent[3], eGPUDataFormat type, const void *data)
+{
+  LIB_assert(mip >= 0 && mip < max_ii(1, mipmaps_));
+  LIB_assert(data != nullptr);
+  UNUSED_VARS_NDEBUG(data);
+
+  int mip_size[3] = {1, 1, 1};
+  this->mip_size_get(mip, mip_size);
+  const int dimensions = this->dimensions_count();
+  for (int i = 0; i < dimensions; i++) {
+    LIB_assert_msg(offset[i] >= 0 && offset[i] + extent[i] <= mip_size[i],
+                   "GPUTexture: update is out of the texture bounds");
+  }
+  UNUSED_VARS_NDEBUG(mip_size, offset);
+
+  size_t texel_len = 1;
+  for (int i = 0; i < dimensions; i++) {
+    texel_len *= size_t(max_ii(1, extent[i]));
+  }
+
+  NullBackend::stats.texture_uploads++;
+  if (format_flag_ & GPU_FORMAT_COMPRESSED) {
+    NullBackend::stats.texture_upload_bytes += ((extent[0] + 3) / 4) *
+                                               ((max_ii(1, extent[1]) + 3) / 4) *
+                                               to_block_size(format_);
+  }
+  else {
+    NullBackend::stats.texture_upload_bytes += texel_len * to_bytesize(format_, type);
+  }
+}
+
+void NullTexture::generate_mipmap()
+{
+  LIB_assert(!(format_flag_ & GPU_FORMAT_COMPRESSED));
+}
+
+void NullTexture::copy_to(Texture *dst)
+{
+  /* Same restrictions as the other back-ends. */
+  LIB_assert((dst->width_get() == w_) && (dst->height_get() == h_) &&
+             (dst->depth_get() == d_));
+  LIB_assert(dst->format_get() == format_);
+  UNUSED_VARS_NDEBUG(dst);
+}
+
+void NullTexture::clear(eGPUDataFormat format, const void *data)
+{
+  LIB_assert(validate_data_format(format_, format));
+  LIB_assert(data != nullptr);
+  UNUSED_VARS_NDEBUG(format, data);
+}
+
+void NullTexture::swizzle_set(const char swizzle_mask[4])
+{
+  memcpy(swizzle_, swizzle_mask, sizeof(swizzle_));
+}
+
+void NullTexture::stencil_texture_mode_set(bool use_stencil)
+{
+  LIB_assert(GPU_texture_stencil(wrap(this)) || !use_stencil);
+  stencil_texture_mode_ = use_stencil;
+}
+
+void NullTexture::mip_range_set(int min, int max)
+{
+  LIB_assert(min <= max && min >= 0 && max <= mipmaps_);
+  mip_min_ = min;
+  mip_max_ = max;
+}
+
+void *NullTexture::read(int mip, eGPUDataFormat type)
+{
+  LIB_assert(!(format_flag_ & GPU_FORMAT_COMPRESSED));
+  LIB_assert(mip >= 0 && mip < max_ii(1, mipmaps_));
+
+  int extent[3] = {1, 1, 1};
+  this->mip_size_get(mip, extent);
+
+  const size_t sample_len = size_t(extent[0]) * max_ii(1, extent[1]) * max_ii(1, extent[2]);
+  const size_t texture_size = sample_len * to_bytesize(format_, type);
+
+  NullBackend::stats.texture_reads++;
+  /* Nothing was ever rendered, contents are undefined. Return zeros to keep it deterministic. */
+  return MEM_callocN(texture_size, "NullTexture::read");
+}
+
+}  // namespace dust::gpu
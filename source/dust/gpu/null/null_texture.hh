@@ -0,0 +1,55 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_texture_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Texture without any storage. Tracks the size it would use on the device and validates
+ * every update and read against its mip dimensions.
+ */
+class NullTexture : public Texture {
+ private:
+  /** Size of all the mip levels, as a device would allocate them. */
+  size_t device_size_ = 0;
+  /** Views and buffer textures do not own any memory. */
+  bool owns_memory_ = false;
+  char swizzle_[4] = {'r', 'g', 'b', 'a'};
+  bool stencil_texture_mode_ = false;
+
+ public:
+  NullTexture(const char *name);
+  ~NullTexture();
+
+  void update_sub(
+      int mip, int offset[3], int extent[3], eGPUDataFormat type, const void *data) override;
+
+  void generate_mipmap() override;
+  void copy_to(Texture *dst) override;
+  void clear(eGPUDataFormat format, const void *data) override;
+  void swizzle_set(const char swizzle_mask[4]) override;
+  void stencil_texture_mode_set(bool use_stencil) override;
+  void mip_range_set(int min, int max) override;
+  void *read(int mip, eGPUDataFormat type) override;
+
+  uint gl_bindcode_get() const override
+  {
+    return 0;
+  }
+
+  size_t device_size_get() const
+  {
+    return device_size_;
+  }
+
+ protected:
+  bool init_internal() override;
+  bool init_internal(GPUVertBuf *vbo) override;
+  bool init_internal(const GPUTexture *src, int mip_offset, int layer_offset) override;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullTexture");
+};
+
+}  // namespace dust::gpu
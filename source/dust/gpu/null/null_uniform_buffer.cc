@@ -0,0 +1,47 @@
+#include "LIB_assert.h"
+
+#include "null_backend.hh"
+#include "null_uniform_buffer.hh"
+
+namespace dust::gpu {
+
+NullUniformBuf::NullUniformBuf(size_t size, const char *name) : UniformBuf(size, name)
+{
+}
+
+NullUniformBuf::~NullUniformBuf()
+{
+  if (is_allocated_) {
+    NullBackend::stats.buffers_len--;
+    NullBackend::stats.buffer_memory -= size_in_bytes_;
+  }
+}
+
+void NullUniformBuf::update(const void *data)
+{
+  LIB_assert(data != nullptr);
+  UNUSED_VARS_NDEBUG(data);
+  if (!is_allocated_) {
+    is_allocated_ = true;
+    NullBackend::stats.buffers_len++;
+    NullBackend::stats.buffer_memory += size_in_bytes_;
+  }
+  NullBackend::stats.buffer_uploads++;
+  NullBackend::stats.buffer_upload_bytes += size_in_bytes_;
+}
+
+void NullUniformBuf::bind(int slot)
+{
+  LIB_assert(slot >= 0);
+  UNUSED_VARS_NDEBUG(slot);
+  if (data_ != nullptr) {
+    this->update(data_);
+    MEM_SAFE_FREE(data_);
+  }
+}
+
+void NullUniformBuf::unbind()
+{
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_uniform_buffer_private.hh"
+
+namespace dust::gpu {
+
+/** Uniform buffer which only accounts for the data it would upload. */
+class NullUniformBuf : public UniformBuf {
+ private:
+  bool is_allocated_ = false;
+
+ public:
+  NullUniformBuf(size_t size, const char *name);
+  ~NullUniformBuf();
+
+  void update(const void *data) override;
+  void bind(int slot) override;
+  void unbind() override;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullUniformBuf");
+};
+
+}  // namespace dust::gpu
@@ -0,0 +1,124 @@
+#include <cstring>
+
+#include "LIB_assert.h"
+
+#include "gpu_memory_budget_private.hh"
+
+#include "null_backend.hh"
+#include "null_vertex_buffer.hh"
+
+namespace dust::gpu {
+
+NullVertBuf::~NullVertBuf()
+{
+  MemoryBudget::get().buffer_remove(this);
+}
+
+void NullVertBuf::device_size_set(size_t size)
+{
+  if (device_size_ == 0 && size > 0) {
+    NullBackend::stats.buffers_len++;
+  }
+  else if (device_size_ > 0 && size == 0) {
+    NullBackend::stats.buffers_len--;
+  }
+  NullBackend::stats.buffer_memory += int64_t(size) - int64_t(device_size_);
+  memory_usage += size;
+  memory_usage -= device_size_;
+  device_size_ = size;
+  MemoryBudget::get().buffer_size_set(this, size);
+}
+
+void NullVertBuf::acquire_data()
+{
+  if (usage_ == GPU_USAGE_DEVICE_ONLY) {
+    return;
+  }
+  /* Discard previous data if any. */
+  MEM_SAFE_FREE(data);
+  data = (uchar *)MEM_mallocN(sizeof(uchar) * this->size_alloc_get(), __func__);
+}
+
+void NullVertBuf::resize_data()
+{
+  if (usage_ == GPU_USAGE_DEVICE_ONLY) {
+    return;
+  }
+  data = (uchar *)MEM_reallocN(data, sizeof(uchar) * this->size_alloc_get());
+}
+
+void NullVertBuf::release_data()
+{
+  if (is_wrapper_) {
+    return;
+  }
+  this->device_size_set(0);
+  MEM_SAFE_FREE(data);
+}
+
+void NullVertBuf::duplicate_data(VertBuf *dst_)
+{
+  NullVertBuf *dst = static_cast<NullVertBuf *>(dst_);
+  LIB_assert(dst->device_size_ == 0);
+  dst->device_size_set(device_size_);
+}
+
+void NullVertBuf::upload_data()
+{
+  if (flag & GPU_VERTBUF_DATA_DIRTY) {
+    const size_t size = this->size_used_get();
+    if (size != device_size_) {
+      this->device_size_set(size);
+    }
+    if (data != nullptr) {
+      NullBackend::stats.buffer_uploads++;
+      NullBackend::stats.buffer_upload_bytes += size;
+    }
+    /* Do not keep host data if not needed. */
+    if (usage_ == GPU_USAGE_STATIC) {
+      MEM_SAFE_FREE(data);
+    }
+    flag &= ~GPU_VERTBUF_DATA_DIRTY;
+    flag |= GPU_VERTBUF_DATA_UPLOADED;
+  }
+}
+
+void NullVertBuf::bind_as_ssbo(uint /*binding*/)
+{
+  this->upload_data();
+}
+
+void NullVertBuf::bind_as_texture(uint /*binding*/)
+{
+  this->upload_data();
+}
+
+void NullVertBuf::update_sub(uint start, uint len, const void *data)
+{
+  LIB_assert(start + len <= device_size_);
+  UNUSED_VARS_NDEBUG(start, data);
+  NullBackend::stats.buffer_uploads++;
+  NullBackend::stats.buffer_upload_bytes += len;
+}
+
+const void *NullVertBuf::read() const
+{
+  /* Nothing is ever written on the device. Ownership goes back to #unmap. */
+  return MEM_callocN(device_size_, "NullVertBuf::read");
+}
+
+void *NullVertBuf::unmap(const void *mapped_data) const
+{
+  void *result = MEM_mallocN(device_size_, __func__);
+  memcpy(result, mapped_data, device_size_);
+  MEM_freeN((void *)mapped_data);
+  return result;
+}
+
+void NullVertBuf::wrap_handle(uint64_t /*handle*/)
+{
+  LIB_assert(device_size_ == 0);
+  is_wrapper_ = true;
+}
+
+}  // namespace dust::gpu
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "MEM_guardedalloc.h"
+
+#include "gpu_vertex_buffer_private.hh"
+
+namespace dust::gpu {
+
+/**
+ * Vertex buffer keeping the same host data life-time as the OpenGL back-end
+ * (data of static buffers is freed after upload) and tracking its would-be device size.
+ */
+class NullVertBuf : public VertBuf {
+ private:
+  /** Size on the device, zero when nothing was uploaded. */
+  size_t device_size_ = 0;
+  /** Buffer handle wrapped from another API. Not owned. */
+  bool is_wrapper_ = false;
+
+ public:
+  ~NullVertBuf() override;
+
+  void bind_as_ssbo(uint binding) override;
+  void bind_as_texture(uint binding) override;
+
+  void update_sub(uint start, uint len, const void *data) override;
+
+  const void *read() const override;
+  void *unmap(const void *mapped_data) const override;
+
+  void wrap_handle(uint64_t handle) override;
+
+ protected:
+  void acquire_data() override;
+  void resize_data() override;
+  void release_data() override;
+  void upload_data() override;
+  void duplicate_data(VertBuf *dst) override;
+
+ private:
+  void device_size_set(size_t size);
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("NullVertBuf");
+};
+
+}  // namespace dust::gpu
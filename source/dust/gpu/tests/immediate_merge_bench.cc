@@ -0,0 +1,103 @@
+/* Draw calls and time saved by merging immediate draws (gpu_immediate_merge.cc).
+ *
+ * Standalone, links against the gpu module only:
+ *   immediate_merge_bench [quad_len] [repeat]
+ * Draws many small quads the way interface code does (one #immBegin per quad, the same uniform
+ * color set before each), with merging disabled then enabled. Runs on the CPU back-end unless
+ * `DUST_GPU_BACKEND` selects another one; "null" measures the host side only.
+ */
+
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+
+#include "LIB_math_base.h"
+#include "LIB_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "GPU_backend.h"
+#include "GPU_context.h"
+#include "GPU_framebuffer.h"
+#include "GPU_immediate.h"
+#include "GPU_immediate_ring.h"
+#include "GPU_shader.h"
+
+#define OFS_SIZE 512
+
+static void draw_quads(int quad_len)
+{
+  const uint pos = GPU_vertformat_attr_add(
+      immVertexFormat(), "pos", GPU_COMP_F32, 2, GPU_FETCH_FLOAT);
+  immBindBuiltinProgram(GPU_SHADER_3D_UNIFORM_COLOR);
+  for (int i = 0; i < quad_len; i++) {
+    const float x = float(i % 64) / 32.0f - 1.0f;
+    const float y = float((i / 64) % 64) / 32.0f - 1.0f;
+    const float size = 1.0f / 64.0f;
+    immUniformColor4f(0.2f, 0.4f, 0.8f, 1.0f);
+    immBegin(GPU_PRIM_TRIS, 6);
+    immVertex2f(pos, x, y);
+    immVertex2f(pos, x + size, y);
+    immVertex2f(pos, x + size, y + size);
+    immVertex2f(pos, x, y);
+    immVertex2f(pos, x + size, y + size);
+    immVertex2f(pos, x, y + size);
+    immEnd();
+  }
+  immUnbindProgram();
+}
+
+static void run(GPUOffScreen *ofs, bool use_merge, int quad_len, int repeat)
+{
+  GPU_immediate_merge_set(use_merge);
+
+  double best_time = DBL_MAX;
+  GPUImmediateRingStats stats = {0};
+  for (int i = 0; i < repeat; i++) {
+    GPU_render_begin();
+    GPU_offscreen_bind(ofs, false);
+    const double start = PIL_check_seconds_timer();
+    draw_quads(quad_len);
+    GPU_finish();
+    best_time = min_dd(best_time, PIL_check_seconds_timer() - start);
+    GPU_offscreen_unbind(ofs, false);
+    /* Publishes the counters of this run. */
+    GPU_render_step();
+    GPU_render_end();
+    GPU_immediate_ring_stats_get(&stats);
+  }
+  printf("merge %-3s %8u draws %8u draw calls %8.2f ms\n",
+         use_merge ? "on" : "off",
+         stats.draw_len,
+         stats.draw_len - stats.merged_len,
+         best_time * 1e3);
+}
+
+int main(int argc, char **argv)
+{
+  const int quad_len = (argc > 1) ? atoi(argv[1]) : 4096;
+  const int repeat = (argc > 2) ? atoi(argv[2]) : 10;
+
+  GPU_backend_type_selection_set(GPU_BACKEND_CPU);
+  if (!GPU_backend_type_selection_from_env()) {
+    fprintf(stderr, "Unknown back-end in DUST_GPU_BACKEND\n");
+    return 1;
+  }
+
+  GPUContext *context = GPU_context_create(nullptr, nullptr);
+  GPU_context_active_set(context);
+  char err_out[256];
+  GPUOffScreen *ofs = GPU_offscreen_create(OFS_SIZE, OFS_SIZE, false, GPU_RGBA8, err_out);
+  if (ofs == nullptr) {
+    fprintf(stderr, "%s\n", err_out);
+    return 1;
+  }
+
+  printf("%d quads, best of %d runs\n", quad_len, repeat);
+  run(ofs, false, quad_len, repeat);
+  run(ofs, true, quad_len, repeat);
+
+  GPU_offscreen_free(ofs);
+  GPU_context_discard(context);
+  return 0;
+}
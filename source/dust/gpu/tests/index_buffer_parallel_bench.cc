@@ -0,0 +1,100 @@
+/* Scaling of #GPU_indexbuf_fill_parallel from one core to all of them.
+ *
+ * Standalone, links against the gpu module only:
+ *   index_buffer_parallel_bench [quad_grid_size] [repeat]
+ * Builds the triangles of a grid of quads, first with a serial loop then in parallel, limiting the
+ * number of threads with a task arena. Without TBB only the single thread run is done.
+ */
+
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#ifdef WITH_TBB
+#  include <tbb/task_arena.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "LIB_math_base.h"
+#include "LIB_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "GPU_index_buffer.h"
+
+/* Number of triangles filled by each task. */
+#define FILL_GRAIN_SIZE 4096
+
+static void grid_tris_fill(void *user_data,
+                           GPUIndexBufBuilder *builder,
+                           uint prim_start,
+                           uint prim_end)
+{
+  const uint grid_size = *static_cast<const uint *>(user_data);
+  for (uint tri = prim_start; tri < prim_end; tri++) {
+    const uint quad = tri / 2;
+    const uint v = (quad / grid_size) * (grid_size + 1) + quad % grid_size;
+    if (tri & 1) {
+      GPU_indexbuf_set_tri_verts(builder, tri, v + 1, v + grid_size + 2, v + grid_size + 1);
+    }
+    else {
+      GPU_indexbuf_set_tri_verts(builder, tri, v, v + 1, v + grid_size + 1);
+    }
+  }
+}
+
+template<typename Fn> static double time_best(int repeat, uint grid_size, const Fn &fn)
+{
+  const uint tri_len = grid_size * grid_size * 2;
+  const uint vert_len = (grid_size + 1) * (grid_size + 1);
+  double best_time = DBL_MAX;
+  for (int i = 0; i < repeat; i++) {
+    GPUIndexBufBuilder builder;
+    GPU_indexbuf_init(&builder, GPU_PRIM_TRIS, tri_len, vert_len);
+    const double start = PIL_check_seconds_timer();
+    fn(&builder);
+    best_time = min_dd(best_time, PIL_check_seconds_timer() - start);
+    /* Only the fill is measured, nothing is sent to a device. */
+    MEM_freeN(builder.data);
+  }
+  return best_time;
+}
+
+int main(int argc, char **argv)
+{
+  uint grid_size = (argc > 1) ? uint(atoi(argv[1])) : 2048;
+  const int repeat = (argc > 2) ? atoi(argv[2]) : 10;
+  const uint tri_len = grid_size * grid_size * 2;
+
+  printf("%u triangles, best of %d runs\n", tri_len, repeat);
+
+  const double serial_time = time_best(repeat, grid_size, [&](GPUIndexBufBuilder *builder) {
+    grid_tris_fill(&grid_size, builder, 0, tri_len);
+  });
+  printf("serial     %8.1f Mtri/s\n", double(tri_len) / serial_time * 1e-6);
+
+  const auto fill_parallel = [&](GPUIndexBufBuilder *builder) {
+    GPU_indexbuf_fill_parallel(builder, tri_len, FILL_GRAIN_SIZE, grid_tris_fill, &grid_size);
+  };
+#ifdef WITH_TBB
+  const int thread_max = max_ii(1, int(std::thread::hardware_concurrency()));
+  for (int thread_len = 1;; thread_len = min_ii(thread_len * 2, thread_max)) {
+    tbb::task_arena arena(thread_len);
+    double time;
+    arena.execute([&]() { time = time_best(repeat, grid_size, fill_parallel); });
+    printf("%2d threads %8.1f Mtri/s (x%.2f)\n",
+           thread_len,
+           double(tri_len) / time * 1e-6,
+           serial_time / time);
+    if (thread_len == thread_max) {
+      break;
+    }
+  }
+#else
+  const double time = time_best(repeat, grid_size, fill_parallel);
+  printf(" 1 threads %8.1f Mtri/s (x%.2f)\n", double(tri_len) / time * 1e-6, serial_time / time);
+#endif
+  return 0;
+}
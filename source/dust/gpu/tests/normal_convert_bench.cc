@@ -0,0 +1,114 @@
+/* Normals packed per second by the array conversions of gpu_vertex_format_convert.cc, compared
+ * with a loop over the single normal conversions.
+ *
+ * Standalone, links against the gpu module only:
+ *   normal_convert_bench [normal_len] [repeat]
+ * The destination is an interleaved position and normal layout so the strided store is measured
+ * as well.
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "LIB_array.hh"
+#include "LIB_math_base.h"
+#include "LIB_math_vector.h"
+#include "LIB_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "GPU_vertex_format.h"
+
+using namespace dust;
+
+/* Position followed by the normal, like the mesh vertex buffers. */
+#define VERT_STRIDE (sizeof(float[3]) + sizeof(GPUNormal))
+#define NOR_OFFSET sizeof(float[3])
+
+template<typename Fn> static double time_best(int repeat, const Fn &fn)
+{
+  double best_time = DBL_MAX;
+  for (int i = 0; i < repeat; i++) {
+    const double start = PIL_check_seconds_timer();
+    fn();
+    best_time = min_dd(best_time, PIL_check_seconds_timer() - start);
+  }
+  return best_time;
+}
+
+static void print_result(const char *name, uint normal_len, double loop_time, double array_time)
+{
+  printf("%-8s loop %8.1f M/s array %8.1f M/s (x%.2f)\n",
+         name,
+         double(normal_len) / loop_time * 1e-6,
+         double(normal_len) / array_time * 1e-6,
+         loop_time / array_time);
+}
+
+int main(int argc, char **argv)
+{
+  const uint normal_len = (argc > 1) ? uint(atoi(argv[1])) : 4 * 1024 * 1024;
+  const int repeat = (argc > 2) ? atoi(argv[2]) : 10;
+
+  Array<float> normals(int64_t(normal_len) * 3);
+  Array<short> normals_short(int64_t(normal_len) * 3);
+  float(*src)[3] = reinterpret_cast<float(*)[3]>(normals.data());
+  short(*src_short)[3] = reinterpret_cast<short(*)[3]>(normals_short.data());
+  for (uint i = 0; i < normal_len; i++) {
+    /* Unit vectors spread over the sphere, including the clamped -1 and 1 values. */
+    const float angle = float(i) * 0.001f;
+    const float z = float(i % 2001) / 1000.0f - 1.0f;
+    const float r = sqrtf(max_ff(0.0f, 1.0f - z * z));
+    src[i][0] = r * cosf(angle);
+    src[i][1] = r * sinf(angle);
+    src[i][2] = z;
+    normal_float_to_short_v3(src_short[i], src[i]);
+  }
+  Array<uchar> verts(int64_t(normal_len) * VERT_STRIDE);
+  uchar *dst = verts.data() + NOR_OFFSET;
+
+  printf("%u normals, best of %d runs\n", normal_len, repeat);
+
+  print_result("i10 v3",
+               normal_len,
+               time_best(repeat,
+                         [&]() {
+                           for (uint i = 0; i < normal_len; i++) {
+                             const GPUPackedNormal n = GPU_normal_convert_i10_v3(src[i]);
+                             memcpy(dst + i * VERT_STRIDE, &n, sizeof(n));
+                           }
+                         }),
+               time_best(repeat, [&]() {
+                 GPU_normal_convert_i10_v3_array(src, dst, VERT_STRIDE, normal_len);
+               }));
+
+  print_result("i10 s3",
+               normal_len,
+               time_best(repeat,
+                         [&]() {
+                           for (uint i = 0; i < normal_len; i++) {
+                             const GPUPackedNormal n = GPU_normal_convert_i10_s3(src_short[i]);
+                             memcpy(dst + i * VERT_STRIDE, &n, sizeof(n));
+                           }
+                         }),
+               time_best(repeat, [&]() {
+                 GPU_normal_convert_i10_s3_array(src_short, dst, VERT_STRIDE, normal_len);
+               }));
+
+  print_result("hq v3",
+               normal_len,
+               time_best(repeat,
+                         [&]() {
+                           for (uint i = 0; i < normal_len; i++) {
+                             GPUNormal *n = reinterpret_cast<GPUNormal *>(dst + i * VERT_STRIDE);
+                             GPU_normal_convert_v3(n, src[i], true);
+                           }
+                         }),
+               time_best(repeat, [&]() {
+                 GPU_normal_convert_v3_array(src, dst, VERT_STRIDE, normal_len, true);
+               }));
+  return 0;
+}
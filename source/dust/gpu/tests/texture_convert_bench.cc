@@ -0,0 +1,95 @@
+/* Throughput of the pixel data format conversions of gpu_texture_convert.cc.
+ *
+ * Standalone, links against the gpu module only:
+ *   texture_convert_bench [texel_len] [repeat]
+ * Build it with and without `-mavx2 -mf16c` to compare the AVX2/F16C kernels against the SSE2
+ * and scalar ones.
+ */
+
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+
+#include "LIB_array.hh"
+#include "LIB_math_base.h"
+#include "LIB_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "../intern/gpu_texture_convert.hh"
+
+using namespace dust;
+using namespace dust::gpu;
+
+struct ConvertCase {
+  const char *name;
+  eGPUDataFormat src_format;
+  eGPUDataFormat dst_format;
+  eGPUTextureFormat tex_format;
+  int component_len;
+};
+
+static const ConvertCase cases[] = {
+    {"float -> half", GPU_DATA_FLOAT, GPU_DATA_HALF_FLOAT, GPU_RGBA16F, 4},
+    {"half -> float", GPU_DATA_HALF_FLOAT, GPU_DATA_FLOAT, GPU_RGBA16F, 4},
+    {"float -> unorm8", GPU_DATA_FLOAT, GPU_DATA_UBYTE, GPU_RGBA8, 4},
+    {"unorm8 -> float", GPU_DATA_UBYTE, GPU_DATA_FLOAT, GPU_RGBA8, 4},
+    /* Goes through the float intermediate buffer. */
+    {"half -> unorm8", GPU_DATA_HALF_FLOAT, GPU_DATA_UBYTE, GPU_RGBA8, 4},
+    {"float -> 10_11_11", GPU_DATA_FLOAT, GPU_DATA_10_11_11_REV, GPU_R11F_G11F_B10F, 3},
+};
+
+static void fill_source(MutableSpan<uchar> bytes, const ConvertCase &test, size_t texel_len)
+{
+  if (test.src_format == GPU_DATA_FLOAT) {
+    /* Covers [-0.25..1.25] so clamping is part of the measure. */
+    float *values = reinterpret_cast<float *>(bytes.data());
+    for (size_t i = 0; i < texel_len * test.component_len; i++) {
+      values[i] = float(i % 1501) / 1000.0f - 0.25f;
+    }
+    return;
+  }
+  for (const int64_t i : bytes.index_range()) {
+    bytes[i] = uchar(i * 31);
+  }
+  if (test.src_format == GPU_DATA_HALF_FLOAT) {
+    /* Keep the values finite. */
+    uint16_t *values = reinterpret_cast<uint16_t *>(bytes.data());
+    for (size_t i = 0; i < texel_len * test.component_len; i++) {
+      values[i] &= 0x3bff;
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const size_t texel_len = (argc > 1) ? size_t(atoll(argv[1])) : 4096 * 4096;
+  const int repeat = (argc > 2) ? atoi(argv[2]) : 10;
+
+  printf("%zu texels, best of %d runs\n", texel_len, repeat);
+  for (const ConvertCase &test : cases) {
+    Array<uchar> src(
+        int64_t(convert_buffer_size(test.src_format, test.component_len, texel_len)));
+    Array<uchar> dst(
+        int64_t(convert_buffer_size(test.dst_format, test.component_len, texel_len)));
+    fill_source(src, test, texel_len);
+
+    double best_time = DBL_MAX;
+    for (int i = 0; i < repeat; i++) {
+      const double start = PIL_check_seconds_timer();
+      convert_texels(src.data(),
+                     test.src_format,
+                     dst.data(),
+                     test.dst_format,
+                     test.tex_format,
+                     test.component_len,
+                     texel_len);
+      best_time = min_dd(best_time, PIL_check_seconds_timer() - start);
+    }
+    printf("%-20s %8.1f Mtexel/s %8.2f GB/s (source)\n",
+           test.name,
+           double(texel_len) / best_time * 1e-6,
+           double(src.size()) / best_time * 1e-9);
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+/* Build step writing the flat create info tables of gpu_shader_create_info_flat.hh.
+ *
+ *   shader_create_info_flatten <info_list> <output.cc>
+ * \a info_list holds the name of one create info per line, empty lines and lines starting with
+ * `#` are skipped. The infos are taken from the registry, finalized, validated and written to
+ * \a output.cc in the listed order. The output is only rewritten when it changes, so the files
+ * depending on it are not rebuilt for nothing.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "LIB_vector.hh"
+
+#include "GPU_shader.h"
+
+#include "../intern/gpu_shader_create_info.hh"
+#include "../intern/gpu_shader_create_info_flat.hh"
+#include "../intern/gpu_shader_create_info_private.hh"
+
+using namespace dust;
+using namespace dust::gpu::shader;
+
+static bool file_read(const char *path, std::string &r_content)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::stringstream ss;
+  ss << file.rdbuf();
+  r_content = ss.str();
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <info_list> <output.cc>\n", argv[0]);
+    return 1;
+  }
+  const char *list_path = argv[1];
+  const char *output_path = argv[2];
+
+  std::ifstream list(list_path);
+  if (!list) {
+    fprintf(stderr, "Unable to open %s\n", list_path);
+    return 1;
+  }
+
+  gpu_shader_create_info_init();
+
+  Vector<const ShaderCreateInfo *> infos;
+  bool found_all = true;
+  std::string name;
+  while (std::getline(list, name)) {
+    if (!name.empty() && name.back() == '\r') {
+      name.pop_back();
+    }
+    if (name.empty() || name[0] == '#') {
+      continue;
+    }
+    const GPUShaderCreateInfo *info = gpu_shader_create_info_get(name.c_str());
+    if (info == nullptr) {
+      fprintf(stderr, "%s: unknown create info %s\n", list_path, name.c_str());
+      found_all = false;
+      continue;
+    }
+    /* The registry doesn't finalize the infos it isn't asked to create shaders from. */
+    ShaderCreateInfo *create_info = const_cast<ShaderCreateInfo *>(
+        reinterpret_cast<const ShaderCreateInfo *>(info));
+    create_info->finalize();
+    infos.append(create_info);
+  }
+
+  std::string source, error;
+  const bool is_valid = found_all && shader_create_info_flatten(infos, source, error);
+  gpu_shader_create_info_exit();
+  if (!is_valid) {
+    fprintf(stderr, "%s", error.c_str());
+    return 1;
+  }
+
+  std::string prev_source;
+  if (file_read(output_path, prev_source) && prev_source == source) {
+    return 0;
+  }
+  std::ofstream output(output_path, std::ios::binary);
+  output << source;
+  if (!output.good()) {
+    fprintf(stderr, "Unable to write %s\n", output_path);
+    return 1;
+  }
+  return 0;
+}
@@ -3,6 +3,11 @@
 
 #include "KERNEL_context.h"
 
+#include "GPU_memory_budget.h"
+#include "GPU_readback.h"
+#include "GPU_texture.h"
+#include "GPU_texture_pool.h"
+
 #include "WM_api.h"
 #include "wm_draw.h"
 #include "wm_event_system.h"
@@ -24,7 +29,19 @@ void WM_main(bContext *C)
     /* Events have left notes about changes, we handle and cache it. */
     wm_event_do_notifiers(C);
 
+    /* Upload this frame's share of the queued texture updates before drawing. */
+    GPU_texture_upload_queue_flush();
+
     /* Execute cached changes draw. */
     wm_draw_update(C);
+
+    /* Deliver the pixel readbacks that completed while drawing. */
+    GPU_readback_poll();
+
+    /* Free transient textures that were not reused by the last redraws. */
+    GPU_texture_pool_step();
+
+    /* Evict cached textures of the memory categories that went over budget. */
+    GPU_memory_budget_step();
   }
 }